@@ -0,0 +1,201 @@
+#include "pch.h"
+
+#include <thread>
+
+#include <XivAlexanderCommon/Utils/DebouncedTask.h>
+#include <XivAlexanderCommon/Utils/ListenerManager.h>
+#include <XivAlexanderCommon/Utils/Utils.h>
+
+// Changes 100 configuration items in a row, each of them requesting its repository to be saved like
+// XivAlexander::Config::Item does, and counts how many times the file actually gets written: once per change when
+// saving right away, which is how it used to be done, and with Utils::DebouncedTask. Then checks that writes keep
+// happening at least every maxDelay while changes never stop, and that flushing writes what is pending.
+// Usage: ScratchProject [directory to write to]
+
+using namespace std::chrono_literals;
+
+static constexpr auto Delay = 100ms;
+static constexpr auto MaxDelay = 500ms;
+
+class Repository {
+	struct Item {
+		int Value = 0;
+		Utils::ListenerManager<Repository, void> OnChange;
+	};
+
+	const std::filesystem::path m_path;
+	std::mutex m_valuesMtx;
+	std::vector<Item> m_items;
+	Utils::CallOnDestruction::Multiple m_cleanup;
+
+	std::mutex m_writesMtx;
+	std::vector<Utils::DebouncedTask::Clock::time_point> m_writes;
+
+public:
+	std::optional<Utils::DebouncedTask> DeferredSave;
+
+	Repository(std::filesystem::path path, size_t itemCount, bool deferred)
+		: m_path(std::move(path))
+		, m_items(itemCount) {
+		if (deferred)
+			DeferredSave.emplace(L"Test_DebouncedTask", [this]() { Save(); }, Delay, MaxDelay);
+		for (auto& item : m_items) {
+			m_cleanup += item.OnChange([this]() {
+				if (DeferredSave)
+					DeferredSave->Schedule();
+				else
+					Save();
+			});
+		}
+	}
+
+	~Repository() {
+		m_cleanup.Clear();
+		if (DeferredSave)
+			DeferredSave->Flush();
+		DeferredSave.reset();
+	}
+
+	void Set(size_t index, int value) {
+		{
+			const auto lock = std::lock_guard(m_valuesMtx);
+			m_items[index].Value = value;
+		}
+		m_items[index].OnChange();
+	}
+
+	void Save() {
+		auto j = nlohmann::json::object();
+		{
+			const auto lock = std::lock_guard(m_valuesMtx);
+			for (size_t i = 0; i < m_items.size(); ++i)
+				j[std::format("Item{}", i)] = m_items[i].Value;
+		}
+		Utils::SaveJsonToFile(m_path, j);
+
+		const auto lock = std::lock_guard(m_writesMtx);
+		m_writes.emplace_back(Utils::DebouncedTask::Clock::now());
+	}
+
+	std::vector<Utils::DebouncedTask::Clock::time_point> Writes() {
+		const auto lock = std::lock_guard(m_writesMtx);
+		return m_writes;
+	}
+
+	bool FileMatches(int valueBase) const {
+		const auto j = Utils::ParseJsonFromFile(m_path);
+		for (size_t i = 0; i < m_items.size(); ++i) {
+			if (j.at(std::format("Item{}", i)).get<int>() != valueBase + static_cast<int>(i))
+				return false;
+		}
+		return true;
+	}
+};
+
+static double Milliseconds(Utils::DebouncedTask::Clock::duration d) {
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto directory = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path() / "Test_DebouncedTask";
+	constexpr size_t ItemCount = 100;
+
+	try {
+		auto success = true;
+		create_directories(directory);
+		const auto path = directory / "config.json";
+
+		for (const auto deferred : { false, true }) {
+			Repository repository(path, ItemCount, deferred);
+			const auto start = Utils::DebouncedTask::Clock::now();
+			for (size_t i = 0; i < ItemCount; ++i)
+				repository.Set(i, 1000 + static_cast<int>(i));
+			const auto burstTime = Utils::DebouncedTask::Clock::now() - start;
+			const auto writesDuringBurst = repository.Writes().size();
+
+			std::this_thread::sleep_for(Delay * 3);
+			const auto writes = repository.Writes();
+			std::cout << std::format("{:<10}: {} changes took {:.3f}ms; {} writes during the burst, {} writes in total\n",
+				deferred ? "deferred" : "immediate", ItemCount, Milliseconds(burstTime), writesDuringBurst, writes.size());
+			if (writes.size() != (deferred ? 1 : ItemCount)) {
+				std::cout << std::format("FAIL: {} writes, expected {}\n", writes.size(), deferred ? 1 : ItemCount);
+				success = false;
+			}
+			if (deferred && writes.size() == 1 && writes[0] - start < Delay) {
+				std::cout << "FAIL: written before the burst settled down\n";
+				success = false;
+			}
+			if (!repository.FileMatches(1000)) {
+				std::cout << "FAIL: file does not hold the last values\n";
+				success = false;
+			}
+		}
+
+		// Changes that never settle down still get written every MaxDelay.
+		{
+			Repository repository(path, ItemCount, true);
+			const auto start = Utils::DebouncedTask::Clock::now();
+			for (auto now = start; now - start < MaxDelay * 4; now = Utils::DebouncedTask::Clock::now()) {
+				repository.Set(0, static_cast<int>((now - start).count()));
+				std::this_thread::sleep_for(Delay / 5);
+			}
+			const auto end = Utils::DebouncedTask::Clock::now();
+
+			auto last = start;
+			auto longestGap = Utils::DebouncedTask::Clock::duration();
+			for (const auto& write : repository.Writes()) {
+				longestGap = std::max(longestGap, write - last);
+				last = write;
+			}
+			longestGap = std::max(longestGap, end - last);
+			std::cout << std::format("continuous: {} writes in {:.0f}ms, at most {:.0f}ms apart\n",
+				repository.Writes().size(), Milliseconds(end - start), Milliseconds(longestGap));
+			// Leave room for the scheduler of a busy machine.
+			if (longestGap > MaxDelay + Delay) {
+				std::cout << std::format("FAIL: {:.0f}ms without a write, expected at most {:.0f}ms\n", Milliseconds(longestGap), Milliseconds(MaxDelay));
+				success = false;
+			}
+		}
+
+		// Pending changes are written when flushed, and dropped when cancelled.
+		{
+			Repository repository(path, ItemCount, true);
+			for (size_t i = 0; i < ItemCount; ++i)
+				repository.Set(i, 2000 + static_cast<int>(i));
+			repository.DeferredSave->Flush();
+			if (repository.Writes().size() != 1 || repository.DeferredSave->Pending() || !repository.FileMatches(2000)) {
+				std::cout << std::format("FAIL: flushing wrote {} times\n", repository.Writes().size());
+				success = false;
+			}
+
+			repository.Set(0, 0);
+			repository.DeferredSave->Cancel();
+			std::this_thread::sleep_for(Delay * 3);
+			if (repository.Writes().size() != 1 || !repository.FileMatches(2000)) {
+				std::cout << "FAIL: written after cancelling\n";
+				success = false;
+			}
+		}
+
+		// Destroying the repository flushes what is pending.
+		{
+			{
+				Repository repository(path, ItemCount, true);
+				for (size_t i = 0; i < ItemCount; ++i)
+					repository.Set(i, 3000 + static_cast<int>(i));
+			}
+			if (!Repository(path, ItemCount, true).FileMatches(3000)) {
+				std::cout << "FAIL: pending changes lost on destruction\n";
+				success = false;
+			}
+		}
+
+		std::filesystem::remove_all(directory);
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
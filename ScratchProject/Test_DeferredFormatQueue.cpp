@@ -0,0 +1,259 @@
+#include "pch.h"
+
+#include <barrier>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <XivAlexanderCommon/Utils/DeferredFormatQueue.h>
+
+// Checks that Utils::DeferredFormatQueue gives the same text as formatting on the spot, for the kinds of arguments
+// Logger gets, and then has several threads log an AllIpcMessageLogger-style message at once: how Logger used to do it,
+// formatting and then pushing into a deque under a mutex, and through the queue, with a consumer thread formatting.
+// Reports time taken and heap allocations made on the logging threads per message.
+// Usage: ScratchProject [messages per thread in thousands] [thread count]
+
+static thread_local size_t s_allocationCount = 0;
+
+void* operator new(size_t size) {
+	++s_allocationCount;
+	if (const auto p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+struct Header {
+	int Category;
+	int Level;
+	int64_t Id;
+};
+
+static constexpr auto IpcFormat = "source={:08x} current={:08x} subtype={:04x} length={:x} (S2C{}{})";
+
+template<typename CharT, typename ... Args>
+static std::string FormatNow(const CharT* format, const Args&... args) {
+	if constexpr (std::is_same_v<CharT, wchar_t>)
+		return Utils::ToUtf8(std::vformat(format, std::make_wformat_args(args...)));
+	else
+		return std::vformat(format, std::make_format_args(args...));
+}
+
+static bool TestFormatting() {
+	auto success = true;
+	Utils::DeferredFormatQueue<Header> queue(64);
+	std::vector<std::string> expected;
+	std::vector<size_t> allocations;
+
+	const auto add = [&]<typename CharT, typename ... Args>(Utils::StaticFormatString<CharT> format, const Args&... args) {
+		expected.emplace_back(FormatNow(format.Get(), args...));
+		s_allocationCount = 0;
+		const auto queued = queue.Push(Header{ 1, 2, static_cast<int64_t>(expected.size() - 1) }, format, args...);
+		const auto allocationCount = s_allocationCount;
+		allocations.emplace_back(allocationCount);
+		if (!queued) {
+			std::cout << std::format("FAIL: message #{} not queued\n", expected.size() - 1);
+			success = false;
+		}
+	};
+
+	const std::string shortString = "ActorControl";
+	const std::string longString(200, 'x');
+	const std::wstring wideString = L"wide str";
+	const wchar_t* pszWide = L"wide ptr";
+	const std::filesystem::path path = L"C:\\Windows\\System32\\kernel32.dll";
+	const void* pointer = &queue;
+
+	add(Utils::StaticFormatString(IpcFormat), 0x1234U, 0x5678U, static_cast<uint16_t>(0x9a), 0x40U, ": Possibly ", shortString.c_str());
+	add(Utils::StaticFormatString("{} and {}"), shortString, std::string_view(shortString).substr(5));
+	add(Utils::StaticFormatString("{}: {}"), pszWide, wideString);
+	add(Utils::StaticFormatString(L"{}: {} ({})"), std::string("narrow"), wideString, 42);
+	add(Utils::StaticFormatString("{} in {}"), path, pszWide);
+	add(Utils::StaticFormatString(L"{} in {}"), path, pszWide);
+	add(Utils::StaticFormatString("{:.3f} {} {} {}"), 3.14159, true, 'c', pointer);
+
+	// Text only known at run time goes in as an argument, and is copied; the exception is gone before consuming.
+	try {
+		throw std::runtime_error("{0} is not a format string");
+	} catch (const std::exception& e) {
+		add(Utils::StaticFormatString("{}"), e.what());
+	}
+
+	add(Utils::StaticFormatString("{}"), longString);
+	add(Utils::StaticFormatString("{} {} {} {} {} {} {} {} {} {} {} {} {}"), 1LL, 2LL, 3LL, 4LL, 5LL, 6LL, 7LL, 8LL, 9LL, 10LL, 11LL, 12LL, 13LL);
+
+	const auto inlineCount = expected.size() - 2;
+	for (size_t i = 0; i < inlineCount; ++i) {
+		if (allocations[i]) {
+			std::cout << std::format("FAIL: message #{} allocated {} time(s) on the logging thread\n", i, allocations[i]);
+			success = false;
+		}
+	}
+
+	expected.reserve(expected.size() + 3);
+	expected.emplace_back("short message");
+	s_allocationCount = 0;
+	queue.PushMessage(Header{ 1, 2, static_cast<int64_t>(expected.size() - 1) }, std::string_view(expected.back()));
+	expected.emplace_back("wide message");
+	queue.PushMessage(Header{ 1, 2, static_cast<int64_t>(expected.size() - 1) }, std::wstring_view(L"wide message"));
+	if (const auto allocationCount = s_allocationCount) {
+		std::cout << std::format("FAIL: short messages allocated {} time(s) on the logging thread\n", allocationCount);
+		success = false;
+	}
+	expected.emplace_back(std::string(300, 'y'));
+	queue.PushMessage(Header{ 1, 2, static_cast<int64_t>(expected.size() - 1) }, std::string(expected.back()));
+
+	size_t consumed = 0;
+	queue.Consume([&](const Header& header, std::string message) {
+		if (header.Id != static_cast<int64_t>(consumed) || header.Category != 1 || header.Level != 2) {
+			std::cout << std::format("FAIL: message #{} came with header of #{}\n", consumed, header.Id);
+			success = false;
+		} else if (message != expected[consumed]) {
+			std::cout << std::format("FAIL: message #{} is \"{}\", expected \"{}\"\n", consumed, message, expected[consumed]);
+			success = false;
+		}
+		++consumed;
+	});
+	if (consumed != expected.size()) {
+		std::cout << std::format("FAIL: {} messages consumed, expected {}\n", consumed, expected.size());
+		success = false;
+	}
+
+	// Full queue drops, and discarding destroys what is left.
+	for (size_t i = 0; i < 70; ++i)
+		queue.Push(Header{}, "{}", longString);
+	if (const auto dropped = queue.TakeDroppedCount(); dropped != 6) {
+		std::cout << std::format("FAIL: {} messages dropped, expected 6\n", dropped);
+		success = false;
+	}
+	queue.Discard();
+	if (queue.HasPending()) {
+		std::cout << "FAIL: messages left after Discard\n";
+		success = false;
+	}
+
+	return success;
+}
+
+struct BenchmarkResult {
+	double NanosecondsPerMessage;
+	double AllocationsPerMessage;
+	size_t Consumed;
+};
+
+// Each thread logs batchSize messages at a time, and waits for the consumer to catch up before the next batch, so that
+// a bounded queue never fills up; only the time spent logging is counted.
+template<typename Produce, typename ConsumeAll>
+static BenchmarkResult RunBenchmark(size_t threadCount, size_t messageCount, size_t batchSize, const Produce& produce, const ConsumeAll& consumeAll) {
+	std::atomic_bool stop = false;
+	std::atomic_size_t consumed = 0;
+	std::thread consumer([&]() {
+		while (!stop)
+			consumed += consumeAll();
+		consumed += consumeAll();
+	});
+
+	std::barrier batchDone(static_cast<ptrdiff_t>(threadCount));
+	std::vector<std::thread> producers;
+	std::vector<double> nanoseconds(threadCount);
+	std::vector<size_t> allocations(threadCount);
+	for (size_t t = 0; t < threadCount; ++t) {
+		producers.emplace_back([&, t]() {
+			for (size_t batchStart = 0; batchStart < messageCount; batchStart += batchSize) {
+				const auto batchEnd = (std::min)(messageCount, batchStart + batchSize);
+				s_allocationCount = 0;
+				const auto start = std::chrono::steady_clock::now();
+				for (auto i = batchStart; i < batchEnd; ++i)
+					produce(static_cast<uint32_t>(t), static_cast<uint32_t>(i));
+				nanoseconds[t] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+				allocations[t] += s_allocationCount;
+
+				batchDone.arrive_and_wait();
+				while (consumed < batchEnd * threadCount)
+					std::this_thread::yield();
+			}
+		});
+	}
+	for (auto& t : producers)
+		t.join();
+	stop = true;
+	consumer.join();
+
+	return {
+		std::accumulate(nanoseconds.begin(), nanoseconds.end(), 0.) / static_cast<double>(threadCount * messageCount),
+		static_cast<double>(std::accumulate(allocations.begin(), allocations.end(), size_t())) / static_cast<double>(threadCount * messageCount),
+		consumed,
+	};
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto messageCount = (argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 200U) * 1000;
+	const auto threadCount = argc > 2 ? static_cast<size_t>(std::wcstoul(argv[2], nullptr, 10)) : 4U;
+
+	try {
+		auto success = TestFormatting();
+
+		static constexpr size_t QueueCapacity = 8192;
+		const auto batchSize = (std::max<size_t>)(1, QueueCapacity / threadCount);
+		static const char* const PossibleTypes[]{ "ActorControlSelf, ActorCast", "ActorControl", nullptr };
+
+		std::mutex mtx;
+		std::deque<std::pair<Header, std::string>> items;
+		const auto formatThenLock = RunBenchmark(threadCount, messageCount, batchSize, [&](uint32_t t, uint32_t i) {
+			const auto pszType = PossibleTypes[i % 3];
+			auto message = FormatNow(IpcFormat, t, i, static_cast<uint16_t>(i), i & 0xFFF, pszType ? ": Possibly " : "", pszType ? pszType : "");
+			const auto lock = std::lock_guard(mtx);
+			items.emplace_back(Header{ 0, 20, static_cast<int64_t>(i) }, std::move(message));
+		}, [&]() {
+			std::deque<std::pair<Header, std::string>> taken;
+			{
+				const auto lock = std::lock_guard(mtx);
+				taken.swap(items);
+			}
+			if (taken.empty())
+				std::this_thread::yield();
+			return taken.size();
+		});
+
+		Utils::DeferredFormatQueue<Header> queue(QueueCapacity);
+		const auto deferred = RunBenchmark(threadCount, messageCount, batchSize, [&](uint32_t t, uint32_t i) {
+			const auto pszType = PossibleTypes[i % 3];
+			queue.Push(Header{ 0, 20, static_cast<int64_t>(i) }, IpcFormat, t, i, static_cast<uint16_t>(i), i & 0xFFF, pszType ? ": Possibly " : "", pszType ? pszType : "");
+		}, [&]() {
+			size_t count = 0;
+			queue.Consume([&](const Header&, std::string) { ++count; });
+			if (!count)
+				std::this_thread::yield();
+			return count;
+		});
+		const auto dropped = queue.TakeDroppedCount();
+
+		std::cout << std::format("{} threads, {} messages each; record size {} bytes\n", threadCount, messageCount, Utils::DeferredFormatQueue<Header>::RecordSize);
+		std::cout << std::format("format, then deque: {:>8.1f}ns/message, {:.2f} allocations/message, {} consumed\n",
+			formatThenLock.NanosecondsPerMessage, formatThenLock.AllocationsPerMessage, formatThenLock.Consumed);
+		std::cout << std::format("deferred format   : {:>8.1f}ns/message, {:.2f} allocations/message, {} consumed, {} dropped\n",
+			deferred.NanosecondsPerMessage, deferred.AllocationsPerMessage, deferred.Consumed, dropped);
+
+		if (deferred.AllocationsPerMessage != 0) {
+			std::cout << "FAIL: deferred format allocated on the logging threads\n";
+			success = false;
+		}
+		if (deferred.Consumed + dropped != threadCount * messageCount) {
+			std::cout << "FAIL: messages went missing\n";
+			success = false;
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
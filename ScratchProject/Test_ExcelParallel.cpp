@@ -0,0 +1,158 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Excel.h>
+#include <XivAlexanderCommon/Sqex/Excel/Generator.h>
+#include <XivAlexanderCommon/Sqex/Excel/Reader.h>
+
+// Compiles one large synthetic sheet, and reads it back, with 1 to N threads.
+// Checks that the output does not depend on the number of threads, and prints how long each took.
+// Usage: ScratchProject [row count] [rows per page]
+
+static const Sqex::Language Languages[]{
+	Sqex::Language::Japanese,
+	Sqex::Language::English,
+	Sqex::Language::German,
+	Sqex::Language::French,
+};
+
+template<typename T>
+static T Measure(const std::string& name, const std::function<T()>& fn) {
+	const auto start = std::chrono::steady_clock::now();
+	auto res = fn();
+	std::cout << std::format("{:>24}: {:.3f}ms\n", name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return res;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto rowCount = argc > 1 ? static_cast<uint32_t>(std::wcstoul(argv[1], nullptr, 10)) : 200000U;
+	const auto rowsPerPage = argc > 2 ? static_cast<size_t>(std::wcstoul(argv[2], nullptr, 10)) : 2000U;
+
+	try {
+		std::vector<Sqex::Excel::Exh::Column> columns;
+		for (const auto& [type, offset] : std::initializer_list<std::pair<Sqex::Excel::Exh::ColumnDataType, uint16_t>>{
+			{Sqex::Excel::Exh::String, 0},
+			{Sqex::Excel::Exh::String, 4},
+			{Sqex::Excel::Exh::UInt32, 8},
+			{Sqex::Excel::Exh::Int16, 12},
+			{Sqex::Excel::Exh::PackedBool2, 14},
+			{Sqex::Excel::Exh::String, 16},
+		}) {
+			Sqex::Excel::Exh::Column column;
+			column.Type = type;
+			column.Offset = offset;
+			columns.emplace_back(column);
+		}
+
+		Sqex::Excel::Depth2ExhExdCreator creator("Synthetic", columns, {});
+		for (const auto language : Languages) {
+			creator.AddLanguage(language);
+			for (uint32_t id = 0; id < rowCount; ++id) {
+				std::vector<Sqex::Excel::ExdColumn> row;
+				for (size_t i = 0; i < columns.size(); ++i) {
+					auto& column = row.emplace_back(Sqex::Excel::ExdColumn{ .Type = columns[i].Type });
+					if (column.Type == Sqex::Excel::Exh::String)
+						column.String = Sqex::SeString(std::format("{}:{}:{} {}", static_cast<int>(language), id, i, std::string(id % 48, 'a' + static_cast<char>(i))));
+					else if (column.Type == Sqex::Excel::Exh::PackedBool2)
+						column.boolean = id % 3 == 0;
+					else
+						column.uint64 = 1ULL * id * (i + 1);
+				}
+				creator.SetRow(id, language, std::move(row));
+			}
+		}
+
+		const auto maxThreads = std::max(1U, std::thread::hardware_concurrency());
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t n = 1; n < maxThreads; n *= 2)
+			threadCounts.emplace_back(n);
+		threadCounts.emplace_back(maxThreads);
+
+		auto success = true;
+		std::map<Sqex::Sqpack::EntryPathSpec, std::vector<char>, Sqex::Sqpack::EntryPathSpec::FullPathComparator> reference;
+		for (const auto threadCount : threadCounts) {
+			creator.MaxThreadCount = threadCount;
+			auto compiled = Measure<decltype(reference)>(std::format("Compile, {} thread(s)", threadCount), [&]() { return creator.Compile(rowsPerPage); });
+			if (reference.empty())
+				reference = std::move(compiled);
+			else if (compiled != reference) {
+				std::cout << "FAIL: compiled files differ\n";
+				success = false;
+			}
+		}
+
+		std::map<Sqex::Sqpack::EntryPathSpec, std::shared_ptr<const Sqex::RandomAccessStream>, Sqex::Sqpack::EntryPathSpec::FullPathComparator> streams;
+		for (const auto& [pathSpec, data] : reference)
+			streams.emplace(pathSpec, std::make_shared<Sqex::MemoryRandomAccessStream>(std::vector<uint8_t>(data.begin(), data.end())));
+		const auto exh = Sqex::Excel::ExhReader("Synthetic", *streams.at(Sqex::Sqpack::EntryPathSpec("exd/Synthetic.exh")));
+
+		const auto getStream = [&streams](const Sqex::Sqpack::EntryPathSpec& pathSpec) -> std::shared_ptr<const Sqex::RandomAccessStream> {
+			return streams.at(pathSpec);
+		};
+
+		std::vector<Sqex::Excel::ExdPageRows> referencePages;
+		for (const auto threadCount : threadCounts) {
+			auto pages = Measure<std::vector<Sqex::Excel::ExdPageRows>>(std::format("Read, {} thread(s)", threadCount), [&]() {
+				std::vector<Sqex::Excel::ExdPageRows> res;
+				Sqex::Excel::ReadDepth2Pages(exh, getStream, threadCount, [&res](Sqex::Excel::ExdPageRows& page) {
+					res.emplace_back(std::move(page));
+					return true;
+				});
+				return res;
+			});
+
+			size_t readRowCount = 0;
+			for (const auto& page : pages) {
+				if (page.Error) {
+					std::cout << "FAIL: error reading a page\n";
+					success = false;
+				}
+				readRowCount += page.Rows.size();
+			}
+			if (readRowCount != 1ULL * rowCount * std::size(Languages)) {
+				std::cout << std::format("FAIL: read {} rows\n", readRowCount);
+				success = false;
+			}
+
+			if (referencePages.empty()) {
+				referencePages = std::move(pages);
+				continue;
+			}
+			for (size_t i = 0; i < pages.size(); ++i) {
+				if (pages[i].Language != referencePages[i].Language
+					|| pages[i].Page.StartId != referencePages[i].Page.StartId
+					|| pages[i].Rows.size() != referencePages[i].Rows.size()) {
+					std::cout << "FAIL: page order differs\n";
+					success = false;
+					break;
+				}
+			}
+		}
+
+		for (const auto threadCount : threadCounts) {
+			size_t handedOver = 0;
+			Sqex::Excel::ReadDepth2Pages(exh, getStream, threadCount, [&handedOver](Sqex::Excel::ExdPageRows&) {
+				return ++handedOver < 2;
+			});
+			if (handedOver != 2) {
+				std::cout << std::format("FAIL: {} thread(s): {} pages handed over after asking to stop at 2\n", threadCount, handedOver);
+				success = false;
+			}
+
+			try {
+				Sqex::Excel::ReadDepth2Pages(exh, getStream, threadCount, [](Sqex::Excel::ExdPageRows&) -> bool {
+					throw std::runtime_error("test");
+				});
+				std::cout << std::format("FAIL: {} thread(s): exception from the callback was not rethrown\n", threadCount);
+				success = false;
+			} catch (const std::runtime_error&) {
+				// pass
+			}
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,125 @@
+#include "pch.h"
+
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Excel.h>
+#include <XivAlexanderCommon/Sqex/Excel/Generator.h>
+#include <XivAlexanderCommon/Sqex/Excel/Reader.h>
+#include <XivAlexanderCommon/Utils/PrefilteredRegex.h>
+
+// Checks that Utils::PrefilteredRegex gives the same result as srell::regex_search for every string cell of a synthetic sheet,
+// and every sheet name, for patterns of the kind found in excel transformation rules; then compares how long each takes.
+// Usage: ScratchProject [row count]
+
+static const char* const Patterns[]{
+	"",
+	".*",
+	"^$",
+	"^item$",
+	"^(item|action)$",
+	"^quest/\\d+/",
+	"^cut_scene/",
+	"Transformation",
+	"<hex:02..0317>",
+	"\\bRESERVED\\b",
+	"^_rsv_",
+	"[ぁ-ん]",
+	"完了",
+	"Kiss of the Skies",
+	"(?:Crystal)+ Tower",
+	"a+b*c?d{2,3}",
+	"\\.\\.\\.$",
+	"dummy|test",
+};
+
+static const char* const Words[]{
+	"Item", "Action", "Transformation", "RESERVED", "_rsv_", "quest", "Crystal", "Tower", "Kiss", "skies", "SKIES", "KISS",
+	"\xE2\x84\xAAiss",  // U+212A KELVIN SIGN
+	"\xC5\xBFkies",  // U+017F LATIN SMALL LETTER LONG S
+	"完了", "ぁ", "aabcddd", "...", "<hex:02..0317>", "dummy", " ", "of", "the",
+};
+
+int wmain(int argc, wchar_t** argv) {
+	const auto rowCount = argc > 1 ? static_cast<uint32_t>(std::wcstoul(argv[1], nullptr, 10)) : 20000U;
+
+	try {
+		std::vector<Sqex::Excel::Exh::Column> columns;
+		for (uint16_t i = 0; i < 4; ++i) {
+			Sqex::Excel::Exh::Column column;
+			column.Type = Sqex::Excel::Exh::String;
+			column.Offset = i * 4;
+			columns.emplace_back(column);
+		}
+
+		std::mt19937 rng(0);
+		Sqex::Excel::Depth2ExhExdCreator creator("Synthetic", columns, {});
+		creator.AddLanguage(Sqex::Language::Unspecified);
+		for (uint32_t id = 0; id < rowCount; ++id) {
+			std::vector<Sqex::Excel::ExdColumn> row;
+			for (size_t i = 0; i < columns.size(); ++i) {
+				std::string s;
+				for (auto n = rng() % 6; n; --n)
+					s += Words[rng() % std::size(Words)];
+				row.emplace_back(Sqex::Excel::ExdColumn{ .Type = Sqex::Excel::Exh::String, .String = Sqex::SeString(std::move(s)) });
+			}
+			creator.SetRow(id, Sqex::Language::Unspecified, std::move(row));
+		}
+
+		std::shared_ptr<Sqex::MemoryRandomAccessStream> exhStream, exdStream;
+		for (auto& [pathSpec, data] : creator.Compile()) {
+			auto stream = std::make_shared<Sqex::MemoryRandomAccessStream>(std::vector<uint8_t>(data.begin(), data.end()));
+			(pathSpec.FullPath.extension() == ".exh" ? exhStream : exdStream) = std::move(stream);
+		}
+		const auto exh = Sqex::Excel::ExhReader("Synthetic", *exhStream);
+		const auto exd = Sqex::Excel::ExdReader(exh, exdStream);
+		const auto indices = std::vector<size_t>{ 0, 1, 2, 3 };
+		const auto projection = exd.ReadColumns(indices);
+
+		std::vector<std::string> cells;
+		for (size_t i = 0; i < indices.size(); ++i)
+			for (const auto& s : projection.EscapedStrings(i))
+				cells.emplace_back(s);
+		for (const auto* name : { "Item", "Action", "quest/000/ClsGla000_00001", "cut_scene/010/VoiceManCut", "CompleteJournal" })
+			cells.emplace_back(name);
+
+		auto success = true;
+		std::chrono::steady_clock::duration regexTime{}, prefilteredTime{};
+		for (const auto icase : { true, false }) {
+			for (const auto* pattern : Patterns) {
+				const auto prefiltered = Utils::PrefilteredRegex(pattern, icase);
+				const auto& regex = prefiltered.Regex();
+
+				std::vector<bool> expected, actual;
+				expected.reserve(cells.size());
+				actual.reserve(cells.size());
+
+				auto start = std::chrono::steady_clock::now();
+				for (const auto& cell : cells)
+					expected.push_back(srell::regex_search(cell, regex));
+				regexTime += std::chrono::steady_clock::now() - start;
+
+				start = std::chrono::steady_clock::now();
+				for (const auto& cell : cells)
+					actual.push_back(prefiltered.Search(cell));
+				prefilteredTime += std::chrono::steady_clock::now() - start;
+
+				const auto matches = std::ranges::count(expected, true);
+				std::cout << std::format("{:>24} icase={:d} literal=\"{}\": {} matches\n", pattern, icase, prefiltered.RequiredLiteral(), matches);
+				if (expected != actual) {
+					std::cout << "FAIL: results differ\n";
+					success = false;
+				}
+			}
+		}
+
+		std::cout << std::format("{} cells; regex_search {:.3f}ms, PrefilteredRegex::Search {:.3f}ms\n",
+			cells.size(),
+			std::chrono::duration<double, std::milli>(regexTime).count(),
+			std::chrono::duration<double, std::milli>(prefilteredTime).count());
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
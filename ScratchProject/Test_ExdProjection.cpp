@@ -0,0 +1,129 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/Excel.h>
+#include <XivAlexanderCommon/Sqex/Excel/Generator.h>
+#include <XivAlexanderCommon/Sqex/Excel/Reader.h>
+
+// Compares reading two columns of a synthetic sheet through ReadDepth2 against ReadColumns.
+// Usage: ScratchProject [row count]
+
+static std::vector<Sqex::Excel::Exh::Column> MakeColumns() {
+	using namespace Sqex::Excel;
+	std::vector<Exh::Column> columns;
+	for (const auto& [type, offset] : std::initializer_list<std::pair<Exh::ColumnDataType, uint16_t>>{
+		{Exh::String, 0},
+		{Exh::UInt32, 4},
+		{Exh::Int16, 8},
+		{Exh::UInt8, 10},
+		{Exh::PackedBool0, 11},
+		{Exh::PackedBool3, 11},
+		{Exh::Float32, 12},
+		{Exh::String, 16},
+		{Exh::Int64, 24},
+		{Exh::String, 32},
+	}) {
+		Exh::Column column;
+		column.Type = type;
+		column.Offset = offset;
+		columns.emplace_back(column);
+	}
+	return columns;
+}
+
+static std::vector<Sqex::Excel::ExdColumn> MakeRow(const std::vector<Sqex::Excel::Exh::Column>& columns, uint32_t id) {
+	using namespace Sqex::Excel;
+	std::vector<ExdColumn> row;
+	for (size_t i = 0; i < columns.size(); ++i) {
+		auto& column = row.emplace_back(ExdColumn{ .Type = columns[i].Type });
+		switch (column.Type) {
+			case Exh::String:
+				column.String = Sqex::SeString(std::format("Row {} column {} {}", id, i, std::string(id % 32, 'x')));
+				break;
+			case Exh::PackedBool0:
+			case Exh::PackedBool3:
+				column.boolean = (id + i) % 3 == 0;
+				break;
+			case Exh::Float32:
+				column.float32 = static_cast<float>(id) / 7.f;
+				break;
+			default:
+				column.uint64 = id * 2654435761ULL + i;
+				break;
+		}
+	}
+	return row;
+}
+
+template<typename T>
+static T Measure(const char* name, const std::function<T()>& fn) {
+	const auto start = std::chrono::steady_clock::now();
+	auto res = fn();
+	std::cout << std::format("{:>10}: {:.3f}ms\n", name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return res;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto rowCount = argc > 1 ? static_cast<uint32_t>(std::wcstoul(argv[1], nullptr, 10)) : 100000U;
+
+	try {
+		const auto columns = MakeColumns();
+		Sqex::Excel::Depth2ExhExdCreator creator("Synthetic", columns, {});
+		creator.AddLanguage(Sqex::Language::Unspecified);
+		for (uint32_t id = 0; id < rowCount; ++id)
+			creator.SetRow(id * 2, Sqex::Language::Unspecified, MakeRow(columns, id * 2));
+
+		std::shared_ptr<Sqex::MemoryRandomAccessStream> exhStream, exdStream;
+		for (auto& [pathSpec, data] : creator.Compile()) {
+			auto stream = std::make_shared<Sqex::MemoryRandomAccessStream>(std::vector<uint8_t>(data.begin(), data.end()));
+			(pathSpec.FullPath.extension() == ".exh" ? exhStream : exdStream) = std::move(stream);
+		}
+		const auto exh = Sqex::Excel::ExhReader("Synthetic", *exhStream);
+		const auto exd = Sqex::Excel::ExdReader(exh, exdStream);
+
+		using Summary = std::tuple<uint64_t, size_t, size_t>;
+		const auto full = Measure<Summary>("ReadDepth2", [&]() {
+			Summary res{};
+			for (const auto id : exd.GetIds()) {
+				const auto row = exd.ReadDepth2(id);
+				std::get<0>(res) += row[1].uint32;
+				std::get<1>(res) += row[7].String.Escaped().size();
+				std::get<2>(res) += row[5].boolean ? 1 : 0;
+			}
+			return res;
+		});
+
+		const auto projected = Measure<Summary>("ReadColumns", [&]() {
+			Summary res{};
+			const auto indices = std::vector<size_t>{ 1, 7, 5 };
+			const auto projection = exd.ReadColumns(indices);
+			for (const auto v : projection.Values<uint32_t>(0))
+				std::get<0>(res) += v;
+			for (const auto& s : projection.EscapedStrings(1))
+				std::get<1>(res) += s.size();
+			for (const auto b : projection.Values<bool>(2))
+				std::get<2>(res) += b ? 1 : 0;
+			return res;
+		});
+
+		auto success = full == projected;
+
+		const auto indices = std::vector<size_t>{ 0, 2, 6, 8 };
+		const auto projection = exd.ReadColumns(indices);
+		const auto ids = exd.GetIds();
+		success &= projection.RowCount() == ids.size();
+		for (size_t i = 0; success && i < ids.size(); ++i) {
+			const auto row = exd.ReadDepth2(ids[i]);
+			success &= projection.RowIds()[i] == ids[i]
+				&& projection.String(0, i).Escaped() == row[0].String.Escaped()
+				&& projection.Values<int16_t>(1)[i] == row[2].int16
+				&& projection.Values<float>(2)[i] == row[6].float32
+				&& projection.Values<int64_t>(3)[i] == row[8].int64;
+		}
+
+		std::cout << (success ? "PASS\n" : "FAIL: projected values differ from full row reads\n");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,166 @@
+#include "pch.h"
+
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/ZiPatch.h>
+
+// Checks Sqex::ZiPatch::FilePartMap against splicing a sorted vector on random overlapping writes, and checks that
+// FilePartIndex survives serialization; then replays chains of overlapping writes of increasing length with both.
+// Usage: ScratchProject [longest chain length]
+
+using Sqex::ZiPatch::FilePart;
+
+// How parts used to be merged, kept as reference.
+static void ReplaceFilePartInVector(std::vector<FilePart>& parts, const FilePart& part) {
+	if (part.TargetSize == 0)
+		return;
+
+	for (const auto splitOffset : { part.TargetOffset, part.TargetOffset + part.TargetSize }) {
+		const auto endOffset = parts.empty() ? 0 : parts.back().TargetOffset + parts.back().TargetSize;
+		if (splitOffset >= endOffset) {
+			if (splitOffset > endOffset)
+				parts.emplace_back(FilePart{ .TargetOffset = endOffset, .TargetSize = splitOffset - endOffset, .SourceIndex = FilePart::SourceIndex_Zeros });
+			continue;
+		}
+
+		auto i = std::upper_bound(parts.begin(), parts.end(), splitOffset, [](uint64_t l, const FilePart& r) { return l < r.TargetOffset; });
+		--i;
+		if (i->TargetOffset == splitOffset)
+			continue;
+
+		auto tail = *i;
+		tail.TargetOffset = splitOffset;
+		tail.TargetSize = i->TargetOffset + i->TargetSize - splitOffset;
+		tail.SplitFrom = static_cast<uint32_t>(i->SplitFrom + splitOffset - i->TargetOffset);
+		i->TargetSize = splitOffset - i->TargetOffset;
+		parts.insert(i + 1, tail);
+	}
+
+	const auto it1 = std::lower_bound(parts.begin(), parts.end(), part.TargetOffset);
+	const auto it2 = std::lower_bound(parts.begin(), parts.end(), part.TargetOffset + part.TargetSize);
+	*it1 = part;
+	parts.erase(it1 + 1, it2);
+}
+
+// Merges runs of zeros, and leaves only what decides the content of each part.
+template<typename R>
+static std::vector<std::tuple<uint64_t, uint64_t, uint32_t, uint32_t, uint32_t>> Normalize(R&& parts) {
+	std::vector<std::tuple<uint64_t, uint64_t, uint32_t, uint32_t, uint32_t>> result;
+	for (const FilePart& part : parts) {
+		if (part.SourceIndex == FilePart::SourceIndex_Zeros) {
+			if (!result.empty() && std::get<2>(result.back()) == FilePart::SourceIndex_Zeros) {
+				std::get<1>(result.back()) += part.TargetSize;
+				continue;
+			}
+			result.emplace_back(part.TargetOffset, part.TargetSize, part.SourceIndex, 0, 0);
+		} else
+			result.emplace_back(part.TargetOffset, part.TargetSize, part.SourceIndex, part.SourceOffset, part.SplitFrom);
+	}
+	return result;
+}
+
+static std::vector<FilePart> RandomWrites(std::mt19937_64& rng, size_t count, uint64_t fileSize) {
+	std::vector<FilePart> writes;
+	writes.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		const auto isZeros = rng() % 8 == 0;
+		writes.emplace_back(FilePart{
+			.TargetOffset = rng() % (fileSize / Sqex::EntryAlignment) * Sqex::EntryAlignment,
+			.TargetSize = (1 + rng() % 64) * Sqex::EntryAlignment,
+			.SourceIndex = isZeros ? FilePart::SourceIndex_Zeros : static_cast<uint32_t>(rng() % 100),
+			.SourceOffset = isZeros ? 0 : static_cast<uint32_t>(rng()),
+		});
+	}
+	return writes;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto longestChain = argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 40000U;
+
+	try {
+		std::mt19937_64 rng(0);
+		auto success = true;
+
+		for (size_t iteration = 0; success && iteration < 2000; ++iteration) {
+			const auto fileSize = (1 + rng() % 64) * Sqex::EntryAlignment;
+			std::vector<FilePart> vector;
+			Sqex::ZiPatch::FilePartMap map;
+			for (const auto& write : RandomWrites(rng, 1 + rng() % 32, fileSize)) {
+				ReplaceFilePartInVector(vector, write);
+				map.Replace(write);
+			}
+
+			if (Normalize(vector) != Normalize(map.Parts())) {
+				std::cout << std::format("FAIL: parts differ at iteration {}\n", iteration);
+				success = false;
+			}
+			if (map.Size() != vector.back().TargetOffset + vector.back().TargetSize) {
+				std::cout << std::format("FAIL: size differs at iteration {}\n", iteration);
+				success = false;
+			}
+			for (uint64_t offset = 0; offset <= map.Size(); offset += Sqex::EntryAlignment / 2) {
+				const auto found = map.Find(offset);
+				if (offset == map.Size() ? found != nullptr : !found || found->TargetOffset > offset || found->TargetOffset + found->TargetSize <= offset) {
+					std::cout << std::format("FAIL: Find({}) at iteration {}\n", offset, iteration);
+					success = false;
+					break;
+				}
+			}
+
+			Sqex::ZiPatch::FilePartIndex index;
+			index.SourceNames = { "a.patch", "b.patch" };
+			index.Files.emplace("x", map);
+			index.Files.emplace("y", Sqex::ZiPatch::FilePartMap());
+			const auto loaded = Sqex::ZiPatch::FilePartIndex::Deserialize(index.Serialize());
+			if (loaded.SourceNames != index.SourceNames
+				|| loaded.Files.size() != index.Files.size()
+				|| Normalize(loaded.Files.at("x").Parts()) != Normalize(map.Parts())
+				|| loaded.Files.at("x").Count() != map.Count()
+				|| loaded.Files.at("y").Count() != 0) {
+				std::cout << std::format("FAIL: serialization at iteration {}\n", iteration);
+				success = false;
+			}
+		}
+
+		for (auto chainLength = std::min<size_t>(2500, longestChain); chainLength <= longestChain; chainLength *= 2) {
+			const auto writes = RandomWrites(rng, chainLength, chainLength * 4096ULL);
+
+			auto start = std::chrono::steady_clock::now();
+			std::vector<FilePart> vector;
+			for (const auto& write : writes)
+				ReplaceFilePartInVector(vector, write);
+			const auto vectorTime = std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			Sqex::ZiPatch::FilePartMap map;
+			for (const auto& write : writes)
+				map.Replace(write);
+			const auto mapTime = std::chrono::steady_clock::now() - start;
+
+			if (Normalize(vector) != Normalize(map.Parts())) {
+				std::cout << std::format("FAIL: parts differ for chain of {}\n", chainLength);
+				success = false;
+			}
+
+			Sqex::ZiPatch::FilePartIndex index;
+			index.Files.emplace("sqpack/ffxiv/000000.win32.dat0", std::move(map));
+			const auto serialized = index.Serialize();
+			start = std::chrono::steady_clock::now();
+			const auto loaded = Sqex::ZiPatch::FilePartIndex::Deserialize(serialized);
+			const auto loadTime = std::chrono::steady_clock::now() - start;
+
+			std::cout << std::format("{:>6} writes, {:>6} parts: vector {:>9.3f}ms, FilePartMap {:>7.3f}ms; serialized {} bytes, loaded in {:.3f}ms\n",
+				chainLength, loaded.Files.begin()->second.Count(),
+				std::chrono::duration<double, std::milli>(vectorTime).count(),
+				std::chrono::duration<double, std::milli>(mapTime).count(),
+				serialized.size(),
+				std::chrono::duration<double, std::milli>(loadTime).count());
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
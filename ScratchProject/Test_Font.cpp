@@ -334,7 +334,7 @@ void compile() {
 		creator.Start();
 		while (!creator.Wait(100)) {
 			const auto progress = creator.GetProgress();
-			std::cout << progress.Indeterminate << " " << progress.Scale(100.) << "%     \r";
+			std::cout << std::format("{} {:.2f}% ({} pages, {:.1f}% filled)     \r", progress.Indeterminate, progress.Scale(100.), progress.Pages, progress.FillRatio() * 100.);
 		}
 		result = creator.GetResult();
 
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/FramePacer.h>
+
+// Checks Utils::FramePacer against a brute-force search for the drift, and then runs it against a simulated clock
+// with synthetic frame times, reporting frame start jitter, processor time spent waiting, and average frame rate.
+// Frames before the pacer has seen how late sleeping returns are left out of jitter; a frame is late if it begins more than
+// one spin step after its target.
+// Uses no Windows headers or precompiled header, so that it can be built along with FramePacer.cpp anywhere.
+// Usage: ScratchProject [frame count]
+
+class SimulatedClock : public Utils::FramePacer::Clock {
+	std::mt19937 m_rng{ 0 };
+
+public:
+	int64_t Now = 1000000000;
+	int64_t SpinStepUs = 1;
+	int64_t SleepGranularityUs = 1000;
+	int64_t SleepJitterUs = 200;
+	int64_t BusyUs = 0;
+
+	int64_t NowUs() override {
+		return Now;
+	}
+
+	void SleepUs(int64_t us) override {
+		Now = (Now + us + SleepGranularityUs - 1) / SleepGranularityUs * SleepGranularityUs;
+		Now += static_cast<int64_t>(m_rng() % (SleepJitterUs + 1));
+	}
+
+	void Spin(bool) override {
+		Now += SpinStepUs;
+		BusyUs += SpinStepUs;
+	}
+};
+
+static int64_t ContinueDriftBySearch(int64_t nowUs, int64_t previousIntervalUs, int64_t previousDriftUs, int64_t newIntervalUs) {
+	const auto lastFrameUs = Utils::FramePacer::NextGridPoint(nowUs, previousIntervalUs, previousDriftUs) - previousIntervalUs;
+	const auto wantUs = lastFrameUs + newIntervalUs;
+	auto minDiff = INT64_MAX;
+	int64_t minDriftUs = 0;
+	for (int64_t i = 0; i < newIntervalUs; ++i) {
+		const auto nextUs = Utils::FramePacer::NextGridPoint(nowUs, newIntervalUs, i);
+		if (nextUs < wantUs)
+			continue;
+		if (nextUs - wantUs < minDiff) {
+			minDiff = nextUs - wantUs;
+			minDriftUs = i;
+		}
+	}
+	if (minDiff == INT64_MAX) {
+		// Every candidate is early; take the earliest possible one.
+		for (int64_t i = 0; i < newIntervalUs; ++i) {
+			if (Utils::FramePacer::NextGridPoint(nowUs, newIntervalUs, i) == nowUs + 1)
+				return i;
+		}
+	}
+	return minDriftUs;
+}
+
+struct SimulationResult {
+	double Fps;
+	int64_t MaxJitterUs;
+	double LateFrameRatio;
+	double BusyUsPerFrame;
+};
+
+static constexpr size_t WarmUpFrameCount = 16;
+
+static SimulationResult Simulate(size_t frameCount, int64_t intervalUs, int64_t sleepGranularityUs, bool allowSleep, int64_t maxWorkUs) {
+	SimulatedClock clock;
+	clock.SleepGranularityUs = sleepGranularityUs;
+	Utils::FramePacer pacer(clock);
+	std::mt19937 rng(1);
+
+	int64_t firstFrameUs = 0, lastFrameUs = 0, maxJitterUs = 0;
+	size_t lateFrameCount = 0;
+	for (size_t i = 0; i < frameCount; ++i) {
+		const auto targetUs = pacer.NextFrameUs(clock.NowUs(), intervalUs, true);
+		const auto wokeUs = pacer.WaitUntil(targetUs, allowSleep, true);
+		if (i >= WarmUpFrameCount) {
+			maxJitterUs = std::max(maxJitterUs, wokeUs - targetUs);
+			lateFrameCount += wokeUs - targetUs > clock.SpinStepUs ? 1 : 0;
+		}
+		if (!i)
+			firstFrameUs = wokeUs;
+		lastFrameUs = wokeUs;
+
+		clock.Now += static_cast<int64_t>(rng() % static_cast<uint32_t>(maxWorkUs + 1));
+	}
+
+	return {
+		.Fps = 1000000. * static_cast<double>(frameCount - 1) / static_cast<double>(lastFrameUs - firstFrameUs),
+		.MaxJitterUs = maxJitterUs,
+		.LateFrameRatio = static_cast<double>(lateFrameCount) / static_cast<double>(frameCount - WarmUpFrameCount),
+		.BusyUsPerFrame = static_cast<double>(clock.BusyUs) / static_cast<double>(frameCount),
+	};
+}
+
+int main(int argc, char** argv) {
+	const auto frameCount = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 10000U;
+
+	try {
+		auto success = true;
+
+		std::mt19937 rng(0);
+		for (size_t i = 0; i < 2000; ++i) {
+			const auto nowUs = 1000000000LL + rng() % 1000000;
+			const auto previousIntervalUs = 1 + static_cast<int64_t>(rng() % 2000);
+			const auto previousDriftUs = static_cast<int64_t>(rng() % previousIntervalUs);
+			const auto newIntervalUs = 1 + static_cast<int64_t>(rng() % 2000);
+			const auto expected = ContinueDriftBySearch(nowUs, previousIntervalUs, previousDriftUs, newIntervalUs);
+			const auto actual = Utils::FramePacer::ContinueDrift(nowUs, previousIntervalUs, previousDriftUs, newIntervalUs);
+			if (expected != actual) {
+				std::cout << "FAIL: ContinueDrift(" << nowUs << ", " << previousIntervalUs << ", " << previousDriftUs << ", " << newIntervalUs << ") = "
+					<< actual << ", expected " << expected << "\n";
+				success = false;
+				break;
+			}
+		}
+
+		for (const auto intervalUs : { 6944LL, 16667LL, 33333LL }) {
+			for (const auto sleepGranularityUs : { 1000LL, 15625LL }) {
+				for (const auto allowSleep : { false, true }) {
+					const auto result = Simulate(frameCount, intervalUs, sleepGranularityUs, allowSleep, intervalUs * 3 / 4);
+					std::cout << "interval=" << std::setw(5) << intervalUs << "us granularity=" << std::setw(5) << sleepGranularityUs << "us sleep=" << allowSleep << ": "
+						<< std::fixed << std::setprecision(3) << result.Fps << "fps (target " << 1000000. / intervalUs << "), max jitter " << result.MaxJitterUs << "us, "
+						<< std::setprecision(2) << result.LateFrameRatio * 100 << "% late, " << std::setprecision(1) << result.BusyUsPerFrame << "us busy per frame\n";
+
+					if (std::abs(result.Fps * intervalUs / 1000000. - 1) > 0.001) {
+						std::cout << "FAIL: frame rate is off\n";
+						success = false;
+					}
+					if (result.LateFrameRatio > 0.01) {
+						std::cout << "FAIL: too many frames began late\n";
+						success = false;
+					}
+					if (allowSleep && sleepGranularityUs == 1000 && result.BusyUsPerFrame > 2000 + 2 * 1000 + 200) {
+						std::cout << "FAIL: spent too long spinning\n";
+						success = false;
+					}
+				}
+			}
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
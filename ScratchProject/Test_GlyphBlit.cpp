@@ -0,0 +1,323 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/FontCsv/BaseDrawableFont.h>
+
+// Compares RgbBitmapCopy against the original per-pixel implementation over random glyphs, colors, opacities, and gamma values,
+// covering every blending branch for RGBA8888 and L8 destinations, and reports glyphs per second of both.
+// Usage: ScratchProject
+
+using Sqex::FontCsv::GlyphMeasurement;
+namespace Texture = Sqex::Texture;
+
+// Original implementation, calling std::pow for every pixel; kept as the golden reference.
+template<
+	typename SrcPixFmt,
+	uint32_t ResolverFunction(const SrcPixFmt&),
+	typename DestPixFmt,
+	typename OpacityType,
+	int VerticalDirection = 1
+> class ReferenceBitmapCopy {
+	static_assert(VerticalDirection == 1 || VerticalDirection == -1);
+
+	static constexpr auto Scaler = 0xFFUL;
+	static constexpr auto MaxOpacity = std::numeric_limits<OpacityType>::max();
+
+	static inline void DrawLineToRgb(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto blendedBgColor = DestPixFmt{
+				(bgColor.R * bgColor.A + destPtr->R * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+				(bgColor.G * bgColor.A + destPtr->G * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+				(bgColor.B * bgColor.A + destPtr->B * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+				DestPixFmt::MaxA - ((DestPixFmt::MaxA - bgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+			};
+			const auto blendedFgColor = DestPixFmt{
+				(fgColor.R * fgColor.A + destPtr->R * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+				(fgColor.G * fgColor.A + destPtr->G * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+				(fgColor.B * fgColor.A + destPtr->B * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+				DestPixFmt::MaxA - ((DestPixFmt::MaxA - fgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+			};
+			const auto currentColor = DestPixFmt{
+				(blendedBgColor.R * (Scaler - opacityScaled) + blendedFgColor.R * opacityScaled) / Scaler,
+				(blendedBgColor.G * (Scaler - opacityScaled) + blendedFgColor.G * opacityScaled) / Scaler,
+				(blendedBgColor.B * (Scaler - opacityScaled) + blendedFgColor.B * opacityScaled) / Scaler,
+				(blendedBgColor.A * (Scaler - opacityScaled) + blendedFgColor.A * opacityScaled) / Scaler,
+			};
+			const auto blendedDestColor = DestPixFmt{
+				(destPtr->R * destPtr->A + currentColor.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+				(destPtr->G * destPtr->A + currentColor.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+				(destPtr->B * destPtr->A + currentColor.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+				DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - currentColor.A)) / DestPixFmt::MaxA,
+			};
+			destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - currentColor.A) + currentColor.R * currentColor.A) / DestPixFmt::MaxR;
+			destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - currentColor.A) + currentColor.G * currentColor.A) / DestPixFmt::MaxG;
+			destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - currentColor.A) + currentColor.B * currentColor.A) / DestPixFmt::MaxB;
+			destPtr->A = blendedDestColor.A;
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	static inline void DrawLineToRgbOpaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			destPtr->R = (bgColor.R * (Scaler - opacityScaled) + fgColor.R * opacityScaled) / Scaler;
+			destPtr->G = (bgColor.G * (Scaler - opacityScaled) + fgColor.G * opacityScaled) / Scaler;
+			destPtr->B = (bgColor.B * (Scaler - opacityScaled) + fgColor.B * opacityScaled) / Scaler;
+			destPtr->A = DestPixFmt::MaxA;
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	template<bool ColorIsForeground>
+	static inline void DrawLineToRgbBinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto opacity = DestPixFmt::MaxA * (ColorIsForeground ? opacityScaled : Scaler - opacityScaled) / Scaler;
+			if (opacity) {
+				const auto blendedDestColor = DestPixFmt{
+					(destPtr->R * destPtr->A + color.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					(destPtr->G * destPtr->A + color.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					(destPtr->B * destPtr->A + color.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - opacity)) / DestPixFmt::MaxA,
+				};
+				destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - opacity) + color.R * opacity) / DestPixFmt::MaxR;
+				destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - opacity) + color.G * opacity) / DestPixFmt::MaxG;
+				destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - opacity) + color.B * opacity) / DestPixFmt::MaxB;
+				destPtr->A = blendedDestColor.A;
+			}
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	static inline void DrawLineToL8(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
+		constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto blendedBgColor = (1 * bgColor * bgOpacity + 1 * *destPtr * (MaxOpacity - bgOpacity)) / MaxOpacity;
+			const auto blendedFgColor = (1 * fgColor * fgOpacity + 1 * *destPtr * (MaxOpacity - fgOpacity)) / MaxOpacity;
+			*destPtr = static_cast<DestPixFmt>((blendedBgColor * (Scaler - opacityScaled) + blendedFgColor * opacityScaled) / Scaler);
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	static inline void DrawLineToL8Opaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, double gamma) {
+		constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			*destPtr = static_cast<DestPixFmt>(MaxOpacity * opacityScaled / Scaler);
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+	template<bool ColorIsForeground>
+	static inline void DrawLineToL8BinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
+		constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+		while (regionWidth--) {
+			const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
+			const auto opacityScaled2 = ColorIsForeground ? opacityScaled : Scaler - opacityScaled;
+			*destPtr = static_cast<DestPixFmt>((*destPtr * (Scaler - opacityScaled2) + 1 * color * opacityScaled2) / Scaler);
+			++destPtr;
+			++srcPtr;
+		}
+	}
+
+public:
+	static inline void CopyTo(const GlyphMeasurement& src, const GlyphMeasurement& dest, const SrcPixFmt* srcBuf, DestPixFmt* destBuf, SSIZE_T srcWidth, SSIZE_T srcHeight, SSIZE_T destWidth, DestPixFmt fgColor, DestPixFmt bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
+		auto destPtrBegin = &destBuf[static_cast<size_t>(1) * dest.top * destWidth + dest.left];
+		auto srcPtrBegin = &srcBuf[static_cast<size_t>(1) * (VerticalDirection == 1 ? src.top : srcHeight - src.top - 1) * srcWidth + src.left];
+		const auto srcPtrDelta = srcWidth * VerticalDirection;
+		const auto regionWidth = src.right - src.left;
+		const auto regionHeight = src.bottom - src.top;
+
+		gamma = 1.0 / gamma;
+
+		if constexpr (std::is_integral_v<DestPixFmt>) {
+			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
+
+			if (fgOpacity == MaxOpacity && bgOpacity == MaxOpacity && fgColor == DestPixFmtMax && bgColor == 0) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8Opaque(destPtrBegin, srcPtrBegin, regionWidth, gamma);
+			} else if (fgOpacity == MaxOpacity && bgOpacity == 0) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8BinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+			} else if (fgOpacity == 0 && bgOpacity == MaxOpacity) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8BinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+			} else {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToL8(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+			}
+		} else {
+			fgColor.A = fgColor.A * fgOpacity / std::numeric_limits<OpacityType>::max();
+			bgColor.A = bgColor.A * bgOpacity / std::numeric_limits<OpacityType>::max();
+			if (fgColor.A == DestPixFmt::MaxA && bgColor.A == DestPixFmt::MaxA) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgbOpaque(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+			} else if (fgColor.A == DestPixFmt::MaxA && bgColor.A == 0) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgbBinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+			} else if (fgColor.A == 0 && bgColor.A == DestPixFmt::MaxA) {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgbBinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+			} else {
+				for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
+					DrawLineToRgb(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+			}
+		}
+	}
+
+};
+
+static uint32_t ResolveByte(const uint8_t& v) {
+	return v;
+}
+
+static uint32_t ResolveFourLevels(const uint8_t& v) {
+	return (v & 3) * 255 / 3;
+}
+
+static uint32_t ResolveRed(const Texture::RGBA8888& v) {
+	return v.R;
+}
+
+static std::mt19937 s_rng(1);
+
+template<typename DestPixFmt>
+static DestPixFmt RandomColor() {
+	if constexpr (std::is_same_v<DestPixFmt, uint8_t>)
+		return static_cast<uint8_t>(s_rng());
+	else
+		return DestPixFmt(static_cast<uint32_t>(s_rng()));
+}
+
+template<typename SrcPixFmt, uint32_t ResolverFunction(const SrcPixFmt&), typename DestPixFmt, int VerticalDirection>
+static size_t CompareRandom(size_t iterations) {
+	size_t mismatches = 0;
+	for (size_t iteration = 0; iteration < iterations; ++iteration) {
+		const SSIZE_T srcWidth = 1 + s_rng() % 70, srcHeight = 1 + s_rng() % 20;
+		const SSIZE_T destWidth = srcWidth + s_rng() % 8;
+
+		std::vector<SrcPixFmt> src(static_cast<size_t>(srcWidth) * srcHeight);
+		for (auto& s : src) {
+			if constexpr (std::is_same_v<SrcPixFmt, uint8_t>)
+				s = static_cast<uint8_t>(s_rng() % 4 ? (s_rng() % 2 ? 0 : 255) : s_rng());
+			else
+				s = SrcPixFmt(static_cast<uint32_t>(s_rng()));
+		}
+
+		std::vector<DestPixFmt> expected(static_cast<size_t>(destWidth) * srcHeight);
+		for (auto& d : expected) {
+			d = RandomColor<DestPixFmt>();
+			if constexpr (!std::is_same_v<DestPixFmt, uint8_t>) {
+				if (s_rng() % 3 == 0)
+					d.A = s_rng() % 2 ? 0 : 255;
+			}
+		}
+		auto actual = expected;
+
+		const GlyphMeasurement srcRect{ false, static_cast<SSIZE_T>(s_rng() % srcWidth), static_cast<SSIZE_T>(s_rng() % srcHeight), srcWidth, srcHeight };
+		const GlyphMeasurement destRect{ false, 0, 0, srcRect.right - srcRect.left, srcRect.bottom - srcRect.top };
+
+		auto fgColor = RandomColor<DestPixFmt>(), bgColor = RandomColor<DestPixFmt>();
+		auto fgOpacity = static_cast<uint8_t>(s_rng()), bgOpacity = static_cast<uint8_t>(s_rng());
+		switch (s_rng() % 4) {
+			case 0:
+				fgOpacity = bgOpacity = 255;
+				if constexpr (std::is_same_v<DestPixFmt, uint8_t>)
+					fgColor = 255, bgColor = 0;
+				else
+					fgColor.A = bgColor.A = 255;
+				break;
+			case 1:
+				fgOpacity = 255;
+				bgOpacity = 0;
+				if constexpr (!std::is_same_v<DestPixFmt, uint8_t>)
+					fgColor.A = 255;
+				break;
+			case 2:
+				fgOpacity = 0;
+				bgOpacity = 255;
+				if constexpr (!std::is_same_v<DestPixFmt, uint8_t>)
+					bgColor.A = 255;
+				break;
+		}
+		static constexpr double Gammas[]{ 1.0, 1.4, 0.7, 2.2, 0.5 };
+		const auto gamma = Gammas[s_rng() % std::size(Gammas)];
+
+		ReferenceBitmapCopy<SrcPixFmt, ResolverFunction, DestPixFmt, uint8_t, VerticalDirection>::CopyTo(srcRect, destRect, &src[0], &expected[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+		Sqex::FontCsv::RgbBitmapCopy<SrcPixFmt, ResolverFunction, DestPixFmt, uint8_t, VerticalDirection>::CopyTo(srcRect, destRect, &src[0], &actual[0], srcWidth, srcHeight, destWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+		if (memcmp(&expected[0], &actual[0], expected.size() * sizeof expected[0]) != 0)
+			mismatches++;
+	}
+	return mismatches;
+}
+
+template<typename DestPixFmt, template<typename, uint32_t(const uint8_t&), typename, typename, int> class Copier>
+static double MeasureGlyphsPerSecond(int blendMode) {
+	static constexpr SSIZE_T GlyphSize = 24, DestWidth = 1024;
+	static constexpr size_t GlyphCount = 100000;
+
+	std::vector<uint8_t> src(GlyphSize * GlyphSize);
+	for (auto& s : src)
+		s = static_cast<uint8_t>(s_rng());
+	std::vector<DestPixFmt> dest(DestWidth * GlyphSize);
+
+	DestPixFmt fgColor, bgColor;
+	uint8_t fgOpacity = 255, bgOpacity = 255;
+	if constexpr (std::is_same_v<DestPixFmt, uint8_t>) {
+		fgColor = 255;
+		bgColor = 0;
+		if (blendMode == 1)
+			bgOpacity = 0;
+		else if (blendMode == 2)
+			fgOpacity = 200, bgOpacity = 100;
+	} else {
+		fgColor = DestPixFmt(0xFFFFFFFFU);
+		bgColor = DestPixFmt(0xFF000000U);
+		if (blendMode == 1)
+			bgColor.A = 0;
+		else if (blendMode == 2)
+			fgColor.A = 200, bgColor.A = 100;
+	}
+
+	const GlyphMeasurement srcRect{ false, 0, 0, GlyphSize, GlyphSize };
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < GlyphCount; ++i) {
+		const auto left = static_cast<SSIZE_T>(i * GlyphSize % (DestWidth - GlyphSize));
+		const GlyphMeasurement destRect{ false, left, 0, left + GlyphSize, GlyphSize };
+		Copier<uint8_t, ResolveByte, DestPixFmt, uint8_t, 1>::CopyTo(srcRect, destRect, &src[0], &dest[0], GlyphSize, GlyphSize, DestWidth, fgColor, bgColor, fgOpacity, bgOpacity, 1.4);
+	}
+	return GlyphCount / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int wmain(int argc, wchar_t** argv) {
+	size_t mismatches = 0;
+	mismatches += CompareRandom<uint8_t, ResolveByte, Texture::RGBA8888, 1>(20000);
+	mismatches += CompareRandom<uint8_t, ResolveFourLevels, Texture::RGBA8888, 1>(5000);
+	mismatches += CompareRandom<Texture::RGBA8888, ResolveRed, Texture::RGBA8888, -1>(5000);
+	mismatches += CompareRandom<uint8_t, ResolveByte, uint8_t, 1>(20000);
+	mismatches += CompareRandom<uint8_t, ResolveFourLevels, uint8_t, 1>(5000);
+	std::cout << std::format("Mismatches: {}\n", mismatches);
+
+	static constexpr const char* BlendModeNames[]{ "opaque", "binary", "blended" };
+	for (int blendMode = 0; blendMode < 3; ++blendMode) {
+		std::cout << std::format("RGBA8888 {:>7}: {:>10.0f} -> {:>10.0f} glyphs/s\n", BlendModeNames[blendMode],
+			MeasureGlyphsPerSecond<Texture::RGBA8888, ReferenceBitmapCopy>(blendMode),
+			MeasureGlyphsPerSecond<Texture::RGBA8888, Sqex::FontCsv::RgbBitmapCopy>(blendMode));
+		std::cout << std::format("L8       {:>7}: {:>10.0f} -> {:>10.0f} glyphs/s\n", BlendModeNames[blendMode],
+			MeasureGlyphsPerSecond<uint8_t, ReferenceBitmapCopy>(blendMode),
+			MeasureGlyphsPerSecond<uint8_t, Sqex::FontCsv::RgbBitmapCopy>(blendMode));
+	}
+	return mismatches ? 1 : 0;
+}
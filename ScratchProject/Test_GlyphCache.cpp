@@ -0,0 +1,97 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex/FontCsv/CreateConfig.h>
+#include <XivAlexanderCommon/Sqex/FontCsv/Creator.h>
+#include <XivAlexanderCommon/Sqex/FontCsv/GlyphCache.h>
+#include <XivAlexanderCommon/Sqex/Texture/ModifiableTextureStream.h>
+
+// Generates the same font set three times against a fresh glyph cache directory:
+// once to fill the cache, once again to confirm that nothing gets rasterized, and once more with one size changed
+// to confirm that only the glyphs of the changed size get rasterized.
+// Usage: ScratchProject [path/to/cache/directory]
+
+static nlohmann::json MakeConfig(double lastHeight) {
+	auto sources = nlohmann::json::object();
+	auto fonts = nlohmann::json::object();
+	for (const auto height : {12., 18., lastHeight}) {
+		const auto sourceName = std::format("dwrite:Arial:{}", height);
+		sources[sourceName] = {{"familyName", "Arial"}, {"height", height}};
+		fonts[std::format("Arial_{}.fdt", fonts.size())] = {
+			{"height", height},
+			{"borderThickness", height > 15 ? 2 : 0},
+			{"borderOpacity", height > 15 ? 255 : 0},
+			{"sources", nlohmann::json::array({{{"name", sourceName}}})},
+		};
+	}
+	return {
+		{"textureWidth", 1024},
+		{"textureHeight", 1024},
+		{"sources", sources},
+		{"targets", {{"font{}.tex", fonts}}},
+	};
+}
+
+struct RunResult {
+	uint64_t Hits;
+	uint64_t Misses;
+	double Seconds;
+	std::vector<std::vector<uint8_t>> Textures;
+};
+
+static RunResult Run(const std::filesystem::path& cacheDir, const nlohmann::json& configJson) {
+	const auto cache = std::make_shared<Sqex::FontCsv::GlyphCache>(cacheDir, 256ULL * 1024 * 1024);
+	auto config = configJson.get<Sqex::FontCsv::CreateConfig::FontCreateConfig>();
+	config.ValidateOrThrow();
+
+	const auto start = std::chrono::steady_clock::now();
+	Sqex::FontCsv::FontSetsCreator creator(config, {});
+	creator.SetGlyphCache(cache);
+	creator.VerifyRequirements(nullptr, nullptr);
+	creator.Start();
+	void(creator.Wait());
+	if (!creator.GetError().empty())
+		throw std::runtime_error(creator.GetError());
+
+	RunResult res{
+		.Hits = cache->HitCount(),
+		.Misses = cache->MissCount(),
+		.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+	};
+	for (const auto& fontSet : creator.GetResult().Result | std::views::values)
+		for (const auto& texture : fontSet.Textures)
+			res.Textures.emplace_back(texture->ReadStreamIntoVector<uint8_t>(0));
+	return res;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto cacheDir = argc > 1 ? std::filesystem::path(argv[1]) : std::filesystem::temp_directory_path() / "XivAlexanderGlyphCacheTest";
+	remove_all(cacheDir);
+
+	try {
+		const auto first = Run(cacheDir, MakeConfig(24));
+		const auto second = Run(cacheDir, MakeConfig(24));
+		const auto third = Run(cacheDir, MakeConfig(26));
+
+		for (const auto& [name, r] : {std::make_pair("cold", &first), std::make_pair("warm", &second), std::make_pair("changed", &third)})
+			std::cout << std::format("{:>8}: {:6} hits, {:6} misses (rasterized), {:.3f}s\n", name, r->Hits, r->Misses, r->Seconds);
+
+		auto success = true;
+		if (second.Misses) {
+			std::cout << "FAIL: warm run rasterized glyphs\n";
+			success = false;
+		}
+		if (second.Textures != first.Textures) {
+			std::cout << "FAIL: warm run produced different textures\n";
+			success = false;
+		}
+		if (!third.Misses || third.Misses >= first.Misses) {
+			std::cout << "FAIL: changed run did not rasterize only the changed size\n";
+			success = false;
+		}
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
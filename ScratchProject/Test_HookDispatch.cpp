@@ -0,0 +1,170 @@
+#include "pch.h"
+
+#include <thread>
+
+#include <XivAlexanderCommon/Utils/CallOnDestruction.h>
+#include <XivAlexanderCommon/Utils/InFlightCounter.h>
+
+// Measures the cost of going through the gateway of XivAlexander::Misc::Hooks::Function, without patching any code:
+// how it used to be (one shared atomic counter released by a CallOnDestruction, and a std::function detour), and how
+// it is now (Utils::InFlightCounter, and a detour invoked through a function pointer).
+// Usage: ScratchProject [calls per thread in millions]
+
+class Gateway {
+public:
+	virtual ~Gateway() = default;
+	virtual int DetouredGateway(int a, int b) = 0;
+	virtual size_t InFlight() const = 0;
+};
+
+class OldGateway : public Gateway {
+	std::atomic_size_t m_hookCounter{};
+	std::function<int(int, int)> m_detour;
+
+	Utils::CallOnDestruction AcquireHookCounter() {
+		m_hookCounter++;
+		return { [this]() {
+			m_hookCounter--;
+		} };
+	}
+
+public:
+	OldGateway(std::function<int(int, int)> detour)
+		: m_detour(std::move(detour)) {
+	}
+
+	int DetouredGateway(int a, int b) override {
+		const auto _hookCounterRelease = AcquireHookCounter();
+		if (m_detour)
+			return m_detour(a, b);
+		else
+			return 0;
+	}
+
+	size_t InFlight() const override {
+		return m_hookCounter;
+	}
+};
+
+class NewGateway : public Gateway {
+	struct DetourBase {
+		int(* const Invoke)(DetourBase*, int, int);
+
+		DetourBase(int(*invoke)(DetourBase*, int, int))
+			: Invoke(invoke) {
+		}
+
+		virtual ~DetourBase() = default;
+	};
+
+	template<typename F>
+	struct Detour : DetourBase {
+		F Fn;
+
+		Detour(F fn)
+			: DetourBase(&InvokeFn)
+			, Fn(std::move(fn)) {
+		}
+
+		static int InvokeFn(DetourBase* self, int a, int b) {
+			return static_cast<Detour*>(self)->Fn(a, b);
+		}
+	};
+
+	Utils::InFlightCounter m_hookCounter;
+	std::unique_ptr<DetourBase> m_detour;
+
+public:
+	template<typename F>
+	NewGateway(F detour)
+		: m_detour(std::make_unique<Detour<F>>(std::move(detour))) {
+	}
+
+	int DetouredGateway(int a, int b) override {
+		const auto _hookCounterRelease = m_hookCounter.Enter();
+		if (const auto detour = m_detour.get())
+			return detour->Invoke(detour, a, b);
+		else
+			return 0;
+	}
+
+	size_t InFlight() const override {
+		return m_hookCounter.Count();
+	}
+};
+
+// Calls through a volatile pointer, like the thunk generated by Binder does, so that nothing gets devirtualized.
+static double NanosecondsPerCall(Gateway& gateway, size_t threadCount, size_t callsPerThread) {
+	std::vector<std::thread> threads;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([&gateway, callsPerThread]() {
+			Gateway* volatile target = &gateway;
+			int sum = 0;
+			for (size_t j = 0; j < callsPerThread; ++j)
+				sum = target->DetouredGateway(sum, static_cast<int>(j));
+			volatile auto sink = sum;
+			(void)sink;
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / callsPerThread;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto callsPerThread = (argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 20U) * 1000000;
+
+	try {
+		auto success = true;
+
+		// The detour sees itself as in flight, like an unhooking destructor would; capture a pointer, like [this] does.
+		const Gateway* self = nullptr;
+		size_t maxInFlight = 0;
+		const auto detour = [&self, &maxInFlight](int a, int b) {
+			maxInFlight = std::max(maxInFlight, self->InFlight());
+			return a + b;
+		};
+		OldGateway oldGateway(detour);
+		NewGateway newGateway(detour);
+		for (Gateway* gateway : std::initializer_list<Gateway*>{ &oldGateway, &newGateway }) {
+			self = gateway;
+			maxInFlight = 0;
+			if (gateway->DetouredGateway(1, 2) != 3 || maxInFlight != 1 || gateway->InFlight() != 0) {
+				std::cout << "FAIL: detour not called while counted as in flight\n";
+				success = false;
+			}
+		}
+
+		Utils::InFlightCounter counter;
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < 8; ++i) {
+			threads.emplace_back([&counter]() {
+				for (size_t j = 0; j < 100000; ++j)
+					const auto scope = counter.Enter();
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		if (counter) {
+			std::cout << std::format("FAIL: {} callers left in flight\n", counter.Count());
+			success = false;
+		}
+
+		const auto add = [p = &counter](int a, int b) { return a + b; };
+		OldGateway oldAdd(add);
+		NewGateway newAdd(add);
+		std::set<size_t> threadCounts{ 1, std::max<size_t>(1, std::thread::hardware_concurrency()) };
+		for (const auto threadCount : threadCounts) {
+			const auto oldNs = NanosecondsPerCall(oldAdd, threadCount, callsPerThread);
+			const auto newNs = NanosecondsPerCall(newAdd, threadCount, callsPerThread);
+			std::cout << std::format("{:>3} threads: before {:>7.2f}ns/call, after {:>7.2f}ns/call\n", threadCount, oldNs, newNs);
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
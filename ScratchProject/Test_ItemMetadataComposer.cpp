@@ -0,0 +1,172 @@
+#include "pch.h"
+
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
+
+// Builds hundreds of synthetic item metadata for body equipment, each editing its own IMC file and the shared EQDP,
+// EQP and EST files, and toggles one of them through Sqex::ThirdParty::TexTools::ItemMetadataComposer: checks that
+// only the files it touches get recomputed, and that the result matches composing everything from scratch.
+// Usage: ScratchProject [number of item metadata]
+
+using Sqex::ThirdParty::TexTools::ItemMetadata;
+using Sqex::ThirdParty::TexTools::ItemMetadataComposer;
+
+static constexpr uint32_t Races[]{ 101, 201, 301, 401 };
+
+static std::shared_ptr<const ItemMetadata> MakeItemMetadata(uint16_t itemId, std::mt19937& rng) {
+	const auto path = std::format("chara/equipment/e{:04}/e{:04}_top.meta", itemId, itemId);
+
+	std::vector<Sqex::Imc::Entry> imc(1 + rng() % 3);
+	for (auto& entry : imc)
+		entry.Variant = static_cast<uint8_t>(1 + rng() % 8);
+
+	std::vector<ItemMetadata::EqdpEntry> eqdp;
+	for (const auto race : Races) {
+		if (rng() % 2)
+			eqdp.emplace_back(ItemMetadata::EqdpEntry{ .RaceCode = race, .Value = static_cast<uint8_t>(rng() % 4) });
+	}
+
+	const uint8_t eqp[2]{ static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()) };
+	const ItemMetadata::EstEntry est{ .RaceCode = static_cast<uint16_t>(Races[rng() % std::size(Races)]), .SetId = itemId, .SkelId = static_cast<uint16_t>(1 + rng() % 100) };
+
+	const auto bytes = []<typename T>(std::span<const T> s) {
+		return std::span(reinterpret_cast<const uint8_t*>(s.data()), s.size_bytes());
+	};
+	std::vector<std::pair<ItemMetadata::MetaDataType, std::span<const uint8_t>>> sections{
+		{ItemMetadata::MetaDataType::Imc, bytes(std::span<const Sqex::Imc::Entry>(imc))},
+		{ItemMetadata::MetaDataType::Eqdp, bytes(std::span<const ItemMetadata::EqdpEntry>(eqdp))},
+		{ItemMetadata::MetaDataType::Eqp, bytes(std::span<const uint8_t>(eqp))},
+		{ItemMetadata::MetaDataType::Est, bytes(std::span(&est, 1))},
+	};
+
+	std::vector<uint8_t> data(sizeof(uint32_t));
+	*reinterpret_cast<uint32_t*>(&data[0]) = ItemMetadata::Version_Value;
+	data.insert(data.end(), path.begin(), path.end());
+	data.push_back(0);
+
+	const auto headerOffset = data.size();
+	const auto locatorOffset = headerOffset + sizeof(ItemMetadata::MetaDataHeader);
+	auto dataOffset = locatorOffset + sizeof(ItemMetadata::MetaDataEntryLocator) * sections.size();
+	data.resize(dataOffset);
+	*reinterpret_cast<ItemMetadata::MetaDataHeader*>(&data[headerOffset]) = {
+		.EntryCount = static_cast<uint32_t>(sections.size()),
+		.HeaderSize = static_cast<uint32_t>(sizeof(ItemMetadata::MetaDataHeader)),
+		.FirstEntryLocatorOffset = static_cast<uint32_t>(locatorOffset),
+	};
+	for (size_t i = 0; i < sections.size(); ++i) {
+		reinterpret_cast<ItemMetadata::MetaDataEntryLocator*>(&data[locatorOffset])[i] = {
+			.Type = sections[i].first,
+			.Offset = static_cast<uint32_t>(data.size()),
+			.Size = static_cast<uint32_t>(sections[i].second.size()),
+		};
+		data.insert(data.end(), sections[i].second.begin(), sections[i].second.end());
+	}
+
+	return std::make_shared<const ItemMetadata>(path, Sqex::MemoryRandomAccessStream(std::move(data)));
+}
+
+static std::vector<uint8_t> MakeOriginalFile(const std::string& path) {
+	if (path.ends_with(".eqp") || path.ends_with(".gmp"))
+		return Sqex::EqpGmp::CollapsedFile(Sqex::EqpGmp::ExpandedFile()).DataBytes();
+	if (path.ends_with(".est"))
+		return Sqex::Est::File().Data();
+	if (path.ends_with(".imc"))
+		return Sqex::Imc::File().Data();
+	if (path.ends_with(".eqdp")) {
+		// Blocks of 160 sets, none of them present.
+		std::vector<uint8_t> data(sizeof(Sqex::Eqdp::Header) + sizeof(uint16_t) * 64, 0xFF);
+		*reinterpret_cast<Sqex::Eqdp::Header*>(&data[0]) = { .Identifier = 0, .BlockMemberCount = 160, .BlockCount = 64 };
+		return data;
+	}
+	throw std::out_of_range("entry not found");
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto itemCount = argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 500U;
+
+	try {
+		auto success = true;
+
+		std::mt19937 rng(0);
+		std::vector<std::shared_ptr<const ItemMetadata>> metadata;
+		for (size_t i = 0; i < itemCount; ++i)
+			metadata.emplace_back(MakeItemMetadata(static_cast<uint16_t>(1 + i), rng));
+
+		size_t originalReads = 0;
+		const auto reader = [&originalReads](const std::string& path) -> std::shared_ptr<Sqex::RandomAccessStream> {
+			++originalReads;
+			return std::make_shared<Sqex::MemoryRandomAccessStream>(MakeOriginalFile(path));
+		};
+		ItemMetadataComposer composer(reader);
+
+		auto start = std::chrono::steady_clock::now();
+		const auto initial = composer.Update(metadata);
+		const auto initialTime = std::chrono::steady_clock::now() - start;
+		const auto initialReads = std::exchange(originalReads, 0);
+
+		// Nothing changed, so nothing should be done.
+		if (const auto unchanged = composer.Update(metadata); !unchanged.empty() || originalReads) {
+			std::cout << std::format("FAIL: {} files recomputed without any change\n", unchanged.size());
+			success = false;
+		}
+
+		// Disable one item metadata in the middle; it touches its own IMC file, and the shared files it has edits for.
+		const auto toggled = metadata[metadata.size() / 2];
+		std::set<std::string> expected{ toggled->TargetImcPath, ItemMetadata::EqpPath, ItemMetadata::EstPath(toggled->EstType) };
+		for (const auto& v : toggled->Get<ItemMetadata::EqdpEntry>(ItemMetadata::MetaDataType::Eqdp))
+			expected.insert(ItemMetadata::EqdpPath(toggled->ItemType, v.RaceCode));
+
+		auto enabled = metadata;
+		enabled.erase(enabled.begin() + static_cast<ptrdiff_t>(metadata.size() / 2));
+		start = std::chrono::steady_clock::now();
+		const auto disabled = composer.Update(enabled);
+		const auto toggleTime = std::chrono::steady_clock::now() - start;
+		const auto toggleReads = std::exchange(originalReads, 0);
+		if (std::set(disabled.begin(), disabled.end()) != expected || disabled.size() != expected.size()) {
+			std::cout << std::format("FAIL: {} files recomputed on disabling, expected {}\n", disabled.size(), expected.size());
+			success = false;
+		}
+		// The IMC file no longer edited by anything goes back to the original, so only the shared ones are read.
+		if (toggleReads != expected.size() - 1) {
+			std::cout << std::format("FAIL: {} original files read on disabling, expected {}\n", toggleReads, expected.size() - 1);
+			success = false;
+		}
+		if (composer.Get(toggled->TargetImcPath)) {
+			std::cout << "FAIL: IMC file of disabled item metadata is still edited\n";
+			success = false;
+		}
+
+		const auto checkAgainstScratch = [&](const std::vector<std::shared_ptr<const ItemMetadata>>& list, const char* when) {
+			ItemMetadataComposer scratch(reader);
+			for (const auto& path : scratch.Update(list)) {
+				const auto incremental = composer.Get(path);
+				if (!incremental || *incremental != *scratch.Get(path)) {
+					std::cout << std::format("FAIL: {} differs from composing from scratch {}\n", path, when);
+					success = false;
+				}
+			}
+			originalReads = 0;
+		};
+		checkAgainstScratch(enabled, "after disabling");
+
+		// Enabling it again at the end moves it after everything else, which matters for the shared files.
+		enabled.emplace_back(toggled);
+		const auto reenabled = composer.Update(enabled);
+		if (std::set(reenabled.begin(), reenabled.end()) != expected || reenabled.size() != expected.size()) {
+			std::cout << std::format("FAIL: {} files recomputed on enabling, expected {}\n", reenabled.size(), expected.size());
+			success = false;
+		}
+		checkAgainstScratch(enabled, "after enabling");
+
+		std::cout << std::format("{} item metadata: composed {} files from {} original files in {:.3f}ms; toggling one recomputed {} files from {} original files in {:.3f}ms\n",
+			metadata.size(), initial.size(), initialReads, std::chrono::duration<double, std::milli>(initialTime).count(),
+			disabled.size(), toggleReads, std::chrono::duration<double, std::milli>(toggleTime).count());
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
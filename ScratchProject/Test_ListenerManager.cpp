@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+
+#include <XivAlexanderCommon/Utils/ListenerManager.h>
+
+// Fires Utils::ListenerManager events from several threads while other threads keep adding and removing callbacks,
+// checking that every callback registered for the whole time gets called exactly once per event; then compares the
+// rate of firing against copying every callback under the lock on each event, which is how it used to be done.
+// Uses no Windows headers or precompiled header, so that it can be built along with CallOnDestruction.cpp anywhere.
+// Usage: ScratchProject [seconds to stress]
+
+struct Source {
+	Utils::ListenerManager<Source, void, size_t&> OnEvent;
+
+	size_t Fire(size_t& counter) {
+		return OnEvent(counter);
+	}
+};
+
+// How events used to be fired, kept as reference.
+class CopyingListenerManager {
+	std::map<size_t, std::function<void(size_t&)>> m_callbacks;
+	std::mutex m_lock;
+
+public:
+	void Add(size_t id, std::function<void(size_t&)> fn) {
+		std::lock_guard lock(m_lock);
+		m_callbacks.emplace(id, std::move(fn));
+	}
+
+	size_t Fire(size_t& counter) {
+		std::vector<std::function<void(size_t&)>> callbacks;
+		{
+			std::lock_guard lock(m_lock);
+			for (const auto& cbp : m_callbacks)
+				callbacks.push_back(cbp.second);
+		}
+
+		size_t notified = 0;
+		for (const auto& cb : callbacks) {
+			cb(counter);
+			notified++;
+		}
+		return notified;
+	}
+};
+
+template<typename Fn>
+static double FiresPerSecond(size_t threadCount, Fn fire) {
+	constexpr size_t FiresPerThread = 1000000;
+	std::vector<std::thread> threads;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([&fire]() {
+			size_t counter = 0;
+			for (size_t j = 0; j < FiresPerThread; ++j)
+				fire(counter);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	return threadCount * FiresPerThread / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	const auto stressSeconds = argc > 1 ? static_cast<int>(std::strtol(argv[1], nullptr, 10)) : 2;
+
+	try {
+		auto success = true;
+
+		{
+			Source source;
+			std::atomic_bool stop = false;
+			std::atomic_size_t failures = 0, fires = 0;
+			std::optional<Utils::CallOnDestruction> removed;
+
+			// Two callbacks that stay for the whole test, and one removed before firing begins.
+			const auto permanent1 = source.OnEvent([](size_t& counter) { counter += 1; });
+			const auto permanent2 = source.OnEvent([](size_t& counter) { counter += 100; });
+			removed.emplace(source.OnEvent([](size_t& counter) { counter += 10000; }));
+			removed.reset();
+			if (source.OnEvent.Empty()) {
+				std::cout << "FAIL: Empty\n";
+				success = false;
+			}
+
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < 4; ++i) {
+				threads.emplace_back([&]() {
+					while (!stop) {
+						size_t counter = 0;
+						source.Fire(counter);
+						// Transient callbacks each add 1000000, so only the permanent ones may show up below that.
+						if (counter % 1000000 != 101)
+							++failures;
+						++fires;
+					}
+				});
+			}
+			for (size_t i = 0; i < 4; ++i) {
+				threads.emplace_back([&]() {
+					while (!stop) {
+						std::vector<Utils::CallOnDestruction> transient;
+						for (size_t j = 0; j < 8; ++j)
+							transient.emplace_back(source.OnEvent([](size_t& counter) { counter += 1000000; }));
+					}
+				});
+			}
+			std::this_thread::sleep_for(std::chrono::seconds(stressSeconds));
+			stop = true;
+			for (auto& thread : threads)
+				thread.join();
+
+			size_t counter = 0;
+			const auto notified = source.Fire(counter);
+			std::cout << "Stress: " << fires.load() << " events fired, " << failures.load() << " wrong\n";
+			if (failures || notified != 2 || counter != 101) {
+				std::cout << "FAIL: " << failures.load() << " wrong events, " << notified << " callbacks left, counter " << counter << "\n";
+				success = false;
+			}
+		}
+
+		for (const auto listenerCount : { 1, 8 }) {
+			Source source;
+			CopyingListenerManager copying;
+			std::vector<Utils::CallOnDestruction> callbacks;
+			for (auto i = 0; i < listenerCount; ++i) {
+				const auto fn = [p = &source](size_t& counter) { counter++; };
+				callbacks.emplace_back(source.OnEvent(fn));
+				copying.Add(i, fn);
+			}
+
+			std::set<size_t> threadCounts{ 1, std::max<size_t>(1, std::thread::hardware_concurrency()) };
+			for (const auto threadCount : threadCounts) {
+				const auto before = FiresPerSecond(threadCount, [&copying](size_t& counter) { copying.Fire(counter); });
+				const auto after = FiresPerSecond(threadCount, [&source](size_t& counter) { source.Fire(counter); });
+				std::cout << listenerCount << " listeners, " << std::setw(3) << threadCount << " threads: "
+					<< std::fixed << std::setprecision(2)
+					<< "before " << std::setw(7) << before / 1000000 << "M events/s, "
+					<< "after " << std::setw(7) << after / 1000000 << "M events/s\n";
+			}
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,298 @@
+#include "pch.h"
+
+#include <deque>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
+#include <XivAlexanderCommon/Utils/Utils.h>
+
+// Feeds random values to Utils::NumericStatisticsTracker and to the deque based implementation it replaced, and checks
+// that every query answers the same, over the whole window and over recent values only, with and without values
+// expiring. Then times adding values and querying median on a tracker of 1024 values, like
+// MessagePumpIntervalTrackerUs, with both implementations.
+// Usage: ScratchProject [number of values to add per configuration]
+
+// How Utils::NumericStatisticsTracker used to be implemented.
+class DequeStatisticsTracker {
+	const size_t m_trackCount;
+	const int64_t m_emptyValue;
+	const int64_t m_maxAgeUs;
+
+	struct Entry {
+		int64_t Value;
+		int64_t TimestampUs;
+		int64_t ExpiryUs;
+	};
+
+	mutable std::deque<Entry> m_values;
+
+public:
+	DequeStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs = INT64_MAX)
+		: m_trackCount(trackCount)
+		, m_emptyValue(emptyValue)
+		, m_maxAgeUs(maxAgeUs) {
+	}
+
+	void AddValue(int64_t v) {
+		const auto nowUs = Utils::QpcUs();
+		m_values.emplace_back(v, nowUs, m_maxAgeUs == INT64_MAX ? INT64_MAX : nowUs + m_maxAgeUs);
+		void(RemoveExpired(nowUs));
+	}
+
+	const std::deque<Entry>& RemoveExpired(int64_t nowUs = Utils::QpcUs()) const {
+		while (!m_values.empty() && (m_values.size() > m_trackCount || m_values.front().ExpiryUs < nowUs))
+			m_values.pop_front();
+		return m_values;
+	}
+
+	int64_t Latest() const {
+		const auto vals = RemoveExpired();
+		return vals.empty() ? m_emptyValue : vals.back().Value;
+	}
+
+	int64_t Min(int64_t sinceUs = 0) const {
+		const auto vals = RemoveExpired();
+		auto found = false;
+		int64_t minValue{};
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs)
+				break;
+			if (!found || minValue > v.Value)
+				minValue = v.Value;
+			found = true;
+		}
+		return found ? minValue : m_emptyValue;
+	}
+
+	int64_t Max(int64_t sinceUs = 0) const {
+		const auto vals = RemoveExpired();
+		auto found = false;
+		int64_t maxValue{};
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs)
+				break;
+			if (!found || maxValue < v.Value)
+				maxValue = v.Value;
+			found = true;
+		}
+		return found ? maxValue : m_emptyValue;
+	}
+
+	int64_t Median(int64_t sinceUs = 0) const {
+		const auto vals = RemoveExpired();
+		std::vector<int64_t> sorted;
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs)
+				break;
+			sorted.emplace_back(v.Value);
+		}
+		if (sorted.empty())
+			return m_emptyValue;
+		std::ranges::sort(sorted);
+		if (sorted.size() % 2 == 0)
+			return (sorted[sorted.size() / 2] + sorted[sorted.size() / 2 - 1]) / 2;
+		return sorted[sorted.size() / 2];
+	}
+
+	std::pair<int64_t, int64_t> MeanAndDeviation(int64_t sinceUs = 0) const {
+		const auto vals = RemoveExpired();
+		int64_t count = 0;
+		int64_t acc{};
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs)
+				break;
+			acc += v.Value;
+			++count;
+		}
+		if (count == 0)
+			return { m_emptyValue, 0 };
+		if (count == 1)
+			return { acc, 0 };
+		const auto mean = acc / count;
+
+		int64_t diffSquaredSum = 0;
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs)
+				break;
+			diffSquaredSum += (v.Value - mean) * (v.Value - mean);
+		}
+		return { mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count)) };
+	}
+
+	size_t Count(int64_t sinceUs = 0) const {
+		const auto vals = RemoveExpired();
+		if (!sinceUs)
+			return vals.size();
+		size_t count = 0;
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs)
+				break;
+			++count;
+		}
+		return count;
+	}
+
+	double CountFractional(int64_t sinceUs = 0) const {
+		const auto vals = RemoveExpired();
+		if (!sinceUs)
+			return static_cast<double>(vals.size());
+		size_t count = 0;
+		int64_t lastTimestamp = INT64_MIN;
+		for (const auto& v : std::ranges::reverse_view(vals)) {
+			if (v.TimestampUs < sinceUs) {
+				if (lastTimestamp != INT64_MIN) {
+					const auto window = lastTimestamp - v.TimestampUs;
+					const auto elapsed = sinceUs - v.TimestampUs;
+					if (window > elapsed)
+						return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
+				}
+				break;
+			}
+			++count;
+			lastTimestamp = v.TimestampUs;
+		}
+		return static_cast<double>(count);
+	}
+};
+
+// Returns a timestamp later than every value added so far, and not later than any value added after.
+static int64_t Marker() {
+	const auto before = Utils::QpcUs();
+	int64_t now;
+	while ((now = Utils::QpcUs()) == before) {
+		// spin until the clock ticks
+	}
+	const auto marker = now;
+	while (Utils::QpcUs() == marker) {
+		// spin until values added from now on get a later timestamp than values added before
+	}
+	return marker;
+}
+
+static bool Compare(const Utils::NumericStatisticsTracker& tracker, const DequeStatisticsTracker& reference, int64_t sinceUs, const std::string& context) {
+	auto success = true;
+	const auto check = [&](const char* name, int64_t actual, int64_t expected) {
+		if (actual == expected)
+			return;
+		std::cout << std::format("FAIL: {}: {}({}) = {}, expected {}\n", context, name, sinceUs, actual, expected);
+		success = false;
+	};
+	check("Min", tracker.Min(sinceUs), reference.Min(sinceUs));
+	check("Max", tracker.Max(sinceUs), reference.Max(sinceUs));
+	check("Median", tracker.Median(sinceUs), reference.Median(sinceUs));
+	const auto [mean, deviation] = tracker.MeanAndDeviation(sinceUs);
+	const auto [expectedMean, expectedDeviation] = reference.MeanAndDeviation(sinceUs);
+	check("Mean", mean, expectedMean);
+	check("Deviation", deviation, expectedDeviation);
+	check("Count", static_cast<int64_t>(tracker.Count(sinceUs)), static_cast<int64_t>(reference.Count(sinceUs)));
+	// Fraction part depends on timestamps, which differ between the two by when each took the value.
+	check("CountFractional", static_cast<int64_t>(tracker.CountFractional(sinceUs)), static_cast<int64_t>(reference.CountFractional(sinceUs)));
+	if (!sinceUs)
+		check("Latest", tracker.Latest(), reference.Latest());
+	return success;
+}
+
+template<typename T>
+static double MeasureNanoseconds(size_t iterations, T fn) {
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; ++i)
+		fn(i);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(iterations);
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto valueCount = argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 3000U;
+
+	try {
+		std::mt19937_64 rng(0);
+		auto success = true;
+
+		for (const auto trackCount : { 1, 2, 7, 10, 64, 1024 }) {
+			for (const auto valueRange : { 4LL, 1000000LL }) {
+				const auto context = std::format("trackCount={}, valueRange={}", trackCount, valueRange);
+				Utils::NumericStatisticsTracker tracker(trackCount, -1);
+				DequeStatisticsTracker reference(trackCount, -1);
+				std::vector<int64_t> markers;
+
+				for (size_t i = 0; i < valueCount && success; ++i) {
+					if (i % 8 == 0)
+						markers.emplace_back(Marker());
+					const auto value = static_cast<int64_t>(rng() % valueRange) - valueRange / 4;
+					tracker.AddValue(value);
+					reference.AddValue(value);
+
+					success &= Compare(tracker, reference, 0, context);
+					success &= Compare(tracker, reference, markers[rng() % markers.size()], context);
+					success &= Compare(tracker, reference, markers.back(), context);
+				}
+
+				tracker.Clear();
+				if (!tracker.Empty() || tracker.Median() != -1 || tracker.Count() != 0) {
+					std::cout << std::format("FAIL: {}: not empty after Clear\n", context);
+					success = false;
+				}
+			}
+		}
+
+		// Values expire maxAgeUs after being added; compare only while nothing is about to expire.
+		{
+			constexpr int64_t MaxAgeUs = 100000;
+			Utils::NumericStatisticsTracker tracker(64, -1, MaxAgeUs);
+			DequeStatisticsTracker reference(64, -1, MaxAgeUs);
+			for (size_t round = 0; round < 5 && success; ++round) {
+				const auto marker = Marker();
+				for (size_t i = 0; i < 40; ++i) {
+					const auto value = static_cast<int64_t>(rng() % 1000);
+					tracker.AddValue(value);
+					reference.AddValue(value);
+				}
+				success &= Compare(tracker, reference, 0, "expiry");
+				success &= Compare(tracker, reference, marker, "expiry");
+				std::this_thread::sleep_for(std::chrono::microseconds(MaxAgeUs * 3 / 2));
+				success &= Compare(tracker, reference, 0, "expiry");
+			}
+		}
+
+		// Times AddValue, Median of every value, and Median of recent values.
+		{
+			constexpr size_t TrackCount = 1024;
+			constexpr size_t Iterations = 20000;
+			Utils::NumericStatisticsTracker tracker(TrackCount, 0);
+			DequeStatisticsTracker reference(TrackCount, 0);
+			for (size_t i = 0; i < TrackCount; ++i) {
+				tracker.AddValue(static_cast<int64_t>(rng() % 100000));
+				reference.AddValue(static_cast<int64_t>(rng() % 100000));
+			}
+
+			int64_t sink = 0;
+			const auto trackerAdd = MeasureNanoseconds(Iterations, [&](size_t i) { tracker.AddValue(static_cast<int64_t>(i * 7919 % 100000)); });
+			const auto referenceAdd = MeasureNanoseconds(Iterations, [&](size_t i) { reference.AddValue(static_cast<int64_t>(i * 7919 % 100000)); });
+			const auto trackerMedian = MeasureNanoseconds(Iterations, [&](size_t) { sink += tracker.Median(); });
+			const auto referenceMedian = MeasureNanoseconds(Iterations / 10, [&](size_t) { sink += reference.Median(); });
+
+			// Median of the last quarter of the values.
+			const auto recent = Marker();
+			for (size_t i = 0; i < TrackCount / 4; ++i) {
+				tracker.AddValue(static_cast<int64_t>(rng() % 100000));
+				reference.AddValue(static_cast<int64_t>(rng() % 100000));
+			}
+			const auto trackerRecentMedian = MeasureNanoseconds(Iterations, [&](size_t) { sink += tracker.Median(recent); });
+			const auto referenceRecentMedian = MeasureNanoseconds(Iterations / 10, [&](size_t) { sink += reference.Median(recent); });
+
+			// Median of recent values makes the tracker keep more treaps from then on.
+			const auto trackerAddAfterRecent = MeasureNanoseconds(Iterations, [&](size_t i) { tracker.AddValue(static_cast<int64_t>(i * 7919 % 100000)); });
+
+			std::cout << std::format("{} values tracked (checksum {})\n", TrackCount, sink % 10);
+			std::cout << std::format("AddValue        : {:>10.1f}ns, was {:>10.1f}ns\n", trackerAdd, referenceAdd);
+			std::cout << std::format("Median()        : {:>10.1f}ns, was {:>10.1f}ns\n", trackerMedian, referenceMedian);
+			std::cout << std::format("Median(recent)  : {:>10.1f}ns, was {:>10.1f}ns\n", trackerRecentMedian, referenceRecentMedian);
+			std::cout << std::format("AddValue, after : {:>10.1f}ns\n", trackerAddAfterRecent);
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,179 @@
+#include "pch.h"
+
+#include <random>
+#include <thread>
+
+#include <XivAlexanderCommon/Sqex/Sqpack.h>
+#include <XivAlexanderCommon/Sqex/ZiPatch/Applier.h>
+#include <XivAlexanderCommon/Sqex/ZiPatch/PatchFileSet.h>
+#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
+
+// Writes a synthetic .dat file as a chain of patch files that rewrite overlapping ranges of it, extracts it to disk,
+// and then compares random reads of Sqex::ZiPatch::PatchedFileStream against reads of the extracted file, reporting
+// latency and throughput with one thread and with every core.
+// Usage: ScratchProject [file size in MiB] [read size in bytes] [directory to extract to]
+
+static std::vector<uint8_t> MakePatchFile(const std::string& path, std::span<const uint8_t> data, uint64_t targetOffset) {
+	using namespace Sqex::ZiPatch;
+	using namespace Sqex::ZiPatch::Chunk;
+
+	std::vector<uint8_t> result(Header::Signature_Value, Header::Signature_Value + sizeof(Header::Signature_Value));
+	const auto addChunk = [&result](std::vector<uint8_t>& chunk, TypeValues type) {
+		auto& header = *reinterpret_cast<ChunkHeader*>(chunk.data());
+		header.Size = static_cast<uint32_t>(chunk.size() - sizeof(ChunkHeader));
+		header.Type = type;
+		const auto crc32 = crc32_z(0, &chunk[offsetof(ChunkHeader, Type)], chunk.size() - offsetof(ChunkHeader, Type));
+		chunk.resize(chunk.size() + sizeof(ChunkFooter));
+		reinterpret_cast<ChunkFooter*>(&chunk[chunk.size() - sizeof(ChunkFooter)])->Crc32 = crc32;
+		result.insert(result.end(), chunk.begin(), chunk.end());
+	};
+
+	// One FileAdd command per 1 MiB, made of blocks of 16000 bytes like game patches are.
+	Utils::ZlibReusableDeflater deflater(Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS);
+	for (size_t commandOffset = 0; commandOffset < data.size(); commandOffset += 1048576) {
+		const auto commandData = data.subspan(commandOffset, std::min<size_t>(1048576, data.size() - commandOffset));
+
+		std::vector<uint8_t> chunk(offsetof(SqpkFile, Path) + path.size() + 1);
+		std::ranges::copy(path, &chunk[offsetof(SqpkFile, Path)]);
+		auto& command = *reinterpret_cast<SqpkFile*>(chunk.data());
+		command.SqpkChunkType = SqpkChunkTypeValues::FileAdd;
+		command.TargetOffset = targetOffset + commandOffset;
+		command.TargetSize = commandData.size();
+		command.PathSize = static_cast<uint32_t>(path.size() + 1);
+
+		for (size_t offset = 0; offset < commandData.size(); offset += 16000) {
+			const auto block = commandData.subspan(offset, std::min<size_t>(16000, commandData.size() - offset));
+			const auto deflated = deflater(block);
+			Sqex::Sqpack::SqData::BlockHeader blockHeader{};
+			blockHeader.HeaderSize = sizeof(blockHeader);
+			blockHeader.CompressedSize = static_cast<uint32_t>(deflated.size());
+			blockHeader.DecompressedSize = static_cast<uint32_t>(block.size());
+
+			const auto blockOffset = chunk.size();
+			chunk.resize(blockOffset + Sqex::Align(sizeof(blockHeader) + deflated.size()).Alloc);
+			memcpy(&chunk[blockOffset], &blockHeader, sizeof(blockHeader));
+			std::ranges::copy(deflated, &chunk[blockOffset + sizeof(blockHeader)]);
+		}
+		addChunk(chunk, TypeValues::Sqpk);
+	}
+
+	std::vector<uint8_t> eof(sizeof(ChunkHeader));
+	addChunk(eof, TypeValues::EndOfFile);
+	return result;
+}
+
+struct ReadResult {
+	double LatencyUs;
+	double ThroughputMBps;
+	bool Matches;
+};
+
+static ReadResult RandomReads(const Sqex::RandomAccessStream& stream, const std::vector<uint8_t>& expected, size_t readSize, size_t threadCount, size_t readsPerThread) {
+	std::vector<std::thread> threads;
+	std::vector<uint8_t> matches(threadCount, 1);
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([&, i]() {
+			std::mt19937_64 rng(i);
+			std::vector<uint8_t> buf(readSize);
+			for (size_t j = 0; j < readsPerThread; ++j) {
+				const auto offset = static_cast<size_t>(rng() % (expected.size() - readSize));
+				stream.ReadStream(offset, std::span(buf));
+				if (!std::equal(buf.begin(), buf.end(), expected.begin() + static_cast<ptrdiff_t>(offset)))
+					matches[i] = 0;
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return {
+		.LatencyUs = elapsed * 1000000 / readsPerThread,
+		.ThroughputMBps = 1. * readSize * threadCount * readsPerThread / elapsed / 1000000,
+		.Matches = std::ranges::all_of(matches, [](const auto m) { return !!m; }),
+	};
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto fileSize = (argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 64U) << 20;
+	const auto readSize = argc > 2 ? static_cast<size_t>(std::wcstoul(argv[2], nullptr, 10)) : 4096U;
+	const auto extractDirectory = argc > 3 ? std::filesystem::path(argv[3]) : std::filesystem::temp_directory_path() / "Test_PatchFileSet";
+	const auto path = std::string("sqpack/ffxiv/000000.win32.dat0");
+
+	try {
+		std::mt19937_64 rng(0);
+		auto success = true;
+
+		// Compressible data: runs of repeated bytes.
+		std::vector<uint8_t> expected(fileSize);
+		for (size_t i = 0; i < expected.size();) {
+			const auto run = std::min<size_t>(expected.size() - i, 1 + rng() % 16);
+			std::fill_n(&expected[i], run, static_cast<uint8_t>(rng()));
+			i += run;
+		}
+
+		// The first patch writes the whole file, and later ones rewrite ranges not aligned to blocks of earlier ones.
+		std::vector<std::vector<uint8_t>> patchFiles;
+		patchFiles.emplace_back(MakePatchFile(path, expected, 0));
+		for (size_t i = 0; i < 16; ++i) {
+			const auto size = static_cast<size_t>(1 + rng() % (fileSize / 8));
+			const auto offset = static_cast<size_t>(rng() % (fileSize - size));
+			for (auto j = offset; j < offset + size; ++j)
+				expected[j] = static_cast<uint8_t>(expected[j] + 1);
+			patchFiles.emplace_back(MakePatchFile(path, std::span(expected).subspan(offset, size), offset));
+		}
+
+		std::vector<std::shared_ptr<const Sqex::RandomAccessStream>> patchFileStreams;
+		for (auto& patchFile : patchFiles)
+			patchFileStreams.emplace_back(std::make_shared<Sqex::MemoryRandomAccessStream>(std::span(patchFile)));
+
+		Sqex::ZiPatch::PatchApplier applier(patchFileStreams);
+		applier.ReadPatchFiles();
+		applier.Apply(extractDirectory);
+		const auto& parts = applier.Files().at(path);
+
+		auto extracted = std::make_shared<Sqex::FileRandomAccessStream>(extractDirectory / path);
+		const auto cached = std::make_shared<Sqex::ZiPatch::PatchedFileStream>(
+			std::make_shared<Sqex::ZiPatch::PatchFileSet>(patchFileStreams), parts);
+		const auto uncached = std::make_shared<Sqex::ZiPatch::PatchedFileStream>(
+			std::make_shared<Sqex::ZiPatch::PatchFileSet>(patchFileStreams, 0), parts);
+
+		if (cached->StreamSize() != expected.size()) {
+			std::cout << std::format("FAIL: size {}, expected {}\n", cached->StreamSize(), expected.size());
+			success = false;
+		}
+		std::vector<uint8_t> whole(expected.size());
+		cached->ReadStream(0, std::span(whole));
+		if (whole != expected) {
+			std::cout << "FAIL: whole file differs\n";
+			success = false;
+		}
+
+		std::cout << std::format("{} MiB in {} parts over {} patch files; reads of {} bytes\n", fileSize >> 20, parts.Count(), patchFiles.size(), readSize);
+		std::set<size_t> threadCounts{ 1, std::max<size_t>(1, std::thread::hardware_concurrency()) };
+		for (const auto threadCount : threadCounts) {
+			for (const auto& [name, stream] : std::initializer_list<std::pair<const char*, const Sqex::RandomAccessStream*>>{
+				{"extracted file", extracted.get()},
+				{"patch files, cached", cached.get()},
+				{"patch files, uncached", uncached.get()},
+			}) {
+				const auto result = RandomReads(*stream, expected, readSize, threadCount, 20000);
+				std::cout << std::format("{:>3} threads, {:<22}: {:>8.2f}us/read, {:>9.1f} MB/s\n", threadCount, name, result.LatencyUs, result.ThroughputMBps);
+				if (!result.Matches) {
+					std::cout << std::format("FAIL: {} returned wrong data\n", name);
+					success = false;
+				}
+			}
+		}
+
+		extracted.reset();
+		std::filesystem::remove_all(extractDirectory);
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
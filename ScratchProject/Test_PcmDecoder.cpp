@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <vorbis/vorbisenc.h>
+
+#include <XivAlexanderCommon/Sqex/Sound/PcmDecoder.h>
+
+// Encodes synthetic stereo tones into wave files of several sample formats (and into Ogg Vorbis), decodes them back
+// through Sqex::Sound::PcmDecoder, and resamples them through Sqex::Sound::ResampledPcmDecoder into several sampling
+// rates. Checks sample counts, RMS error against the analytic signal, and that a tone starting at a loop point starts
+// at the loop point converted by the ratio of sampling rates, which is how MusicImporter aligns loops. Then measures
+// how fast a minute of music decodes and resamples in-process.
+// Uses no Windows headers or precompiled header, so that it can be built along with PcmDecoder.cpp, RandomAccessStream.cpp
+// and CallOnDestruction.cpp anywhere.
+// Usage: ScratchProject [seconds of audio to measure speed with]
+
+static constexpr double Frequencies[2]{ 997, 5003 };
+static constexpr double Amplitudes[2]{ 0.5, 0.3 };
+
+// Silence until onset, then cosines; the cosine starts at full amplitude, so that the first sample above a threshold
+// is the first sample of the tone.
+static double ToneAt(double seconds, size_t channel, double onsetSeconds) {
+	if (seconds < onsetSeconds)
+		return 0;
+	return Amplitudes[channel] * std::cos(2 * std::numbers::pi * Frequencies[channel] * (seconds - onsetSeconds));
+}
+
+static std::vector<float> MakeTone(uint32_t rate, size_t blockCount, size_t onsetBlock) {
+	std::vector<float> res(blockCount * 2);
+	for (size_t i = 0; i < blockCount; ++i) {
+		for (size_t c = 0; c < 2; ++c)
+			res[i * 2 + c] = static_cast<float>(ToneAt(static_cast<double>(i) / rate, c, static_cast<double>(onsetBlock) / rate));
+	}
+	return res;
+}
+
+static std::vector<uint8_t> MakeWave(const std::vector<uint8_t>& format, const std::vector<uint8_t>& data) {
+	std::vector<uint8_t> res;
+	const auto insert = [&res](const auto& v) {
+		res.insert(res.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof v);
+	};
+	insert(Utils::LE(0x46464952U));  // "RIFF"
+	insert(Utils::LE(static_cast<uint32_t>(4 + 8 + format.size() + 8 + data.size())));
+	insert(Utils::LE(0x45564157U));  // "WAVE"
+	insert(Utils::LE(0x20746D66U));  // "fmt "
+	insert(Utils::LE(static_cast<uint32_t>(format.size())));
+	res.insert(res.end(), format.begin(), format.end());
+	insert(Utils::LE(0x61746164U));  // "data"
+	insert(Utils::LE(static_cast<uint32_t>(data.size())));
+	res.insert(res.end(), data.begin(), data.end());
+	return res;
+}
+
+static std::vector<uint8_t> MakePcmWave(const std::vector<float>& samples, uint32_t rate, uint16_t formatTag, uint16_t bitsPerSample) {
+	std::vector<uint8_t> format(sizeof(Sqex::Sound::WaveFormatEx));
+	auto& wfex = *reinterpret_cast<Sqex::Sound::WaveFormatEx*>(&format[0]);
+	wfex.wFormatTag = formatTag;
+	wfex.nChannels = 2;
+	wfex.nSamplesPerSec = rate;
+	wfex.wBitsPerSample = bitsPerSample;
+	wfex.nBlockAlign = static_cast<uint16_t>(2 * bitsPerSample / 8);
+	wfex.nAvgBytesPerSec = rate * wfex.nBlockAlign;
+
+	std::vector<uint8_t> data;
+	for (const auto sample : samples) {
+		if (formatTag == Sqex::Sound::WaveFormatEx::FormatTag_IeeeFloat) {
+			data.insert(data.end(), reinterpret_cast<const uint8_t*>(&sample), reinterpret_cast<const uint8_t*>(&sample) + 4);
+		} else {
+			auto scaled = static_cast<int32_t>(std::clamp(std::round(sample * std::ldexp(1., bitsPerSample - 1)), -std::ldexp(1., bitsPerSample - 1), std::ldexp(1., bitsPerSample - 1) - 1));
+			if (bitsPerSample == 8)
+				scaled += 0x80;  // 8-bit samples are unsigned
+			for (size_t i = 0; i < bitsPerSample / 8U; ++i)
+				data.push_back(static_cast<uint8_t>(scaled >> (8 * i)));
+		}
+	}
+	return MakeWave(format, data);
+}
+
+static const Sqex::Sound::ADPCMCOEFSET MsAdpcmCoefficients[7]{
+	{256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208}, {392, -232},
+};
+static constexpr int MsAdpcmAdaptationTable[16]{
+	230, 230, 230, 230, 307, 409, 512, 614,
+	768, 614, 512, 409, 307, 230, 230, 230,
+};
+
+// Encodes samples of one channel of one block, from the third sample on; returns squared error.
+static double EncodeMsAdpcmChannel(std::span<const int> samples, int predictor, int delta, std::vector<uint8_t>* nibbles) {
+	const auto [coef1, coef2] = MsAdpcmCoefficients[predictor];
+	int sample1 = samples[1], sample2 = samples[0];
+	double error = 0;
+	for (size_t i = 2; i < samples.size(); ++i) {
+		const auto predicted = (sample1 * coef1 + sample2 * coef2) / 256;
+		const auto nibble = std::clamp(static_cast<int>(std::lround(static_cast<double>(samples[i] - predicted) / delta)), -8, 7);
+		const auto decoded = std::clamp(predicted + nibble * delta, -32768, 32767);
+		error += std::pow(decoded - samples[i], 2);
+		sample2 = sample1;
+		sample1 = decoded;
+		delta = std::max(16, MsAdpcmAdaptationTable[nibble & 0xF] * delta / 256);
+		if (nibbles)
+			nibbles->push_back(static_cast<uint8_t>(nibble & 0xF));
+	}
+	return error;
+}
+
+static std::vector<uint8_t> MakeMsAdpcmWave(const std::vector<float>& samples, uint32_t rate, uint16_t blockAlign) {
+	constexpr size_t Channels = 2;
+	std::vector<uint8_t> format(sizeof(Sqex::Sound::WaveFormatEx) + 4 + sizeof MsAdpcmCoefficients);
+	auto& adpcm = *reinterpret_cast<Sqex::Sound::ADPCMWAVEFORMAT*>(&format[0]);
+	const auto samplesPerBlock = (blockAlign - 7 * Channels) * 2 / Channels + 2;
+	adpcm.wfx.wFormatTag = Sqex::Sound::WaveFormatEx::FormatTag_MsAdpcm;
+	adpcm.wfx.nChannels = Channels;
+	adpcm.wfx.nSamplesPerSec = rate;
+	adpcm.wfx.nBlockAlign = blockAlign;
+	adpcm.wfx.nAvgBytesPerSec = static_cast<uint32_t>(1ULL * rate * blockAlign / samplesPerBlock);
+	adpcm.wfx.wBitsPerSample = 4;
+	adpcm.wfx.cbSize = static_cast<uint16_t>(format.size() - sizeof(Sqex::Sound::WaveFormatEx));
+	adpcm.wSamplesPerBlock = static_cast<short>(samplesPerBlock);
+	adpcm.wNumCoef = 7;
+	std::ranges::copy(MsAdpcmCoefficients, adpcm.aCoef);
+
+	const auto blockCount = samples.size() / Channels;
+	std::vector<uint8_t> data;
+	for (size_t from = 0; from < blockCount; from += samplesPerBlock) {
+		const auto count = std::min(samplesPerBlock, blockCount - from);
+		uint8_t predictors[Channels]{};
+		int deltas[Channels]{};
+		std::vector<uint8_t> nibbles[Channels];
+		std::vector<int> channelSamples[Channels];
+		for (size_t c = 0; c < Channels; ++c) {
+			for (size_t i = 0; i < std::max<size_t>(2, count); ++i)
+				channelSamples[c].push_back(static_cast<int>(std::clamp(std::round(samples[(from + std::min(i, count - 1)) * Channels + c] * 32768.), -32768., 32767.)));
+
+			auto bestError = std::numeric_limits<double>::infinity();
+			for (int predictor = 0; predictor < 7; ++predictor) {
+				for (const auto delta : { 16, 64, 256, 1024 }) {
+					if (const auto error = EncodeMsAdpcmChannel(std::span(channelSamples[c]).subspan(0, count), predictor, delta, nullptr); error < bestError) {
+						bestError = error;
+						predictors[c] = static_cast<uint8_t>(predictor);
+						deltas[c] = delta;
+					}
+				}
+			}
+			EncodeMsAdpcmChannel(std::span(channelSamples[c]).subspan(0, count), predictors[c], deltas[c], &nibbles[c]);
+		}
+
+		const auto insert16 = [&data](int v) {
+			data.push_back(static_cast<uint8_t>(v));
+			data.push_back(static_cast<uint8_t>(v >> 8));
+		};
+		for (const auto predictor : predictors)
+			data.push_back(predictor);
+		for (const auto delta : deltas)
+			insert16(delta);
+		for (size_t c = 0; c < Channels; ++c)
+			insert16(channelSamples[c][1]);
+		for (size_t c = 0; c < Channels; ++c)
+			insert16(channelSamples[c][0]);
+		for (size_t i = 0; i < nibbles[0].size(); ++i)
+			data.push_back(static_cast<uint8_t>((nibbles[0][i] << 4) | nibbles[1][i]));
+	}
+	return MakeWave(format, data);
+}
+
+static std::vector<uint8_t> MakeOggVorbis(const std::vector<float>& samples, uint32_t rate, uint32_t loopStart, uint32_t loopEnd) {
+	vorbis_info vi{};
+	vorbis_dsp_state vd{};
+	vorbis_block vb{};
+	ogg_stream_state os{};
+	vorbis_comment vc{};
+	vorbis_info_init(&vi);
+	vorbis_encode_init_vbr(&vi, 2, rate, 0.8f);
+	vorbis_comment_init(&vc);
+	vorbis_comment_add_tag(&vc, "LoopStart", std::format("{}", loopStart).c_str());
+	vorbis_comment_add_tag(&vc, "LoopEnd", std::format("{}", loopEnd).c_str());
+	vorbis_analysis_init(&vd, &vi);
+	vorbis_block_init(&vd, &vb);
+	ogg_stream_init(&os, 0);
+
+	std::vector<uint8_t> res;
+	ogg_page og{};
+	ogg_packet op{};
+	const auto appendPage = [&res, &og]() {
+		res.insert(res.end(), og.header, og.header + og.header_len);
+		res.insert(res.end(), og.body, og.body + og.body_len);
+	};
+
+	ogg_packet header{}, headerComments{}, headerCode{};
+	vorbis_analysis_headerout(&vd, &vc, &header, &headerComments, &headerCode);
+	ogg_stream_packetin(&os, &header);
+	ogg_stream_packetin(&os, &headerComments);
+	ogg_stream_packetin(&os, &headerCode);
+	while (ogg_stream_flush(&os, &og))
+		appendPage();
+
+	const auto blockCount = samples.size() / 2;
+	for (size_t from = 0; ; from += 4096) {
+		const auto count = std::min<size_t>(4096, blockCount - std::min(from, blockCount));
+		if (count) {
+			const auto buf = vorbis_analysis_buffer(&vd, static_cast<int>(count));
+			for (size_t i = 0; i < count; ++i) {
+				buf[0][i] = samples[(from + i) * 2];
+				buf[1][i] = samples[(from + i) * 2 + 1];
+			}
+		}
+		vorbis_analysis_wrote(&vd, static_cast<int>(count));
+		while (vorbis_analysis_blockout(&vd, &vb) == 1) {
+			vorbis_analysis(&vb, nullptr);
+			vorbis_bitrate_addblock(&vb);
+			while (vorbis_bitrate_flushpacket(&vd, &op)) {
+				ogg_stream_packetin(&os, &op);
+				while (ogg_stream_pageout(&os, &og))
+					appendPage();
+			}
+		}
+		if (!count)
+			break;
+	}
+	while (ogg_stream_flush(&os, &og))
+		appendPage();
+
+	ogg_stream_clear(&os);
+	vorbis_block_clear(&vb);
+	vorbis_dsp_clear(&vd);
+	vorbis_comment_clear(&vc);
+	vorbis_info_clear(&vi);
+	return res;
+}
+
+static std::vector<float> DecodeAll(Sqex::Sound::PcmDecoder& decoder, size_t chunkBlockCount) {
+	std::vector<float> res;
+	while (true) {
+		const auto read = decoder.Read(chunkBlockCount);
+		if (read.empty())
+			break;
+		if (read.size() > chunkBlockCount * decoder.GetChannels())
+			throw std::runtime_error("read more than requested");
+		res.insert(res.end(), read.begin(), read.end());
+	}
+	return res;
+}
+
+static double Rms(const std::vector<float>& a, const std::vector<float>& b, size_t from, size_t to) {
+	double sum = 0;
+	for (size_t i = from; i < to; ++i)
+		sum += std::pow(static_cast<double>(a[i]) - b[i], 2);
+	return to > from ? std::sqrt(sum / static_cast<double>(to - from)) : 0;
+}
+
+static size_t FirstBlockAbove(const std::vector<float>& samples, size_t channel, double threshold) {
+	for (size_t i = 0; i * 2 + channel < samples.size(); ++i) {
+		if (samples[i * 2 + channel] >= threshold)
+			return i;
+	}
+	return SIZE_MAX;
+}
+
+static std::shared_ptr<Sqex::RandomAccessStream> ToStream(std::vector<uint8_t> data) {
+	return std::make_shared<Sqex::MemoryRandomAccessStream>(std::move(data));
+}
+
+static bool IsLoopStartTag(const std::string& key) {
+	return std::ranges::equal(key, std::string_view("LoopStart"), [](char a, char b) {
+		return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+	});
+}
+
+int main(int argc, char** argv) {
+	const auto speedTestSeconds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60UL;
+
+	try {
+		auto success = true;
+		constexpr uint32_t SourceRate = 44100;
+		constexpr size_t LoopStart = 12345;
+		constexpr size_t BlockCount = SourceRate * 2 + 77;
+		const auto tone = MakeTone(SourceRate, BlockCount, LoopStart);
+
+		struct DecodeCase {
+			const char* Name;
+			std::vector<uint8_t> File;
+			double MaxRms;
+			size_t MaxOnsetError;  // lossy codecs take a few samples to follow a step
+			bool LoopTagged;
+		};
+		std::vector<DecodeCase> decodeCases;
+		decodeCases.emplace_back("pcm8", MakePcmWave(tone, SourceRate, Sqex::Sound::WaveFormatEx::FormatTag_Pcm, 8), 1. / 128, 0, false);
+		decodeCases.emplace_back("pcm16", MakePcmWave(tone, SourceRate, Sqex::Sound::WaveFormatEx::FormatTag_Pcm, 16), 1. / 32768, 0, false);
+		decodeCases.emplace_back("pcm24", MakePcmWave(tone, SourceRate, Sqex::Sound::WaveFormatEx::FormatTag_Pcm, 24), 1. / 8388608, 0, false);
+		decodeCases.emplace_back("float32", MakePcmWave(tone, SourceRate, Sqex::Sound::WaveFormatEx::FormatTag_IeeeFloat, 32), 1e-9, 0, false);
+		decodeCases.emplace_back("ms-adpcm", MakeMsAdpcmWave(tone, SourceRate, 1024), 0.01, 8, false);
+		decodeCases.emplace_back("vorbis", MakeOggVorbis(tone, SourceRate, LoopStart, BlockCount - 1), 0.02, 256, true);
+
+		for (const auto& [name, file, maxRms, maxOnsetError, loopTagged] : decodeCases) {
+			const auto decoder = Sqex::Sound::PcmDecoder::CreateNew(ToStream(file));
+			const auto decoded = DecodeAll(*decoder, 1000);
+			const auto rms = Rms(decoded, tone, 0, std::min(decoded.size(), tone.size()));
+			const auto onset = FirstBlockAbove(decoded, 0, 0.1);
+			std::cout << std::format("decode {:<8}: {} blocks (expected {}, reported {}), rms error {:.2e}, tone starts at {} (expected {})\n",
+				name, decoded.size() / 2, BlockCount, decoder->GetBlockCount(), rms, onset, LoopStart);
+			if (decoded.size() != tone.size() || decoder->GetBlockCount() != BlockCount) {
+				std::cout << "FAIL: sample count differs\n";
+				success = false;
+			}
+			if (rms > maxRms) {
+				std::cout << std::format("FAIL: rms error above {:.2e}\n", maxRms);
+				success = false;
+			}
+			if (onset + maxOnsetError < LoopStart || onset > LoopStart + maxOnsetError) {
+				std::cout << "FAIL: tone moved\n";
+				success = false;
+			}
+			const auto& tags = decoder->GetTags();
+			const auto loopStartTag = std::ranges::find_if(tags, [](const auto& tag) { return IsLoopStartTag(tag.first); });
+			if (loopStartTag != tags.end())
+				std::cout << std::format("decode {:<8}: LoopStart tag {} (expected {})\n", name, loopStartTag->second, LoopStart);
+			if (loopStartTag == tags.end() ? loopTagged : std::strtoul(loopStartTag->second.c_str(), nullptr, 10) != LoopStart) {
+				std::cout << "FAIL: LoopStart tag missing or differs\n";
+				success = false;
+			}
+		}
+
+		// The last pair has no small ratio, and uses interpolated filter coefficients.
+		for (const auto& [from, to] : std::vector<std::pair<uint32_t, uint32_t>>{ {44100, 48000}, {48000, 44100}, {32000, 44100}, {22050, 48000}, {48000, 32000}, {44100, 44101} }) {
+			const auto sourceBlockCount = from * 2 + 77;
+			const auto sourceLoopStart = from / 4 + 1;
+			const auto source = MakeTone(from, sourceBlockCount, sourceLoopStart);
+			const auto resampler = std::make_unique<Sqex::Sound::ResampledPcmDecoder>(Sqex::Sound::PcmDecoder::CreateNew(ToStream(MakePcmWave(source, from, Sqex::Sound::WaveFormatEx::FormatTag_IeeeFloat, 32))), to);
+			const auto resampled = DecodeAll(*resampler, 777);
+
+			const auto expectedBlockCount = (1ULL * sourceBlockCount * to + from - 1) / from;
+			const auto expectedLoopStart = 1ULL * sourceLoopStart * to / from;
+			std::vector<float> analytic(resampled.size());
+			for (size_t i = 0; i < analytic.size(); ++i)
+				analytic[i] = static_cast<float>(ToneAt(static_cast<double>(i / 2) / to, i % 2, static_cast<double>(sourceLoopStart) / from));
+
+			// Away from the onset and the end, where a band-limited signal can't follow a step.
+			const auto margin = static_cast<size_t>(to / 20);
+			const auto rms = Rms(resampled, analytic, (expectedLoopStart + margin) * 2, resampled.size() - margin * 2);
+			const auto onset = FirstBlockAbove(resampled, 0, 0.1);
+			std::cout << std::format("resample {:>5} -> {:>5}: {} blocks (expected {}, reported {}), rms error {:.2e} ({:.1f}dB), loop start {} (expected {})\n",
+				from, to, resampled.size() / 2, expectedBlockCount, resampler->GetBlockCount(), rms, 20 * std::log10(rms / Amplitudes[0]), onset, expectedLoopStart);
+			if (resampled.size() / 2 != expectedBlockCount || resampler->GetBlockCount() != expectedBlockCount) {
+				std::cout << "FAIL: sample count differs\n";
+				success = false;
+			}
+			if (rms > 1e-4) {
+				std::cout << "FAIL: rms error above 1e-4\n";
+				success = false;
+			}
+			if (onset + 1 < expectedLoopStart || onset > expectedLoopStart + 1) {
+				std::cout << "FAIL: loop start moved\n";
+				success = false;
+			}
+		}
+
+		{
+			const auto blockCount = SourceRate * static_cast<size_t>(speedTestSeconds);
+			const auto file = MakeMsAdpcmWave(MakeTone(SourceRate, blockCount, 0), SourceRate, 1024);
+			const auto start = std::chrono::steady_clock::now();
+			const auto resampler = std::make_unique<Sqex::Sound::ResampledPcmDecoder>(Sqex::Sound::PcmDecoder::CreateNew(ToStream(file)), 48000);
+			size_t total = 0;
+			while (true) {
+				const auto read = resampler->Read(8192);
+				if (read.empty())
+					break;
+				total += read.size();
+			}
+			const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << std::format("speed: {}s of stereo ms-adpcm at 44100Hz decoded and resampled to 48000Hz in {:.3f}s ({:.0f}x realtime, {} samples)\n",
+				speedTestSeconds, elapsed, speedTestSeconds / elapsed, total);
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
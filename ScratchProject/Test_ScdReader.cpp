@@ -0,0 +1,186 @@
+#include "pch.h"
+
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Sound/Reader.h>
+#include <XivAlexanderCommon/Sqex/Sound/Writer.h>
+
+// Writes synthetic .scd files holding Ogg and MS-ADPCM sound entries of increasing sample data size, and enumerates
+// their sound entries through Sqex::Sound::ScdReader, counting bytes read from the file: how it used to be done (every
+// entry read as a whole), and how it is now (headers read, sample data left in the file until asked for). Then checks
+// that the sample data read on demand is what was written.
+// Usage: ScratchProject [largest sample data size per entry in MiB]
+
+class CountingStream : public Sqex::RandomAccessStream {
+	const std::shared_ptr<const Sqex::RandomAccessStream> m_stream;
+
+public:
+	mutable std::atomic_uint64_t BytesRead = 0;
+	mutable std::atomic_uint64_t Reads = 0;
+
+	CountingStream(std::shared_ptr<const Sqex::RandomAccessStream> stream)
+		: m_stream(std::move(stream)) {
+	}
+
+	[[nodiscard]] uint64_t StreamSize() const override {
+		return m_stream->StreamSize();
+	}
+
+	uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+		const auto read = m_stream->ReadStreamPartial(offset, buf, length);
+		BytesRead += read;
+		++Reads;
+		return read;
+	}
+};
+
+struct SyntheticEntry {
+	std::vector<uint8_t> Data;
+	std::vector<uint8_t> VorbisHeader;
+	std::set<uint32_t> Marks;
+	bool Ogg;
+};
+
+static Sqex::Sound::ScdWriter::SoundEntry MakeSoundEntry(const SyntheticEntry& synthetic) {
+	using namespace Sqex::Sound;
+
+	ScdWriter::SoundEntry entry;
+	if (synthetic.Ogg) {
+		// Kept the same size regardless of data size, so that only sample data grows.
+		std::vector<uint32_t> seekTable;
+		for (size_t i = 0; i < 16; ++i)
+			seekTable.push_back(static_cast<uint32_t>(synthetic.Data.size() * i / 16));
+		entry = ScdWriter::SoundEntry::FromOgg(synthetic.VorbisHeader, synthetic.Data, 2, 44100, 0, static_cast<uint32_t>(synthetic.Data.size()), std::span(seekTable));
+	} else {
+		ADPCMWAVEFORMAT format{};
+		format.wfx.wFormatTag = WaveFormatEx::FormatTag_MsAdpcm;
+		format.wfx.nChannels = 2;
+		format.wfx.nSamplesPerSec = 44100;
+		format.wfx.cbSize = sizeof(ADPCMWAVEFORMAT) - sizeof(WaveFormatEx);
+		entry.Header = {
+			.ChannelCount = 2,
+			.SamplingRate = 44100,
+			.Format = SoundEntryHeader::EntryFormat_WaveFormatAdpcm,
+		};
+		entry.ExtraData.resize(sizeof format);
+		memcpy(&entry.ExtraData[0], &format, sizeof format);
+		entry.Data = synthetic.Data;
+	}
+
+	auto& mark = entry.AuxChunks[std::string(SoundEntryAuxChunk::Name_Mark, sizeof SoundEntryAuxChunk::Name_Mark)];
+	mark.resize((3 + synthetic.Marks.size()) * 4);
+	reinterpret_cast<uint32_t*>(&mark[0])[2] = static_cast<uint32_t>(synthetic.Marks.size());
+	std::ranges::copy(synthetic.Marks, reinterpret_cast<uint32_t*>(&mark[0]) + 3);
+	return entry;
+}
+
+// How sound entries used to be read: each of them, sample data included, into its own buffer.
+static size_t ReadEntriesAsWhole(const Sqex::RandomAccessStream& stream) {
+	const auto header = stream.ReadStream<Sqex::Sound::ScdHeader>(0);
+	const auto offsets = stream.ReadStream<Sqex::Sound::Offsets>(header.HeaderSize);
+	const auto entryOffsets = stream.ReadStreamIntoVector<uint32_t>(offsets.SoundEntryOffset, offsets.SoundEntryCount);
+	size_t channels = 0;
+	for (size_t i = 0; i < entryOffsets.size(); ++i) {
+		const auto next = i + 1 < entryOffsets.size() ? entryOffsets[i + 1] : header.FileSize.Value();
+		const auto buffer = stream.ReadStreamIntoVector<uint8_t>(entryOffsets[i], next - entryOffsets[i]);
+		channels += reinterpret_cast<const Sqex::Sound::SoundEntryHeader*>(&buffer[0])->ChannelCount;
+	}
+	return channels;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto maxDataSize = (argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 64U) << 20;
+
+	try {
+		std::mt19937_64 rng(0);
+		auto success = true;
+
+		for (size_t dataSize = 16384; dataSize <= maxDataSize; dataSize *= 16) {
+			std::vector<SyntheticEntry> synthetic(4);
+			Sqex::Sound::ScdWriter writer;
+			for (size_t i = 0; i < synthetic.size(); ++i) {
+				auto& entry = synthetic[i];
+				entry.Ogg = i % 2 == 0;
+				entry.Data.resize(dataSize);
+				for (auto& b : entry.Data)
+					b = static_cast<uint8_t>(rng());
+				if (entry.Ogg) {
+					entry.VorbisHeader.resize(3000 + rng() % 1000);
+					for (auto& b : entry.VorbisHeader)
+						b = static_cast<uint8_t>(rng());
+				}
+				for (size_t j = 0; j < 8; ++j)
+					entry.Marks.insert(static_cast<uint32_t>(rng() % dataSize));
+				writer.SetSoundEntry(i, MakeSoundEntry(entry));
+			}
+			const auto file = std::make_shared<Sqex::MemoryRandomAccessStream>(writer.Export());
+
+			const auto before = std::make_shared<CountingStream>(file);
+			auto start = std::chrono::steady_clock::now();
+			const auto beforeChannels = ReadEntriesAsWhole(*before);
+			const auto beforeTime = std::chrono::steady_clock::now() - start;
+
+			const auto after = std::make_shared<CountingStream>(file);
+			start = std::chrono::steady_clock::now();
+			const auto reader = Sqex::Sound::ScdReader(after);
+			const auto entries = reader.ReadSoundEntries();
+			size_t afterChannels = 0;
+			std::vector<std::set<uint32_t>> marks;
+			for (const auto& entry : entries) {
+				afterChannels += entry.Header->ChannelCount;
+				marks.emplace_back(entry.GetMarkedSampleBlockIndices());
+				if (entry.Header->Format == Sqex::Sound::SoundEntryHeader::EntryFormat_Ogg)
+					void(entry.GetOggSeekTable());
+			}
+			const auto afterTime = std::chrono::steady_clock::now() - start;
+			const auto afterBytesRead = after->BytesRead.load();
+
+			std::cout << std::format("{:>6} KiB per entry, file {:>7} KiB: before {:>9} bytes read in {:>8.3f}ms, after {:>6} bytes read in {} reads in {:>6.3f}ms\n",
+				dataSize >> 10, file->StreamSize() >> 10,
+				before->BytesRead.load(), std::chrono::duration<double, std::milli>(beforeTime).count(),
+				afterBytesRead, after->Reads.load(), std::chrono::duration<double, std::milli>(afterTime).count());
+
+			if (beforeChannels != afterChannels || entries.size() != synthetic.size()) {
+				std::cout << "FAIL: entries differ\n";
+				success = false;
+			}
+			if (afterBytesRead >= 65536) {
+				std::cout << "FAIL: enumeration read sample data\n";
+				success = false;
+			}
+
+			for (size_t i = 0; i < entries.size() && i < synthetic.size(); ++i) {
+				if (marks[i] != synthetic[i].Marks) {
+					std::cout << std::format("FAIL: marks of entry #{} differ\n", i);
+					success = false;
+				}
+				if (entries[i].Data->StreamSize() != synthetic[i].Data.size()
+					|| entries[i].Data->ReadStreamIntoVector<uint8_t>(0) != synthetic[i].Data) {
+					std::cout << std::format("FAIL: sample data of entry #{} differs\n", i);
+					success = false;
+				}
+
+				if (synthetic[i].Ogg) {
+					auto expected = synthetic[i].VorbisHeader;
+					expected.insert(expected.end(), synthetic[i].Data.begin(), synthetic[i].Data.end());
+					if (entries[i].GetOggFile() != expected) {
+						std::cout << std::format("FAIL: ogg file of entry #{} differs\n", i);
+						success = false;
+					}
+				} else {
+					const auto wav = entries[i].GetMsAdpcmWavFile();
+					if (wav.size() < synthetic[i].Data.size() || !std::equal(synthetic[i].Data.begin(), synthetic[i].Data.end(), wav.end() - static_cast<ptrdiff_t>(synthetic[i].Data.size()))) {
+						std::cout << std::format("FAIL: wav file of entry #{} differs\n", i);
+						success = false;
+					}
+				}
+			}
+		}
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+
+#include <Psapi.h>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Sound/Reader.h>
+#include <XivAlexanderCommon/Sqex/Sound/Writer.h>
+
+// Makes sound entries holding several hundred MiB of sample data in total, and writes a .scd file out of them for each
+// of a few targets like MusicImporter does: through ScdWriter::ExportStream, sharing the sample data between targets
+// and writing the file in chunks, and how it used to be done, giving every target its own copy of the sound entries
+// and assembling the whole file in memory before writing it. Reports export time and peak memory use of each, and
+// checks that both produce the same bytes.
+// Usage: ScratchProject [total sample data size in MiB] [directory to write to]
+
+static constexpr size_t TargetCount = 2;
+static constexpr size_t EntryCount = 4;
+
+static size_t PeakWorkingSetSize() {
+	PROCESS_MEMORY_COUNTERS pmc{ sizeof pmc };
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof pmc))
+		throw std::runtime_error("GetProcessMemoryInfo failed");
+	return pmc.PeakWorkingSetSize;
+}
+
+static size_t WorkingSetSize() {
+	PROCESS_MEMORY_COUNTERS pmc{ sizeof pmc };
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof pmc))
+		throw std::runtime_error("GetProcessMemoryInfo failed");
+	return pmc.WorkingSetSize;
+}
+
+static Sqex::Sound::ScdWriter::SoundEntry MakeSoundEntry(std::mt19937_64& rng, size_t dataSize) {
+	using namespace Sqex::Sound;
+
+	ADPCMWAVEFORMAT format{};
+	format.wfx.wFormatTag = WaveFormatEx::FormatTag_MsAdpcm;
+	format.wfx.nChannels = 2;
+	format.wfx.nSamplesPerSec = 44100;
+	format.wfx.cbSize = sizeof(ADPCMWAVEFORMAT) - sizeof(WaveFormatEx);
+
+	ScdWriter::SoundEntry entry;
+	entry.Header = {
+		.ChannelCount = 2,
+		.SamplingRate = 44100,
+		.Format = SoundEntryHeader::EntryFormat_WaveFormatAdpcm,
+	};
+	entry.ExtraData.resize(sizeof format);
+	memcpy(&entry.ExtraData[0], &format, sizeof format);
+
+	entry.Data.resize(dataSize);
+	for (auto& v : span_cast<uint64_t>(entry.Data, 0, dataSize / sizeof uint64_t))
+		v = rng();
+
+	auto& mark = entry.AuxChunks[std::string(SoundEntryAuxChunk::Name_Mark, sizeof SoundEntryAuxChunk::Name_Mark)];
+	mark.resize(4 * 4);
+	reinterpret_cast<uint32_t*>(&mark[0])[2] = 1;
+	reinterpret_cast<uint32_t*>(&mark[0])[3] = static_cast<uint32_t>(rng() % dataSize);
+	return entry;
+}
+
+static Sqex::Sound::ScdWriter MakeWriter(std::mt19937_64& rng) {
+	std::vector<std::vector<uint8_t>> table1(EntryCount), table2(EntryCount), table4(EntryCount);
+	for (auto* table : { &table1, &table2, &table4 }) {
+		for (auto& item : *table) {
+			item.resize(0x40 + rng() % 0x40);
+			for (auto& b : item)
+				b = static_cast<uint8_t>(rng());
+		}
+	}
+
+	Sqex::Sound::ScdWriter writer;
+	writer.SetTable1(std::move(table1));
+	writer.SetTable2(std::move(table2));
+	writer.SetTable4(std::move(table4));
+	return writer;
+}
+
+static void WriteStream(const std::filesystem::path& path, const Sqex::RandomAccessStream& data) {
+	std::ofstream out(path, std::ios::binary);
+	std::vector<char> buf(65536);
+	Sqex::Align<uint64_t>(data.StreamSize(), buf.size()).IterateChunked([&](uint64_t, uint64_t offset, uint64_t size) {
+		data.ReadStream(offset, &buf[0], size);
+		out.write(&buf[0], static_cast<std::streamsize>(size));
+	});
+	if (!out)
+		throw std::runtime_error(std::format("failed to write to {}", path.string()));
+}
+
+static double Milliseconds(std::chrono::steady_clock::duration d) {
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto dataSize = (argc > 1 ? static_cast<size_t>(std::wcstoul(argv[1], nullptr, 10)) : 512U) << 20;
+	const auto directory = argc > 2 ? std::filesystem::path(argv[2]) : std::filesystem::temp_directory_path() / "Test_ScdWriter";
+
+	try {
+		auto success = true;
+		create_directories(directory);
+
+		std::mt19937_64 rng(0);
+		std::vector<Sqex::Sound::ScdWriter::SoundEntry> entries;
+		for (size_t i = 0; i < EntryCount; ++i)
+			entries.emplace_back(MakeSoundEntry(rng, dataSize / EntryCount));
+		const auto writerTemplate = MakeWriter(rng);
+
+		// Peak working set size only ever grows, so the one expected to use less memory goes first.
+		auto baseline = WorkingSetSize();
+		auto start = std::chrono::steady_clock::now();
+		for (auto& entry : entries)
+			entry.ShareData();
+		for (size_t target = 0; target < TargetCount; ++target) {
+			auto writer = writerTemplate;
+			for (size_t i = 0; i < entries.size(); ++i)
+				writer.SetSoundEntry(i, entries[i]);
+			WriteStream(directory / std::format("streamed{}.scd", target), *writer.ExportStream());
+		}
+		const auto streamedTime = std::chrono::steady_clock::now() - start;
+		const auto streamedPeak = PeakWorkingSetSize() - baseline;
+
+		baseline = WorkingSetSize();
+		start = std::chrono::steady_clock::now();
+		for (size_t target = 0; target < TargetCount; ++target) {
+			auto writer = writerTemplate;
+			for (size_t i = 0; i < entries.size(); ++i) {
+				auto entry = entries[i];
+				entry.Data = entry.DataStream->ReadStreamIntoVector<uint8_t>(0);
+				entry.DataStream = nullptr;
+				writer.SetSoundEntry(i, std::move(entry));
+			}
+			const auto data = writer.Export();
+			std::ofstream(directory / std::format("assembled{}.scd", target), std::ios::binary).write(reinterpret_cast<const char*>(&data[0]), static_cast<std::streamsize>(data.size()));
+		}
+		const auto assembledTime = std::chrono::steady_clock::now() - start;
+		const auto assembledPeak = PeakWorkingSetSize() - baseline;
+
+		std::cout << std::format("{} targets of {} MiB of sample data each\n", TargetCount, dataSize >> 20);
+		std::cout << std::format("streamed : {:>10.3f}ms, peak working set {:>6} MiB over baseline\n", Milliseconds(streamedTime), streamedPeak >> 20);
+		std::cout << std::format("assembled: {:>10.3f}ms, peak working set {:>6} MiB over baseline\n", Milliseconds(assembledTime), assembledPeak >> 20);
+		if (streamedPeak > 64U << 20) {
+			std::cout << "FAIL: streamed export held too much in memory\n";
+			success = false;
+		}
+
+		for (size_t target = 0; target < TargetCount; ++target) {
+			const auto streamedPath = directory / std::format("streamed{}.scd", target);
+			const auto assembledPath = directory / std::format("assembled{}.scd", target);
+			std::ifstream streamedFile(streamedPath, std::ios::binary), assembledFile(assembledPath, std::ios::binary);
+			std::vector<char> buf1(1 << 20), buf2(1 << 20);
+			while (streamedFile && assembledFile) {
+				streamedFile.read(&buf1[0], static_cast<std::streamsize>(buf1.size()));
+				assembledFile.read(&buf2[0], static_cast<std::streamsize>(buf2.size()));
+				if (streamedFile.gcount() != assembledFile.gcount() || !std::equal(buf1.begin(), buf1.begin() + streamedFile.gcount(), buf2.begin())) {
+					std::cout << std::format("FAIL: files of target #{} differ\n", target);
+					success = false;
+					break;
+				}
+			}
+			if (streamedFile.good() != assembledFile.good()) {
+				std::cout << std::format("FAIL: files of target #{} differ in size\n", target);
+				success = false;
+			}
+		}
+
+		// Reads in chunks of an odd size, so that they straddle the boundaries between headers and sample data.
+		{
+			auto writer = writerTemplate;
+			for (size_t i = 0; i < entries.size(); ++i)
+				writer.SetSoundEntry(i, entries[i]);
+			const auto stream = writer.ExportStream();
+			const auto file = std::make_shared<Sqex::FileRandomAccessStream>(directory / "assembled0.scd");
+			if (stream->StreamSize() != file->StreamSize()) {
+				std::cout << "FAIL: stream size differs\n";
+				success = false;
+			} else {
+				std::vector<uint8_t> buf1(65521), buf2(65521);
+				Sqex::Align<uint64_t>(stream->StreamSize(), buf1.size()).IterateChunkedBreakable([&](uint64_t, uint64_t offset, uint64_t size) {
+					stream->ReadStream(offset, &buf1[0], size);
+					file->ReadStream(offset, &buf2[0], size);
+					if (!std::equal(buf1.begin(), buf1.begin() + static_cast<ptrdiff_t>(size), buf2.begin())) {
+						std::cout << std::format("FAIL: {} bytes from offset {} differ\n", size, offset);
+						success = false;
+						return false;
+					}
+					return true;
+				});
+			}
+
+			const auto readEntries = Sqex::Sound::ScdReader(file).ReadSoundEntries();
+			if (readEntries.size() != entries.size()) {
+				std::cout << std::format("FAIL: {} sound entries read, expected {}\n", readEntries.size(), entries.size());
+				success = false;
+			}
+			for (size_t i = 0; i < readEntries.size() && i < entries.size(); ++i) {
+				if (readEntries[i].Data->StreamSize() != entries[i].GetDataSize()) {
+					std::cout << std::format("FAIL: sample data of entry #{} differs in size\n", i);
+					success = false;
+				}
+			}
+		}
+
+		std::filesystem::remove_all(directory);
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/SignatureScanner.h>
+
+// Checks that Utils::SignatureScanner::Scan finds the same matches as ScanNaive on small random buffers over a small alphabet,
+// and on a large random image with patterns planted across block boundaries; then compares how long each takes on the image.
+// Uses no Windows headers or precompiled header, so that it can be built along with SignatureScanner.cpp anywhere.
+// Usage: ScratchProject [image size in MiB] [pattern count]
+
+int main(int argc, char** argv) {
+	const auto imageSize = (argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 32U) << 20;
+	const auto patternCount = argc > 2 ? static_cast<size_t>(std::strtoul(argv[2], nullptr, 10)) : 16U;
+
+	try {
+		std::mt19937 rng(0);
+		auto success = true;
+
+		for (size_t iteration = 0; iteration < 20000; ++iteration) {
+			std::vector<uint8_t> data(rng() % 300);
+			for (auto& b : data)
+				b = static_cast<uint8_t>(rng() % 4);
+
+			Utils::SignatureScanner scanner;
+			for (auto n = 1 + rng() % 5; n; --n) {
+				std::string pattern(1 + rng() % 8, '\0'), mask(pattern.size(), '\0');
+				for (size_t i = 0; i < pattern.size(); ++i) {
+					pattern[i] = static_cast<char>(rng() % 4);
+					switch (rng() % 4) {
+						case 0: mask[i] = 0; break;
+						case 1: mask[i] = static_cast<char>(rng()); break;
+						default: mask[i] = static_cast<char>(0xFF);
+					}
+				}
+				scanner.Add(pattern, mask);
+			}
+
+			if (scanner.Scan(data) != scanner.ScanNaive(data)) {
+				std::cout << "FAIL: results differ at iteration " << iteration << "\n";
+				success = false;
+				break;
+			}
+		}
+
+		std::vector<uint8_t> image(imageSize);
+		for (auto& b : image)
+			b = static_cast<uint8_t>(rng());
+
+		Utils::SignatureScanner scanner;
+		std::vector<std::vector<size_t>> planted(patternCount);
+		for (size_t i = 0; i < patternCount; ++i) {
+			std::string pattern(16 + rng() % 24, '\0'), mask(pattern.size(), static_cast<char>(0xFF));
+			for (auto& c : pattern)
+				c = static_cast<char>(rng());
+			for (auto n = rng() % 8; n; --n)
+				mask[rng() % mask.size()] = 0;
+			scanner.Add(pattern, mask);
+
+			for (size_t j = 0; j < 4; ++j) {
+				const auto offset = j == 0
+					? ((i + 1) * Utils::SignatureScanner::BlockSize - pattern.size() / 2) % (image.size() - pattern.size())
+					: rng() % (image.size() - pattern.size());
+				std::copy_n(pattern.begin(), pattern.size(), &image[offset]);
+				planted[i].push_back(offset);
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		const auto actual = scanner.Scan(image);
+		const auto scanTime = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		const auto expected = scanner.ScanNaive(image);
+		const auto naiveTime = std::chrono::steady_clock::now() - start;
+
+		if (actual != expected) {
+			std::cout << "FAIL: results differ on image\n";
+			success = false;
+		}
+		for (size_t i = 0; i < patternCount; ++i) {
+			for (const auto offset : planted[i]) {
+				if (std::ranges::find(actual[i], offset) == actual[i].end()) {
+					std::cout << "FAIL: pattern " << i << " not found at 0x" << std::hex << offset << std::dec << "\n";
+					success = false;
+				}
+			}
+		}
+
+		std::cout << (image.size() >> 20) << " MiB, " << patternCount << " patterns; "
+			<< "Scan " << std::chrono::duration<double, std::milli>(scanTime).count() << "ms, "
+			<< "ScanNaive " << std::chrono::duration<double, std::milli>(naiveTime).count() << "ms\n";
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
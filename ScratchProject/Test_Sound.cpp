@@ -120,10 +120,11 @@ int main() {
 						resolved |= importer.ResolveSources(dirName, dirPath);
 					if (!resolved)
 						throw std::runtime_error("Not all source files are found");
-					importer.Merge([](std::filesystem::path path, std::vector<uint8_t> data) {
+					importer.Merge([](const std::filesystem::path& path, const Sqex::RandomAccessStream& data) {
 						const auto targetPath = std::filesystem::path(std::format(LR"(C:\Users\SP\AppData\Roaming\XivAlexander\ReplacementFileEntries\{0})", path.wstring()));
 						create_directories(targetPath.parent_path());
-						Utils::Win32::Handle::FromCreateFile(targetPath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, 0).Write(0, std::span(data));
+						const auto buf = data.ReadStreamIntoVector<uint8_t>(0);
+						Utils::Win32::Handle::FromCreateFile(targetPath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, 0).Write(0, std::span(buf));
 						});
 				} catch (const std::exception& e) {
 					std::cout << std::format("Error on {}: {}\n", target.path.front(), e.what());
@@ -0,0 +1,183 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex.h>
+#include <XivAlexanderCommon/Sqex/Texture/Mipmap.h>
+#include <XivAlexanderCommon/Utils/Dxt.h>
+#include <XivAlexanderCommon/Utils/DxtDecoder.h>
+
+// Measures conversion speed of MemoryBackedMipmap::NewARGB8888From for every supported format in megapixels per second,
+// and checks that every DXT decoder implementation produces the same pixels as the original per-block decoders.
+// Usage: ScratchProject [width] [height] [repeat count]
+
+static std::vector<uint8_t> RandomBytes(size_t length, uint32_t seed) {
+	std::vector<uint8_t> res(length);
+	auto state = seed * 2654435761U + 1;
+	for (auto& b : res) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		b = static_cast<uint8_t>(state);
+	}
+	return res;
+}
+
+static std::vector<uint8_t> RandomHalfFloats(size_t count, uint32_t seed) {
+	// Keep values in [0, 2) so that clamping is exercised without producing NaNs.
+	auto res = RandomBytes(count * 2, seed);
+	for (size_t i = 1; i < res.size(); i += 2)
+		res[i] &= 0x3F;
+	return res;
+}
+
+static std::vector<uint8_t> RandomFloats(size_t count, uint32_t seed) {
+	const auto bytes = RandomBytes(count, seed);
+	std::vector<uint8_t> res(count * sizeof(float));
+	const auto view = span_cast<float>(res);
+	for (size_t i = 0; i < count; ++i)
+		view[i] = static_cast<float>(bytes[i]) / 200.f;
+	return res;
+}
+
+// DecompressBlockDXT1 and DecompressBlockDXT5 pack pixels as 0xRRGGBBAA; repack them into RGBA8888.
+static void RepackReference(std::vector<uint32_t>& pixels) {
+	for (auto& p : pixels)
+		p = Sqex::Texture::RGBA8888(p >> 24, (p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF).Value;
+}
+
+// DecompressBlockDXT1 decodes the fourth color of three color blocks into opaque black, but it is transparent black.
+static void ClearTransparentReferencePixels(uint32_t width, uint32_t height, const std::vector<uint8_t>& blocks, std::vector<uint32_t>& pixels) {
+	for (uint32_t by = 0; by < height / 4; ++by) {
+		for (uint32_t bx = 0; bx < width / 4; ++bx) {
+			const auto block = &blocks[(static_cast<size_t>(by) * (width / 4) + bx) * 8];
+			const auto color0 = block[0] | block[1] << 8;
+			const auto color1 = block[2] | block[3] << 8;
+			if (color0 > color1)
+				continue;
+			const auto code = static_cast<uint32_t>(block[4] | block[5] << 8 | block[6] << 16 | block[7] << 24);
+			for (uint32_t i = 0; i < 16; ++i) {
+				if (((code >> (2 * i)) & 3) == 3)
+					pixels[static_cast<size_t>(by * 4 + i / 4) * width + bx * 4 + i % 4] = 0;
+			}
+		}
+	}
+}
+
+// Decodes single blocks of known colors, and checks each channel.
+static bool TestChannelOrder() {
+	auto success = true;
+	const auto check = [&](const char* name, const uint8_t* block, void(*decode)(uint32_t, uint32_t, uint32_t, uint32_t, const uint8_t*, uint32_t*, Utils::DxtDecoderIsa), Sqex::Texture::RGBA8888 expected) {
+		for (const auto isa : {Utils::DxtDecoderIsa::Scalar, Utils::DxtDecoderIsa::Sse2, Utils::DxtDecoderIsa::Avx2}) {
+			if (Utils::ResolveDxtDecoderIsa(isa) != isa)
+				continue;
+			uint32_t pixels[16];
+			decode(4, 4, 0, 1, block, pixels, isa);
+			const auto actual = Sqex::Texture::RGBA8888(pixels[0]);
+			if (actual.R != expected.R || actual.G != expected.G || actual.B != expected.B || actual.A != expected.A) {
+				std::cout << std::format("FAIL: {} ({}): got R={} G={} B={} A={}, expected R={} G={} B={} A={}\n",
+					name, Utils::DxtDecoderIsaName(isa),
+					static_cast<uint32_t>(actual.R), static_cast<uint32_t>(actual.G), static_cast<uint32_t>(actual.B), static_cast<uint32_t>(actual.A),
+					static_cast<uint32_t>(expected.R), static_cast<uint32_t>(expected.G), static_cast<uint32_t>(expected.B), static_cast<uint32_t>(expected.A));
+				success = false;
+			}
+		}
+	};
+
+	// color0 = pure red in R5G6B5, color1 = black, and every index 0.
+	const uint8_t dxt1Red[8]{0x00, 0xF8, 0x00, 0x00, 0, 0, 0, 0};
+	check("DXT1 red", dxt1Red, Utils::DecompressBlockRowsDXT1, {255, 0, 0, 255});
+
+	// Three color mode, with every index 3.
+	const uint8_t dxt1Transparent[8]{0x00, 0x00, 0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF};
+	check("DXT1 transparent", dxt1Transparent, Utils::DecompressBlockRowsDXT1, {0, 0, 0, 0});
+
+	// Alpha nibbles of 0x8, and color0 = pure blue.
+	const uint8_t dxt3Blue[16]{0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x1F, 0x00, 0x00, 0x00, 0, 0, 0, 0};
+	check("DXT3 blue", dxt3Blue, Utils::DecompressBlockRowsDXT3, {0, 0, 255, 0x88});
+
+	// alpha0 = 0x40, and color0 = pure green.
+	const uint8_t dxt5Green[16]{0x40, 0x00, 0, 0, 0, 0, 0, 0, 0xE0, 0x07, 0x00, 0x00, 0, 0, 0, 0};
+	check("DXT5 green", dxt5Green, Utils::DecompressBlockRowsDXT5, {0, 255, 0, 0x40});
+
+	return success;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	const auto width = argc > 1 ? std::wcstoul(argv[1], nullptr, 10) : 4096UL;
+	const auto height = argc > 2 ? std::wcstoul(argv[2], nullptr, 10) : 4096UL;
+	const auto repeat = argc > 3 ? std::wcstoul(argv[3], nullptr, 10) : 10UL;
+	const auto pixelCount = static_cast<size_t>(width) * height;
+
+	std::cout << std::format("{}x{}, repeated {} time(s); DXT decoder: {}\n", width, height, repeat, Utils::DxtDecoderIsaName(Utils::ResolveDxtDecoderIsa()));
+	auto success = TestChannelOrder();
+
+	const std::pair<Sqex::Texture::Format, const char*> formats[]{
+		{Sqex::Texture::Format::L8, "L8"},
+		{Sqex::Texture::Format::A8, "A8"},
+		{Sqex::Texture::Format::A4R4G4B4, "A4R4G4B4"},
+		{Sqex::Texture::Format::A1R5G5B5, "A1R5G5B5"},
+		{Sqex::Texture::Format::A8R8G8B8, "A8R8G8B8"},
+		{Sqex::Texture::Format::X8R8G8B8, "X8R8G8B8"},
+		{Sqex::Texture::Format::A16B16G16R16F, "A16B16G16R16F"},
+		{Sqex::Texture::Format::A32B32G32R32F, "A32B32G32R32F"},
+		{Sqex::Texture::Format::DXT1, "DXT1"},
+		{Sqex::Texture::Format::DXT3, "DXT3"},
+		{Sqex::Texture::Format::DXT5, "DXT5"},
+		{Sqex::Texture::Format::BC7, "BC7"},
+	};
+	for (const auto& [format, name] : formats) {
+		const auto length = Sqex::Texture::RawDataLength(format, width, height, 1);
+		auto data = format == Sqex::Texture::Format::A16B16G16R16F ? RandomHalfFloats(pixelCount * 4, 1)
+			: format == Sqex::Texture::Format::A32B32G32R32F ? RandomFloats(pixelCount * 4, 1)
+			: RandomBytes(length, 1);
+		const auto source = std::make_shared<Sqex::Texture::MemoryBackedMipmap>(width, height, 1, format, std::move(data));
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < repeat; ++i)
+			void(Sqex::Texture::MemoryBackedMipmap::NewARGB8888From(source.get()));
+		const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("{:>16}: {:10.1f} MP/s\n", name, static_cast<double>(pixelCount) * repeat / elapsed / 1000000.);
+	}
+
+	std::cout << "\nSingle-threaded DXT decoders:\n";
+	const auto dxtWidth = width / 4 * 4, dxtHeight = height / 4 * 4;
+	for (const auto& [format, name] : formats) {
+		const auto decode = format == Sqex::Texture::Format::DXT1 ? Utils::DecompressBlockRowsDXT1
+			: format == Sqex::Texture::Format::DXT3 ? Utils::DecompressBlockRowsDXT3
+			: format == Sqex::Texture::Format::DXT5 ? Utils::DecompressBlockRowsDXT5
+			: nullptr;
+		if (!decode)
+			continue;
+
+		const auto data = RandomBytes(Sqex::Texture::RawDataLength(format, dxtWidth, dxtHeight, 1), 2);
+		std::vector<uint32_t> reference(static_cast<size_t>(dxtWidth) * dxtHeight);
+		if (format == Sqex::Texture::Format::DXT1) {
+			Utils::BlockDecompressImageDXT1(dxtWidth, dxtHeight, &data[0], &reference[0]);
+			RepackReference(reference);
+			ClearTransparentReferencePixels(dxtWidth, dxtHeight, data, reference);
+		} else if (format == Sqex::Texture::Format::DXT5) {
+			Utils::BlockDecompressImageDXT5(dxtWidth, dxtHeight, &data[0], &reference[0]);
+			RepackReference(reference);
+		} else
+			decode(dxtWidth, dxtHeight, 0, dxtHeight / 4, &data[0], &reference[0], Utils::DxtDecoderIsa::Scalar);
+
+		for (const auto isa : {Utils::DxtDecoderIsa::Scalar, Utils::DxtDecoderIsa::Sse2, Utils::DxtDecoderIsa::Avx2}) {
+			if (Utils::ResolveDxtDecoderIsa(isa) != isa) {
+				std::cout << std::format("{:>16}: {:>6}: not supported\n", name, Utils::DxtDecoderIsaName(isa));
+				continue;
+			}
+
+			std::vector<uint32_t> decoded(reference.size());
+			const auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < repeat; ++i)
+				decode(dxtWidth, dxtHeight, 0, dxtHeight / 4, &data[0], &decoded[0], isa);
+			const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::cout << std::format("{:>16}: {:>6}: {:10.1f} MP/s{}\n", name, Utils::DxtDecoderIsaName(isa),
+				static_cast<double>(decoded.size()) * repeat / elapsed / 1000000.,
+				decoded == reference ? "" : " (MISMATCH)");
+			success &= decoded == reference;
+		}
+	}
+
+	std::cout << (success ? "PASS\n" : "FAIL\n");
+	return success ? 0 : 1;
+}
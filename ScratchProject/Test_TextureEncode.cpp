@@ -0,0 +1,134 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex.h>
+#include <XivAlexanderCommon/Sqex/Texture/Encoder.h>
+#include <XivAlexanderCommon/Sqex/Texture/Mipmap.h>
+#include <XivAlexanderCommon/Sqex/Texture/ModifiableTextureStream.h>
+#include <XivAlexanderCommon/Utils/DxtDecoder.h>
+
+// Encodes a texture into every supported block compressed format and preset, and reports
+// PSNR of the first mipmap against the source, and encoding throughput in megapixels per second including mipmap generation.
+// Also checks that BC1 keeps pixels with alpha below 128 transparent, and the others opaque.
+// Usage: ScratchProject [path/to/texture.tex]
+// Without a path, a synthetic 2048x2048 image with gradients, edges, noise, and varying alpha is used.
+
+static std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> SyntheticImage(size_t width, size_t height) {
+	auto res = std::make_shared<Sqex::Texture::MemoryBackedMipmap>(width, height, 1, Sqex::Texture::Format::A8R8G8B8);
+	const auto view = res->View<Sqex::Texture::RGBA8888>();
+	uint32_t noise = 1;
+	for (size_t y = 0; y < height; ++y) {
+		for (size_t x = 0; x < width; ++x) {
+			noise ^= noise << 13;
+			noise ^= noise >> 17;
+			noise ^= noise << 5;
+			const auto r = 128. + 100. * std::sin(x * 0.05) * std::cos(y * 0.03) + static_cast<int>(noise % 9) - 4;
+			const auto g = 255. * x / width;
+			const auto b = (x / 37 + y / 23) % 2 ? 200. : 40.;
+			const auto a = 128. + 127. * std::sin((x + y) * 0.02);
+			view[y * width + x].SetFrom(
+				static_cast<uint32_t>(std::clamp(r, 0., 255.)),
+				static_cast<uint32_t>(std::clamp(g, 0., 255.)),
+				static_cast<uint32_t>(std::clamp(b, 0., 255.)),
+				static_cast<uint32_t>(std::clamp(a, 0., 255.)));
+		}
+	}
+	return res;
+}
+
+static double Psnr(std::span<const Sqex::Texture::RGBA8888> source, const std::vector<uint32_t>& decoded, bool withAlpha) {
+	double squaredError = 0;
+	size_t count = 0;
+	for (size_t i = 0; i < source.size(); ++i) {
+		const auto& s = source[i];
+		const auto d = Sqex::Texture::RGBA8888(decoded[i]);
+		const int diffs[4]{
+			static_cast<int>(s.R) - static_cast<int>(d.R),
+			static_cast<int>(s.G) - static_cast<int>(d.G),
+			static_cast<int>(s.B) - static_cast<int>(d.B),
+			static_cast<int>(s.A) - static_cast<int>(d.A),
+		};
+		for (size_t c = 0; c < (withAlpha ? 4U : 3U); ++c, ++count)
+			squaredError += diffs[c] * diffs[c];
+	}
+	if (squaredError == 0)
+		return INFINITY;
+	return 10. * std::log10(255. * 255. / (squaredError / static_cast<double>(count)));
+}
+
+// BC1 has 1-bit alpha; pixels with alpha below 128 should come back transparent, and the others opaque.
+static size_t CountBc1AlphaMismatches(std::span<const Sqex::Texture::RGBA8888> source, const std::vector<uint32_t>& decoded) {
+	size_t count = 0;
+	for (size_t i = 0; i < source.size(); ++i)
+		count += Sqex::Texture::RGBA8888(decoded[i]).A != (source[i].A < 128 ? 0U : 255U);
+	return count;
+}
+
+int wmain(int argc, wchar_t** argv) {
+	std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> source;
+	if (argc > 1) {
+		const auto texture = Sqex::Texture::ModifiableTextureStream(std::make_shared<Sqex::FileRandomAccessStream>(std::filesystem::path(argv[1])));
+		source = Sqex::Texture::MemoryBackedMipmap::NewARGB8888From(texture.GetMipmap(0, 0).get());
+	} else {
+		source = SyntheticImage(2048, 2048);
+	}
+	const auto width = source->Width, height = source->Height;
+	const auto sourceView = source->View<Sqex::Texture::RGBA8888>();
+
+	std::cout << std::format("{}x{}\n", width, height);
+	auto success = true;
+	for (const auto& [type, name] : {
+		std::make_pair(Sqex::Texture::Format::DXT1, "BC1"),
+		std::make_pair(Sqex::Texture::Format::DXT5, "BC3"),
+		std::make_pair(Sqex::Texture::Format::BC7, "BC7"),
+	}) {
+		for (const auto preset : {Sqex::Texture::EncodePreset::Fast, Sqex::Texture::EncodePreset::Quality}) {
+			for (const auto filter : {Sqex::Texture::MipmapFilter::Box, Sqex::Texture::MipmapFilter::Kaiser}) {
+				const auto start = std::chrono::steady_clock::now();
+				const auto encoded = Sqex::Texture::EncodeTexture(*source, {
+					.Type = type,
+					.Preset = preset,
+					.Filter = filter,
+				});
+				const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				size_t pixelCount = 0;
+				for (size_t i = 0; i < encoded->GetMipmapCount(); ++i)
+					pixelCount += static_cast<size_t>(encoded->GetMipmap(i, 0)->Width) * encoded->GetMipmap(i, 0)->Height;
+
+				const auto blocks = encoded->GetMipmap(0, 0)->ReadStreamIntoVector<uint8_t>(0);
+				std::vector<uint32_t> decoded(sourceView.size());
+				const auto blockRows = static_cast<uint32_t>((height + 3) / 4);
+				switch (type) {
+					case Sqex::Texture::Format::DXT1:
+						Utils::DecompressBlockRowsDXT1(width, height, 0, blockRows, &blocks[0], &decoded[0]);
+						break;
+					case Sqex::Texture::Format::DXT5:
+						Utils::DecompressBlockRowsDXT5(width, height, 0, blockRows, &blocks[0], &decoded[0]);
+						break;
+					case Sqex::Texture::Format::BC7:
+						Utils::DecompressBlockRowsBC7(width, height, 0, blockRows, &blocks[0], &decoded[0]);
+						break;
+				}
+
+				std::cout << std::format("{} {:>7} {:>6}: PSNR(RGB) {:6.2f} dB, PSNR(RGBA) {:6.2f} dB, {:8.2f} MP/s ({} mipmaps)\n",
+					name,
+					preset == Sqex::Texture::EncodePreset::Fast ? "fast" : "quality",
+					filter == Sqex::Texture::MipmapFilter::Box ? "box" : "kaiser",
+					Psnr(sourceView, decoded, false),
+					Psnr(sourceView, decoded, true),
+					static_cast<double>(pixelCount) / elapsed / 1000000.,
+					encoded->GetMipmapCount());
+
+				if (type == Sqex::Texture::Format::DXT1) {
+					if (const auto mismatches = CountBc1AlphaMismatches(sourceView, decoded)) {
+						std::cout << std::format("FAIL: {} pixel(s) with wrong BC1 alpha\n", mismatches);
+						success = false;
+					}
+				}
+			}
+		}
+	}
+
+	std::cout << (success ? "PASS\n" : "");
+	return success ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#include "pch.h"
+
+#include <XivAlexanderCommon/Sqex.h>
+#include <XivAlexanderCommon/Sqex/Network/TimingTrace.h>
+
+// Replays network timing traces saved from "Save Decision Trace..." menu, and prints extra delay statistics.
+// Usage: ScratchProject NetworkTimingTrace_YYYYMMDD_HHMMSS.bin [more .bin files...]
+int wmain(int argc, wchar_t** argv) {
+	if (argc < 2) {
+		std::cout << "Usage: ScratchProject <trace.bin> [trace.bin...]\n";
+		return 1;
+	}
+
+	std::vector<Sqex::Network::TimingTrace::Event> allEvents;
+	for (int i = 1; i < argc; ++i) {
+		const auto path = std::filesystem::path(argv[i]);
+		const auto data = Sqex::FileRandomAccessStream(path).ReadStreamIntoVector<uint8_t>(0);
+		const auto trace = Sqex::Network::TimingTrace::Trace::Deserialize(std::span(data));
+
+		std::cout << std::format("{}: {} events ({} overwritten)\n", path.filename(), trace.Events.size(), trace.OverwrittenCount);
+		std::cout << trace.Analyze().ToString() << "\n";
+
+		auto csvPath = path;
+		Utils::SaveToFile(csvPath.replace_extension(L".csv"), trace.ToCsv());
+
+		allEvents.insert(allEvents.end(), trace.Events.begin(), trace.Events.end());
+	}
+
+	if (argc > 2) {
+		Sqex::Network::TimingTrace::Trace merged;
+		merged.Events = std::move(allEvents);
+		std::cout << "All traces:\n" << merged.Analyze().ToString();
+	}
+	return 0;
+}
@@ -0,0 +1,578 @@
+#include "pch.h"
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#include <XivAlexanderCommon/Sqex/Sqpack.h>
+#include <XivAlexanderCommon/Sqex/ZiPatch/Applier.h>
+#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
+
+// Writes small synthetic patch files in memory, applies them with Sqex::ZiPatch::PatchApplier, and compares every
+// target file against the result of applying the same commands directly to byte arrays. Checks that damage to each kind
+// of chunk is detected, and that patch files are read only once; then measures how fast large synthetic patch files are
+// read and applied. Uses nothing but the standard library besides the applier, so that it runs on other platforms too.
+// Usage: ScratchProject [benchmark size in MiB] [benchmark target directory]
+
+using namespace Sqex::ZiPatch;
+using namespace Sqex::ZiPatch::Chunk;
+
+struct ExpectedState {
+	std::map<std::string, std::vector<uint8_t>> Files;
+	std::set<std::string> RemovedFiles;
+	std::set<std::string> Directories;
+
+	void Write(const std::string& path, uint64_t offset, std::span<const uint8_t> data) {
+		RemovedFiles.erase(path);
+		auto& file = Files[path];
+		if (file.size() < offset + data.size())
+			file.resize(static_cast<size_t>(offset + data.size()));
+		std::ranges::copy(data, file.begin() + static_cast<ptrdiff_t>(offset));
+	}
+
+	void Remove(const std::string& path) {
+		if (Files.erase(path))
+			RemovedFiles.insert(path);
+	}
+};
+
+class SyntheticPatch {
+	Utils::ZlibReusableDeflater m_deflater{ Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS };
+
+public:
+	ExpectedState& Expected;
+	std::vector<uint8_t> Data;
+	size_t LastChunkOffset = 0;
+
+	SyntheticPatch(ExpectedState& expected)
+		: Expected(expected)
+		, Data(Header::Signature_Value, Header::Signature_Value + sizeof(Header::Signature_Value)) {
+		auto chunk = NewChunk<FileHeader>();
+		memcpy(Command<FileHeader>(chunk).PatchType, "DIFF", 4);
+		AddChunk(chunk, TypeValues::FileHeader);
+
+		auto targetInfo = NewChunk<SqpkTargetInfo>();
+		Command<SqpkTargetInfo>(targetInfo).Platform = Platform::Win32;
+		AddSqpkChunk(targetInfo, SqpkChunkTypeValues::TargetInfo);
+	}
+
+	template<typename T>
+	static std::vector<uint8_t> NewChunk(size_t extraSize = 0) {
+		return std::vector<uint8_t>(sizeof(T) + extraSize);
+	}
+
+	// For commands ending with a string, as data following the string begins right after its terminating null.
+	static std::vector<uint8_t> NewChunkWithString(size_t stringOffset, const std::string& s) {
+		std::vector<uint8_t> chunk(stringOffset + s.size() + 1);
+		std::ranges::copy(s, &chunk[stringOffset]);
+		return chunk;
+	}
+
+	template<typename T>
+	static T& Command(std::vector<uint8_t>& chunk) {
+		return *reinterpret_cast<T*>(chunk.data());
+	}
+
+	void AddChunk(std::vector<uint8_t>& chunk, TypeValues type) {
+		auto& header = Command<ChunkHeader>(chunk);
+		header.Size = static_cast<uint32_t>(chunk.size() - sizeof(ChunkHeader));
+		header.Type = type;
+		const auto crc32 = crc32_z(0, &chunk[offsetof(ChunkHeader, Type)], chunk.size() - offsetof(ChunkHeader, Type));
+		chunk.resize(chunk.size() + sizeof(ChunkFooter));
+		reinterpret_cast<ChunkFooter*>(&chunk[chunk.size() - sizeof(ChunkFooter)])->Crc32 = crc32;
+		LastChunkOffset = Data.size();
+		Data.insert(Data.end(), chunk.begin(), chunk.end());
+	}
+
+	void AddSqpkChunk(std::vector<uint8_t>& chunk, SqpkChunkTypeValues type) {
+		auto& header = Command<SqpkBase>(chunk);
+		header.Size = static_cast<uint32_t>(chunk.size() - sizeof(ChunkHeader));
+		header.SqpkChunkType = type;
+		AddChunk(chunk, TypeValues::Sqpk);
+	}
+
+	static std::string DataPath(uint16_t mainId, uint16_t subId, uint32_t fileId) {
+		return std::format("sqpack/ffxiv/{:02x}{:04x}.win32.dat{}", mainId, subId, fileId);
+	}
+
+	void FileAdd(const std::string& path, uint64_t targetOffset, std::span<const uint8_t> data, size_t blockSize, bool deflate) {
+		auto chunk = NewChunkWithString(offsetof(SqpkFile, Path), path);
+		auto& command = Command<SqpkFile>(chunk);
+		command.TargetOffset = targetOffset;
+		command.TargetSize = data.size();
+		command.PathSize = static_cast<uint32_t>(path.size() + 1);
+
+		for (size_t offset = 0; offset < data.size(); offset += blockSize) {
+			const auto block = data.subspan(offset, std::min(blockSize, data.size() - offset));
+			const auto stored = deflate ? std::span<const uint8_t>(m_deflater(block)) : block;
+			Sqex::Sqpack::SqData::BlockHeader blockHeader{};
+			blockHeader.HeaderSize = sizeof(blockHeader);
+			blockHeader.CompressedSize = deflate ? static_cast<uint32_t>(stored.size()) : Sqex::Sqpack::SqData::BlockHeader::CompressedSizeNotCompressed;
+			blockHeader.DecompressedSize = static_cast<uint32_t>(block.size());
+
+			const auto blockOffset = chunk.size();
+			chunk.resize(blockOffset + Sqex::Align(sizeof(blockHeader) + stored.size()).Alloc);
+			memcpy(&chunk[blockOffset], &blockHeader, sizeof(blockHeader));
+			std::ranges::copy(stored, &chunk[blockOffset + sizeof(blockHeader)]);
+		}
+		AddSqpkChunk(chunk, SqpkChunkTypeValues::FileAdd);
+
+		if (targetOffset == 0)
+			Expected.Files[path].clear();
+		Expected.Write(path, targetOffset, data);
+	}
+
+	void FileDelete(const std::string& path) {
+		auto chunk = NewChunkWithString(offsetof(SqpkFile, Path), path);
+		Command<SqpkFile>(chunk).PathSize = static_cast<uint32_t>(path.size() + 1);
+		AddSqpkChunk(chunk, SqpkChunkTypeValues::FileDelete);
+
+		Expected.Remove(path);
+	}
+
+	void FileRemoveAll() {
+		auto chunk = NewChunk<SqpkFile>();
+		AddSqpkChunk(chunk, SqpkChunkTypeValues::FileRemoveAll);
+
+		std::vector<std::string> paths;
+		for (const auto& path : Expected.Files | std::views::keys) {
+			if (path.starts_with("sqpack/ffxiv/") || path.starts_with("movie/ffxiv/"))
+				paths.emplace_back(path);
+		}
+		for (const auto& path : paths)
+			Expected.Remove(path);
+	}
+
+	void DataAdd(uint16_t mainId, uint16_t subId, uint32_t fileId, uint32_t blockIndex, std::span<const uint8_t> data, uint32_t clearBlockCount) {
+		auto chunk = NewChunk<SqpkDataAdd>(data.size());
+		auto& command = Command<SqpkDataAdd>(chunk);
+		command.MainId = mainId;
+		command.SubId = subId;
+		command.FileId = fileId;
+		command.TargetBlockIndex = blockIndex;
+		command.TargetDataBlockCount = static_cast<uint32_t>(data.size() / Sqex::EntryAlignment);
+		command.TargetClearBlockCount = clearBlockCount;
+		std::ranges::copy(data, &chunk[sizeof(SqpkDataAdd)]);
+		AddSqpkChunk(chunk, SqpkChunkTypeValues::DataAdd);
+
+		const auto path = DataPath(mainId, subId, fileId);
+		Expected.Write(path, 1ULL * blockIndex * Sqex::EntryAlignment, data);
+		Expected.Write(path, 1ULL * blockIndex * Sqex::EntryAlignment + data.size(), std::vector<uint8_t>(1ULL * clearBlockCount * Sqex::EntryAlignment));
+	}
+
+	void DataDeleteOrExpand(SqpkChunkTypeValues type, uint16_t mainId, uint16_t subId, uint32_t fileId, uint32_t blockIndex, uint32_t blockCount) {
+		auto chunk = NewChunk<SqpkDataExpandDelete>();
+		auto& command = Command<SqpkDataExpandDelete>(chunk);
+		command.MainId = mainId;
+		command.SubId = subId;
+		command.FileId = fileId;
+		command.TargetBlockIndex = blockIndex;
+		command.TargetDataBlockCount = blockCount;
+		AddSqpkChunk(chunk, type);
+
+		if (!blockCount)
+			return;
+
+		// Header size, type, decompressed size, and allocated block count excluding the header itself.
+		std::vector<uint8_t> blocks(1ULL * blockCount * Sqex::EntryAlignment);
+		blocks[0] = Sqex::EntryAlignment;
+		reinterpret_cast<uint32_t*>(&blocks[0])[3] = blockCount - 1;
+		Expected.Write(DataPath(mainId, subId, fileId), 1ULL * blockIndex * Sqex::EntryAlignment, blocks);
+	}
+
+	void HeaderCommand(bool isVersion, uint16_t mainId, uint16_t subId, uint32_t fileId, std::span<const uint8_t, 1024> data) {
+		auto chunk = NewChunk<SqpkDatHeader>(data.size());
+		auto& command = Command<SqpkDatHeader>(chunk);
+		command.MainId = mainId;
+		command.SubId = subId;
+		command.FileId = fileId;
+		std::ranges::copy(data, &chunk[sizeof(SqpkDatHeader)]);
+		AddSqpkChunk(chunk, isVersion ? SqpkChunkTypeValues::DatHeaderVersion : SqpkChunkTypeValues::DatHeaderSqpack);
+
+		Expected.Write(DataPath(mainId, subId, fileId), isVersion ? 0 : 1024, data);
+	}
+
+	void Directory(const std::string& path, bool add) {
+		auto chunk = NewChunkWithString(offsetof(AddDirectory, DirName), path);
+		Command<AddDirectory>(chunk).DirNameSize = static_cast<uint32_t>(path.size() + 1);
+		AddChunk(chunk, add ? TypeValues::AddDirectory : TypeValues::DeleteDirectory);
+
+		if (add)
+			Expected.Directories.insert(path);
+		else
+			Expected.Directories.erase(path);
+	}
+
+	void Finish() {
+		auto chunk = NewChunk<EndOfFile>();
+		AddChunk(chunk, TypeValues::EndOfFile);
+	}
+};
+
+static std::vector<uint8_t> RandomData(std::mt19937& rng, size_t size) {
+	// Runs of repeated bytes, so that deflate has something to do.
+	std::vector<uint8_t> data(size);
+	for (size_t i = 0; i < size;) {
+		const auto run = std::min<size_t>(size - i, 1 + rng() % 16);
+		std::fill_n(&data[i], run, static_cast<uint8_t>(rng()));
+		i += run;
+	}
+	return data;
+}
+
+class CountingStream : public Sqex::RandomAccessStream {
+	const std::shared_ptr<const RandomAccessStream> m_stream;
+
+public:
+	mutable std::atomic_uint64_t ReadBytes = 0;
+
+	CountingStream(std::shared_ptr<const RandomAccessStream> stream)
+		: m_stream(std::move(stream)) {
+	}
+
+	[[nodiscard]] uint64_t StreamSize() const override { return m_stream->StreamSize(); }
+
+	uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+		const auto read = m_stream->ReadStreamPartial(offset, buf, length);
+		ReadBytes += read;
+		return read;
+	}
+};
+
+static void ThreadedForRanges(size_t count, uint32_t threadCount, const std::function<void(size_t from, size_t to)>& fn) {
+	threadCount = static_cast<uint32_t>(std::min<size_t>({ threadCount, count, std::max(4U, std::thread::hardware_concurrency()) }));
+	if (threadCount <= 1) {
+		if (count)
+			fn(0, count);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < threadCount; ++i)
+		threads.emplace_back(fn, count * i / threadCount, count * (i + 1) / threadCount);
+	for (auto& thread : threads)
+		thread.join();
+}
+
+static std::vector<uint8_t> ReadAll(PatchApplier& applier, const std::string& path) {
+	std::vector<uint8_t> result;
+	applier.WriteFile(path, [&result](uint64_t offset, std::span<const uint8_t> data) {
+		if (offset != result.size())
+			throw std::runtime_error(std::format("WriteFile skipped from {} to {}", result.size(), offset));
+		result.insert(result.end(), data.begin(), data.end());
+	});
+	return result;
+}
+
+static bool Compare(PatchApplier& applier, const ExpectedState& expected, size_t iteration) {
+	auto success = true;
+	if (applier.Files().size() != expected.Files.size()) {
+		std::cout << std::format("FAIL: iteration {}: {} files, expected {}\n", iteration, applier.Files().size(), expected.Files.size());
+		success = false;
+	}
+	for (const auto& [path, data] : expected.Files) {
+		if (!applier.Files().contains(path)) {
+			std::cout << std::format("FAIL: iteration {}: {} missing\n", iteration, path);
+			success = false;
+		} else if (ReadAll(applier, path) != data) {
+			std::cout << std::format("FAIL: iteration {}: {} differs\n", iteration, path);
+			success = false;
+		}
+	}
+	if (applier.RemovedFiles() != expected.RemovedFiles) {
+		std::cout << std::format("FAIL: iteration {}: removed files differ\n", iteration);
+		success = false;
+	}
+	if (applier.Directories() != expected.Directories) {
+		std::cout << std::format("FAIL: iteration {}: directories differ\n", iteration);
+		success = false;
+	}
+	return success;
+}
+
+static std::vector<std::shared_ptr<const Sqex::RandomAccessStream>> ToStreams(const std::vector<std::vector<uint8_t>>& patchFiles) {
+	std::vector<std::shared_ptr<const Sqex::RandomAccessStream>> streams;
+	for (const auto& patchFile : patchFiles)
+		streams.emplace_back(std::make_shared<Sqex::MemoryRandomAccessStream>(std::span(const_cast<uint8_t*>(patchFile.data()), patchFile.size())));
+	return streams;
+}
+
+static std::vector<std::vector<uint8_t>> MakeRandomPatchFiles(std::mt19937& rng, ExpectedState& expected, size_t patchFileCount, size_t commandCount) {
+	static const std::string PlainPaths[]{ "boot/a.exe", "movie/ffxiv/00000.bk2", "sqpack/ffxiv/000000.win32.index", "sqpack/ffxiv/000000.win32.index2" };
+
+	std::vector<std::vector<uint8_t>> patchFiles;
+	for (size_t i = 0; i < patchFileCount; ++i) {
+		SyntheticPatch patch(expected);
+		for (size_t j = 0; j < commandCount; ++j) {
+			const auto mainId = static_cast<uint16_t>(rng() % 2);
+			const auto fileId = static_cast<uint32_t>(rng() % 2);
+			switch (rng() % 20) {
+				case 0:
+					patch.FileDelete(PlainPaths[rng() % std::size(PlainPaths)]);
+					break;
+				case 1:
+					if (rng() % 4 == 0)
+						patch.FileRemoveAll();
+					break;
+				case 2:
+				case 3: {
+					const auto blockIndex = static_cast<uint32_t>(rng() % 64);
+					const auto type = rng() % 2 ? SqpkChunkTypeValues::DataDelete : SqpkChunkTypeValues::DataExpand;
+					patch.DataDeleteOrExpand(type, mainId, 0, fileId, blockIndex, static_cast<uint32_t>(rng() % 8));
+					break;
+				}
+				case 4: {
+					std::vector<uint8_t> data = RandomData(rng, 1024);
+					patch.HeaderCommand(rng() % 2 == 0, mainId, 0, fileId, std::span<const uint8_t, 1024>(data));
+					break;
+				}
+				case 5:
+					patch.Directory(std::format("dir{}", rng() % 4), rng() % 3 != 0);
+					break;
+				case 6:
+				case 7:
+				case 8:
+				case 9: {
+					const auto data = RandomData(rng, (1 + rng() % 16) * Sqex::EntryAlignment);
+					patch.DataAdd(mainId, 0, fileId, static_cast<uint32_t>(rng() % 64), data, static_cast<uint32_t>(rng() % 4));
+					break;
+				}
+				default: {
+					const auto& path = PlainPaths[rng() % std::size(PlainPaths)];
+					const auto data = RandomData(rng, 1 + rng() % 10000);
+					const auto targetOffset = rng() % 3 == 0 ? 0 : rng() % 12000;
+					patch.FileAdd(path, targetOffset, data, 1 + rng() % 4000, rng() % 2 == 0);
+				}
+			}
+		}
+		patch.Finish();
+		patchFiles.emplace_back(std::move(patch.Data));
+	}
+	return patchFiles;
+}
+
+// Returns the message of the CorruptDataException thrown while reading and writing every file, or an empty string.
+static std::string ApplyCorrupt(const std::vector<std::vector<uint8_t>>& patchFiles) {
+	try {
+		PatchApplier applier(ToStreams(patchFiles));
+		applier.ReadPatchFiles();
+		for (const auto& path : applier.Files() | std::views::keys)
+			ReadAll(applier, path);
+		return {};
+	} catch (const Sqex::CorruptDataException& e) {
+		return e.what();
+	}
+}
+
+static bool TestCorruption() {
+	auto success = true;
+	const auto expectDetected = [&](const char* what, const std::vector<std::vector<uint8_t>>& patchFiles) {
+		if (ApplyCorrupt(patchFiles).empty()) {
+			std::cout << std::format("FAIL: {} not detected\n", what);
+			success = false;
+		}
+	};
+
+	std::mt19937 rng(1);
+	const auto data = RandomData(rng, 64 * Sqex::EntryAlignment);
+	const auto blockSize = 16 * Sqex::EntryAlignment;
+
+	const std::string path = "boot/a.exe";
+	for (const auto deflate : { false, true }) {
+		ExpectedState expected;
+		SyntheticPatch patch(expected);
+		patch.FileAdd(path, 0, data, blockSize, deflate);
+		const auto firstBlockOffset = patch.LastChunkOffset + offsetof(SqpkFile, Path) + path.size() + 1;
+		patch.Finish();
+
+		auto corrupt = patch.Data;
+		corrupt[firstBlockOffset + sizeof(Sqex::Sqpack::SqData::BlockHeader) + 1] ^= 1;
+		expectDetected(deflate ? "damaged deflated block" : "damaged stored block", { corrupt });
+
+		// BlockHeader::Version is not needed for applying, and is only covered by the chunk CRC32.
+		const auto& firstBlock = *reinterpret_cast<const Sqex::Sqpack::SqData::BlockHeader*>(&patch.Data[firstBlockOffset]);
+		const auto secondBlockOffset = firstBlockOffset + Sqex::Align(firstBlock.HeaderSize + (deflate ? firstBlock.CompressedSize : firstBlock.DecompressedSize)).Alloc;
+		corrupt = patch.Data;
+		corrupt[secondBlockOffset + offsetof(Sqex::Sqpack::SqData::BlockHeader, Version)] ^= 1;
+		expectDetected("damaged block header", { corrupt });
+	}
+
+	{
+		ExpectedState expected;
+		SyntheticPatch patch(expected);
+		patch.DataAdd(0, 0, 0, 0, data, 1);
+		const auto chunkOffset = patch.LastChunkOffset;
+		const auto chunkSize = patch.Data.size() - chunkOffset;
+		patch.Finish();
+
+		auto corrupt = patch.Data;
+		corrupt[chunkOffset + chunkSize / 2] ^= 1;
+		expectDetected("damaged DataAdd", { corrupt });
+	}
+
+	{
+		// Chunks not carrying target file data are checked when the patch files are read.
+		ExpectedState expected;
+		SyntheticPatch patch(expected);
+		patch.Directory("dir0", true);
+		const auto nameEnd = patch.Data.size() - sizeof(ChunkFooter) - 1;
+		patch.Finish();
+
+		patch.Data[nameEnd] ^= 1;
+		try {
+			PatchApplier(ToStreams({ patch.Data })).ReadPatchFiles();
+			std::cout << "FAIL: damaged AddDirectory not detected\n";
+			success = false;
+		} catch (const Sqex::CorruptDataException&) {
+			// pass
+		}
+	}
+
+	{
+		// Data entirely replaced by a later patch file is never read, so damage to it does not matter.
+		ExpectedState expected;
+		std::vector<std::vector<uint8_t>> patchFiles;
+		for (size_t i = 0; i < 2; ++i) {
+			SyntheticPatch patch(expected);
+			patch.FileAdd(path, 0, i == 0 ? data : RandomData(rng, data.size()), blockSize, false);
+			patch.Finish();
+			patchFiles.emplace_back(std::move(patch.Data));
+		}
+		patchFiles[0][patchFiles[0].size() / 2] ^= 1;
+
+		PatchApplier applier(ToStreams(patchFiles));
+		applier.ReadPatchFiles();
+		if (ReadAll(applier, path) != expected.Files.at(path)) {
+			std::cout << "FAIL: superseded data affected result\n";
+			success = false;
+		}
+	}
+
+	{
+		// CRC32 of parts recorded on the first write is checked on later ones, even without checking chunks.
+		ExpectedState expected;
+		SyntheticPatch patch(expected);
+		patch.FileAdd(path, 0, data, blockSize, false);
+		const auto firstBlockDataOffset = patch.LastChunkOffset + offsetof(SqpkFile, Path) + path.size() + 1 + sizeof(Sqex::Sqpack::SqData::BlockHeader);
+		patch.Finish();
+		std::vector<std::vector<uint8_t>> patchFiles{ std::move(patch.Data) };
+
+		PatchApplier applier(ToStreams(patchFiles));
+		applier.ReadPatchFiles();
+		ReadAll(applier, path);
+		applier.VerifyChunkCrc32 = false;
+		patchFiles[0][firstBlockDataOffset] ^= 1;
+		try {
+			ReadAll(applier, path);
+			std::cout << "FAIL: change after recording part CRC32 not detected\n";
+			success = false;
+		} catch (const Sqex::CorruptDataException&) {
+			// pass
+		}
+	}
+
+	return success;
+}
+
+int main(int argc, char** argv) {
+	const auto benchmarkSize = (argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 256U) << 20;
+	const auto benchmarkDirectory = argc > 2 ? std::filesystem::path(argv[2]) : std::filesystem::temp_directory_path() / "Test_ZiPatchApplier";
+
+	try {
+		std::mt19937 rng(0);
+		auto success = true;
+
+		for (size_t iteration = 0; success && iteration < 200; ++iteration) {
+			ExpectedState expected;
+			const auto patchFiles = MakeRandomPatchFiles(rng, expected, 1 + rng() % 4, 1 + rng() % 40);
+
+			for (const auto threads : { 1U, 4U }) {
+				PatchApplier applier(ToStreams(patchFiles));
+				applier.ParallelForRanges = ThreadedForRanges;
+				applier.MaxThreadCount = threads;
+				applier.ReadPatchFiles();
+				success &= Compare(applier, expected, iteration);
+
+				// Second pass checks against CRC32 recorded on the first.
+				success &= Compare(applier, expected, iteration);
+			}
+		}
+
+		success &= TestCorruption();
+
+		// Eight target files, each written by FileAdd commands spread across four patch files.
+		ExpectedState expected;
+		std::vector<std::vector<uint8_t>> patchFiles;
+		uint64_t patchBytes = 0, targetBytes = 0;
+		{
+			std::vector<std::unique_ptr<SyntheticPatch>> patches;
+			for (size_t i = 0; i < 4; ++i)
+				patches.emplace_back(std::make_unique<SyntheticPatch>(expected));
+
+			const auto fileSize = benchmarkSize / 8;
+			for (size_t i = 0; i < 8; ++i) {
+				const auto data = RandomData(rng, fileSize);
+				for (size_t j = 0; j < 4; ++j) {
+					const auto from = fileSize * j / 4, to = fileSize * (j + 1) / 4;
+					patches[j]->FileAdd(std::format("game/file{}.bin", i), from, std::span(data).subspan(from, to - from), 16000, i % 2 == 0);
+				}
+				targetBytes += fileSize;
+			}
+			for (auto& patch : patches) {
+				patch->Finish();
+				patchBytes += patch->Data.size();
+				patchFiles.emplace_back(std::move(patch->Data));
+			}
+		}
+
+		for (const auto threads : { 1U, UINT32_MAX }) {
+			std::vector<std::shared_ptr<const Sqex::RandomAccessStream>> streams;
+			std::vector<std::shared_ptr<CountingStream>> counters;
+			for (const auto& stream : ToStreams(patchFiles))
+				streams.emplace_back(counters.emplace_back(std::make_shared<CountingStream>(stream)));
+
+			PatchApplier applier(streams);
+			applier.ParallelForRanges = ThreadedForRanges;
+			applier.MaxThreadCount = threads;
+
+			auto start = std::chrono::steady_clock::now();
+			applier.ReadPatchFiles();
+			const auto readTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			applier.Apply(benchmarkDirectory);
+			const auto applyTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			uint64_t readBytes = 0;
+			for (const auto& counter : counters)
+				readBytes += counter->ReadBytes;
+			if (readBytes > patchBytes + patchBytes / 16) {
+				std::cout << std::format("FAIL: read {} bytes from {} bytes of patch files\n", readBytes, patchBytes);
+				success = false;
+			}
+
+			std::cout << std::format("{} threads: ReadPatchFiles {:.1f} MB/s ({} MiB), Apply {:.1f} MB/s ({} MiB), {:.3f}x patch file size read\n",
+				threads == 1 ? "1" : "all",
+				patchBytes / readTime / 1000000, patchBytes >> 20,
+				targetBytes / applyTime / 1000000, targetBytes >> 20,
+				static_cast<double>(readBytes) / static_cast<double>(patchBytes));
+		}
+
+		for (const auto& [path, data] : expected.Files) {
+			std::ifstream in(benchmarkDirectory / path, std::ios::binary);
+			std::vector<uint8_t> written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			if (written != data) {
+				std::cout << std::format("FAIL: {} differs after Apply\n", path);
+				success = false;
+			}
+		}
+		std::filesystem::remove_all(benchmarkDirectory);
+
+		std::cout << (success ? "PASS\n" : "");
+		return success ? 0 : 1;
+	} catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+}
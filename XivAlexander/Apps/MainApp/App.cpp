@@ -131,6 +131,7 @@ struct XivAlexander::Apps::MainApp::App::Implementation {
 		Cleanup += [this]() { MainWindow.reset(); };
 
 		Cleanup += ExitProcess.SetHook([this](UINT exitCode) {
+			Config->FlushSave();
 			if (this->MainWindow)
 				SendMessageW(this->MainWindow->Handle(), WM_CLOSE, exitCode, 2);
 			TerminateProcess(GetCurrentProcess(), exitCode);
@@ -302,6 +303,7 @@ XivAlexander::Apps::MainApp::App::~App() {
 		// Unloading despite IsUnloadable being set.
 		// Either process is terminating to begin with, or something went wrong,
 		// so terminating self is the right choice.
+		m_pImpl->Config->FlushSave();
 		TerminateProcess(GetCurrentProcess(), 0);
 	}
 
@@ -314,6 +316,7 @@ XivAlexander::Apps::MainApp::App::~App() {
 		// Being destructed from DllMain(Process detach).
 		// Should have been cleaned up first, but couldn't get a chance,
 		// so the only thing possible is to force quit, or an error message will appear.
+		m_pImpl->Config->FlushSave();
 		TerminateProcess(GetCurrentProcess(), 0);
 	}
 
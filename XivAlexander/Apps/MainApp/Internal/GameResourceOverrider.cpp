@@ -234,12 +234,20 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 			});
 
 
-		for (auto ptr : Misc::Signatures::LookupForData(Misc::Signatures::SectionFilterTextOnly,
+		const auto signatureMatches = Misc::Signatures::LookupForData(Misc::Signatures::SectionFilterTextOnly, {
+			{
 				"\x40\x57\x48\x8d\x3d\x00\x00\x00\x00\x00\x8b\xd8\x4c\x8b\xd2\xf7\xd1\x00\x85\xc0\x74\x25\x41\xf6\xc2\x03\x74\x1f\x41\x0f\xb6\x12\x8b\xc1",
 				"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF",
 				34,
-				{}
-			)) {
+			},
+			{
+				"\x8b\x01\x25\xff\xff\xff\x00\x48\x03\xc1",
+				"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF",
+				10,
+			},
+		});
+
+		for (auto ptr : signatureMatches[0]) {
 			FoundPathHashFunctions.emplace_back(std::make_unique<Misc::Hooks::PointerFunction<size_t, uint32_t, const char*, size_t>>(
 				"FFXIV::GeneralHashCalcFn",
 				reinterpret_cast<size_t(__stdcall*)(uint32_t, const char*, size_t)>(ptr)
@@ -339,11 +347,7 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 			});
 		}
 		
-		for (auto ptr : Misc::Signatures::LookupForData(
-			Misc::Signatures::SectionFilterTextOnly,
-			"\x8b\x01\x25\xff\xff\xff\x00\x48\x03\xc1",
-			"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF",
-			10, {})) {
+		for (auto ptr : signatureMatches[1]) {
 			FoundStringIndirectionResolverFunctions.emplace_back(std::make_unique<Misc::Hooks::PointerFunction<const char8_t*, const char8_t*>>(
 				"FFXIV::StringIndirectionResolverFunctions",
 				reinterpret_cast<const char8_t* (__stdcall*)(const char8_t*)>(ptr)
@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 
 #include <XivAlexanderCommon/Utils/CallOnDestruction.h>
+#include <XivAlexanderCommon/Utils/FramePacer.h>
 
 #include "Config.h"
 #include "Apps/MainApp/App.h"
@@ -11,6 +12,24 @@
 
 static constexpr auto SecondToMicrosecondMultiplier = 1000000ULL;
 
+class QpcClock : public Utils::FramePacer::Clock {
+public:
+	int64_t NowUs() override {
+		return Utils::QpcUs();
+	}
+
+	void SleepUs(int64_t us) override {
+		::Sleep(static_cast<DWORD>(us / 1000));
+	}
+
+	void Spin(bool yield) override {
+		if (yield)
+			::Sleep(0);
+		else
+			YieldProcessor();
+	}
+};
+
 struct XivAlexander::Apps::MainApp::Internal::MainThreadTimingHandler::Implementation {
 	Apps::MainApp::App& App;
 	const std::shared_ptr<Config> Config;
@@ -23,11 +42,12 @@ struct XivAlexander::Apps::MainApp::Internal::MainThreadTimingHandler::Implement
 	std::set<int64_t> MessagePumpGuaranteeCounterUs;
 	Utils::NumericStatisticsTracker MessagePumpIntervalTrackerUs{ 1024, 0 };
 
+	QpcClock Clock;
+	Utils::FramePacer Pacer{ Clock };
+
 	Utils::CallOnDestruction::Multiple Cleanup;
 
 	UINT LastPeekMessageHadRemoveMsg{};
-	int64_t LastLockedFramerateRenderIntervalUs{};
-	int64_t LastLockedFramerateRenderDriftUs{};
 
 	Implementation(Apps::MainApp::App& app)
 		: App(app)
@@ -51,57 +71,34 @@ struct XivAlexander::Apps::MainApp::Internal::MainThreadTimingHandler::Implement
 
 					auto recordPumpInterval = false;
 					if (!waitUntilCounterUs) {
-						uint64_t waitForUs = 0, waitForDrift = 0;
-						const auto test = Utils::QpcUs();
+						int64_t intervalUs = 0;
+						auto keepPhase = false;
 						if (const auto& networkingHelper = App.GetNetworkTimingHandler(); networkingHelper && rt.LockFramerateAutomatic) {
 							const auto& group = networkingHelper->GetCooldownGroup(Apps::MainApp::Internal::NetworkTimingHandler::CooldownGroup::Id_Gcd);
 							if (group.DurationUs != UINT64_MAX) {
-								const auto frameInterval = static_cast<int64_t>(Config::RuntimeRepository::CalculateLockFramerateIntervalUs(
+								intervalUs = static_cast<int64_t>(Config::RuntimeRepository::CalculateLockFramerateIntervalUs(
 									rt.LockFramerateTargetFramerateRangeFrom,
 									rt.LockFramerateTargetFramerateRangeTo,
 									group.DurationUs,
 									rt.LockFramerateMaximumRenderIntervalDeviation
 								));
-								if (frameInterval && LastLockedFramerateRenderIntervalUs && LastLockedFramerateRenderIntervalUs != frameInterval) {
-									const auto prevRenderTimestamp = nowUs / LastLockedFramerateRenderIntervalUs * LastLockedFramerateRenderIntervalUs + LastLockedFramerateRenderDriftUs + frameInterval;
-									int64_t minDiff = UINT64_MAX;
-									int64_t minDriftUs = 0;
-									for (int64_t i = 0; i < frameInterval; ++i) {
-										const auto nextRenderTimestamp = static_cast<int64_t>((1 + (nowUs - i) / frameInterval) * frameInterval + i);
-										if (nextRenderTimestamp < prevRenderTimestamp)
-											continue;
-										const auto diff = nextRenderTimestamp - prevRenderTimestamp;
-										if (diff < minDiff) {
-											minDiff = diff;
-											minDriftUs = i;
-										}
-									}
-									LastLockedFramerateRenderDriftUs = minDriftUs;
-								}
-								waitForUs = LastLockedFramerateRenderIntervalUs = frameInterval;
-								waitForDrift = LastLockedFramerateRenderDriftUs;
-							} else {
-								waitForUs = LastLockedFramerateRenderIntervalUs = static_cast<uint64_t>(1000000. / std::min(1000000., std::max(1., rt.LockFramerateTargetFramerateRangeTo.Value())));
-								waitForDrift = 0;
-							}
-						} else {
-							waitForUs = rt.LockFramerateInterval;
-							waitForDrift = 0;
-						}
-						if (waitForUs) {
+								keepPhase = true;
+							} else
+								intervalUs = static_cast<int64_t>(1000000. / std::min(1000000., std::max(1., rt.LockFramerateTargetFramerateRangeTo.Value())));
+						} else
+							intervalUs = static_cast<int64_t>(rt.LockFramerateInterval.Value());
+
+						if (intervalUs) {
 							recordPumpInterval = true;
-							waitUntilCounterUs = (1 + (nowUs - waitForDrift) / waitForUs) * waitForUs + waitForDrift;
+							waitUntilCounterUs = Pacer.NextFrameUs(nowUs, intervalUs, keepPhase);
 						}
 					}
 
 					if (waitUntilCounterUs > 0 && !LastMessagePumpCounterUs.empty()) {
+						// With more CPU time allowed, spin all the way without giving up the processor, as before.
 						const auto useMoreCpuTime = rt.UseMoreCpuTime.Value();
-						while (waitUntilCounterUs > (nowUs = Utils::QpcUs())) {
-							if (useMoreCpuTime)
-								void(0);
-							else
-								::Sleep(0);
-						}
+						Pacer.SpinBudgetUs = static_cast<int64_t>(rt.LockFramerateSpinBudget.Value());
+						nowUs = Pacer.WaitUntil(waitUntilCounterUs, !useMoreCpuTime, !useMoreCpuTime);
 						LastMessagePumpCounterUs.push_back(nowUs);
 					} else {
 						LastMessagePumpCounterUs.push_back(nowUs);
@@ -2,6 +2,7 @@
 #include "Apps/MainApp/Internal/NetworkTimingHandler.h"
 
 #include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Sqex/Network/TimingTrace.h>
 
 #include "Apps/MainApp/App.h"
 #include "Apps/MainApp/Internal/MainThreadTimingHandler.h"
@@ -11,6 +12,8 @@
 #include "resource.h"
 
 using namespace Sqex::Network::Structure;
+using Sqex::Network::TimingTrace::Event;
+using Sqex::Network::TimingTrace::EventType;
 
 struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementation {
 	static constexpr int64_t AutoAttackDelayUs = 100000;
@@ -66,20 +69,16 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 							.RequestUs = Utils::QpcUs(),
 							});
 
-						if (runtimeConfig.UseHighLatencyMitigationLogging) {
-							const auto delayUs = LastAnimationLockEndsAtUs ? PendingActions.back().RequestUs - *LastAnimationLockEndsAtUs : INT64_MAX;
-							const auto prevRelativeUs = LatestSuccessfulRequest ? PendingActions.back().RequestUs - LatestSuccessfulRequest->RequestUs : INT64_MAX;
-
-							Impl.Logger->Format(
-								LogCategory::NetworkTimingHandler,
-								"{:x}: C2S_ActionRequest({:04x}): actionId={:04x} sequence={:04x}{}{}",
-								conn.Socket(),
-								pMessage->Data.Ipc.SubType,
-								actionRequest.ActionId,
-								actionRequest.Sequence,
-								delayUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" delay={}s", static_cast<double>(delayUs) / SecondToMicrosecondMultiplier),
-								prevRelativeUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" prevRelative={}s", static_cast<double>(prevRelativeUs) / SecondToMicrosecondMultiplier));
-						}
+						Impl.Record(Event{
+							.Type = EventType::ActionRequest,
+							.SubType = pMessage->Data.Ipc.SubType,
+							.Socket = static_cast<uint64_t>(conn.Socket()),
+							.TimestampUs = PendingActions.back().RequestUs,
+							.ActionId = actionRequest.ActionId,
+							.Sequence = actionRequest.Sequence,
+							.DelayUs = LastAnimationLockEndsAtUs ? PendingActions.back().RequestUs - *LastAnimationLockEndsAtUs : INT64_MAX,
+							.DurationUs = LatestSuccessfulRequest ? PendingActions.back().RequestUs - LatestSuccessfulRequest->RequestUs : INT64_MAX,
+						}, runtimeConfig.UseHighLatencyMitigationLogging);
 
 						// If there was no action queued to begin with before the current one, update the base lock time to now.
 						if (PendingActions.size() == 1 && (!PendingActions.back().RequestUs || (!LastAnimationLockEndsAtUs || *LastAnimationLockEndsAtUs < PendingActions.back().RequestUs)))
@@ -113,12 +112,14 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 							auto& actionEffect = pMessage->Data.Ipc.Data.S2C_ActionEffect;
 							int64_t originalWaitUs, waitUs;
 
-							std::stringstream description;
-							description << std::format("{:x}: S2C_ActionEffect({:04x}): actionId={:04x} sourceSequence={:04x}",
-								conn.Socket(),
-								pMessage->Data.Ipc.SubType,
-								actionEffect.ActionId,
-								actionEffect.SourceSequence);
+							Event event{
+								.Type = EventType::ActionEffect,
+								.SubType = pMessage->Data.Ipc.SubType,
+								.Socket = static_cast<uint64_t>(conn.Socket()),
+								.TimestampUs = nowUs,
+								.ActionId = actionEffect.ActionId,
+								.Sequence = actionEffect.SourceSequence,
+							};
 
 							if (const auto it = OriginalWaitUsMap.find(actionEffect.SourceSequence); it == OriginalWaitUsMap.end())
 								waitUs = originalWaitUs = actionEffect.AnimationLockDurationUs();
@@ -138,16 +139,12 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 								} else {
 									LastAnimationLockEndsAtUs = nowUs + waitUs;
 								}
-								description << " serverOriginated";
+								event.ServerOriginated = 1;
 
 							} else {
 								// find the one sharing Sequence, assuming action responses are always in order
 								while (!PendingActions.empty() && PendingActions.front().Sequence != actionEffect.SourceSequence) {
-									const auto& item = PendingActions.front();
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
-										item.ActionId, item.Sequence);
+									RecordIgnoredRequest(PendingActions.front());
 									PendingActions.pop_front();
 								}
 
@@ -155,14 +152,14 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 									LatestSuccessfulRequest = PendingActions.front();
 									LatestSuccessfulRequest->ResponseUs = nowUs;
 									LatestSuccessfulRequest->OriginalWaitUs = originalWaitUs;
+									event.RequestUs = LatestSuccessfulRequest->RequestUs;
 
 									// 100ms animation lock after cast ends stays. Modify animation lock duration for instant actions only.
 									// Since no other action is in progress right before the cast ends, we can safely replace the animation lock with the latest after-cast lock.
 									if (!LatestSuccessfulRequest->CastTimeUs) {
 										const auto rttUs = static_cast<int64_t>(nowUs - LatestSuccessfulRequest->RequestUs);
 										conn.ApplicationLatencyUs.AddValue(rttUs);
-										description << std::format(" rtt={}us", rttUs);
-										LastAnimationLockEndsAtUs = ResolveNextAnimationLockEndUs(*LastAnimationLockEndsAtUs, nowUs, originalWaitUs, rttUs, description);
+										LastAnimationLockEndsAtUs = ResolveNextAnimationLockEndUs(*LastAnimationLockEndsAtUs, nowUs, originalWaitUs, rttUs, event);
 
 									} else {
 										LastAnimationLockEndsAtUs = LatestSuccessfulRequest->RequestUs + LatestSuccessfulRequest->CastTimeUs + waitUs;
@@ -175,12 +172,15 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 							}
 
 							waitUs = *LastAnimationLockEndsAtUs - nowUs;
-							if (waitUs == originalWaitUs || (LatestSuccessfulRequest && LatestSuccessfulRequest->CastTimeUs)) {
-								description << std::format(" wait={}us", originalWaitUs);
+							event.OriginalWaitUs = originalWaitUs;
+							event.WaitUs = waitUs;
+							event.CastInProgress = LatestSuccessfulRequest && LatestSuccessfulRequest->CastTimeUs ? 1 : 0;
+							event.PreviewMode = runtimeConfig.UseHighLatencyMitigationPreviewMode ? 1 : 0;
+							if (waitUs == originalWaitUs || event.CastInProgress) {
+								// Nothing to adjust.
 							} else if (waitUs < 0) {
-								const auto invalidWaitUs = waitUs;
 								waitUs = 0;
-								description << std::format(" wait={}us->{}us->{}us (ping/jitter too high)", originalWaitUs, invalidWaitUs, waitUs);
+								event.WaitClamped = 1;
 
 								if (!runtimeConfig.UseHighLatencyMitigationPreviewMode) {
 									actionEffect.AnimationLockDurationUs(0);
@@ -189,8 +189,6 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 								}
 
 							} else if (waitUs < originalWaitUs) {
-								description << std::format(" wait={}us->{}us", originalWaitUs, waitUs);
-
 								if (!runtimeConfig.UseHighLatencyMitigationPreviewMode) {
 									actionEffect.AnimationLockDurationUs(waitUs);
 									if (LatestSuccessfulRequest)
@@ -198,7 +196,6 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 								}
 
 							}
-							description << std::format(" next={:%H:%M:%S}", std::chrono::system_clock::now() + std::chrono::microseconds(waitUs));
 
 							if (Config->Runtime.SynchronizeProcessing) {
 								if (auto& handler = Impl.App.GetMainThreadTimingHelper()) {
@@ -206,8 +203,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 								}
 							}
 
-							if (runtimeConfig.UseHighLatencyMitigationLogging)
-								Impl.Logger->Log(LogCategory::NetworkTimingHandler, description.str());
+							Impl.Record(event, runtimeConfig.UseHighLatencyMitigationLogging);
 
 						} else if (pMessage->Data.Ipc.SubType == gameConfig.S2C_ActorControlSelf) {
 							auto& actorControlSelf = pMessage->Data.Ipc.Data.S2C_ActorControlSelf;
@@ -233,14 +229,15 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 										}
 									}
 
-									if (runtimeConfig.UseHighLatencyMitigationLogging) {
-										Impl.Logger->Format(
-											LogCategory::NetworkTimingHandler,
-											"{:x}: S2C_ActorControlSelf/Cooldown: actionId={:04x} group={:04x} duration={:.02f}s",
-											conn.Socket(),
-											cooldown.ActionId, cooldown.CooldownGroupId,
-											cooldown.DurationF());
-									}
+									Impl.Record(Event{
+										.Type = EventType::Cooldown,
+										.SubType = pMessage->Data.Ipc.SubType,
+										.Socket = static_cast<uint64_t>(conn.Socket()),
+										.TimestampUs = nowUs,
+										.ActionId = cooldown.ActionId,
+										.Sequence = cooldown.CooldownGroupId,
+										.DurationUs = static_cast<int64_t>(cooldown.DurationUs()),
+									}, runtimeConfig.UseHighLatencyMitigationLogging);
 								}
 
 								group.DurationUs = cooldown.DurationUs();
@@ -257,24 +254,21 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 										(rollback.SourceSequence != 0 && PendingActions.front().Sequence != rollback.SourceSequence)
 										|| (rollback.SourceSequence == 0 && PendingActions.front().ActionId != rollback.ActionId)
 										)) {
-									const auto& item = PendingActions.front();
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
-										item.ActionId, item.Sequence);
+									RecordIgnoredRequest(PendingActions.front());
 									PendingActions.pop_front();
 								}
 
 								if (!PendingActions.empty())
 									PendingActions.pop_front();
 
-								if (runtimeConfig.UseHighLatencyMitigationLogging)
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										"{:x}: S2C_ActorControlSelf/ActionRejected: actionId={:04x} sourceSequence={:04x}",
-										conn.Socket(),
-										rollback.ActionId,
-										rollback.SourceSequence);
+								Impl.Record(Event{
+									.Type = EventType::ActionRejected,
+									.SubType = pMessage->Data.Ipc.SubType,
+									.Socket = static_cast<uint64_t>(conn.Socket()),
+									.TimestampUs = nowUs,
+									.ActionId = rollback.ActionId,
+									.Sequence = rollback.SourceSequence,
+								}, runtimeConfig.UseHighLatencyMitigationLogging);
 							}
 
 						} else if (pMessage->Data.Ipc.SubType == gameConfig.S2C_ActorControl) {
@@ -286,23 +280,20 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 
 								// find the one sharing Sequence, assuming action responses are always in order
 								while (!PendingActions.empty() && PendingActions.front().ActionId != cancelCast.ActionId) {
-									const auto& item = PendingActions.front();
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
-										item.ActionId, item.Sequence);
+									RecordIgnoredRequest(PendingActions.front());
 									PendingActions.pop_front();
 								}
 
 								if (!PendingActions.empty())
 									PendingActions.pop_front();
 
-								if (runtimeConfig.UseHighLatencyMitigationLogging)
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										"{:x}: S2C_ActorControl/CancelCast: actionId={:04x}",
-										conn.Socket(),
-										cancelCast.ActionId);
+								Impl.Record(Event{
+									.Type = EventType::CancelCast,
+									.SubType = pMessage->Data.Ipc.SubType,
+									.Socket = static_cast<uint64_t>(conn.Socket()),
+									.TimestampUs = nowUs,
+									.ActionId = cancelCast.ActionId,
+								}, runtimeConfig.UseHighLatencyMitigationLogging);
 							}
 
 						} else if (pMessage->Data.Ipc.SubType == gameConfig.S2C_ActorCast) {
@@ -313,14 +304,15 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 							if (!PendingActions.empty())
 								PendingActions.front().CastTimeUs = actorCast.CastTimeUs();
 
-							if (runtimeConfig.UseHighLatencyMitigationLogging)
-								Impl.Logger->Format(
-									LogCategory::NetworkTimingHandler,
-									"{:x}: S2C_ActorCast: actionId={:04x} time={:.3f} target={:08x}",
-									conn.Socket(),
-									actorCast.ActionId,
-									actorCast.CastTimeF,
-									actorCast.TargetId);
+							Impl.Record(Event{
+								.Type = EventType::ActorCast,
+								.SubType = pMessage->Data.Ipc.SubType,
+								.Socket = static_cast<uint64_t>(conn.Socket()),
+								.TimestampUs = nowUs,
+								.ActionId = actorCast.ActionId,
+								.Sequence = actorCast.TargetId,
+								.DurationUs = static_cast<int64_t>(actorCast.CastTimeUs()),
+							}, runtimeConfig.UseHighLatencyMitigationLogging);
 						}
 					}
 				}
@@ -332,10 +324,24 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 			Conn.RemoveMessageHandlers(this);
 		}
 
-		int64_t ResolveNextAnimationLockEndUs(const int64_t lastAnimationLockEndsAtUs, const int64_t nowUs, const int64_t originalWaitUs, const int64_t rttUs, std::stringstream& description) {
+		void RecordIgnoredRequest(const PendingAction& item) {
+			// Always logged, as this indicates that some expected message has not been handled.
+			Impl.Record(Event{
+				.Type = EventType::ActionRequestIgnored,
+				.Socket = static_cast<uint64_t>(Conn.Socket()),
+				.TimestampUs = Utils::QpcUs(),
+				.ActionId = item.ActionId,
+				.Sequence = item.Sequence,
+				.RequestUs = item.RequestUs,
+			}, true);
+		}
+
+		int64_t ResolveNextAnimationLockEndUs(const int64_t lastAnimationLockEndsAtUs, const int64_t nowUs, const int64_t originalWaitUs, const int64_t rttUs, Event& event) {
 			const auto& runtimeConfig = Config->Runtime;
 			const auto mode = runtimeConfig.HighLatencyMitigationMode.Value();
-			description << std::format(" mode={}", static_cast<int>(mode) + 1);
+			event.UsedRtt = 1;
+			event.Mode = static_cast<uint8_t>(static_cast<int>(mode) + 1);
+			event.RttUs = rttUs;
 
 			// Obtain actual connection latency statistics.
 			// Preference for socket latency measurement if available.
@@ -354,10 +360,9 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 			// - Server RTT measurement is faster than actual latency
 			if (latencyUs == INT64_MAX || rttUs < latencyUs) {
 				latencyUs = latencyEstimateUs;
-				description << std::format(" latency={}us*", latencyUs);
-			} else {
-				description << std::format(" latency={}us", latencyUs);
+				event.EstimatedLatency = 1;
 			}
+			event.LatencyUs = event.AdjustedLatencyUs = latencyUs;
 
 			auto delay = 0LL;
 
@@ -374,10 +379,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 					// Server-side focused mode. Attempts to guess the server delay from response time statistics.
 					// Handles fake-ping VPN usage by using estimated latency when necessary.
 					auto bestLatencyUs = std::max(latencyUs, latencyEstimateUs);
-					
-					if(bestLatencyUs != latencyUs) {
-						description << std::format("->{}us", bestLatencyUs);
-					}
+					event.AdjustedLatencyUs = bestLatencyUs;
 
 					// Estimate server delay, using modulus to handle high ping rtt multipliers.
 					delay = bestLatencyUs > 0 ? ((rttUs % bestLatencyUs) + (rttUs - bestLatencyUs)) / 2 : rttUs;
@@ -389,7 +391,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 			delay = std::max(delay, 0LL);
 
 			// Return the new animation lock time without server response time delay, but with artificial delay (safety/lag) value.
-			description << std::format(" delay={}us", delay);
+			event.DelayUs = delay;
 			return nowUs + (originalWaitUs - rttUs) + delay;
 		}
 	};
@@ -398,6 +400,7 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 	Apps::MainApp::App& App;
 	const std::shared_ptr<Misc::Logger> Logger;
 	SocketHook& SocketHook;
+	Sqex::Network::TimingTrace::Recorder TimingTrace;
 	std::map<SingleConnection*, std::unique_ptr<SingleConnectionHandler>> Handlers{};
 	Utils::CallOnDestruction::Multiple Cleanup;
 
@@ -426,6 +429,12 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 	void CallOnActionRequestListener(const XivIpcs::C2S_ActionRequest& req) const {
 		This.OnActionRequestListener(req);
 	}
+
+	void Record(const Event& event, bool log) {
+		TimingTrace.Record(event);
+		if (log && Logger->IsEnabled(LogCategory::NetworkTimingHandler, LogLevel::Info))
+			Logger->Log(LogCategory::NetworkTimingHandler, Sqex::Network::TimingTrace::FormatEvent(event, Sqex::Network::TimingTrace::CurrentQpcToEpochOffsetUs()));
+	}
 };
 
 XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::NetworkTimingHandler(Apps::MainApp::App& app)
@@ -437,3 +446,7 @@ XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::~NetworkTimingHandl
 const XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::CooldownGroup& XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::GetCooldownGroup(uint32_t groupId) const {
 	return m_pImpl->LastCooldownGroup[groupId];
 }
+
+Sqex::Network::TimingTrace::Trace XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::GetTimingTrace() const {
+	return m_pImpl->TimingTrace.TakeSnapshot();
+}
@@ -3,6 +3,7 @@
 #include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
 #include <XivAlexanderCommon/Utils/ListenerManager.h>
 #include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Sqex/Network/TimingTrace.h>
 
 namespace XivAlexander::Apps::MainApp {
 	class App;
@@ -27,6 +28,7 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		};
 
 		const CooldownGroup& GetCooldownGroup(uint32_t groupId) const;
+		[[nodiscard]] Sqex::Network::TimingTrace::Trace GetTimingTrace() const;
 		Utils::ListenerManager<Implementation, void, const CooldownGroup&, bool> OnCooldownGroupUpdateListener;
 		Utils::ListenerManager<Implementation, void, const Sqex::Network::Structure::XivIpcs::C2S_ActionRequest&> OnActionRequestListener;
 	};
@@ -14,6 +14,9 @@ using namespace Sqex::Network::Structure;
 
 static Utils::OodleNetworkFunctions s_oodle{};
 
+// Indexed by CompressionType.
+static constexpr const char* CompressionTypeNames[]{ "None", "Deflate", "Oodle" };
+
 class XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleStream {
 	Misc::Logger& m_logger;
 	const std::string m_name;
@@ -24,6 +27,19 @@ class XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleStream {
 	std::vector<uint8_t> m_buffer{};
 	size_t m_pointer = 0;
 
+	struct BundleTrace {
+		uint64_t EndPosition;  // Stream position right after the last byte of the bundle (or received chunk).
+		int64_t TimestampUs;  // When the whole data became available to XivAlexander.
+		CompressionType Compression;
+	};
+
+	// Number of bytes ever consumed from this stream.
+	uint64_t m_consumedPosition = 0;
+	std::deque<BundleTrace> m_traces;
+
+	// If set, time taken for each bundle from entering XivAlexander to being consumed from this stream is recorded here, indexed by compression type.
+	std::span<Utils::LatencyHistogram> m_consumeLatencyHistogramsUs;
+
 public:
 	class SingleStreamWriter {
 		SingleStream& m_stream;
@@ -63,6 +79,27 @@ public:
 		return { *this };
 	}
 
+	void RecordConsumeLatencyTo(std::span<Utils::LatencyHistogram> histograms) {
+		m_consumeLatencyHistogramsUs = histograms;
+	}
+
+	/// \brief Marks everything written so far and not marked yet as having become available to XivAlexander at given time.
+	void MarkWritten(int64_t timestampUs, CompressionType compression = CompressionType::None) {
+		const auto endPosition = m_consumedPosition + Available();
+		if (!m_traces.empty() && m_traces.back().EndPosition >= endPosition)
+			return;
+		m_traces.emplace_back(BundleTrace{ endPosition, timestampUs, compression });
+	}
+
+	/// \brief Finds when the byte right before given stream position has become available to XivAlexander.
+	[[nodiscard]] int64_t TimestampBefore(uint64_t position) const {
+		for (const auto& trace : m_traces) {
+			if (trace.EndPosition >= position)
+				return trace.TimestampUs;
+		}
+		return Utils::QpcUs();
+	}
+
 	void Write(const void* buf, size_t length) {
 		const auto uint8buf = static_cast<const uint8_t*>(buf);
 		m_buffer.insert(m_buffer.end(), uint8buf, uint8buf + length);
@@ -91,14 +128,26 @@ public:
 	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
 	void Consume(size_t count) {
 		m_pointer += count * sizeof(T);
+		m_consumedPosition += count * sizeof(T);
 		if (m_pointer == m_buffer.size()) {
 			m_buffer.clear();
 			m_pointer = 0;
 		} else if (m_pointer > m_buffer.size()) {
+			m_consumedPosition -= m_pointer - m_buffer.size();
 			m_buffer.clear();
 			m_pointer = 0;
 			m_logger.Log(LogCategory::SocketHook, "SingleStream: overconsuming", LogLevel::Warning);
 		}
+
+		if (!m_traces.empty() && m_traces.front().EndPosition <= m_consumedPosition) {
+			const auto nowUs = Utils::QpcUs();
+			do {
+				const auto& trace = m_traces.front();
+				if (const auto index = static_cast<size_t>(trace.Compression); index < m_consumeLatencyHistogramsUs.size())
+					m_consumeLatencyHistogramsUs[index].Record(nowUs - trace.TimestampUs);
+				m_traces.pop_front();
+			} while (!m_traces.empty() && m_traces.front().EndPosition <= m_consumedPosition);
+		}
 	}
 
 	template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
@@ -143,6 +192,8 @@ public:
 			if (buf.size_bytes() < pGamePacket->TotalLength)
 				break;
 
+			const auto enteredUs = TimestampBefore(m_consumedPosition + pGamePacket->TotalLength);
+
 			try {
 				auto messages = pGamePacket->GetMessages(m_inflater, m_unoodler);
 				auto header = *pGamePacket;
@@ -194,6 +245,7 @@ public:
 				m_logger.Format<XivAlexander::LogLevel::Warning>(XivAlexander::LogCategory::SocketHook, "{}: Error: {}\n{}", m_name, e.what(), pGamePacket->Represent());
 				target.Write(pGamePacket, pGamePacket->TotalLength);
 			}
+			target.MarkWritten(enteredUs, pGamePacket->CompressionType);
 
 			Consume(pGamePacket->TotalLength);
 		}
@@ -256,6 +308,7 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 		if (auto write = RecvRaw.Write();
 			!write.Write(std::max(0, SocketHook.recv.bridge(SingleConnection.m_socket, write.Allocate<char>(65536), 65536, 0))))
 			return;
+		RecvRaw.MarkWritten(Utils::QpcUs());
 
 		ProcessRecvData();
 	}
@@ -287,8 +340,11 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 
 						// Add statistics sample
 						SingleConnection.ApplicationLatencyUs.AddValue(delayUs);
-						if (const auto latency = SingleConnection.FetchSocketLatencyUs())
+						SingleConnection.ApplicationLatencyHistogramUs.Record(delayUs);
+						if (const auto latency = SingleConnection.FetchSocketLatencyUs()) {
 							SingleConnection.SocketLatencyUs.AddValue(*latency);
+							SingleConnection.SocketLatencyHistogramUs.Record(*latency);
+						}
 					}
 					break;
 
@@ -368,12 +424,12 @@ struct XivAlexander::Apps::MainApp::Internal::SocketHook::Implementation {
 		try {
 			AllowedIpRange = Utils::ParseIpRange(game.Server_IpRange, runtime.TakeOverAllAddresses, runtime.TakeOverPrivateAddresses, runtime.TakeOverLoopbackAddresses);
 		} catch (const std::exception& e) {
-			SocketHook.m_logger->Format<LogLevel::Error>(LogCategory::SocketHook, e.what());
+			SocketHook.m_logger->Format<LogLevel::Error>(LogCategory::SocketHook, "{}", e.what());
 		}
 		try {
 			AllowedPortRange = Utils::ParsePortRange(game.Server_PortRange, runtime.TakeOverAllPorts);
 		} catch (const std::exception& e) {
-			SocketHook.m_logger->Format<LogLevel::Error>(LogCategory::SocketHook, e.what());
+			SocketHook.m_logger->Format<LogLevel::Error>(LogCategory::SocketHook, "{}", e.what());
 		}
 	}
 
@@ -507,6 +563,8 @@ XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation::Impleme
 XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleConnection(Internal::SocketHook& hook, SOCKET s)
 	: m_socket(s)
 	, m_pImpl(std::make_unique<Implementation>(*this, hook)) {
+	m_pImpl->RecvProcessed.RecordConsumeLatencyTo(IncomingTunnelLatencyHistogramsUs);
+	m_pImpl->SendProcessed.RecordConsumeLatencyTo(OutgoingTunnelLatencyHistogramsUs);
 }
 
 XivAlexander::Apps::MainApp::Internal::SingleConnection::~SingleConnection() = default;
@@ -564,6 +622,16 @@ const Utils::NumericStatisticsTracker* XivAlexander::Apps::MainApp::Internal::Si
 	return m_pImpl->SocketHook.m_pImpl->PingTracker.GetTrackerUs(local.sin_addr, remote.sin_addr);
 }
 
+const Utils::LatencyHistogram* XivAlexander::Apps::MainApp::Internal::SingleConnection::GetPingLatencyHistogramUs() const {
+	if (m_pImpl->LocalAddress.ss_family != AF_INET || m_pImpl->RemoteAddress.ss_family != AF_INET)
+		return nullptr;
+	const auto& local = *reinterpret_cast<const sockaddr_in*>(&m_pImpl->LocalAddress);
+	const auto& remote = *reinterpret_cast<const sockaddr_in*>(&m_pImpl->RemoteAddress);
+	if (!local.sin_addr.s_addr || !remote.sin_addr.s_addr)
+		return nullptr;
+	return m_pImpl->SocketHook.m_pImpl->PingTracker.GetHistogramUs(local.sin_addr, remote.sin_addr);
+}
+
 XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App & app)
 	: m_logger(Misc::Logger::Acquire())
 	, OnSocketFound([this](const auto& cb) { if (m_pImpl) { for (const auto& val : m_pImpl->Sockets | std::views::values) cb(*val); } }) {
@@ -610,45 +678,52 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 
 			s_oodle.OodleNetwork1_Shared_Size = static_cast<Utils::OodleNetwork1_Shared_Size*>(callTargetAddresses[0]);
 			s_oodle.OodleNetwork1_Shared_SetWindow = static_cast<Utils::OodleNetwork1_Shared_SetWindow*>(callTargetAddresses[2]);
-			basePtr = static_cast<uint8_t*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\xcc\xb8\x00\xb4\x2e\x00\xc3",
-				"\xff\xff\xff\xff\xff\xff",
-				6, {}).front()) + 1;
-
-			s_oodle.OodleNetwork1UDP_State_Size = reinterpret_cast<Utils::OodleNetwork1UDP_State_Size*>(basePtr);
-
+			const auto oodleFunctions = Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly, {
+				{
+					"\xcc\xb8\x00\xb4\x2e\x00\xc3",
+					"\xff\xff\xff\xff\xff\xff",
+					6,
+				},
 #ifdef _WIN64
-			s_oodle.OodleNetwork1UDP_Train = static_cast<Utils::OodleNetwork1UDP_Train*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\x48\x89\x5c\x24\x08\x48\x89\x6c\x24\x10\x48\x89\x74\x24\x18\x48\x89\x7c\x24\x20\x41\x56\x48\x83\xec\x30\x48\x8b\xf2",
-				"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
-				29, {}).front());
-
-			s_oodle.OodleNetwork1UDP_Decode = static_cast<Utils::OodleNetwork1UDP_Decode*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\x40\x53\x48\x83\xec\x00\x48\x8b\x44\x24\x68\x49\x8b\xd9\x48\x85\xc0\x7e",
-				"\xff\xff\xff\xff\xff\x00\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
-				18, {}).front());
-
-			s_oodle.OodleNetwork1UDP_Encode = reinterpret_cast<Utils::OodleNetwork1UDP_Encode*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\x4c\x89\x4c\x24\x20\x4c\x89\x44\x24\x18\x48\x89\x4c\x24\x08\x55\x56\x57\x41\x55\x41\x57\x48\x8d\x6c\x24\xd1",
-				"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
-				27, {}).front());
+				{
+					"\x48\x89\x5c\x24\x08\x48\x89\x6c\x24\x10\x48\x89\x74\x24\x18\x48\x89\x7c\x24\x20\x41\x56\x48\x83\xec\x30\x48\x8b\xf2",
+					"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+					29,
+				},
+				{
+					"\x40\x53\x48\x83\xec\x00\x48\x8b\x44\x24\x68\x49\x8b\xd9\x48\x85\xc0\x7e",
+					"\xff\xff\xff\xff\xff\x00\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+					18,
+				},
+				{
+					"\x4c\x89\x4c\x24\x20\x4c\x89\x44\x24\x18\x48\x89\x4c\x24\x08\x55\x56\x57\x41\x55\x41\x57\x48\x8d\x6c\x24\xd1",
+					"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+					27,
+				},
 #else
-			s_oodle.OodleNetwork1UDP_Train = static_cast<Utils::OodleNetwork1UDP_Train*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\x56\x6a\x08\x68\x00\x84\x4a\x00",
-				"\xff\xff\xff\xff\xff\xff\xff\xff",
-				8, {}).front());
-
-			s_oodle.OodleNetwork1UDP_Decode = static_cast<Utils::OodleNetwork1UDP_Decode*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\x8b\x44\x24\x18\x56\x85\xc0\x7e\x00\x8b\x74\x24\x14\x85\xf6\x7e\x00\x3b\xf0",
-				"\xff\xff\xff\xff\xff\xff\xff\xff\x00\xff\xff\xff\xff\xff\xff\xff\x00\xff\xff",
-				19, {}).front());
-
-			s_oodle.OodleNetwork1UDP_Encode = reinterpret_cast<Utils::OodleNetwork1UDP_Encode*>(Misc::Hooks::LookupForData(&Misc::Hooks::SectionFilterTextOnly,
-				"\xff\x74\x24\x14\x8b\x4c\x24\x08\xff\x74\x24\x14\xff\x74\x24\x14\xff\x74\x24\x14\xe8\x00\x00\x00\x00\xc2\x14\x00\xcc\xcc\xcc\xcc\xb8",
-				"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x00\x00\x00\x00\xff\xff\xff\xff\xff\xff\xff\xff",
-				33, {}).front());
-			
+				{
+					"\x56\x6a\x08\x68\x00\x84\x4a\x00",
+					"\xff\xff\xff\xff\xff\xff\xff\xff",
+					8,
+				},
+				{
+					"\x8b\x44\x24\x18\x56\x85\xc0\x7e\x00\x8b\x74\x24\x14\x85\xf6\x7e\x00\x3b\xf0",
+					"\xff\xff\xff\xff\xff\xff\xff\xff\x00\xff\xff\xff\xff\xff\xff\xff\x00\xff\xff",
+					19,
+				},
+				{
+					"\xff\x74\x24\x14\x8b\x4c\x24\x08\xff\x74\x24\x14\xff\x74\x24\x14\xff\x74\x24\x14\xe8\x00\x00\x00\x00\xc2\x14\x00\xcc\xcc\xcc\xcc\xb8",
+					"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x00\x00\x00\x00\xff\xff\xff\xff\xff\xff\xff\xff",
+					33,
+				},
 #endif
+			});
+
+			basePtr = static_cast<uint8_t*>(oodleFunctions[0].front()) + 1;
+			s_oodle.OodleNetwork1UDP_State_Size = reinterpret_cast<Utils::OodleNetwork1UDP_State_Size*>(basePtr);
+			s_oodle.OodleNetwork1UDP_Train = static_cast<Utils::OodleNetwork1UDP_Train*>(oodleFunctions[1].front());
+			s_oodle.OodleNetwork1UDP_Decode = static_cast<Utils::OodleNetwork1UDP_Decode*>(oodleFunctions[2].front());
+			s_oodle.OodleNetwork1UDP_Encode = reinterpret_cast<Utils::OodleNetwork1UDP_Encode*>(oodleFunctions[3].front());
 			s_oodle.found = true;
 		} catch (const std::exception& e) {
 			m_logger->Format<LogLevel::Warning>(LogCategory::SocketHook, "Failed to find oodle stuff: {}", e.what());
@@ -695,6 +770,7 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 								return send.bridge(s, buf, len, flags);
 
 							conn->m_pImpl->SendRaw.Write(buf, len);
+							conn->m_pImpl->SendRaw.MarkWritten(Utils::QpcUs());
 							conn->m_pImpl->ProcessSendData();
 							conn->m_pImpl->AttemptSend();
 							return len;
@@ -826,6 +902,17 @@ std::wstring XivAlexander::Apps::MainApp::Internal::SocketHook::Describe() const
 	if (!m_pImpl)
 		return {};
 
+	const auto describePercentiles = [this](const Utils::LatencyHistogram* histogram) -> std::wstring {
+		if (!histogram)
+			return {};
+		const auto snapshot = histogram->TakeSnapshot();
+		if (!snapshot.Count())
+			return {};
+		return m_pImpl->Config->Runtime.FormatStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_LATENCY_PERCENTILES,
+			snapshot.Percentile(50), snapshot.Percentile(90), snapshot.Percentile(99), snapshot.Percentile(99.9),
+			snapshot.Max(), snapshot.Count());
+	};
+
 	while (true) {
 		try {
 			std::wstring result;
@@ -840,6 +927,7 @@ std::wstring XivAlexander::Apps::MainApp::Internal::SocketHook::Describe() const
 					const auto [mean, dev] = conn->SocketLatencyUs.MeanAndDeviation();
 					result += m_pImpl->Config->Runtime.FormatStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_SOCKET_LATENCY,
 						*latency, conn->SocketLatencyUs.Median(), mean, dev);
+					result += describePercentiles(&conn->SocketLatencyHistogramUs);
 				} else
 					result += m_pImpl->Config->Runtime.GetStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_SOCKET_LATENCY_FAILURE);
 
@@ -847,6 +935,7 @@ std::wstring XivAlexander::Apps::MainApp::Internal::SocketHook::Describe() const
 					const auto [mean, dev] = tracker->MeanAndDeviation();
 					result += m_pImpl->Config->Runtime.FormatStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_PING_LATENCY,
 						tracker->Latest(), tracker->Median(), mean, dev);
+					result += describePercentiles(conn->GetPingLatencyHistogramUs());
 				} else
 					result += m_pImpl->Config->Runtime.GetStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_PING_LATENCY_FAILURE);
 
@@ -854,6 +943,59 @@ std::wstring XivAlexander::Apps::MainApp::Internal::SocketHook::Describe() const
 					const auto [mean, dev] = conn->ApplicationLatencyUs.MeanAndDeviation();
 					result += m_pImpl->Config->Runtime.FormatStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_RESPONSE_DELAY,
 						conn->ApplicationLatencyUs.Median(), mean, dev);
+					result += describePercentiles(&conn->ApplicationLatencyHistogramUs);
+				}
+
+				for (const auto& [direction, histograms] : {
+					std::make_pair(L"S2C", &conn->IncomingTunnelLatencyHistogramsUs),
+					std::make_pair(L"C2S", &conn->OutgoingTunnelLatencyHistogramsUs),
+				}) {
+					for (size_t i = 0; i < histograms->size(); ++i) {
+						if (const auto percentiles = describePercentiles(&(*histograms)[i]); !percentiles.empty()) {
+							result += m_pImpl->Config->Runtime.FormatStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_TUNNEL_LATENCY,
+								direction, Utils::FromUtf8(CompressionTypeNames[i]));
+							result += percentiles;
+						}
+					}
+				}
+				result += L"\n";
+			}
+			return result;
+		} catch (...) {
+			// ignore
+		}
+	}
+}
+
+std::string XivAlexander::Apps::MainApp::Internal::SocketHook::ExportLatencyHistograms() const {
+	if (!m_pImpl)
+		return {};
+
+	while (true) {
+		try {
+			std::string result;
+			for (const auto& entry : m_pImpl->Sockets) {
+				const auto& conn = entry.second;
+				const auto title = std::format("{:x} ({} -> {})",
+					entry.first,
+					Utils::ToString(conn->m_pImpl->LocalAddress),
+					Utils::ToString(conn->m_pImpl->RemoteAddress));
+
+				result += conn->SocketLatencyHistogramUs.TakeSnapshot().ToCsv(std::format("{}: Socket Latency (us)", title));
+				result += "\n";
+				if (const auto histogram = conn->GetPingLatencyHistogramUs()) {
+					result += histogram->TakeSnapshot().ToCsv(std::format("{}: Ping Latency (us)", title));
+					result += "\n";
+				}
+				result += conn->ApplicationLatencyHistogramUs.TakeSnapshot().ToCsv(std::format("{}: Response Delay (us)", title));
+				result += "\n";
+				for (size_t i = 0; i < conn->IncomingTunnelLatencyHistogramsUs.size(); ++i) {
+					result += conn->IncomingTunnelLatencyHistogramsUs[i].TakeSnapshot().ToCsv(std::format("{}: Processing Delay, S2C, {} (us)", title, CompressionTypeNames[i]));
+					result += "\n";
+				}
+				for (size_t i = 0; i < conn->OutgoingTunnelLatencyHistogramsUs.size(); ++i) {
+					result += conn->OutgoingTunnelLatencyHistogramsUs[i].TakeSnapshot().ToCsv(std::format("{}: Processing Delay, C2S, {} (us)", title, CompressionTypeNames[i]));
+					result += "\n";
 				}
 			}
 			return result;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <XivAlexanderCommon/Utils/LatencyHistogram.h>
 #include <XivAlexanderCommon/Utils/ListenerManager.h>
 #include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
 
@@ -50,6 +51,17 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		Utils::NumericStatisticsTracker SocketLatencyUs{ 10, 0 };
 		Utils::NumericStatisticsTracker ApplicationLatencyUs{ 10, 0 };
 		const Utils::NumericStatisticsTracker* GetPingLatencyTrackerUs() const;
+
+		// Sampled on every keep-alive response, and kept for the lifetime of the connection.
+		Utils::LatencyHistogram SocketLatencyHistogramUs;
+		Utils::LatencyHistogram ApplicationLatencyHistogramUs;
+		const Utils::LatencyHistogram* GetPingLatencyHistogramUs() const;
+
+		// Time taken from data entering XivAlexander to processed bundle leaving XivAlexander, indexed by compression type.
+		// Incoming: from recv returning data to the game reading the processed bundle.
+		// Outgoing: from the game calling send to the processed bundle being sent to the server.
+		std::array<Utils::LatencyHistogram, 3> IncomingTunnelLatencyHistogramsUs;
+		std::array<Utils::LatencyHistogram, 3> OutgoingTunnelLatencyHistogramsUs;
 	};
 
 	class SocketHook {
@@ -86,5 +98,8 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		void ReleaseSockets();
 
 		[[nodiscard]] std::wstring Describe() const;
+
+		/// \brief Formats latency histograms of all connections as CSV.
+		[[nodiscard]] std::string ExportLatencyHistograms() const;
 	};
 }
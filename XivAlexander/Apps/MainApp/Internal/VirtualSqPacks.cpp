@@ -21,6 +21,7 @@
 #include <XivAlexanderCommon/Sqex/Sqpack/Reader.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/TextureEntryProvider.h>
 #include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
+#include <XivAlexanderCommon/Utils/PrefilteredRegex.h>
 #include <XivAlexanderCommon/Utils/Win32/Process.h>
 #include <XivAlexanderCommon/Utils/Win32/TaskDialogBuilder.h>
 #include <XivAlexanderCommon/Utils/Win32/ThreadPool.h>
@@ -50,6 +51,9 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 	std::map<std::filesystem::path, Sqex::Sqpack::Creator::SqpackViews> SqpackViews;
 	std::map<HANDLE, std::unique_ptr<OverlayedHandleData>> OverlayedHandles;
 
+	Sqex::ThirdParty::TexTools::ItemMetadataComposer MetadataComposer{ [this](const std::string& path) { return GetOriginalEntry(path); } };
+	std::map<std::string, std::shared_ptr<Sqex::Sqpack::EntryProvider>> MetadataProviders;
+
 	uint64_t LastIoRequestTimestamp = 0;
 	Utils::Win32::Event IoEvent = Utils::Win32::Event::Create();
 	Utils::Win32::Event IoLockEvent = Utils::Win32::Event::Create(nullptr, TRUE, TRUE);
@@ -105,11 +109,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 	struct ReflectUsedEntriesTempData {
 		std::map<Sqex::Sqpack::EntryPathSpec, std::tuple<Sqex::Sqpack::HotSwappableEntryProvider*, std::shared_ptr<Sqex::Sqpack::EntryProvider>, std::string>, Sqex::Sqpack::EntryPathSpec::AllHashComparator> Replacements;
-		std::map<std::string, Sqex::Est::File> Est;
-		Sqex::EqpGmp::ExpandedFile Eqp;
-		Sqex::EqpGmp::ExpandedFile Gmp;
-		std::map<std::string, Sqex::Imc::File> Imc;
-		std::map<std::pair<Sqex::ThirdParty::TexTools::ItemMetadata::TargetItemType, uint32_t>, Sqex::Eqdp::ExpandedFile> Eqdp;
+		std::vector<std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata>> Metadata;
 	};
 
 	void ReflectUsedEntries(bool isCalledFromConstructor = false) {
@@ -143,10 +143,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			const auto resumeIo = Utils::CallOnDestruction([this]() { IoLockEvent.Set(); });
 		}
 
-		ReflectUsedEntriesTempData tempData{
-			.Eqp{*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath)},
-			.Gmp{*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath)},
-		};
+		ReflectUsedEntriesTempData tempData;
 
 		// Step. Find voices to enable or disable
 		const auto voBattle = Sqex::Sqpack::SqexHash("sound/voice/vo_battle", SIZE_MAX);
@@ -189,8 +186,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 				if (!entry.IsMetadata()) {
 					ReflectUsedEntries_FindPlaceholders(it->second, tempData, entry.FullPath);
 				} else {
-					const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false });
-					const auto metadata = Sqex::ThirdParty::TexTools::ItemMetadata(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
+					const auto& metadata = *ttmp.GetItemMetadata(entry);
 					ReflectUsedEntries_FindPlaceholders(it->second, tempData, metadata.TargetImcPath);
 					ReflectUsedEntries_FindPlaceholders(it->second, tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath);
 					ReflectUsedEntries_FindPlaceholders(it->second, tempData, Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath);
@@ -266,15 +262,15 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			}
 			});
 
-		// Step. Replace metadata files
-		for (const auto& [path, data] : tempData.Est)
-			ReflectUsedEntries_SetFromBuffer(tempData, path, data.Data());
-		ReflectUsedEntries_SetFromBuffer(tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqpPath, tempData.Eqp.DataBytes());
-		ReflectUsedEntries_SetFromBuffer(tempData, Sqex::ThirdParty::TexTools::ItemMetadata::GmpPath, tempData.Gmp.DataBytes());
-		for (const auto& [path, data] : tempData.Imc)
-			ReflectUsedEntries_SetFromBuffer(tempData, path, data.Data());
-		for (const auto& [eqdpKey, data] : tempData.Eqdp)
-			ReflectUsedEntries_SetFromBuffer(tempData, Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(eqdpKey.first, eqdpKey.second), data.Data());
+		// Step. Replace metadata files; only the ones whose item metadata have changed get recomputed
+		for (const auto& path : MetadataComposer.Update(tempData.Metadata)) {
+			if (const auto data = MetadataComposer.Get(path))
+				MetadataProviders.insert_or_assign(path, std::make_shared<Sqex::Sqpack::OnTheFlyBinaryEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(*data)));
+			else
+				MetadataProviders.erase(path);
+		}
+		for (const auto& [path, provider] : MetadataProviders)
+			ReflectUsedEntries_SetFromProvider(tempData, path, provider);
 
 		// Step. Apply replacements
 		for (const auto& pathSpec : tempData.Replacements | std::views::keys) {
@@ -325,32 +321,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		const Sqex::ThirdParty::TexTools::ModEntry& entry
 	) {
 		if (entry.IsMetadata()) {
-			const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false });
-			const auto metadata = Sqex::ThirdParty::TexTools::ItemMetadata(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
-			metadata.ApplyImcEdits([&]() -> Sqex::Imc::File& {
-				const auto imcPath = metadata.TargetImcPath;
-				if (const auto it = tempData.Imc.find(imcPath); it == tempData.Imc.end())
-					return tempData.Imc[imcPath] = Sqex::Imc::File(*GetOriginalEntry(metadata.SourceImcPath));
-				else
-					return it->second;
-				});
-			metadata.ApplyEqdpEdits([&](auto type, auto race) -> Sqex::Eqdp::ExpandedFile& {
-				const auto key = std::make_pair(type, race);
-				if (const auto it = tempData.Eqdp.find(key); it == tempData.Eqdp.end())
-					return tempData.Eqdp[key] = Sqex::Eqdp::ExpandedFile(*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(type, race)));
-				else
-					return it->second;
-				});
-			metadata.ApplyEqpEdits(tempData.Eqp);
-			metadata.ApplyGmpEdits(tempData.Gmp);
-
-			const auto estPath = Sqex::ThirdParty::TexTools::ItemMetadata::EstPath(metadata.EstType);
-			if (estPath) {
-				if (const auto it = tempData.Est.find(estPath); it == tempData.Est.end())
-					metadata.ApplyEstEdits(tempData.Est[estPath] = Sqex::Est::File(*GetOriginalEntry(estPath)));
-				else
-					metadata.ApplyEstEdits(it->second);
-			}
+			tempData.Metadata.emplace_back(ttmp.GetItemMetadata(entry));
 		} else {
 			const auto entryIt = tempData.Replacements.find(entry.FullPath);
 			if (entryIt == tempData.Replacements.end())
@@ -364,10 +335,10 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		}
 	}
 
-	void ReflectUsedEntries_SetFromBuffer(
+	void ReflectUsedEntries_SetFromProvider(
 		ReflectUsedEntriesTempData& tempData,
 		const std::string& path,
-		const std::vector<uint8_t>& data
+		std::shared_ptr<Sqex::Sqpack::EntryProvider> provider
 	) {
 		const auto pathSpec = Sqex::Sqpack::EntryPathSpec(path);
 
@@ -375,8 +346,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		if (entryIt == tempData.Replacements.end())
 			return;
 
-		std::get<1>(entryIt->second) = std::make_shared<Sqex::Sqpack::OnTheFlyBinaryEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(data));
-		// std::get<1>(entryIt->second) = std::make_shared<Sqex::Sqpack::EmptyOrObfuscatedEntryProvider>(path, std::make_shared<Sqex::MemoryRandomAccessStream>(data));
+		std::get<1>(entryIt->second) = std::move(provider);
 		std::get<2>(entryIt->second) = "Metadata";
 	}
 
@@ -502,7 +472,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 									writer.SetSoundEntry(i, Sqex::Sound::ScdWriter::SoundEntry::EmptyEntry());
 								}
 								EmptyScd = std::make_shared<Sqex::MemoryRandomAccessStream>(
-									Sqex::Sqpack::MemoryBinaryEntryProvider("dummy/dummy", std::make_shared<Sqex::MemoryRandomAccessStream>(writer.Export()), Config->Runtime.CompressModdedFiles ? Z_BEST_COMPRESSION : Z_NO_COMPRESSION)
+									Sqex::Sqpack::MemoryBinaryEntryProvider("dummy/dummy", writer.ExportStream(), Config->Runtime.CompressModdedFiles ? Z_BEST_COMPRESSION : Z_NO_COMPRESSION)
 									.ReadStreamIntoVector<uint8_t>(0));
 								//EmptyScd = std::make_shared<Sqex::MemoryRandomAccessStream>(
 								//	Sqex::Sqpack::EmptyOrObfuscatedEntryProvider("dummy/dummy", std::make_shared<Sqex::MemoryRandomAccessStream>(writer.Export()))
@@ -1010,11 +980,11 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 				if (needRecreate) {
 					create_directories(cachedDir);
 
-					std::vector<std::pair<srell::u8cregex, std::map<Sqex::Language, std::vector<size_t>>>> columnMaps;
-					std::vector<std::pair<srell::u8cregex, Misc::ExcelTransformConfig::PluralColumns>> pluralColumns;
+					std::vector<std::pair<Utils::PrefilteredRegex, std::map<Sqex::Language, std::vector<size_t>>>> columnMaps;
+					std::vector<std::pair<Utils::PrefilteredRegex, Misc::ExcelTransformConfig::PluralColumns>> pluralColumns;
 					struct ReplacementRule {
-						srell::u8cregex exhNamePattern;
-						srell::u8cregex stringPattern;
+						Utils::PrefilteredRegex exhNamePattern;
+						Utils::PrefilteredRegex stringPattern;
 						std::vector<Sqex::Language> sourceLanguage;
 						std::string replaceTo;
 						std::set<size_t> columnIndices;
@@ -1034,10 +1004,10 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 							from_json(Utils::ParseJsonFromFile(Config->TranslatePath(configFile)), transformConfig);
 
 							for (const auto& entry : transformConfig.columnMap) {
-								columnMaps.emplace_back(srell::u8cregex(entry.first, srell::regex_constants::ECMAScript | srell::regex_constants::icase), entry.second);
+								columnMaps.emplace_back(Utils::PrefilteredRegex(entry.first, true), entry.second);
 							}
 							for (const auto& entry : transformConfig.pluralMap) {
-								pluralColumns.emplace_back(srell::u8cregex(entry.first, srell::regex_constants::ECMAScript | srell::regex_constants::icase), entry.second);
+								pluralColumns.emplace_back(Utils::PrefilteredRegex(entry.first, true), entry.second);
 							}
 							for (const auto& entry : transformConfig.replacementTemplates) {
 								columnReplacementTemplates.emplace(entry.first, std::make_pair(
@@ -1049,8 +1019,8 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 								for (const auto& targetGroupName : rule.targetGroups) {
 									for (const auto& target : transformConfig.targetGroups.at(targetGroupName).columnIndices) {
 										rowReplacementRules[transformConfig.targetLanguage].emplace_back(ReplacementRule{
-											srell::u8cregex(target.first, srell::regex_constants::ECMAScript | srell::regex_constants::icase),
-											srell::u8cregex(rule.stringPattern, srell::regex_constants::ECMAScript | srell::regex_constants::icase),
+											Utils::PrefilteredRegex(target.first, true),
+											Utils::PrefilteredRegex(rule.stringPattern, true),
 											transformConfig.sourceLanguages,
 											rule.replaceTo,
 											{target.second.begin(), target.second.end()},
@@ -1073,6 +1043,39 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 						return;
 					}
 
+					// Resolve which rules apply to which sheet once, instead of matching sheet name patterns from every task.
+					struct SheetRules {
+						Misc::ExcelTransformConfig::PluralColumns pluralColumnIndices;
+						std::map<Sqex::Language, std::vector<const ReplacementRule*>> rowReplacementRules;
+						std::map<Sqex::Language, std::vector<size_t>> columnMap;
+					};
+					std::map<std::string, SheetRules> sheetRulesTable;
+					for (const auto& exhName : exhTable | std::views::keys) {
+						auto& sheetRules = sheetRulesTable[exhName];
+						for (const auto& [pattern, data] : pluralColumns) {
+							if (pattern.Search(exhName)) {
+								sheetRules.pluralColumnIndices = data;
+								break;
+							}
+						}
+
+						for (const auto language : fallbackLanguageList)
+							sheetRules.rowReplacementRules.emplace(language, std::vector<const ReplacementRule*>{});
+						for (const auto& [language, rules] : rowReplacementRules) {
+							auto& exhRules = sheetRules.rowReplacementRules[language];
+							for (const auto& rule : rules)
+								if (rule.exhNamePattern.Search(exhName))
+									exhRules.emplace_back(&rule);
+						}
+
+						for (const auto& [pattern, data] : columnMaps) {
+							if (!pattern.Search(exhName))
+								continue;
+							for (const auto& [language, data2] : data)
+								sheetRules.columnMap[language] = data2;
+						}
+					}
+
 					const auto actCtx = Dll::ActivationContext().With();
 					Utils::Win32::TpEnvironment pool(L"SetUpMergedExd");
 					progressWindow.UpdateMessage(Utils::ToUtf8(Config->Runtime.GetStringRes(IDS_TITLE_GENERATING_EXD_FILES)));
@@ -1082,6 +1085,13 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					for (const auto& exhName : exhTable | std::views::keys)
 						progressPerTask.emplace(exhName, 0);
 					progressWindow.UpdateProgress(0, 1ULL * exhTable.size() * ProgressMaxPerTask);
+
+					// Each sheet runs as one task of the pool, and splits reading and compiling its pages across the threads
+					// the other sheets in flight leave idle, so that a few large sheets left at the end do not run serially.
+					std::atomic_size_t sheetsInFlight = 0;
+					const auto threadsPerSheet = [&]() {
+						return static_cast<uint32_t>(std::max<size_t>(1, pool.ThreadCount() / std::max<size_t>(1, sheetsInFlight)));
+					};
 					{
 						const auto ttmpl = Utils::Win32::Handle::FromCreateFile(cachedDir / "TTMPL.mpl.tmp", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, 0);
 						const auto ttmpd = Utils::Win32::Handle::FromCreateFile(cachedDir / "TTMPD.mpd.tmp", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, 0);
@@ -1097,6 +1107,9 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 										if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
 											return;
 
+										++sheetsInFlight;
+										const auto leaveSheet = Utils::CallOnDestruction([&sheetsInFlight]() { --sheetsInFlight; });
+
 										lastStep = "Calculate maximum progress";
 										size_t progressIndex = 0;
 										uint64_t currentProgressMax = 0;
@@ -1106,6 +1119,19 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 											progressStoreTarget = (1ULL * progressIndex * ProgressMaxPerTask + (currentProgressMax ? currentProgress * ProgressMaxPerTask / currentProgressMax : 0)) / (readers.size() + 2ULL);
 										};
 
+										// Pages are applied in order as soon as each is read, one at a time, from whichever thread read it.
+										const auto readPages = [&](const Sqex::Excel::ExhReader& exh, const auto& streamGetter, const std::function<void(Sqex::Excel::ExdPageRows&)>& onPage) {
+											currentProgressMax = 1ULL * exh.Languages.size() * exh.Pages.size();
+											Sqex::Excel::ReadDepth2Pages(exh, streamGetter, threadsPerSheet(), [&](Sqex::Excel::ExdPageRows& page) {
+												if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
+													return false;
+												onPage(page);
+												currentProgress++;
+												publishProgress();
+												return true;
+											});
+										};
+
 										lastStep = "Load source EXH/D files";
 										const auto exhPath = Sqex::Sqpack::EntryPathSpec(std::format("exd/{}.exh", exhName));
 										std::unique_ptr<Sqex::Excel::Depth2ExhExdCreator> exCreator;
@@ -1130,27 +1156,26 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 											exCreator->AddLanguage(Sqex::Language::ChineseSimplified);
 											exCreator->AddLanguage(Sqex::Language::Korean);
 
-											currentProgressMax = 1ULL * exhReaderSource.Languages.size() * exhReaderSource.Pages.size();
-											for (const auto language : exhReaderSource.Languages) {
-												for (const auto& page : exhReaderSource.Pages) {
-													if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
-														return;
-													currentProgress++;
-													publishProgress();
-
-													const auto exdPathSpec = exhReaderSource.GetDataPathSpec(page, language);
-													try {
-														const auto exdReader = Sqex::Excel::ExdReader(exhReaderSource, creator[exdPathSpec]);
-														exCreator->AddLanguage(language);
-														for (const auto i : exdReader.GetIds())
-															exCreator->SetRow(i, language, exdReader.ReadDepth2(i));
-													} catch (const std::out_of_range&) {
-														// pass
-													} catch (const std::exception& e) {
-														throw std::runtime_error(std::format("Error occurred while processing {}: {}", exdPathSpec, e.what()));
-													}
+											readPages(exhReaderSource, [&creator](const Sqex::Sqpack::EntryPathSpec& pathSpec) -> std::shared_ptr<const Sqex::RandomAccessStream> {
+												return creator[pathSpec];
+											}, [&](Sqex::Excel::ExdPageRows& page) {
+												const auto exdPathSpec = exhReaderSource.GetDataPathSpec(page.Page, page.Language);
+												try {
+													if (page.Error && page.Rows.empty())
+														std::rethrow_exception(page.Error);
+													exCreator->AddLanguage(page.Language);
+													for (auto& [i, row] : page.Rows)
+														exCreator->SetRow(i, page.Language, std::move(row));
+													if (page.Error)
+														std::rethrow_exception(page.Error);
+												} catch (const std::out_of_range&) {
+													// pass
+												} catch (const std::exception& e) {
+													throw std::runtime_error(std::format("Error occurred while processing {}: {}", exdPathSpec, e.what()));
 												}
-											}
+											});
+											if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
+												return;
 											currentProgress = 0;
 											progressIndex++;
 											publishProgress();
@@ -1158,33 +1183,23 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 										lastStep = "Load basic stuff";
 										const auto sourceLanguages{ exCreator->Languages };
-										const auto pluralColumnIndices = [&]() {
-											for (const auto& [pattern, data] : pluralColumns) {
-												if (srell::regex_search(exhName, pattern))
-													return data;
-											}
-											return Misc::ExcelTransformConfig::PluralColumns();
-										}();
-										const auto exhRowReplacementRules = [&]() {
-											std::map<Sqex::Language, std::vector<ReplacementRule>> res;
-											for (const auto language : fallbackLanguageList)
-												res.emplace(language, std::vector<ReplacementRule>{});
-
-											for (auto& [language, rules] : rowReplacementRules) {
-												auto& exhRules = res.at(language);
-												for (auto& rule : rules)
-													if (srell::regex_search(exhName, rule.exhNamePattern))
-														exhRules.emplace_back(rule);
-											}
-											return res;
-										}();
-										const auto columnMap = [&]() -> std::map<Sqex::Language, std::vector<size_t>> {
-											std::map<Sqex::Language, std::vector<size_t>> res;
-											for (const auto& [pattern, data] : columnMaps) {
-												if (!srell::regex_search(exhName, pattern))
-													continue;
-												for (const auto& [language, data2] : data)
-													res[language] = data2;
+										const auto& sheetRules = sheetRulesTable.at(exhName);
+										const auto& pluralColumnIndices = sheetRules.pluralColumnIndices;
+										const auto& exhRowReplacementRules = sheetRules.rowReplacementRules;
+										const auto& columnMap = sheetRules.columnMap;
+
+										// String patterns only need to be tried on string columns that the rule targets.
+										const auto exhColumnReplacementRules = [&]() {
+											std::map<Sqex::Language, std::vector<std::vector<const ReplacementRule*>>> res;
+											for (const auto& [language, rules] : exhRowReplacementRules) {
+												auto& byColumn = res[language];
+												byColumn.resize(exCreator->Columns.size());
+												for (const auto* rule : rules) {
+													for (const auto columnIndex : rule->columnIndices) {
+														if (columnIndex < byColumn.size() && exCreator->Columns[columnIndex].IsString())
+															byColumn[columnIndex].emplace_back(rule);
+													}
+												}
 											}
 											return res;
 										}();
@@ -1319,109 +1334,108 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 											for (const auto& reader : readers) {
 												try {
 													const auto exhReaderCurrent = Sqex::Excel::ExhReader(exhName, *(*reader)[exhPath]);
-													currentProgressMax = 1ULL * exhReaderCurrent.Languages.size() * exhReaderCurrent.Pages.size();
-													for (const auto language : exhReaderCurrent.Languages) {
-														for (const auto& page : exhReaderCurrent.Pages) {
-															if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
-																return;
-															currentProgress++;
-															publishProgress();
-
-															const auto exdPathSpec = exhReaderCurrent.GetDataPathSpec(page, language);
-															try {
-																Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
-																	"[{}] Adding {}", exhName, exdPathSpec);
-																const auto exdReader = Sqex::Excel::ExdReader(exhReaderCurrent, (*reader)[exdPathSpec]);
-																exCreator->AddLanguage(language);
-																for (const auto i : exdReader.GetIds()) {
-																	auto row = exdReader.ReadDepth2(i);
-																	const auto rowSetIt = exCreator->Data.find(i);
-																	if (rowSetIt == exCreator->Data.end())
-																		continue;
+													readPages(exhReaderCurrent, [&reader](const Sqex::Sqpack::EntryPathSpec& pathSpec) -> std::shared_ptr<const Sqex::RandomAccessStream> {
+														return (*reader)[pathSpec];
+													}, [&](Sqex::Excel::ExdPageRows& page) {
+														const auto language = page.Language;
+														const auto exdPathSpec = exhReaderCurrent.GetDataPathSpec(page.Page, language);
+														try {
+															Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
+																"[{}] Adding {}", exhName, exdPathSpec);
+															if (page.Error && page.Rows.empty())
+																std::rethrow_exception(page.Error);
+															exCreator->AddLanguage(language);
+															for (auto& [i, row] : page.Rows) {
+																const auto rowSetIt = exCreator->Data.find(i);
+																if (rowSetIt == exCreator->Data.end())
+																	continue;
 
-																	const auto& rowSet = rowSetIt->second;
-																	auto referenceRowLanguage = Sqex::Language::Unspecified;
-																	const std::vector<Sqex::Excel::ExdColumn>* referenceRowPtr = nullptr;
-																	for (const auto& l : exCreator->FillMissingLanguageFrom) {
-																		if (auto it = rowSet.find(l);
-																			it != rowSet.end()) {
-																			referenceRowLanguage = l;
-																			referenceRowPtr = &it->second;
-																			break;
-																		}
+																const auto& rowSet = rowSetIt->second;
+																auto referenceRowLanguage = Sqex::Language::Unspecified;
+																const std::vector<Sqex::Excel::ExdColumn>* referenceRowPtr = nullptr;
+																for (const auto& l : exCreator->FillMissingLanguageFrom) {
+																	if (auto it = rowSet.find(l);
+																		it != rowSet.end()) {
+																		referenceRowLanguage = l;
+																		referenceRowPtr = &it->second;
+																		break;
 																	}
-																	if (!referenceRowPtr)
-																		continue;
-																	const auto& referenceRow = *referenceRowPtr;
-
-																	auto prevRow{ std::move(row) };
-																	row = referenceRow;
-
-																	Sqex::SeString pluralBaseString;
-																	{
-																		constexpr auto N = Misc::ExcelTransformConfig::PluralColumns::Index_NoColumn;
-																		size_t cols[]{
-																			pluralColumnIndices.capitalizedColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.capitalizedColumnIndex),
-																			pluralColumnIndices.singularColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.singularColumnIndex),
-																			pluralColumnIndices.pluralColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.pluralColumnIndex),
-																			pluralColumnIndices.languageSpecificColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.languageSpecificColumnIndex),
-																		};
-																		for (auto& col : cols) {
-																			if (col == N || col >= prevRow.size() || prevRow[col].Type != Sqex::Excel::Exh::ColumnDataType::String)
-																				col = N;
-																			else if (!prevRow[col].String.Empty() && pluralBaseString.Empty())
-																				pluralBaseString = prevRow[col].String;
-																		}
+																}
+																if (!referenceRowPtr)
+																	continue;
+																const auto& referenceRow = *referenceRowPtr;
+
+																auto prevRow{ std::move(row) };
+																row = referenceRow;
+
+																Sqex::SeString pluralBaseString;
+																{
+																	constexpr auto N = Misc::ExcelTransformConfig::PluralColumns::Index_NoColumn;
+																	size_t cols[]{
+																		pluralColumnIndices.capitalizedColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.capitalizedColumnIndex),
+																		pluralColumnIndices.singularColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.singularColumnIndex),
+																		pluralColumnIndices.pluralColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.pluralColumnIndex),
+																		pluralColumnIndices.languageSpecificColumnIndex == N ? N : translateColumnIndex(referenceRowLanguage, language, pluralColumnIndices.languageSpecificColumnIndex),
+																	};
+																	for (auto& col : cols) {
+																		if (col == N || col >= prevRow.size() || prevRow[col].Type != Sqex::Excel::Exh::ColumnDataType::String)
+																			col = N;
+																		else if (!prevRow[col].String.Empty() && pluralBaseString.Empty())
+																			pluralBaseString = prevRow[col].String;
 																	}
+																}
 
-																	for (size_t j = 0; j < row.size(); ++j) {
-																		if (row[j].Type != Sqex::Excel::Exh::ColumnDataType::String)
-																			continue;
-
-																		const auto otherColIndex = translateColumnIndex(referenceRowLanguage, language, j);
-																		if (otherColIndex >= prevRow.size()) {
-																			if (otherColIndex != j)
-																				Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
-																					"[{}] Skipping column: Column {} of language {} is was requested but there are {} columns",
-																					exhName, j, otherColIndex, static_cast<int>(language), prevRow.size());
-																			continue;
-																		}
+																for (size_t j = 0; j < row.size(); ++j) {
+																	if (row[j].Type != Sqex::Excel::Exh::ColumnDataType::String)
+																		continue;
 
-																		if (prevRow[otherColIndex].Type != Sqex::Excel::Exh::ColumnDataType::String) {
+																	const auto otherColIndex = translateColumnIndex(referenceRowLanguage, language, j);
+																	if (otherColIndex >= prevRow.size()) {
+																		if (otherColIndex != j)
 																			Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
-																				"[{}] Skipping column: Column {} of language {} is string but column {} of language {} is not a string",
-																				exhName, j, static_cast<int>(referenceRowLanguage), otherColIndex, static_cast<int>(language));
-																			continue;
-																		}
-
-																		if (prevRow[otherColIndex].String.Empty()) {
-																			if (pluralBaseString.Empty())
-																				continue;
+																				"[{}] Skipping column: Column {} of language {} is was requested but there are {} columns",
+																				exhName, j, otherColIndex, static_cast<int>(language), prevRow.size());
+																		continue;
+																	}
 
-																			if (j != pluralColumnIndices.singularColumnIndex
-																				&& j != pluralColumnIndices.pluralColumnIndex
-																				&& j != pluralColumnIndices.capitalizedColumnIndex
-																				&& j != pluralColumnIndices.languageSpecificColumnIndex) {
-																				continue;
-																			}
+																	if (prevRow[otherColIndex].Type != Sqex::Excel::Exh::ColumnDataType::String) {
+																		Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
+																			"[{}] Skipping column: Column {} of language {} is string but column {} of language {} is not a string",
+																			exhName, j, static_cast<int>(referenceRowLanguage), otherColIndex, static_cast<int>(language));
+																		continue;
+																	}
 
-																			row[j].String = pluralBaseString;
+																	if (prevRow[otherColIndex].String.Empty()) {
+																		if (pluralBaseString.Empty())
 																			continue;
-																		}
 
-																		if (prevRow[otherColIndex].String.Escaped().starts_with("_rsv_"))
+																		if (j != pluralColumnIndices.singularColumnIndex
+																			&& j != pluralColumnIndices.pluralColumnIndex
+																			&& j != pluralColumnIndices.capitalizedColumnIndex
+																			&& j != pluralColumnIndices.languageSpecificColumnIndex) {
 																			continue;
+																		}
 
-																		row[j].String = std::move(prevRow[otherColIndex].String);
+																		row[j].String = pluralBaseString;
+																		continue;
 																	}
-																	exCreator->SetRow(i, language, std::move(row), false);
+
+																	if (prevRow[otherColIndex].String.Escaped().starts_with("_rsv_"))
+																		continue;
+
+																	row[j].String = std::move(prevRow[otherColIndex].String);
 																}
-															} catch (const std::exception& e) {
-																Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
-																	"[{}] Skipping {} because of error: {}", exhName, exdPathSpec, e.what());
+																exCreator->SetRow(i, language, std::move(row), false);
 															}
+															if (page.Error)
+																std::rethrow_exception(page.Error);
+														} catch (const std::exception& e) {
+															Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
+																"[{}] Skipping {} because of error: {}", exhName, exdPathSpec, e.what());
 														}
-													}
+													});
+													if (progressWindow.GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
+														return;
 												} catch (const std::out_of_range&) {
 													// pass
 												}
@@ -1540,6 +1554,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 											std::map<Sqex::Language, std::vector<Sqex::Excel::ExdColumn>> pendingReplacements;
 											for (const auto& language : exCreator->Languages) {
 												const auto& rules = exhRowReplacementRules.at(language);
+												const auto& columnRules = exhColumnReplacementRules.at(language);
 
 												std::set<Misc::ExcelTransformConfig::IgnoredCell>* currentIgnoredCells = nullptr;
 												if (const auto it = ignoredCells.find(language); it != ignoredCells.end())
@@ -1577,11 +1592,12 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 														}
 													}
 
-													for (const auto& rule : rules) {
-														if (!rule.columnIndices.contains(columnIndex))
-															continue;
+													if (columnIndex >= columnRules.size())
+														continue;
 
-														if (!srell::regex_search(row[columnIndex].String.Escaped(), rule.stringPattern))
+													for (const auto* pRule : columnRules[columnIndex]) {
+														const auto& rule = *pRule;
+														if (!rule.stringPattern.Search(row[columnIndex].String.Escaped()))
 															continue;
 
 														std::vector p = { std::format("{}:{}", exhName, id) };
@@ -1683,6 +1699,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 
 										{
 											lastStep = "Compile";
+											exCreator->MaxThreadCount = threadsPerSheet();
 											auto compiled = exCreator->Compile();
 
 											lastStep = "Compress";
@@ -1834,6 +1851,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					case IDRETRY:
 						continue;
 					case IDABORT:
+						Config->FlushSave();
 						ExitProcess(-1);
 					case IDIGNORE:
 						return;
@@ -1999,6 +2017,12 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					cfg.ValidateOrThrow();
 
 					Sqex::FontCsv::FontSetsCreator fontCreator(cfg, Utils::Win32::Process::Current().PathOf().parent_path());
+					try {
+						fontCreator.SetGlyphCache(std::make_shared<Sqex::FontCsv::GlyphCache>(Config->Init.ResolveConfigStorageDirectoryPath() / "Cached" / "Glyphs", 512ULL * 1024 * 1024));
+					} catch (const std::exception& e) {
+						Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks,
+							"\t=> Not using glyph cache: {}", e.what());
+					}
 					for (const auto& additionalSqpackRootDirectory : Config->Runtime.AdditionalSqpackRootDirectories.Value()) {
 						try {
 							const auto info = Misc::GameInstallationDetector::GetGameReleaseInfo(Config::TranslatePath(additionalSqpackRootDirectory));
@@ -2143,6 +2167,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 					case IDRETRY:
 						continue;
 					case IDABORT:
+						Config->FlushSave();
 						ExitProcess(-1);
 					case IDIGNORE:
 						return;
@@ -2497,8 +2522,18 @@ void XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::TtmpSet::ForEachEntr
 	}
 }
 
+std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata> XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::TtmpSet::GetItemMetadata(const Sqex::ThirdParty::TexTools::ModEntry& entry) {
+	auto key = std::make_pair(entry.ModOffset, entry.FullPath);
+	if (const auto it = ItemMetadataCache.find(key); it != ItemMetadataCache.end())
+		return it->second;
+
+	const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ DataFile, false });
+	return ItemMetadataCache[std::move(key)] = std::make_shared<const Sqex::ThirdParty::TexTools::ItemMetadata>(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
+}
+
 void XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::TtmpSet::TryCleanupUnusedFiles() {
 	DataFile.Clear();
+	ItemMetadataCache.clear();
 	for (const auto& path : {
 			ListPath.parent_path() / "TTMPD.mpd",
 			ListPath.parent_path() / "choices.json",
@@ -48,8 +48,13 @@ namespace XivAlexander::Apps::MainApp::Internal {
 			Utils::Win32::Handle DataFile;
 			nlohmann::json Choices;
 
+			// Parsed item metadata, by offset in DataFile and target path.
+			std::map<std::pair<uint64_t, std::string>, std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata>> ItemMetadataCache;
+
 			void FixChoices();
 
+			std::shared_ptr<const Sqex::ThirdParty::TexTools::ItemMetadata> GetItemMetadata(const Sqex::ThirdParty::TexTools::ModEntry& entry);
+
 			using TraverseCallbackResult = Sqex::ThirdParty::TexTools::TTMPL::TraverseCallbackResult;
 
 			void ForEachEntry(bool choiceOnly, std::function<void(const Sqex::ThirdParty::TexTools::ModEntry&)> cb) const;
@@ -84,6 +84,8 @@ bool XivAlexander::Apps::MainApp::Window::ConfigWindow::TrySave() {
 		m_direct(m_directPtr, SCI_GETTEXT, buf.length(), reinterpret_cast<sptr_t>(&buf[0]));
 		buf.resize(buf.length() - 1);
 		auto buf2 = nlohmann::json::parse(buf).dump(1, '\t');
+		// A save scheduled from earlier changes would otherwise overwrite this.
+		m_pRepository->FlushSave();
 		Utils::SaveToFile(m_pRepository->GetConfigPath(), buf2);
 		const auto firstVisibleLine = m_direct(m_directPtr, SCI_GETFIRSTVISIBLELINE, 0, 0);
 		std::vector<std::pair<size_t, size_t>> selections(m_direct(m_directPtr, SCI_GETSELECTIONS, 0, 0));
@@ -17,6 +17,7 @@
 #include "Apps/MainApp/App.h"
 #include "Apps/MainApp/Internal/GameResourceOverrider.h"
 #include "Apps/MainApp/Internal/MainThreadTimingHandler.h"
+#include "Apps/MainApp/Internal/NetworkTimingHandler.h"
 #include "Apps/MainApp/Internal/SocketHook.h"
 #include "Apps/MainApp/Internal/VirtualSqPacks.h"
 #include "Apps/MainApp/Window/ConfigWindow.h"
@@ -232,6 +233,7 @@ LRESULT XivAlexander::Apps::MainApp::Window::MainWindow::WndProc(HWND hwnd, UINT
 			DestroyWindow(m_hWnd);
 		} else if (lParam == 2) {
 			RemoveTrayIcon();
+			m_config->FlushSave();
 			TerminateProcess(GetCurrentProcess(), static_cast<UINT>(wParam));
 		} else {
 			switch (Dll::MessageBoxF(m_hWnd, MB_YESNOCANCEL | MB_ICONQUESTION, m_config->Runtime.FormatStringRes(IDS_CONFIRM_MAIN_WINDOW_CLOSE,
@@ -1033,6 +1035,7 @@ void XivAlexander::Apps::MainApp::Window::MainWindow::SetMenuStates() const {
 		SetMenuState(hMenu, ID_NETWORK_HIGHLATENCYMITIGATION_MODE_3, config.HighLatencyMitigationMode == HighLatencyMitigationMode::SimulateNormalizedRttAndLatency, true);
 		SetMenuState(hMenu, ID_NETWORK_HIGHLATENCYMITIGATION_USELOGGING, config.UseHighLatencyMitigationLogging, true);
 		SetMenuState(hMenu, ID_NETWORK_HIGHLATENCYMITIGATION_PREVIEWMODE, config.UseHighLatencyMitigationPreviewMode, true);
+		SetMenuState(hMenu, ID_NETWORK_HIGHLATENCYMITIGATION_SAVETRACE, false, config.UseNetworkTimingHandler);
 		SetMenuState(hMenu, ID_NETWORK_USEIPCTYPEFINDER, config.UseOpcodeFinder, true);
 		SetMenuState(hMenu, ID_NETWORK_USEALLIPCMESSAGELOGGER, config.UseAllIpcMessageLogger, true);
 		SetMenuState(hMenu, ID_NETWORK_REDUCEPACKETDELAY, config.ReducePacketDelay, true);
@@ -1218,6 +1221,7 @@ void XivAlexander::Apps::MainApp::Window::MainWindow::OnCommand_Menu_File(int me
 		case ID_FILE_FORCEEXITGAME:
 			if (Dll::MessageBoxF(m_hWnd, MB_YESNO | MB_ICONQUESTION, m_config->Runtime.GetStringRes(IDS_CONFIRM_EXIT_GAME)) == IDYES) {
 				RemoveTrayIcon();
+				m_config->FlushSave();
 				TerminateProcess(GetCurrentProcess(), 0);
 			}
 			return;
@@ -1375,6 +1379,40 @@ void XivAlexander::Apps::MainApp::Window::MainWindow::OnCommand_Menu_Network(int
 				});
 			return;
 
+		case ID_NETWORK_HIGHLATENCYMITIGATION_SAVETRACE: {
+			const auto& handler = m_app.GetNetworkTimingHandler();
+			if (!handler)
+				return;
+
+			const auto trace = handler->GetTimingTrace();
+			SYSTEMTIME lt{};
+			GetLocalTime(&lt);
+			const auto basePath = m_config->Init.ResolveConfigStorageDirectoryPath() / std::format(L"NetworkTimingTrace_{:04}{:02}{:02}_{:02}{:02}{:02}",
+				lt.wYear, lt.wMonth, lt.wDay, lt.wHour, lt.wMinute, lt.wSecond);
+			auto textPath = basePath, csvPath = basePath, binaryPath = basePath;
+			textPath.replace_extension(L".log");
+			csvPath.replace_extension(L".csv");
+			binaryPath.replace_extension(L".bin");
+			Utils::SaveToFile(textPath, std::format("{}\n{}", trace.Analyze().ToString(), trace.ToText()));
+			Utils::SaveToFile(csvPath, trace.ToCsv());
+			const auto binary = trace.Serialize();
+			Utils::SaveToFile(binaryPath, std::span(reinterpret_cast<const char*>(binary.data()), binary.size()));
+			if (Dll::MessageBoxF(m_hWnd, MB_YESNO | MB_ICONINFORMATION, IDS_LOG_SAVED, textPath.wstring()) == IDYES)
+				Utils::Win32::ShellExecutePathOrThrow(textPath, m_hWnd);
+			return;
+		}
+
+		case ID_NETWORK_SAVELATENCYHISTOGRAMS: {
+			SYSTEMTIME lt{};
+			GetLocalTime(&lt);
+			const auto path = m_config->Init.ResolveConfigStorageDirectoryPath() / std::format(L"LatencyHistograms_{:04}{:02}{:02}_{:02}{:02}{:02}.csv",
+				lt.wYear, lt.wMonth, lt.wDay, lt.wHour, lt.wMinute, lt.wSecond);
+			Utils::SaveToFile(path, m_app.GetSocketHook().ExportLatencyHistograms());
+			if (Dll::MessageBoxF(m_hWnd, MB_YESNO | MB_ICONINFORMATION, IDS_LOG_SAVED, path.wstring()) == IDYES)
+				Utils::Win32::ShellExecutePathOrThrow(path, m_hWnd);
+			return;
+		}
+
 		case ID_NETWORK_TROUBLESHOOTREMOTEADDRESSES_TAKEOVERLOOPBACKADDRESSES:
 			config.TakeOverLoopbackAddresses.Toggle();
 			return;
@@ -1829,10 +1867,15 @@ void XivAlexander::Apps::MainApp::Window::MainWindow::OnCommand_Menu_Modding(int
 									if (!resolved)
 										throw std::runtime_error("Not all source files are found");
 
-									importer.Merge([&targetBasePath](std::filesystem::path path, std::vector<uint8_t> data) {
+									importer.Merge([&targetBasePath](const std::filesystem::path& path, const Sqex::RandomAccessStream& data) {
 										const auto targetPath = targetBasePath / path;
 										create_directories(targetPath.parent_path());
-										Utils::Win32::Handle::FromCreateFile(targetPath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, 0).Write(0, std::span(data));
+										const auto file = Utils::Win32::Handle::FromCreateFile(targetPath, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, 0);
+										std::vector<uint8_t> buf(65536);
+										Sqex::Align<uint64_t>(data.StreamSize(), buf.size()).IterateChunked([&](uint64_t, uint64_t offset, uint64_t size) {
+											data.ReadStream(offset, &buf[0], size);
+											file.Write(offset, &buf[0], static_cast<size_t>(size));
+											});
 										});
 									if (m_backgroundWorkerProgressWindow->GetCancelEvent().Wait(0) == WAIT_OBJECT_0)
 										return;
@@ -46,11 +46,16 @@ static const std::map<Sqex::Region, int> RegionResourceIdMap{
 	{Sqex::Region::Korea, IDS_REGION_NAME_KOREA},
 };
 
+// Changes are usually made in bursts, such as from dragging a slider or reloading; write once when they settle down.
+static constexpr auto SaveDelay = std::chrono::milliseconds(500);
+static constexpr auto SaveMaxDelay = std::chrono::seconds(5);
+
 XivAlexander::Config::BaseRepository::BaseRepository(__in_opt const Config* pConfig, std::filesystem::path path, std::string parentKey)
 	: m_pConfig(pConfig)
 	, m_sConfigPath(std::move(path))
 	, m_parentKey(std::move(parentKey))
-	, m_logger(Misc::Logger::Acquire()) {
+	, m_logger(Misc::Logger::Acquire())
+	, m_deferredSave(L"Config::BaseRepository::DeferredSave", [this]() { SaveNow(m_sConfigPath); }, SaveDelay, SaveMaxDelay) {
 }
 
 XivAlexander::Config::BaseRepository::~BaseRepository() = default;
@@ -74,6 +79,9 @@ Utils::CallOnDestruction XivAlexander::Config::ItemBase::AddAndCallOnChange(std:
 void XivAlexander::Config::BaseRepository::Reload(const std::filesystem::path & from) {
 	m_loaded = true;
 
+	// What is about to be loaded takes precedence over changes not yet written.
+	m_deferredSave.Cancel();
+
 	nlohmann::json totalConfig;
 	if (exists(from.empty() ? m_sConfigPath : from)) {
 		try {
@@ -129,6 +137,14 @@ XivAlexander::Config::RuntimeRepository::RuntimeRepository(__in_opt const Config
 		Utils::Win32::Error::SetDefaultLanguageId(GetLangId());
 		});
 
+	m_cleanup += MinimumLogLevels.AddAndCallOnChange([&]() {
+		const auto logger = Misc::Logger::Acquire();
+		for (const auto& [category, name] : Misc::Logger::LogCategoryNames) {
+			const auto it = MinimumLogLevels.Value().find(name);
+			logger->SetMinimumLevel(category, it == MinimumLogLevels.Value().end() ? LogLevel::Debug : it->second);
+		}
+		});
+
 	m_cleanup += MusicImportConfig.AddAndCallOnChange([&]() {
 		std::set<std::string> newKeys;
 		m_musicDirectoryPurchaseWebsites.clear();
@@ -317,8 +333,16 @@ XivAlexander::Config::Config(std::filesystem::path initializationConfigPath)
 	Game.Reload();
 }
 
-XivAlexander::Config::~Config() = default;
+XivAlexander::Config::~Config() {
+	FlushSave();
+}
+
 
+void XivAlexander::Config::FlushSave() {
+	Init.FlushSave();
+	Runtime.FlushSave();
+	Game.FlushSave();
+}
 
 void XivAlexander::Config::Reload() {
 	Init.Reload();
@@ -336,9 +360,10 @@ Utils::CallOnDestruction XivAlexander::Config::BaseRepository::WithSuppressSave(
 			m_suppressSave.SupressionCounter -= 1;
 			if (m_suppressSave.SupressionCounter || !m_suppressSave.PendingSave)
 				return;
+			m_suppressSave.PendingSave = false;
 		}
 
-		Save();
+		m_deferredSave.Schedule();
 	} };
 }
 
@@ -348,7 +373,29 @@ void XivAlexander::Config::BaseRepository::Save(const std::filesystem::path & to
 		return;
 	}
 
-	const auto& targetPath = to.empty() ? m_sConfigPath : to;
+	if (to.empty() || to == m_sConfigPath)
+		m_deferredSave.Run();
+	else
+		SaveNow(to);
+}
+
+void XivAlexander::Config::BaseRepository::ScheduleSave() {
+	{
+		const auto _ = std::lock_guard(m_suppressSave.Mtx);
+		if (m_suppressSave.SupressionCounter) {
+			m_suppressSave.PendingSave = true;
+			return;
+		}
+	}
+
+	m_deferredSave.Schedule();
+}
+
+void XivAlexander::Config::BaseRepository::FlushSave() {
+	m_deferredSave.Flush();
+}
+
+void XivAlexander::Config::BaseRepository::SaveNow(const std::filesystem::path & targetPath) {
 	if (targetPath.empty())
 		return;
 
@@ -397,6 +444,42 @@ void XivAlexander::Config::Item<uint16_t>::SaveTo(nlohmann::json & data) const {
 	data[Name] = std::format("0x{:04x}", m_value);
 }
 
+void XivAlexander::to_json(nlohmann::json & j, const LogLevel & value) {
+	switch (value) {
+		case LogLevel::Info:
+			j = "Info";
+			break;
+
+		case LogLevel::Warning:
+			j = "Warning";
+			break;
+
+		case LogLevel::Error:
+			j = "Error";
+			break;
+
+		case LogLevel::Debug:
+		default:
+			j = "Debug";
+	}
+}
+
+void XivAlexander::from_json(const nlohmann::json & it, LogLevel & value) {
+	auto newValueString = Utils::FromUtf8(it.get<std::string>());
+	CharLowerW(&newValueString[0]);
+
+	value = LogLevel::Debug;
+	if (newValueString.empty())
+		return;
+
+	if (newValueString.substr(0, std::min<size_t>(4, newValueString.size())) == L"info")
+		value = LogLevel::Info;
+	else if (newValueString.substr(0, std::min<size_t>(7, newValueString.size())) == L"warning")
+		value = LogLevel::Warning;
+	else if (newValueString.substr(0, std::min<size_t>(5, newValueString.size())) == L"error")
+		value = LogLevel::Error;
+}
+
 void XivAlexander::to_json(nlohmann::json & j, const Language & value) {
 	switch (value) {
 		case Language::English:
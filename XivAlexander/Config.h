@@ -1,6 +1,7 @@
 #pragma once
 
 #include <XivAlexanderCommon/Sqex.h>
+#include <XivAlexanderCommon/Utils/DebouncedTask.h>
 #include <XivAlexanderCommon/Utils/ListenerManager.h>
 
 namespace XivAlexander {
@@ -8,6 +9,8 @@ namespace XivAlexander {
 		class Logger;
 	}
 
+	enum class LogLevel;
+
 	enum class Language {
 		SystemDefault,
 		English,
@@ -29,6 +32,8 @@ namespace XivAlexander {
 		auto operator<=>(const PatchInstruction&) const = default;
 	};
 
+	void to_json(nlohmann::json&, const LogLevel&);
+	void from_json(const nlohmann::json&, LogLevel&);
 	void to_json(nlohmann::json&, const Language&);
 	void from_json(const nlohmann::json&, Language&);
 	void to_json(nlohmann::json&, const HighLatencyMitigationMode&);
@@ -80,7 +85,7 @@ namespace XivAlexander {
 				, m_value(std::move(defaultValue))
 				, m_sanitizer([](T v) { return std::move(v); }) {
 
-				pRepository->m_cleanup += OnChange([pRepository]() { pRepository->Save(); });
+				pRepository->m_cleanup += OnChange([pRepository]() { pRepository->ScheduleSave(); });
 			}
 
 			Item(BaseRepository* pRepository, const char* pszName, const T& defaultValue, std::function<T(const T&)> validator)
@@ -88,7 +93,7 @@ namespace XivAlexander {
 				, m_value(std::move(defaultValue))
 				, m_sanitizer(validator) {
 
-				pRepository->m_cleanup += OnChange([pRepository]() { pRepository->Save(); });
+				pRepository->m_cleanup += OnChange([pRepository]() { pRepository->ScheduleSave(); });
 			}
 
 			bool LoadFrom(const nlohmann::json& data) override;
@@ -177,6 +182,11 @@ namespace XivAlexander {
 
 			std::vector<ItemBase*> m_allItems;
 
+			// Writes changes to m_sConfigPath, once a burst of changes settles down.
+			Utils::DebouncedTask m_deferredSave;
+
+			void SaveNow(const std::filesystem::path& targetPath);
+
 		protected:
 			Utils::CallOnDestruction::Multiple m_cleanup;
 
@@ -188,7 +198,16 @@ namespace XivAlexander {
 
 			Utils::CallOnDestruction WithSuppressSave();
 
+			/// \brief Saves to the given path, or to the config path if empty, from the current thread.
 			void Save(const std::filesystem::path& to = {});
+
+			/// \brief Saves to the config path from a background thread, shortly after the last of consecutive calls.
+			void ScheduleSave();
+
+			/// \brief Saves to the config path from the current thread if a scheduled save has not happened yet.
+			void FlushSave();
+
+			/// \brief Loads from the given path, or from the config path if empty. A scheduled save not yet happened is dropped.
 			virtual void Reload(const std::filesystem::path& from = {});
 
 			[[nodiscard]] auto GetConfigPath() const { return m_sConfigPath; }
@@ -229,6 +248,9 @@ namespace XivAlexander {
 			Item<bool> UseWordWrap_XivAlexLogWindow = CreateConfigItem(this, "UseWordWrap_XivAlexLogWindow", false);
 			Item<bool> UseMonospaceFont_XivAlexLogWindow = CreateConfigItem(this, "UseMonospaceFont_XivAlexLogWindow", false);
 
+			// Log items below the given level are dropped before being formatted, by category name. Categories not listed keep everything.
+			Item<std::map<std::string, LogLevel>> MinimumLogLevels = CreateConfigItem<std::map<std::string, LogLevel>>(this, "MinimumLogLevels");
+
 			Item<bool> UseNetworkTimingHandler = CreateConfigItem(this, "UseNetworkTimingHandler", true);
 			Item<HighLatencyMitigationMode> HighLatencyMitigationMode = CreateConfigItem(this, "HighLatencyMitigationMode", HighLatencyMitigationMode::SimulateNormalizedRttAndLatency);
 			Item<bool> UseHighLatencyMitigationLogging = CreateConfigItem(this, "UseHighLatencyMitigationLogging", true);
@@ -281,6 +303,9 @@ namespace XivAlexander {
 				return std::min<uint64_t>(std::max<uint64_t>(0, val), 1000000);
 				});
 			Item<uint64_t> LockFramerateGlobalCooldown = CreateConfigItem<uint64_t>(this, "LockFramerateGlobalCooldown", 250);
+			Item<uint64_t> LockFramerateSpinBudget = CreateConfigItem<uint64_t>(this, "LockFramerateSpinBudget", 2000, [](const uint64_t& val) {
+				return std::min<uint64_t>(val, 1000000);
+				});
 
 			Item<bool> UseMainThreadTimingHandler = CreateConfigItem(this, "UseMainThreadTimingHandler", false);
 
@@ -416,6 +441,9 @@ namespace XivAlexander {
 
 		void Reload();
 
+		/// \brief Writes pending changes of every repository now; call before terminating the process, which skips destructors.
+		void FlushSave();
+
 		static std::shared_ptr<Config> Acquire();
 	};
 }
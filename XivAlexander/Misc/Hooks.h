@@ -1,6 +1,7 @@
 #pragma once
 
 #include <XivAlexanderCommon/Utils/CallOnDestruction.h>
+#include <XivAlexanderCommon/Utils/InFlightCounter.h>
 #include <XivAlexanderCommon/Utils/Win32/HeapAllocator.h>
 #include <XivAlexanderCommon/Utils/Win32/Process.h>
 #include "Misc/Signatures.h"
@@ -43,8 +44,33 @@ namespace XivAlexander::Misc::Hooks {
 	protected:
 		typedef R(__stdcall* FunctionType)(Args...);
 
+		// Invoked through a plain function pointer, so that the body of the detour gets inlined into Invoke.
+		struct DetourBase {
+			R(* const Invoke)(DetourBase*, Args...);
+
+			DetourBase(R(*invoke)(DetourBase*, Args...))
+				: Invoke(invoke) {
+			}
+
+			virtual ~DetourBase() = default;
+		};
+
+		template<typename F>
+		struct Detour : DetourBase {
+			F Fn;
+
+			Detour(F fn)
+				: DetourBase(&InvokeFn)
+				, Fn(std::move(fn)) {
+			}
+
+			static R InvokeFn(DetourBase* self, Args...args) {
+				return static_cast<Detour*>(self)->Fn(std::forward<Args>(args)...);
+			}
+		};
+
 		FunctionType m_bridge = nullptr;
-		std::function<std::remove_pointer_t<FunctionType>> m_detour = nullptr;
+		std::unique_ptr<DetourBase> m_detour;
 
 		static R __stdcall DetouredGatewayTemplateFunction(Args...args) {
 			const volatile auto target = reinterpret_cast<Function<R, Args...>*>(Binder::DummyAddress);
@@ -80,12 +106,16 @@ namespace XivAlexander::Misc::Hooks {
 			return true;
 		}
 
-		Utils::CallOnDestruction SetHook(std::function<std::remove_pointer_t<FunctionType>> pfnDetour) {
-			if (!pfnDetour)
-				throw std::invalid_argument("pfnDetour cannot be null");
+		template<typename F>
+		Utils::CallOnDestruction SetHook(F pfnDetour) {
+			static_assert(std::is_invocable_r_v<R, F&, Args...>);
+			if constexpr (std::is_constructible_v<bool, const F&>) {
+				if (!pfnDetour)
+					throw std::invalid_argument("pfnDetour cannot be null");
+			}
 			if (m_detour)
 				throw std::runtime_error("Cannot add multiple hooks");
-			m_detour = std::move(pfnDetour);
+			m_detour = std::make_unique<Detour<F>>(std::move(pfnDetour));
 			HookEnable();
 
 			return Utils::CallOnDestruction([this, m_destructed = m_destructed]() {
@@ -98,20 +128,13 @@ namespace XivAlexander::Misc::Hooks {
 		}
 
 	protected:
-		std::atomic_size_t m_hookCounter{};
-
-		Utils::CallOnDestruction AcquireHookCounter() {
-			m_hookCounter++;
-			return { [this]() {
-				m_hookCounter--;
-			} };
-		}
+		Utils::InFlightCounter m_hookCounter;
 
 		// Keep it virtual; need to deref from template function accepting instance of this class which is a template class
 		virtual R DetouredGateway(Args...args) {
-			const auto _hookCounterRelease = AcquireHookCounter();
-			if (m_detour)
-				return m_detour(std::forward<Args>(args)...);
+			const auto _hookCounterRelease = m_hookCounter.Enter();
+			if (const auto detour = m_detour.get())
+				return detour->Invoke(detour, std::forward<Args>(args)...);
 			else
 				return bridge(std::forward<Args>(args)...);
 		}
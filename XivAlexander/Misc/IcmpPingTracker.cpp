@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "IcmpPingTracker.h"
 
+#include <XivAlexanderCommon/Utils/LatencyHistogram.h>
 #include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
 #include <XivAlexanderCommon/Utils/Win32/Closeable.h>
 
@@ -34,6 +35,7 @@ struct XivAlexander::Misc::IcmpPingTracker::Implementation {
 	struct SingleTracker {
 		Misc::IcmpPingTracker& IcmpPingTracker;
 		const std::shared_ptr<Utils::NumericStatisticsTracker> Tracker;
+		const std::shared_ptr<Utils::LatencyHistogram> Histogram;
 		const Utils::Win32::Event ExitEvent;
 		const ConnectionPair Pair;
 		// needs to be last, as "this" needs to be done initializing
@@ -42,6 +44,7 @@ struct XivAlexander::Misc::IcmpPingTracker::Implementation {
 		SingleTracker(Misc::IcmpPingTracker& icmpPingTracker, const ConnectionPair& pair)
 			: IcmpPingTracker(icmpPingTracker)
 			, Tracker(std::make_shared<Utils::NumericStatisticsTracker>(8, INT64_MAX, 60 * 1000 * 1000))
+			, Histogram(std::make_shared<Utils::LatencyHistogram>())
 			, ExitEvent(Utils::Win32::Event::Create())
 			, Pair(pair)
 			, WorkerThread(std::format(L"XivAlexander::App::Network::IcmpPingTracker({:x})::SingleTracker({:x}: {} <-> {})",
@@ -86,6 +89,7 @@ struct XivAlexander::Misc::IcmpPingTracker::Implementation {
 
 						const auto latest = Tracker->Latest();
 						Tracker->AddValue(latencyUs);
+						Histogram->Record(latencyUs);
 
 						// if ping changes by more than 10%, then ping again to confirm
 						if (latencyUs > 0 && 100 * std::abs(latest - latencyUs) / latencyUs >= 10)
@@ -151,3 +155,10 @@ const Utils::NumericStatisticsTracker* XivAlexander::Misc::IcmpPingTracker::GetT
 		return it->second->Tracker.get();
 	return nullptr;
 }
+
+const Utils::LatencyHistogram* XivAlexander::Misc::IcmpPingTracker::GetHistogramUs(const in_addr& source, const in_addr& destination) const {
+	const auto pair = ConnectionPair{source, destination};
+	if (const auto it = m_pImpl->Trackers.find(pair); it != m_pImpl->Trackers.end())
+		return it->second->Histogram.get();
+	return nullptr;
+}
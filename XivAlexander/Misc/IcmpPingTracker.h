@@ -2,6 +2,7 @@
 #include "XivAlexanderCommon/Utils/CallOnDestruction.h"
 
 namespace Utils {
+	class LatencyHistogram;
 	class NumericStatisticsTracker;
 }
 
@@ -19,5 +20,6 @@ namespace XivAlexander::Misc {
 		Utils::CallOnDestruction Track(const in_addr& source, const in_addr& destination);
 
 		[[nodiscard]] const Utils::NumericStatisticsTracker* GetTrackerUs(const in_addr& source, const in_addr& destination) const;
+		[[nodiscard]] const Utils::LatencyHistogram* GetHistogramUs(const in_addr& source, const in_addr& destination) const;
 	};
 }
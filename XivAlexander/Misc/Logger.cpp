@@ -26,13 +26,19 @@ std::weak_ptr<XivAlexander::Misc::Logger> XivAlexander::Misc::Logger::s_instance
 
 struct XivAlexander::Misc::Logger::Implementation final {
 	static const int MaxLogCount = 128 * 1024;
+	static const size_t PendingItemCount = 8192;
+
 	Logger& logger;
-	std::condition_variable m_threadTrigger;
 
-	bool m_bQuitting = false;
-	std::mutex m_pendingItemLock;
+	std::atomic_bool m_bQuitting = false;
+	std::atomic_bool m_bDispatcherSleeping = false;
+	std::atomic_bool m_bDispatcherRunning = false;
+
+	// Held by whoever is consuming logger.m_pendingItems.
+	std::mutex m_consumerLock;
+
 	std::mutex m_itemLock;
-	std::deque<LogItem> m_items, m_pendingItems;
+	std::deque<LogItem> m_items;
 	uint64_t m_logIdCounter = 1;
 
 	Utils::Win32::Thread m_hDispatcherThread;
@@ -43,55 +49,96 @@ struct XivAlexander::Misc::Logger::Implementation final {
 
 	~Implementation() {
 		m_bQuitting = true;
-		m_threadTrigger.notify_all();
+		WakeDispatcher();
 		if (m_hDispatcherThread)
 			void(m_hDispatcherThread.Wait(INFINITE));
+
+		std::lock_guard lock(m_consumerLock);
+		logger.m_pendingItems.Discard();
+	}
+
+	void OnItemQueued() {
+		if (m_bDispatcherRunning) {
+			WakeDispatcher();
+
+		} else if (std::unique_lock lock(m_consumerLock, std::try_to_lock); lock.owns_lock()) {
+			// Nobody is listening yet; keep the logs around for WithLogs.
+			std::deque<LogItem> items;
+			ConsumePendingItems(items);
+			CommitItems(items);
+		}
+	}
+
+	void WakeDispatcher() {
+		if (m_bDispatcherSleeping && m_bDispatcherSleeping.exchange(false))
+			m_bDispatcherSleeping.notify_one();
 	}
 
-	void AddLogItem(LogItem item) {
-		std::lock_guard lock(m_pendingItemLock);
-		item.id = m_logIdCounter++;
-		if (m_hDispatcherThread) {
-			m_pendingItems.push_back(std::move(item));
-			while (m_pendingItems.size() > MaxLogCount)
-				m_pendingItems.pop_front();
-			m_threadTrigger.notify_all();
-		} else {
+	// Caller must hold m_consumerLock.
+	void ConsumePendingItems(std::deque<LogItem>& items) {
+		logger.m_pendingItems.Consume([&](const PendingItemHeader& header, std::string message) {
+			auto& item = items.emplace_back(LogItem{
+				m_logIdCounter++,
+				header.Category,
+				header.Timestamp,
+				header.Level,
+				std::move(message),
+			});
+			OutputDebugStringW(std::format(L"{}\n", item.log).c_str());
+		});
+
+		if (const auto dropped = logger.m_pendingItems.TakeDroppedCount()) {
+			items.emplace_back(LogItem{
+				m_logIdCounter++,
+				LogCategory::General,
+				std::chrono::system_clock::now(),
+				LogLevel::Warning,
+				std::format("{} log item(s) have been dropped, as they were being added faster than they could be processed.", dropped),
+			});
+		}
+	}
+
+	void CommitItems(const std::deque<LogItem>& items) {
+		std::lock_guard lock(m_itemLock);
+		for (const auto& item : items) {
 			m_items.push_back(item);
+			if (m_items.size() > MaxLogCount)
+				m_items.pop_front();
 		}
 	}
 
+	// Caller must hold m_consumerLock.
 	void StartDispatcher() {
 		if (m_hDispatcherThread)
 			return;
 
-		std::lock_guard lock(m_pendingItemLock);
-		if (m_hDispatcherThread)
-			return;
-
+		m_bDispatcherRunning = true;
 		m_hDispatcherThread = Utils::Win32::Thread(std::format(L"XivAlexander::App::Misc::Logger({:x})::Implementation({:x}::DispatcherThreadBody",
 			reinterpret_cast<size_t>(&logger), reinterpret_cast<size_t>(this)
 		), [this]() {
-			while (true) {
+			while (!m_bQuitting) {
 				std::deque<LogItem> pendingItems;
 				{
-					std::unique_lock lock(m_pendingItemLock);
-					if (m_pendingItems.empty()) {
-						m_threadTrigger.wait(lock);
-						if (m_bQuitting)
-							return;
-					}
-					pendingItems = std::move(m_pendingItems);
+					std::lock_guard lock(m_consumerLock);
+					ConsumePendingItems(pendingItems);
+					CommitItems(pendingItems);
+				}
+
+				if (!pendingItems.empty()) {
+					logger.OnNewLogItem(pendingItems);
+					continue;
 				}
+
+				m_bDispatcherSleeping = true;
+				bool hasPendingItems;
 				{
-					std::lock_guard lock(m_itemLock);
-					for (auto& item : pendingItems) {
-						m_items.push_back(item);
-						if (m_items.size() > MaxLogCount)
-							m_items.pop_front();
-					}
+					std::lock_guard lock(m_consumerLock);
+					hasPendingItems = logger.m_pendingItems.HasPending();
 				}
-				logger.OnNewLogItem(pendingItems);
+				if (hasPendingItems || m_bQuitting)
+					m_bDispatcherSleeping = false;
+				else
+					m_bDispatcherSleeping.wait(true);
 			}
 		});
 	}
@@ -118,12 +165,23 @@ std::string XivAlexander::Misc::Logger::LogItem::Format() const {
 }
 
 XivAlexander::Misc::Logger::Logger()
-	: m_pImpl(std::make_unique<Implementation>(*this))
+	: m_pendingItems(Implementation::PendingItemCount)
+	, m_pImpl(std::make_unique<Implementation>(*this))
 	, OnNewLogItem([this](const auto& cb) {
+		{
+			std::lock_guard lock(m_pImpl->m_consumerLock);
+			if (!m_pImpl->m_bDispatcherRunning) {
+				std::deque<LogItem> items;
+				m_pImpl->ConsumePendingItems(items);
+				m_pImpl->CommitItems(items);
+				m_pImpl->StartDispatcher();
+			}
+		}
 		std::lock_guard lock(m_pImpl->m_itemLock);
 		cb(m_pImpl->m_items);
-		m_pImpl->StartDispatcher();
 	}) {
+	for (auto& level : m_minimumLevels)
+		level = LogLevel::Debug;
 	Utils::Win32::DebugPrint(L"Logger: New");
 }
 
@@ -145,7 +203,8 @@ XivAlexander::Misc::Logger::~Logger() {
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const char* s, LogLevel level) {
-	Log(category, std::string(s), level);
+	if (IsEnabled(category, level))
+		EnqueueMessage(category, level, std::string_view(s));
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const char8_t* s, LogLevel level) {
@@ -153,33 +212,42 @@ void XivAlexander::Misc::Logger::Log(LogCategory category, const char8_t* s, Log
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const wchar_t* s, LogLevel level) {
-	Log(category, Utils::ToUtf8(s), level);
+	if (IsEnabled(category, level))
+		EnqueueMessage(category, level, std::wstring_view(s));
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const std::string& s, LogLevel level) {
-	OutputDebugStringW(std::format(L"{}\n", s).c_str());
-	m_pImpl->AddLogItem(LogItem{
-		0,
-		category,
-		std::chrono::system_clock::now(),
-		level,
-		s,
-	});
+	if (IsEnabled(category, level))
+		EnqueueMessage(category, level, std::string_view(s));
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const std::wstring& s, LogLevel level) {
-	Log(category, Utils::ToUtf8(s), level);
+	if (IsEnabled(category, level))
+		EnqueueMessage(category, level, std::wstring_view(s));
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, WORD wLanguage, UINT uStringResId, LogLevel level) {
-	Log(category, FindStringResourceEx(Dll::Module(), uStringResId, wLanguage) + 1, level);
+	if (IsEnabled(category, level))
+		EnqueueMessage(category, level, std::wstring_view(GetStringResource(uStringResId, wLanguage)));
 }
 
 void XivAlexander::Misc::Logger::Clear() {
-	std::lock_guard lock(m_pImpl->m_itemLock);
-	std::lock_guard lock2(m_pImpl->m_pendingItemLock);
+	std::lock_guard lock(m_pImpl->m_consumerLock);
+	std::lock_guard lock2(m_pImpl->m_itemLock);
+	m_pendingItems.Discard();
 	m_pImpl->m_items.clear();
-	m_pImpl->m_pendingItems.clear();
+}
+
+void XivAlexander::Misc::Logger::SetMinimumLevel(LogCategory category, LogLevel level) {
+	m_minimumLevels[static_cast<size_t>(category)] = level;
+}
+
+XivAlexander::LogLevel XivAlexander::Misc::Logger::GetMinimumLevel(LogCategory category) const {
+	return m_minimumLevels[static_cast<size_t>(category)];
+}
+
+void XivAlexander::Misc::Logger::OnItemQueued() {
+	m_pImpl->OnItemQueued();
 }
 
 void XivAlexander::Misc::Logger::AskAndExportLogs(HWND hwndDialogParent, std::string_view heading, std::string_view preformatted) {
@@ -367,6 +435,15 @@ void XivAlexander::Misc::Logger::AskAndExportLogs(HWND hwndDialogParent, std::st
 }
 
 void XivAlexander::Misc::Logger::WithLogs(const std::function<void(const std::deque<LogItem>& items)>& cb) const {
+	if (!m_pImpl->m_bDispatcherRunning) {
+		std::lock_guard lock(m_pImpl->m_consumerLock);
+		if (!m_pImpl->m_bDispatcherRunning) {
+			std::deque<LogItem> items;
+			m_pImpl->ConsumePendingItems(items);
+			m_pImpl->CommitItems(items);
+		}
+	}
+
 	std::lock_guard lock(m_pImpl->m_itemLock);
 	cb(m_pImpl->m_items);
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <XivAlexanderCommon/Utils/DeferredFormatQueue.h>
 #include <XivAlexanderCommon/Utils/ListenerManager.h>
 #include <XivAlexanderCommon/Utils/Win32/Resource.h>
 
@@ -41,6 +44,15 @@ namespace XivAlexander::Misc {
 		};
 
 	protected:
+		struct PendingItemHeader {
+			LogCategory Category;
+			LogLevel Level;
+			std::chrono::system_clock::time_point Timestamp;
+		};
+
+		// Log items waiting to be formatted by the dispatcher thread; outlives m_pImpl, which owns the thread.
+		Utils::DeferredFormatQueue<PendingItemHeader> m_pendingItems;
+
 		struct Implementation;
 		const std::unique_ptr<Implementation> m_pImpl;
 
@@ -71,33 +83,69 @@ namespace XivAlexander::Misc {
 		void WithLogs(const std::function<void(const std::deque<LogItem>& items)>& cb) const;
 		Utils::ListenerManager<Logger, void, const std::deque<LogItem>&> OnNewLogItem;
 
+		[[nodiscard]] bool IsEnabled(LogCategory category, LogLevel level) const {
+			return level >= m_minimumLevels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+		}
+
+		void SetMinimumLevel(LogCategory category, LogLevel level);
+		[[nodiscard]] LogLevel GetMinimumLevel(LogCategory category) const;
+
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
-		void Format(LogCategory category, const char* format, Args&&...args) {
-			Log(category, std::vformat(format, std::make_format_args(std::forward<Args>(args)...)), Level);
+		void Format(LogCategory category, Utils::StaticFormatString<char> format, Args&&...args) {
+			if (IsEnabled(category, Level))
+				EnqueueFormat(category, Level, format, std::forward<Args>(args)...);
 		}
 
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
-		void Format(LogCategory category, const wchar_t* format, Args&&...args) {
-			Log(category, std::vformat(format, std::make_wformat_args(std::forward<Args>(args)...)), Level);
+		void Format(LogCategory category, Utils::StaticFormatString<wchar_t> format, Args&&...args) {
+			if (IsEnabled(category, Level))
+				EnqueueFormat(category, Level, format, std::forward<Args>(args)...);
 		}
 
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
-		void Format(LogCategory category, const char8_t* format, Args&&...args) {
-			Log(category, std::vformat(reinterpret_cast<const char*>(format), std::make_format_args(std::forward<Args>(args)...)), Level);
+		void Format(LogCategory category, Utils::StaticFormatString<char8_t> format, Args&&...args) {
+			if (IsEnabled(category, Level))
+				EnqueueFormat(category, Level, Utils::StaticFormatString<char>::AssumeStatic(reinterpret_cast<const char*>(format.Get())), std::forward<Args>(args)...);
 		}
 
 	private:
 		static const wchar_t* GetStringResource(UINT uStringResFormatId, WORD wLanguage = MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL));
 
+		// String resources stay mapped for as long as the module is loaded.
+		static Utils::StaticFormatString<wchar_t> GetStringResourceFormat(UINT uStringResFormatId, WORD wLanguage = MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL)) {
+			return Utils::StaticFormatString<wchar_t>::AssumeStatic(GetStringResource(uStringResFormatId, wLanguage));
+		}
+
 	public:
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void Format(LogCategory category, WORD wLanguage, UINT uStringResFormatId, Args&&...args) {
-			Log(category, std::vformat(GetStringResource(uStringResFormatId, wLanguage), std::make_wformat_args(std::forward<Args>(args)...)), Level);
+			if (IsEnabled(category, Level))
+				EnqueueFormat(category, Level, GetStringResourceFormat(uStringResFormatId, wLanguage), std::forward<Args>(args)...);
 		}
 
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void FormatDefaultLanguage(LogCategory category, UINT uStringResFormatId, Args&&...args) {
-			Log(category, std::vformat(GetStringResource(uStringResFormatId), std::make_wformat_args(std::forward<Args>(args)...)), Level);
+			if (IsEnabled(category, Level))
+				EnqueueFormat(category, Level, GetStringResourceFormat(uStringResFormatId), std::forward<Args>(args)...);
+		}
+
+	private:
+		static constexpr size_t LogCategoryCount = static_cast<size_t>(LogCategory::PatchCode) + 1;
+		std::array<std::atomic<LogLevel>, LogCategoryCount> m_minimumLevels;
+
+		/// \brief Wakes the dispatcher thread up, or formats queued items right away if no dispatcher is running yet.
+		void OnItemQueued();
+
+		template<typename T>
+		void EnqueueMessage(LogCategory category, LogLevel level, T&& message) {
+			m_pendingItems.PushMessage({ category, level, std::chrono::system_clock::now() }, std::forward<T>(message));
+			OnItemQueued();
+		}
+
+		template<typename CharT, typename ... Args>
+		void EnqueueFormat(LogCategory category, LogLevel level, Utils::StaticFormatString<CharT> format, const Args&...args) {
+			m_pendingItems.Push({ category, level, std::chrono::system_clock::now() }, format, args...);
+			OnItemQueued();
 		}
 	};
 }
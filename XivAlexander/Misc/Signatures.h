@@ -7,8 +7,19 @@ namespace XivAlexander::Misc::Signatures {
 	typedef bool (*SectionFilter)(const IMAGE_SECTION_HEADER&);
 	bool SectionFilterTextOnly(const IMAGE_SECTION_HEADER& pSectionHeader);
 
+	struct DataPattern {
+		const char* Pattern;
+		const char* Mask;
+		size_t Length;
+		std::vector<size_t> NextOffsets;
+	};
+
 	[[nodiscard]] std::vector<void*> LookupForData(SectionFilter lookupInSection, const char* sPattern, const char* sMask, size_t length, const std::vector<size_t>& nextOffsets);
 
+	/// \brief Looks for all the given patterns, going through each section only once.
+	/// \returns Matching addresses for each pattern, in the order given.
+	[[nodiscard]] std::vector<std::vector<void*>> LookupForData(SectionFilter lookupInSection, const std::vector<DataPattern>& patterns);
+
 	template<typename T>
 	class Signature {
 	protected:
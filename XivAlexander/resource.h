@@ -215,6 +215,8 @@
 #define IDS_OPCODEUPDATE_ERROR_404      298
 #define IDS_OPCODEUPDATE_OK_NOTCHANGED  299
 #define IDS_OPCODEUPDATE_OK_CHANGED     300
+#define IDS_SOCKETHOOK_SOCKET_DESCRIBE_LATENCY_PERCENTILES 301
+#define IDS_SOCKETHOOK_SOCKET_DESCRIBE_TUNNEL_LATENCY 302
 #define IDC_INTERVAL_EDIT               1001
 #define IDC_TARGETFRAMERATE_EDIT        1002
 #define IDC_FPSDEV_EDIT                 1003
@@ -389,13 +391,15 @@
 #define ID_CONFIGURE_CHECKFORUPDATEDOPCODESONSTARTUP 40532
 #define ID_Menu                         40533
 #define ID_CONFIGURE_GAMEFIX_EMPTY      40534
+#define ID_NETWORK_SAVELATENCYHISTOGRAMS 40535
+#define ID_NETWORK_HIGHLATENCYMITIGATION_SAVETRACE 40536
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        208
-#define _APS_NEXT_COMMAND_VALUE         40535
+#define _APS_NEXT_COMMAND_VALUE         40537
 #define _APS_NEXT_CONTROL_VALUE         1034
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
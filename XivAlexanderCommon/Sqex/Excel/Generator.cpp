@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Excel/Generator.h"
 
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
 Sqex::Excel::Depth2ExhExdCreator::Depth2ExhExdCreator(std::string name, std::vector<Exh::Column> columns, const Exh::ExhFlag& flag)
 	: Name(std::move(name))
 	, Columns(std::move(columns))
@@ -66,7 +68,7 @@ void Sqex::Excel::Depth2ExhExdCreator::SetRow(uint32_t id, Language language, st
 		target = std::move(row);
 }
 
-std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>> Sqex::Excel::Depth2ExhExdCreator::Flush(uint32_t startId, std::map<uint32_t, std::vector<char>> rows, Language language) {
+std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>> Sqex::Excel::Depth2ExhExdCreator::Flush(uint32_t startId, std::map<uint32_t, std::vector<char>> rows, Language language) const {
 	Exd::Header exdHeader;
 	const auto exdHeaderSpan = span_cast<char>(1, &exdHeader);
 	memcpy(exdHeader.Signature, Exd::Header::Signature_Value, 4);
@@ -129,6 +131,95 @@ std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>> Sqex::Excel::Depth2Exh
 	);
 }
 
+std::optional<std::pair<Sqex::Sqpack::EntryPathSpec, std::vector<char>>> Sqex::Excel::Depth2ExhExdCreator::CompilePage(uint32_t startId, std::span<const uint32_t> ids, Language language) const {
+	std::map<uint32_t, std::vector<char>> rows;
+	for (const auto id : ids) {
+		// Rows that do not exist in this language are left out of the page.
+		const auto& rowSet = Data.at(id);
+		const auto rowIt = rowSet.find(language);
+		if (rowIt == rowSet.end() || rowIt->second.empty())
+			continue;
+		const auto& columns = rowIt->second;
+
+		std::vector<char> row(sizeof Exd::RowHeader + FixedDataSize);
+
+		const auto fixedDataOffset = sizeof Exd::RowHeader;
+		const auto variableDataOffset = fixedDataOffset + FixedDataSize;
+
+		for (size_t i = 0; i < columns.size(); ++i) {
+			const auto& column = columns[i];
+			const auto& columnDefinition = Columns[i];
+			size_t validSize = 0;
+			switch (columnDefinition.Type) {
+				case Exh::String:
+				{
+					const auto stringOffset = BE(static_cast<uint32_t>(row.size() - variableDataOffset));
+					std::copy_n(reinterpret_cast<const char*>(&stringOffset), 4, &row[fixedDataOffset + columnDefinition.Offset]);
+					row.reserve(row.size() + column.String.Escaped().size() + 1);
+					row.insert(row.end(), column.String.Escaped().begin(), column.String.Escaped().end());
+					row.push_back(0);
+					break;
+				}
+
+				case Exh::Bool:
+				case Exh::Int8:
+				case Exh::UInt8:
+					validSize = 1;
+					break;
+
+				case Exh::Int16:
+				case Exh::UInt16:
+					validSize = 2;
+					break;
+
+				case Exh::Int32:
+				case Exh::UInt32:
+				case Exh::Float32:
+					validSize = 4;
+					break;
+
+				case Exh::Int64:
+				case Exh::UInt64:
+					validSize = 8;
+					break;
+
+				case Exh::PackedBool0:
+				case Exh::PackedBool1:
+				case Exh::PackedBool2:
+				case Exh::PackedBool3:
+				case Exh::PackedBool4:
+				case Exh::PackedBool5:
+				case Exh::PackedBool6:
+				case Exh::PackedBool7:
+					if (column.boolean)
+						row[fixedDataOffset + columnDefinition.Offset] |= (1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0)));
+					else
+						row[fixedDataOffset + columnDefinition.Offset] &= ~((1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0))));
+					break;
+			}
+			if (validSize) {
+				const auto target = std::span(row).subspan(fixedDataOffset + columnDefinition.Offset, validSize);
+				std::copy_n(&column.Buffer[0], validSize, &target[0]);
+				// ReSharper disable once CppUseRangeAlgorithm
+				std::reverse(target.begin(), target.end());
+			}
+		}
+		row.resize(Sqex::Align<size_t>(row.size(), 4));
+
+		auto& rowHeader = *reinterpret_cast<Exd::RowHeader*>(&row[0]);
+		rowHeader.DataSize = static_cast<uint32_t>(row.size() - sizeof rowHeader);
+		rowHeader.SubRowCount = 1;
+
+		if (reinterpret_cast<const Exd::RowHeader*>(&row[0])->DataSize != row.size() - 6)
+			__debugbreak();
+
+		rows.emplace(id, std::move(row));
+	}
+	if (rows.empty())
+		return std::nullopt;
+	return Flush(startId, std::move(rows), language);
+}
+
 std::map<Sqex::Sqpack::EntryPathSpec, std::vector<char>, Sqex::Sqpack::EntryPathSpec::FullPathComparator> Sqex::Excel::Depth2ExhExdCreator::Compile(size_t divideUnit) {
 	std::map<Sqpack::EntryPathSpec, std::vector<char>, Sqpack::EntryPathSpec::FullPathComparator> result;
 	std::vector<std::pair<Exh::Pagination, std::vector<uint32_t>>> pages;
@@ -148,107 +239,30 @@ std::map<Sqex::Sqpack::EntryPathSpec, std::vector<char>, Sqex::Sqpack::EntryPath
 		return {};
 	pages.back().first.RowCountWithSkip = pages.back().second.back() - pages.back().second.front() + 1;
 
-	for (const auto& page : pages) {
-		for (const auto language : Languages) {
-			std::map<uint32_t, std::vector<char>> rows;
-			for (const auto id : page.second) {
-				std::vector<char> row(sizeof Exd::RowHeader + FixedDataSize);
-
-				const auto fixedDataOffset = sizeof Exd::RowHeader;
-				const auto variableDataOffset = fixedDataOffset + FixedDataSize;
-
-				auto sourceLanguage = language;
-				auto& rowSet = Data[id];
-				if (rowSet.find(sourceLanguage) == rowSet.end()) {
-					sourceLanguage = Language::Unspecified;
-					for (auto lang : FillMissingLanguageFrom) {
-						if (rowSet.find(lang) == rowSet.end()) {
-							sourceLanguage = lang;
-							break;
-						}
-					}
-					if (sourceLanguage == Language::Unspecified)
-						continue;
-				}
-
-				auto& columns = rowSet[sourceLanguage];
-				if (columns.empty())
-					continue;
-
-				for (size_t i = 0; i < columns.size(); ++i) {
-					auto& column = columns[i];
-					const auto& columnDefinition = Columns[i];
-					switch (columnDefinition.Type) {
-						case Exh::String:
-						{
-							const auto stringOffset = BE(static_cast<uint32_t>(row.size() - variableDataOffset));
-							std::copy_n(reinterpret_cast<const char*>(&stringOffset), 4, &row[fixedDataOffset + columnDefinition.Offset]);
-							row.reserve(row.size() + column.String.Escaped().size() + 1);
-							row.insert(row.end(), column.String.Escaped().begin(), column.String.Escaped().end());
-							row.push_back(0);
-							column.ValidSize = 0;
-							break;
-						}
-
-						case Exh::Bool:
-						case Exh::Int8:
-						case Exh::UInt8:
-							column.ValidSize = 1;
-							break;
-
-						case Exh::Int16:
-						case Exh::UInt16:
-							column.ValidSize = 2;
-							break;
-
-						case Exh::Int32:
-						case Exh::UInt32:
-						case Exh::Float32:
-							column.ValidSize = 4;
-							break;
-
-						case Exh::Int64:
-						case Exh::UInt64:
-							column.ValidSize = 8;
-							break;
-
-						case Exh::PackedBool0:
-						case Exh::PackedBool1:
-						case Exh::PackedBool2:
-						case Exh::PackedBool3:
-						case Exh::PackedBool4:
-						case Exh::PackedBool5:
-						case Exh::PackedBool6:
-						case Exh::PackedBool7:
-							column.ValidSize = 0;
-							if (column.boolean)
-								row[fixedDataOffset + columnDefinition.Offset] |= (1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0)));
-							else
-								row[fixedDataOffset + columnDefinition.Offset] &= ~((1 << (static_cast<int>(column.Type) - static_cast<int>(Exh::PackedBool0))));
-							break;
-					}
-					if (column.ValidSize) {
-						const auto target = std::span(row).subspan(fixedDataOffset + columnDefinition.Offset, column.ValidSize);
-						std::copy_n(&column.Buffer[0], column.ValidSize, &target[0]);
-						// ReSharper disable once CppUseRangeAlgorithm
-						std::reverse(target.begin(), target.end());
-					}
-				}
-				row.resize(Sqex::Align<size_t>(row.size(), 4));
-
-				auto& rowHeader = *reinterpret_cast<Exd::RowHeader*>(&row[0]);
-				rowHeader.DataSize = static_cast<uint32_t>(row.size() - sizeof rowHeader);
-				rowHeader.SubRowCount = 1;
-
-				if (reinterpret_cast<const Exd::RowHeader*>(&row[0])->DataSize != row.size() - 6)
-					__debugbreak();
-
-				rows.emplace(id, std::move(row));
+	// Pages only read Data, so every page of every language can be serialized at the same time.
+	std::vector<std::pair<const std::pair<Exh::Pagination, std::vector<uint32_t>>*, Language>> pageLanguages;
+	for (const auto& page : pages)
+		for (const auto language : Languages)
+			pageLanguages.emplace_back(&page, language);
+
+	std::vector<std::optional<std::pair<Sqpack::EntryPathSpec, std::vector<char>>>> compiledPages(pageLanguages.size());
+	std::vector<std::exception_ptr> errors(pageLanguages.size());
+	Utils::Win32::ParallelForRanges(L"Sqex::Excel::Depth2ExhExdCreator::Compile", pageLanguages.size(), 1, [&](size_t from, size_t to) {
+		for (auto i = from; i < to; ++i) {
+			try {
+				const auto& [page, language] = pageLanguages[i];
+				compiledPages[i] = CompilePage(page->first.StartId, page->second, language);
+			} catch (...) {
+				errors[i] = std::current_exception();
 			}
-			if (rows.empty())
-				continue;
-			result.emplace(Flush(page.first.StartId, std::move(rows), language));
 		}
+	}, MaxThreadCount);
+
+	for (size_t i = 0; i < compiledPages.size(); ++i) {
+		if (errors[i])
+			std::rethrow_exception(errors[i]);
+		if (compiledPages[i])
+			result.emplace(std::move(*compiledPages[i]));
 	}
 
 	{
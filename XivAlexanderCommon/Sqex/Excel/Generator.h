@@ -14,6 +14,9 @@ namespace Sqex::Excel {
 		std::vector<Language> Languages;
 		std::vector<Language> FillMissingLanguageFrom;
 
+		// Number of threads to serialize pages with from Compile. Output does not depend on this.
+		uint32_t MaxThreadCount = UINT32_MAX;
+
 		Depth2ExhExdCreator(std::string name, std::vector<Exh::Column> columns, const Exh::ExhFlag& flag);
 
 		void AddLanguage(Language language);
@@ -22,7 +25,8 @@ namespace Sqex::Excel {
 		void SetRow(uint32_t id, Language language, std::vector<ExdColumn> row, bool replace = true);
 
 	private:
-		std::pair<Sqpack::EntryPathSpec, std::vector<char>> Flush(uint32_t startId, std::map<uint32_t, std::vector<char>> rows, Language language);
+		[[nodiscard]] std::optional<std::pair<Sqpack::EntryPathSpec, std::vector<char>>> CompilePage(uint32_t startId, std::span<const uint32_t> ids, Language language) const;
+		[[nodiscard]] std::pair<Sqpack::EntryPathSpec, std::vector<char>> Flush(uint32_t startId, std::map<uint32_t, std::vector<char>> rows, Language language) const;
 
 	public:
 		std::map<Sqpack::EntryPathSpec, std::vector<char>, Sqpack::EntryPathSpec::FullPathComparator> Compile(size_t divideUnit = SIZE_MAX);
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Excel/Reader.h"
 
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
 Sqex::Excel::ExlReader::ExlReader(const RandomAccessStream& stream) {
 	std::string data(static_cast<size_t>(stream.StreamSize()), '\0');
 	stream.ReadStream(0, std::span(data));
@@ -223,9 +225,204 @@ std::vector<std::vector<Sqex::Excel::ExdColumn>> Sqex::Excel::ExdReader::ReadDep
 	return result;
 }
 
+static size_t ProjectedValueSize(Sqex::Excel::Exh::ColumnDataType type) {
+	using namespace Sqex::Excel;
+	switch (type) {
+		case Exh::String:
+			return 0;
+
+		case Exh::Bool:
+		case Exh::Int8:
+		case Exh::UInt8:
+		case Exh::PackedBool0:
+		case Exh::PackedBool1:
+		case Exh::PackedBool2:
+		case Exh::PackedBool3:
+		case Exh::PackedBool4:
+		case Exh::PackedBool5:
+		case Exh::PackedBool6:
+		case Exh::PackedBool7:
+			return 1;
+
+		case Exh::Int16:
+		case Exh::UInt16:
+			return 2;
+
+		case Exh::Int32:
+		case Exh::UInt32:
+		case Exh::Float32:
+			return 4;
+
+		case Exh::Int64:
+		case Exh::UInt64:
+			return 8;
+
+		default:
+			throw Sqex::CorruptDataException(std::format("Invald column type {}", static_cast<uint32_t>(type)));
+	}
+}
+
+Sqex::Excel::ExdProjection Sqex::Excel::ExdReader::ReadColumns(std::span<const size_t> columnIndices) const {
+	if (m_depth != Exh::Level2 && m_depth != Exh::Level3)
+		throw std::invalid_argument("Unsupported sheet depth");
+
+	ExdProjection result;
+
+	// Every row lies after the row locators; read all of them at once.
+	const auto dataOffset = static_cast<uint64_t>(sizeof Header) + Header.IndexSize;
+	const auto streamSize = m_stream->StreamSize();
+	if (streamSize < dataOffset)
+		throw CorruptDataException("Row locators extend beyond end of data");
+	auto data = std::make_shared<std::vector<char>>(m_stream->ReadStreamIntoVector<char>(dataOffset, static_cast<size_t>(streamSize - dataOffset)));
+
+	struct RowRef {
+		std::span<const char> FixedData;
+		std::span<const char> FullData;
+	};
+	std::vector<RowRef> rows;
+	rows.reserve(m_rowLocators.size());
+	result.m_rowIds.reserve(m_rowLocators.size());
+	for (const auto& [rowId, offset] : m_rowLocators) {
+		if (offset < dataOffset || offset - dataOffset + sizeof Exd::RowHeader > data->size())
+			throw CorruptDataException(std::format("Row {} is out of range", rowId));
+
+		const auto rowOffset = static_cast<size_t>(offset - dataOffset);
+		Exd::RowHeader rowHeader;
+		std::copy_n(&(*data)[rowOffset], sizeof rowHeader, reinterpret_cast<char*>(&rowHeader));
+		if (rowOffset + sizeof rowHeader + rowHeader.DataSize > data->size())
+			throw CorruptDataException(std::format("Row {} is out of range", rowId));
+
+		const auto fullData = std::span<const char>(*data).subspan(rowOffset + sizeof rowHeader, rowHeader.DataSize);
+		if (m_depth == Exh::Level2) {
+			if (rowHeader.SubRowCount != 1)
+				throw CorruptDataException("SubRowCount > 1 on 2nd depth sheet");
+			if (fullData.size() < m_fixedDataSize)
+				throw CorruptDataException(std::format("Row {} is too short", rowId));
+
+			rows.emplace_back(RowRef{ fullData.subspan(0, m_fixedDataSize), fullData });
+			result.m_rowIds.emplace_back(rowId);
+		} else {
+			for (size_t i = 0, i_ = rowHeader.SubRowCount; i < i_; ++i) {
+				const auto baseOffset = i * (2 + m_fixedDataSize);
+				if (fullData.size() < baseOffset + 2 + m_fixedDataSize)
+					throw CorruptDataException(std::format("Row {} is too short", rowId));
+
+				BE<uint16_t> subRowId;
+				std::copy_n(&fullData[baseOffset], 2, reinterpret_cast<char*>(&subRowId));
+				rows.emplace_back(RowRef{ fullData.subspan(baseOffset + 2, m_fixedDataSize), fullData });
+				result.m_rowIds.emplace_back(rowId);
+				result.m_subRowIds.emplace_back(subRowId);
+			}
+		}
+	}
+
+	result.m_columns.reserve(columnIndices.size());
+	for (const auto columnIndex : columnIndices) {
+		const auto& columnDefinition = ColumnDefinitions->at(columnIndex);
+		const auto type = columnDefinition.Type.Value();
+		const size_t columnOffset = columnDefinition.Offset;
+		const auto valueSize = ProjectedValueSize(type);
+		if (columnOffset + (valueSize ? valueSize : 4) > m_fixedDataSize)
+			throw CorruptDataException(std::format("Column {} is out of range", columnIndex));
+
+		auto& column = result.m_columns.emplace_back(ExdProjection::Column{ .Type = type });
+		if (type == Exh::String) {
+			column.Strings.reserve(rows.size());
+			for (const auto& row : rows) {
+				BE<uint32_t> stringOffset;
+				std::copy_n(&row.FixedData[columnOffset], 4, reinterpret_cast<char*>(&stringOffset));
+				if (m_fixedDataSize + stringOffset >= row.FullData.size())
+					throw CorruptDataException("String offset is out of range");
+
+				const auto* const ptr = &row.FullData[m_fixedDataSize + stringOffset];
+				column.Strings.emplace_back(ptr, strnlen(ptr, row.FullData.size() - m_fixedDataSize - stringOffset));
+			}
+
+		} else if (type >= Exh::PackedBool0 && type <= Exh::PackedBool7) {
+			const auto mask = static_cast<char>(1 << (static_cast<int>(type) - static_cast<int>(Exh::PackedBool0)));
+			column.Values.resize(rows.size());
+			for (size_t i = 0; i < rows.size(); ++i)
+				column.Values[i] = (rows[i].FixedData[columnOffset] & mask) ? 1 : 0;
+
+		} else if (type == Exh::Bool) {
+			column.Values.resize(rows.size());
+			for (size_t i = 0; i < rows.size(); ++i)
+				column.Values[i] = rows[i].FixedData[columnOffset] ? 1 : 0;
+
+		} else {
+			// Stored in big endian.
+			column.Values.resize(rows.size() * valueSize);
+			for (size_t i = 0; i < rows.size(); ++i) {
+				const auto* const source = &rows[i].FixedData[columnOffset];
+				std::reverse_copy(source, source + valueSize, reinterpret_cast<char*>(&column.Values[i * valueSize]));
+			}
+		}
+	}
+
+	result.m_data = std::move(data);
+	return result;
+}
+
 std::vector<uint32_t> Sqex::Excel::ExdReader::GetIds() const {
 	std::vector<uint32_t> ids;
 	for (const auto& id : m_rowLocators | std::views::keys)
 		ids.emplace_back(id);
 	return ids;
 }
+
+std::span<const std::string_view> Sqex::Excel::ExdProjection::EscapedStrings(size_t column) const {
+	const auto& col = m_columns.at(column);
+	if (col.Type != Exh::String)
+		throw std::invalid_argument("Not a string column");
+	return col.Strings;
+}
+
+Sqex::SeString Sqex::Excel::ExdProjection::String(size_t column, size_t row) const {
+	return SeString(std::string(EscapedStrings(column)[row]));
+}
+
+void Sqex::Excel::ReadDepth2Pages(
+	const ExhReader& exh,
+	const std::function<std::shared_ptr<const RandomAccessStream>(const Sqpack::EntryPathSpec&)>& streamGetter,
+	uint32_t maxThreadCount,
+	const std::function<bool(ExdPageRows&)>& onPage) {
+	std::vector<ExdPageRows> pages;
+	for (const auto language : exh.Languages)
+		for (const auto& page : exh.Pages)
+			pages.emplace_back(ExdPageRows{ .Language = language, .Page = page });
+
+	std::mutex handOverMtx;
+	std::vector<bool> pageRead(pages.size());
+	size_t nextHandOver = 0;
+	std::exception_ptr handOverError;
+	std::atomic_bool stop = false;
+	Utils::Win32::ParallelForRanges(L"Sqex::Excel::ReadDepth2Pages", pages.size(), 1, [&](size_t from, size_t to) {
+		for (auto i = from; i < to && !stop; ++i) {
+			auto& item = pages[i];
+			try {
+				const auto reader = ExdReader(exh, streamGetter(exh.GetDataPathSpec(item.Page, item.Language)));
+				for (const auto id : reader.GetIds())
+					item.Rows.emplace_back(id, reader.ReadDepth2(id));
+			} catch (...) {
+				item.Error = std::current_exception();
+			}
+
+			// Hand over every page that is ready and has nothing unread before it; a page read ahead waits here.
+			const auto lock = std::lock_guard(handOverMtx);
+			pageRead[i] = true;
+			for (; !stop && nextHandOver < pages.size() && pageRead[nextHandOver]; ++nextHandOver) {
+				auto page = std::move(pages[nextHandOver]);
+				try {
+					if (!onPage(page))
+						stop = true;
+				} catch (...) {
+					handOverError = std::current_exception();
+					stop = true;
+				}
+			}
+		}
+	}, maxThreadCount);
+
+	if (handOverError)
+		std::rethrow_exception(handOverError);
+}
@@ -55,6 +55,86 @@ namespace Sqex::Excel {
 		void Dump() const;
 	};
 
+	/// \brief Values of selected columns across every row of an EXD page, stored column by column.
+	///
+	/// Numeric and boolean values are stored in native byte order in contiguous arrays.
+	/// Strings are kept as views into the page data, which this object keeps alive, and are turned into SeString only on request.
+	class ExdProjection {
+		friend class ExdReader;
+
+		struct Column {
+			Exh::ColumnDataType Type;
+			std::vector<uint8_t> Values;
+			std::vector<std::string_view> Strings;
+		};
+
+		std::shared_ptr<const std::vector<char>> m_data;
+		std::vector<uint32_t> m_rowIds;
+		std::vector<uint16_t> m_subRowIds;
+		std::vector<Column> m_columns;
+
+	public:
+		[[nodiscard]] size_t RowCount() const { return m_rowIds.size(); }
+		[[nodiscard]] size_t ColumnCount() const { return m_columns.size(); }
+		[[nodiscard]] Exh::ColumnDataType ColumnType(size_t column) const { return m_columns.at(column).Type; }
+
+		[[nodiscard]] std::span<const uint32_t> RowIds() const { return m_rowIds; }
+
+		/// \brief Subrow IDs of each row, or an empty span if read from a 2nd depth sheet.
+		[[nodiscard]] std::span<const uint16_t> SubRowIds() const { return m_subRowIds; }
+
+		/// \brief Values of a numeric or boolean column, one per row.
+		/// \tparam T bool for Bool and PackedBool columns, or the matching fixed width type for other columns.
+		template<typename T>
+		[[nodiscard]] std::span<const T> Values(size_t column) const {
+			const auto& col = m_columns.at(column);
+			if (!IsValueTypeOf<T>(col.Type))
+				throw std::invalid_argument(std::format("Column type {} cannot be read as requested type", static_cast<uint32_t>(col.Type)));
+			return { reinterpret_cast<const T*>(col.Values.data()), col.Values.size() / sizeof(T) };
+		}
+
+		/// \brief Escaped strings of a string column, one per row. Views stay valid while this object exists.
+		[[nodiscard]] std::span<const std::string_view> EscapedStrings(size_t column) const;
+
+		[[nodiscard]] SeString String(size_t column, size_t row) const;
+
+		template<typename T>
+		[[nodiscard]] static constexpr bool IsValueTypeOf(Exh::ColumnDataType type) {
+			switch (type) {
+				case Exh::Bool:
+				case Exh::PackedBool0:
+				case Exh::PackedBool1:
+				case Exh::PackedBool2:
+				case Exh::PackedBool3:
+				case Exh::PackedBool4:
+				case Exh::PackedBool5:
+				case Exh::PackedBool6:
+				case Exh::PackedBool7:
+					return std::is_same_v<T, bool>;
+				case Exh::Int8:
+					return std::is_same_v<T, int8_t>;
+				case Exh::UInt8:
+					return std::is_same_v<T, uint8_t>;
+				case Exh::Int16:
+					return std::is_same_v<T, int16_t>;
+				case Exh::UInt16:
+					return std::is_same_v<T, uint16_t>;
+				case Exh::Int32:
+					return std::is_same_v<T, int32_t>;
+				case Exh::UInt32:
+					return std::is_same_v<T, uint32_t>;
+				case Exh::Float32:
+					return std::is_same_v<T, float>;
+				case Exh::Int64:
+					return std::is_same_v<T, int64_t>;
+				case Exh::UInt64:
+					return std::is_same_v<T, uint64_t>;
+				default:
+					return false;
+			}
+		}
+	};
+
 	class ExdReader {
 		const std::shared_ptr<const RandomAccessStream> m_stream;
 		const size_t m_fixedDataSize;
@@ -77,6 +157,32 @@ namespace Sqex::Excel {
 
 		[[nodiscard]] std::vector<std::vector<ExdColumn>> ReadDepth3(uint32_t index) const;
 
+		/// \brief Reads the given columns of every row, and every subrow for 3rd depth sheets, in ascending row ID order.
+		///
+		/// The page data is read from the stream only once, and no per-row objects are created.
+		[[nodiscard]] ExdProjection ReadColumns(std::span<const size_t> columnIndices) const;
+
 		[[nodiscard]] std::vector<uint32_t> GetIds() const;
 	};
+
+	/// \brief Rows of one page of one language of a 2nd depth sheet.
+	struct ExdPageRows {
+		Sqex::Language Language{};
+		Exh::Pagination Page;
+		std::vector<std::pair<uint32_t, std::vector<ExdColumn>>> Rows;
+
+		// Set if the page could not be read entirely. Rows read before the error are kept.
+		std::exception_ptr Error;
+	};
+
+	/// \brief Reads every row of every page of every language of a 2nd depth sheet, using up to maxThreadCount threads.
+	/// \param streamGetter Returns the stream of an EXD file. Called from multiple threads at once.
+	/// \param onPage Called once per language and page, one call at a time, ordered by exh.Languages then exh.Pages
+	/// no matter which finished first. Only pages read ahead of the next one in order are kept in memory.
+	/// Return false to skip the remaining pages; anything thrown is rethrown once the reading threads have stopped.
+	void ReadDepth2Pages(
+		const ExhReader& exh,
+		const std::function<std::shared_ptr<const RandomAccessStream>(const Sqpack::EntryPathSpec&)>& streamGetter,
+		uint32_t maxThreadCount,
+		const std::function<bool(ExdPageRows&)>& onPage);
 }
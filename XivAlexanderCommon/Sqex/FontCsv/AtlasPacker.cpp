@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/AtlasPacker.h"
+
+class SkylineAtlasPacker : public Sqex::FontCsv::AtlasPacker {
+	struct Segment {
+		uint32_t X;
+		uint32_t Y;
+		uint32_t Width;
+	};
+
+	const uint32_t m_right;
+	const uint32_t m_bottom;
+
+	// Sorted by X, and covers from left to right without gaps.
+	std::vector<Segment> m_segments;
+
+public:
+	SkylineAtlasPacker(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom)
+		: m_right(right)
+		, m_bottom(bottom) {
+		m_segments.emplace_back(Segment{ left, top, static_cast<uint32_t>(right) - left });
+	}
+
+	std::optional<Position> Allocate(uint16_t width, uint16_t height) override {
+		if (!width || !height)
+			return std::nullopt;
+
+		// Bottom-left rule: lowest resulting top edge, then leftmost.
+		auto bestBottom = UINT32_MAX;
+		uint32_t bestX = 0, bestY = 0;
+		for (size_t i = 0; i < m_segments.size(); ++i) {
+			const auto x = m_segments[i].X;
+			if (x + width > m_right)
+				break;
+
+			uint32_t y = 0;
+			for (size_t j = i, remaining = width; remaining; ++j) {
+				y = std::max(y, m_segments[j].Y);
+				remaining -= std::min<size_t>(remaining, m_segments[j].Width);
+			}
+			if (y + height > m_bottom || y + height >= bestBottom)
+				continue;
+
+			bestBottom = y + height;
+			bestX = x;
+			bestY = y;
+		}
+		if (bestBottom == UINT32_MAX)
+			return std::nullopt;
+
+		std::vector<Segment> segments;
+		segments.reserve(m_segments.size() + 2);
+		const auto placedRight = bestX + width;
+		for (const auto& segment : m_segments) {
+			const auto segmentRight = segment.X + segment.Width;
+			if (segmentRight <= bestX || segment.X >= placedRight) {
+				segments.emplace_back(segment);
+				continue;
+			}
+			if (segment.X < bestX)
+				segments.emplace_back(Segment{ segment.X, segment.Y, bestX - segment.X });
+			if (segments.empty() || segments.back().X < bestX)
+				segments.emplace_back(Segment{ bestX, bestBottom, width });
+			if (segmentRight > placedRight)
+				segments.emplace_back(Segment{ placedRight, segment.Y, segmentRight - placedRight });
+		}
+
+		m_segments.clear();
+		for (const auto& segment : segments) {
+			if (!m_segments.empty() && m_segments.back().Y == segment.Y)
+				m_segments.back().Width += segment.Width;
+			else
+				m_segments.emplace_back(segment);
+		}
+
+		return Position{ static_cast<uint16_t>(bestX), static_cast<uint16_t>(bestY) };
+	}
+};
+
+class MaxRectsAtlasPacker : public Sqex::FontCsv::AtlasPacker {
+	struct Rect {
+		uint32_t X;
+		uint32_t Y;
+		uint32_t Width;
+		uint32_t Height;
+
+		[[nodiscard]] uint32_t Right() const { return X + Width; }
+		[[nodiscard]] uint32_t Bottom() const { return Y + Height; }
+
+		[[nodiscard]] bool Intersects(const Rect& r) const {
+			return X < r.Right() && r.X < Right() && Y < r.Bottom() && r.Y < Bottom();
+		}
+
+		[[nodiscard]] bool Contains(const Rect& r) const {
+			return X <= r.X && Y <= r.Y && r.Right() <= Right() && r.Bottom() <= Bottom();
+		}
+	};
+
+	std::vector<Rect> m_free;
+
+public:
+	MaxRectsAtlasPacker(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) {
+		m_free.emplace_back(Rect{ left, top, static_cast<uint32_t>(right) - left, static_cast<uint32_t>(bottom) - top });
+	}
+
+	std::optional<Position> Allocate(uint16_t width, uint16_t height) override {
+		if (!width || !height)
+			return std::nullopt;
+
+		// Best short side fit, then best long side fit, then topmost, then leftmost.
+		const Rect* best = nullptr;
+		auto bestKey = std::make_tuple(UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX);
+		for (const auto& r : m_free) {
+			if (r.Width < width || r.Height < height)
+				continue;
+			const auto leftoverX = r.Width - width, leftoverY = r.Height - height;
+			const auto key = std::make_tuple(std::min(leftoverX, leftoverY), std::max(leftoverX, leftoverY), r.Y, r.X);
+			if (key < bestKey) {
+				bestKey = key;
+				best = &r;
+			}
+		}
+		if (!best)
+			return std::nullopt;
+
+		const auto placed = Rect{ best->X, best->Y, width, height };
+
+		// Split every free rectangle overlapping the placed one into the maximal rectangles around it.
+		std::vector<Rect> split;
+		size_t kept = 0;
+		for (const auto& r : m_free) {
+			if (!r.Intersects(placed)) {
+				m_free[kept++] = r;
+				continue;
+			}
+			if (placed.X > r.X)
+				split.emplace_back(Rect{ r.X, r.Y, placed.X - r.X, r.Height });
+			if (placed.Right() < r.Right())
+				split.emplace_back(Rect{ placed.Right(), r.Y, r.Right() - placed.Right(), r.Height });
+			if (placed.Y > r.Y)
+				split.emplace_back(Rect{ r.X, r.Y, r.Width, placed.Y - r.Y });
+			if (placed.Bottom() < r.Bottom())
+				split.emplace_back(Rect{ r.X, placed.Bottom(), r.Width, r.Bottom() - placed.Bottom() });
+		}
+
+		m_free.resize(kept);
+
+		// Rectangles that were not split cannot be inside the new ones, as the new ones are parts of rectangles that were maximal.
+		const auto existingCount = m_free.size();
+		for (size_t i = 0; i < split.size(); ++i) {
+			auto contained = false;
+			for (size_t j = 0; j < existingCount && !contained; ++j)
+				contained = m_free[j].Contains(split[i]);
+			for (size_t j = 0; j < split.size() && !contained; ++j) {
+				// Of two identical rectangles, keep the first one.
+				if (i != j && split[j].Contains(split[i]))
+					contained = !split[i].Contains(split[j]) || j < i;
+			}
+			if (!contained)
+				m_free.emplace_back(split[i]);
+		}
+
+		return Position{ static_cast<uint16_t>(placed.X), static_cast<uint16_t>(placed.Y) };
+	}
+};
+
+std::unique_ptr<Sqex::FontCsv::AtlasPacker> Sqex::FontCsv::AtlasPacker::New(AtlasPackingPolicy policy, uint16_t left, uint16_t top, uint16_t right, uint16_t bottom) {
+	if (left > right || top > bottom)
+		throw std::invalid_argument("Invalid atlas area");
+
+	switch (policy) {
+		case AtlasPackingPolicy::Skyline:
+			return std::make_unique<SkylineAtlasPacker>(left, top, right, bottom);
+		case AtlasPackingPolicy::MaxRects:
+			return std::make_unique<MaxRectsAtlasPacker>(left, top, right, bottom);
+		default:
+			throw std::invalid_argument("Unsupported atlas packing policy");
+	}
+}
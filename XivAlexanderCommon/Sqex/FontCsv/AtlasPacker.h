@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace Sqex::FontCsv {
+	enum class AtlasPackingPolicy : uint8_t {
+		// Fill glyphs left to right in rows, in the order they are added. Same as layouts made by earlier versions.
+		RowFill,
+
+		// Place each glyph at the lowest position along the top edge of glyphs placed so far.
+		Skyline,
+
+		// Keep track of every maximal free rectangle, and place each glyph where it fits the tightest.
+		MaxRects,
+	};
+
+	/// \brief Finds space for rectangles in a single page of a texture atlas.
+	///
+	/// Results depend only on the sequence of requested sizes, so that layouts stay the same across runs.
+	class AtlasPacker {
+	public:
+		struct Position {
+			uint16_t X;
+			uint16_t Y;
+		};
+
+		virtual ~AtlasPacker() = default;
+
+		/// \brief Reserves a width x height rectangle.
+		/// \returns Top left corner of the reserved rectangle, or std::nullopt if there is no room left for it.
+		[[nodiscard]] virtual std::optional<Position> Allocate(uint16_t width, uint16_t height) = 0;
+
+		/// \brief Creates a packer for rectangle spanning from (left, top) to (right, bottom), exclusive.
+		/// \param policy Either Skyline or MaxRects.
+		[[nodiscard]] static std::unique_ptr<AtlasPacker> New(AtlasPackingPolicy policy, uint16_t left, uint16_t top, uint16_t right, uint16_t bottom);
+	};
+}
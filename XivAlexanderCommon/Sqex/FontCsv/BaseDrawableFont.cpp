@@ -0,0 +1,257 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/BaseDrawableFont.h"
+
+#include <intrin.h>
+
+// All kernels here must produce exactly the same result as the per-pixel formulas in RgbBitmapCopy.
+// Every intermediate value fits in 16 bits, as they are at most 255 * 255, and x / 255 is computed as (x * 0x8081) >> 23,
+// which is exact for every x in [0, 65535].
+
+static uint32_t Div255(uint32_t x) {
+	return x / 255;
+}
+
+static __m128i Div255(__m128i x) {
+	return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(static_cast<short>(0x8081))), 7);
+}
+
+static __m128i Select(__m128i mask, __m128i ifSet, __m128i ifUnset) {
+	return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifUnset));
+}
+
+// Broadcasts alpha of each of two pixels in 16-bit lanes to all lanes of the pixel.
+static __m128i BroadcastAlpha(__m128i x) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xFF), 0xFF);
+}
+
+// Broadcasts coverage of two pixels to all lanes of each pixel.
+static __m128i BroadcastCoverage(const uint8_t* coverage) {
+	return _mm_set_epi16(coverage[1], coverage[1], coverage[1], coverage[1], coverage[0], coverage[0], coverage[0], coverage[0]);
+}
+
+static __m128i SplatColor(Sqex::Texture::RGBA8888 color) {
+	return _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color.Value)), _mm_setzero_si128());
+}
+
+static bool IsSse2Supported() {
+	static const auto Supported = !!IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+	return Supported;
+}
+
+Sqex::FontCsv::GlyphGammaTable::GlyphGammaTable(double gamma)
+	: m_gamma(gamma) {
+	for (uint32_t i = 0; i < m_table.size(); ++i)
+		m_table[i] = static_cast<uint8_t>((uint32_t)(std::pow(1.0 * i / 255, 1.0 / gamma) * 255));
+}
+
+const Sqex::FontCsv::GlyphGammaTable& Sqex::FontCsv::GlyphGammaTable::Get(double gamma) {
+	thread_local std::optional<GlyphGammaTable> s_last;
+	if (!s_last || s_last->m_gamma != gamma)
+		s_last.emplace(gamma);
+	return *s_last;
+}
+
+static void BlendRgba8888OpaquePixel(Sqex::Texture::RGBA8888& d, uint32_t o, Sqex::Texture::RGBA8888 fg, Sqex::Texture::RGBA8888 bg) {
+	d.SetFrom(
+		Div255(bg.R * (255 - o) + fg.R * o),
+		Div255(bg.G * (255 - o) + fg.G * o),
+		Div255(bg.B * (255 - o) + fg.B * o),
+		255);
+}
+
+void Sqex::FontCsv::BlendGlyphRgba8888Opaque(Texture::RGBA8888* dest, const uint8_t* coverage, size_t count, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor) {
+	size_t i = 0;
+	if (IsSse2Supported()) {
+		const auto fg = SplatColor(fgColor);
+		const auto bg = SplatColor(bgColor);
+		const auto v255 = _mm_set1_epi16(255);
+		const auto alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+		const auto blend = [&](const uint8_t* c) {
+			const auto o = BroadcastCoverage(c);
+			const auto res = Div255(_mm_add_epi16(_mm_mullo_epi16(bg, _mm_sub_epi16(v255, o)), _mm_mullo_epi16(fg, o)));
+			return Select(alphaMask, v255, res);
+		};
+		for (; i + 4 <= count; i += 4) {
+			const auto lo = blend(&coverage[i]);
+			const auto hi = blend(&coverage[i + 2]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_packus_epi16(lo, hi));
+		}
+	}
+	for (; i < count; ++i)
+		BlendRgba8888OpaquePixel(dest[i], coverage[i], fgColor, bgColor);
+}
+
+static void BlendRgba8888BinaryPixel(Sqex::Texture::RGBA8888& d, uint32_t opacity, Sqex::Texture::RGBA8888 color) {
+	if (!opacity)
+		return;
+	const uint32_t da = d.A;
+	const auto r = Div255(d.R * da + color.R * (255 - da));
+	const auto g = Div255(d.G * da + color.G * (255 - da));
+	const auto b = Div255(d.B * da + color.B * (255 - da));
+	const auto a = 255 - Div255((255 - da) * (255 - opacity));
+	d.SetFrom(
+		Div255(r * (255 - opacity) + color.R * opacity),
+		Div255(g * (255 - opacity) + color.G * opacity),
+		Div255(b * (255 - opacity) + color.B * opacity),
+		a);
+}
+
+void Sqex::FontCsv::BlendGlyphRgba8888Binary(Texture::RGBA8888* dest, const uint8_t* coverage, size_t count, Texture::RGBA8888 color, bool colorIsForeground) {
+	size_t i = 0;
+	if (IsSse2Supported()) {
+		const auto c = SplatColor(color);
+		const auto v255 = _mm_set1_epi16(255);
+		const auto zero = _mm_setzero_si128();
+		const auto alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+		const auto blend = [&](__m128i d, const uint8_t* cov) {
+			auto op = BroadcastCoverage(cov);
+			if (!colorIsForeground)
+				op = _mm_sub_epi16(v255, op);
+			const auto invOp = _mm_sub_epi16(v255, op);
+			const auto da = BroadcastAlpha(d);
+			const auto invDa = _mm_sub_epi16(v255, da);
+			const auto blendedDest = Div255(_mm_add_epi16(_mm_mullo_epi16(d, da), _mm_mullo_epi16(c, invDa)));
+			const auto blendedDestAlpha = _mm_sub_epi16(v255, Div255(_mm_mullo_epi16(invDa, invOp)));
+			const auto res = Div255(_mm_add_epi16(_mm_mullo_epi16(blendedDest, invOp), _mm_mullo_epi16(c, op)));
+			return Select(_mm_cmpeq_epi16(op, zero), d, Select(alphaMask, blendedDestAlpha, res));
+		};
+		for (; i + 4 <= count; i += 4) {
+			const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dest[i]));
+			const auto lo = blend(_mm_unpacklo_epi8(d, zero), &coverage[i]);
+			const auto hi = blend(_mm_unpackhi_epi8(d, zero), &coverage[i + 2]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_packus_epi16(lo, hi));
+		}
+	}
+	for (; i < count; ++i)
+		BlendRgba8888BinaryPixel(dest[i], colorIsForeground ? coverage[i] : 255 - coverage[i], color);
+}
+
+static void BlendRgba8888Pixel(Sqex::Texture::RGBA8888& d, uint32_t o, Sqex::Texture::RGBA8888 fg, Sqex::Texture::RGBA8888 bg) {
+	const uint32_t da = d.A;
+	const uint32_t bgA = bg.A, fgA = fg.A;
+	const uint32_t blendedBg[4]{
+		Div255(bg.R * bgA + d.R * (255 - bgA)),
+		Div255(bg.G * bgA + d.G * (255 - bgA)),
+		Div255(bg.B * bgA + d.B * (255 - bgA)),
+		255 - Div255((255 - bgA) * (255 - da)),
+	};
+	const uint32_t blendedFg[4]{
+		Div255(fg.R * fgA + d.R * (255 - fgA)),
+		Div255(fg.G * fgA + d.G * (255 - fgA)),
+		Div255(fg.B * fgA + d.B * (255 - fgA)),
+		255 - Div255((255 - fgA) * (255 - da)),
+	};
+	uint32_t current[4];
+	for (size_t c = 0; c < 4; ++c)
+		current[c] = Div255(blendedBg[c] * (255 - o) + blendedFg[c] * o);
+	const auto ca = current[3];
+	const auto r = Div255(d.R * da + current[0] * (255 - da));
+	const auto g = Div255(d.G * da + current[1] * (255 - da));
+	const auto b = Div255(d.B * da + current[2] * (255 - da));
+	const auto a = 255 - Div255((255 - da) * (255 - ca));
+	d.SetFrom(
+		Div255(r * (255 - ca) + current[0] * ca),
+		Div255(g * (255 - ca) + current[1] * ca),
+		Div255(b * (255 - ca) + current[2] * ca),
+		a);
+}
+
+void Sqex::FontCsv::BlendGlyphRgba8888(Texture::RGBA8888* dest, const uint8_t* coverage, size_t count, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor) {
+	size_t i = 0;
+	if (IsSse2Supported()) {
+		const auto v255 = _mm_set1_epi16(255);
+		const auto zero = _mm_setzero_si128();
+		const auto alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+		const auto bgA = _mm_set1_epi16(static_cast<short>(bgColor.A));
+		const auto fgA = _mm_set1_epi16(static_cast<short>(fgColor.A));
+		const auto invBgA = _mm_sub_epi16(v255, bgA);
+		const auto invFgA = _mm_sub_epi16(v255, fgA);
+		const auto bgPremultiplied = _mm_mullo_epi16(SplatColor(bgColor), bgA);
+		const auto fgPremultiplied = _mm_mullo_epi16(SplatColor(fgColor), fgA);
+		const auto blend = [&](__m128i d, const uint8_t* cov) {
+			const auto o = BroadcastCoverage(cov);
+			const auto da = BroadcastAlpha(d);
+			const auto invDa = _mm_sub_epi16(v255, da);
+			const auto blendedBg = Select(alphaMask,
+				_mm_sub_epi16(v255, Div255(_mm_mullo_epi16(invBgA, invDa))),
+				Div255(_mm_add_epi16(bgPremultiplied, _mm_mullo_epi16(d, invBgA))));
+			const auto blendedFg = Select(alphaMask,
+				_mm_sub_epi16(v255, Div255(_mm_mullo_epi16(invFgA, invDa))),
+				Div255(_mm_add_epi16(fgPremultiplied, _mm_mullo_epi16(d, invFgA))));
+			const auto current = Div255(_mm_add_epi16(_mm_mullo_epi16(blendedBg, _mm_sub_epi16(v255, o)), _mm_mullo_epi16(blendedFg, o)));
+			const auto ca = BroadcastAlpha(current);
+			const auto invCa = _mm_sub_epi16(v255, ca);
+			const auto blendedDest = Div255(_mm_add_epi16(_mm_mullo_epi16(d, da), _mm_mullo_epi16(current, invDa)));
+			const auto blendedDestAlpha = _mm_sub_epi16(v255, Div255(_mm_mullo_epi16(invDa, invCa)));
+			const auto res = Div255(_mm_add_epi16(_mm_mullo_epi16(blendedDest, invCa), _mm_mullo_epi16(current, ca)));
+			return Select(alphaMask, blendedDestAlpha, res);
+		};
+		for (; i + 4 <= count; i += 4) {
+			const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dest[i]));
+			const auto lo = blend(_mm_unpacklo_epi8(d, zero), &coverage[i]);
+			const auto hi = blend(_mm_unpackhi_epi8(d, zero), &coverage[i + 2]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_packus_epi16(lo, hi));
+		}
+	}
+	for (; i < count; ++i)
+		BlendRgba8888Pixel(dest[i], coverage[i], fgColor, bgColor);
+}
+
+void Sqex::FontCsv::BlendGlyphL8Opaque(uint8_t* dest, const uint8_t* coverage, size_t count) {
+	// 255 * coverage / 255 is always coverage itself.
+	std::copy_n(coverage, count, dest);
+}
+
+void Sqex::FontCsv::BlendGlyphL8Binary(uint8_t* dest, const uint8_t* coverage, size_t count, uint8_t color, bool colorIsForeground) {
+	size_t i = 0;
+	if (IsSse2Supported()) {
+		const auto c = _mm_set1_epi16(color);
+		const auto v255 = _mm_set1_epi16(255);
+		const auto zero = _mm_setzero_si128();
+		const auto blend = [&](__m128i d, __m128i op) {
+			if (!colorIsForeground)
+				op = _mm_sub_epi16(v255, op);
+			return Div255(_mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(v255, op)), _mm_mullo_epi16(c, op)));
+		};
+		for (; i + 16 <= count; i += 16) {
+			const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dest[i]));
+			const auto o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&coverage[i]));
+			const auto lo = blend(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(o, zero));
+			const auto hi = blend(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(o, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_packus_epi16(lo, hi));
+		}
+	}
+	for (; i < count; ++i) {
+		const uint32_t op = colorIsForeground ? coverage[i] : 255 - coverage[i];
+		dest[i] = static_cast<uint8_t>(Div255(dest[i] * (255 - op) + color * op));
+	}
+}
+
+void Sqex::FontCsv::BlendGlyphL8(uint8_t* dest, const uint8_t* coverage, size_t count, uint8_t fgColor, uint8_t bgColor, uint8_t fgOpacity, uint8_t bgOpacity) {
+	size_t i = 0;
+	if (IsSse2Supported()) {
+		const auto v255 = _mm_set1_epi16(255);
+		const auto zero = _mm_setzero_si128();
+		const auto bgPremultiplied = _mm_set1_epi16(static_cast<short>(bgColor * bgOpacity));
+		const auto fgPremultiplied = _mm_set1_epi16(static_cast<short>(fgColor * fgOpacity));
+		const auto invBgOpacity = _mm_set1_epi16(static_cast<short>(255 - bgOpacity));
+		const auto invFgOpacity = _mm_set1_epi16(static_cast<short>(255 - fgOpacity));
+		const auto blend = [&](__m128i d, __m128i o) {
+			const auto blendedBg = Div255(_mm_add_epi16(bgPremultiplied, _mm_mullo_epi16(d, invBgOpacity)));
+			const auto blendedFg = Div255(_mm_add_epi16(fgPremultiplied, _mm_mullo_epi16(d, invFgOpacity)));
+			return Div255(_mm_add_epi16(_mm_mullo_epi16(blendedBg, _mm_sub_epi16(v255, o)), _mm_mullo_epi16(blendedFg, o)));
+		};
+		for (; i + 16 <= count; i += 16) {
+			const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dest[i]));
+			const auto o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&coverage[i]));
+			const auto lo = blend(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(o, zero));
+			const auto hi = blend(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(o, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_packus_epi16(lo, hi));
+		}
+	}
+	for (; i < count; ++i) {
+		const auto blendedBg = Div255(bgColor * bgOpacity + dest[i] * (255 - bgOpacity));
+		const auto blendedFg = Div255(fgColor * fgOpacity + dest[i] * (255 - fgOpacity));
+		dest[i] = static_cast<uint8_t>(Div255(blendedBg * (255 - coverage[i]) + blendedFg * coverage[i]));
+	}
+}
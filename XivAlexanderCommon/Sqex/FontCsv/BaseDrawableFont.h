@@ -6,6 +6,32 @@
 #include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
 
 namespace Sqex::FontCsv {
+	/// \brief Maps glyph coverage in [0, 255] to gamma corrected coverage.
+	class GlyphGammaTable {
+		double m_gamma;
+		std::array<uint8_t, 256> m_table{};
+
+	public:
+		explicit GlyphGammaTable(double gamma);
+
+		/// \brief Gets the table for gamma, reusing the table built by the last call from the same thread if gamma did not change.
+		static const GlyphGammaTable& Get(double gamma);
+
+		uint8_t operator[](uint32_t coverage) const {
+			return m_table[std::min<uint32_t>(coverage, 255)];
+		}
+	};
+
+	// Blends rows of gamma corrected glyph coverage into 32-bit and 8-bit destinations, using SSE2 where available.
+	// Results are identical to the per-pixel formulas in RgbBitmapCopy.
+
+	void BlendGlyphRgba8888Opaque(Texture::RGBA8888* dest, const uint8_t* coverage, size_t count, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor);
+	void BlendGlyphRgba8888Binary(Texture::RGBA8888* dest, const uint8_t* coverage, size_t count, Texture::RGBA8888 color, bool colorIsForeground);
+	void BlendGlyphRgba8888(Texture::RGBA8888* dest, const uint8_t* coverage, size_t count, Texture::RGBA8888 fgColor, Texture::RGBA8888 bgColor);
+	void BlendGlyphL8Opaque(uint8_t* dest, const uint8_t* coverage, size_t count);
+	void BlendGlyphL8Binary(uint8_t* dest, const uint8_t* coverage, size_t count, uint8_t color, bool colorIsForeground);
+	void BlendGlyphL8(uint8_t* dest, const uint8_t* coverage, size_t count, uint8_t fgColor, uint8_t bgColor, uint8_t fgOpacity, uint8_t bgOpacity);
+
 	template<
 		typename SrcPixFmt,
 		uint32_t ResolverFunction(const SrcPixFmt&),
@@ -17,155 +43,184 @@ namespace Sqex::FontCsv {
 
 		static constexpr auto Scaler = 0xFFUL;
 		static constexpr auto MaxOpacity = std::numeric_limits<OpacityType>::max();
+		static constexpr size_t CoverageChunkSize = 256;
+
+		static constexpr bool UseRgba8888Kernels = std::is_same_v<DestPixFmt, Texture::RGBA8888>;
+		static constexpr bool UseL8Kernels = std::is_same_v<DestPixFmt, uint8_t> && std::is_same_v<OpacityType, uint8_t>;
 
-		static inline void DrawLineToRgb(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
-			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
-				const auto blendedBgColor = DestPixFmt{
-					(bgColor.R * bgColor.A + destPtr->R * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
-					(bgColor.G * bgColor.A + destPtr->G * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
-					(bgColor.B * bgColor.A + destPtr->B * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
-					DestPixFmt::MaxA - ((DestPixFmt::MaxA - bgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-				};
-				const auto blendedFgColor = DestPixFmt{
-					(fgColor.R * fgColor.A + destPtr->R * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
-					(fgColor.G * fgColor.A + destPtr->G * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
-					(fgColor.B * fgColor.A + destPtr->B * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
-					DestPixFmt::MaxA - ((DestPixFmt::MaxA - fgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-				};
-				const auto currentColor = DestPixFmt{
-					(blendedBgColor.R * (Scaler - opacityScaled) + blendedFgColor.R * opacityScaled) / Scaler,
-					(blendedBgColor.G * (Scaler - opacityScaled) + blendedFgColor.G * opacityScaled) / Scaler,
-					(blendedBgColor.B * (Scaler - opacityScaled) + blendedFgColor.B * opacityScaled) / Scaler,
-					(blendedBgColor.A * (Scaler - opacityScaled) + blendedFgColor.A * opacityScaled) / Scaler,
-				};
-				const auto blendedDestColor = DestPixFmt{
-					(destPtr->R * destPtr->A + currentColor.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-					(destPtr->G * destPtr->A + currentColor.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-					(destPtr->B * destPtr->A + currentColor.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-					DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - currentColor.A)) / DestPixFmt::MaxA,
-				};
-				destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - currentColor.A) + currentColor.R * currentColor.A) / DestPixFmt::MaxR;
-				destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - currentColor.A) + currentColor.G * currentColor.A) / DestPixFmt::MaxG;
-				destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - currentColor.A) + currentColor.B * currentColor.A) / DestPixFmt::MaxB;
-				destPtr->A = blendedDestColor.A;
-				++destPtr;
-				++srcPtr;
+		static inline void DrawLineToRgb(DestPixFmt* destPtr, const uint8_t* coverage, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor) {
+			if constexpr (UseRgba8888Kernels) {
+				BlendGlyphRgba8888(destPtr, coverage, regionWidth, fgColor, bgColor);
+			} else {
+				while (regionWidth--) {
+					const uint32_t opacityScaled = *coverage;
+					const auto blendedBgColor = DestPixFmt{
+						(bgColor.R * bgColor.A + destPtr->R * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+						(bgColor.G * bgColor.A + destPtr->G * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+						(bgColor.B * bgColor.A + destPtr->B * (DestPixFmt::MaxA - bgColor.A)) / DestPixFmt::MaxA,
+						DestPixFmt::MaxA - ((DestPixFmt::MaxA - bgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					};
+					const auto blendedFgColor = DestPixFmt{
+						(fgColor.R * fgColor.A + destPtr->R * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+						(fgColor.G * fgColor.A + destPtr->G * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+						(fgColor.B * fgColor.A + destPtr->B * (DestPixFmt::MaxA - fgColor.A)) / DestPixFmt::MaxA,
+						DestPixFmt::MaxA - ((DestPixFmt::MaxA - fgColor.A) * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+					};
+					const auto currentColor = DestPixFmt{
+						(blendedBgColor.R * (Scaler - opacityScaled) + blendedFgColor.R * opacityScaled) / Scaler,
+						(blendedBgColor.G * (Scaler - opacityScaled) + blendedFgColor.G * opacityScaled) / Scaler,
+						(blendedBgColor.B * (Scaler - opacityScaled) + blendedFgColor.B * opacityScaled) / Scaler,
+						(blendedBgColor.A * (Scaler - opacityScaled) + blendedFgColor.A * opacityScaled) / Scaler,
+					};
+					const auto blendedDestColor = DestPixFmt{
+						(destPtr->R * destPtr->A + currentColor.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+						(destPtr->G * destPtr->A + currentColor.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+						(destPtr->B * destPtr->A + currentColor.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+						DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - currentColor.A)) / DestPixFmt::MaxA,
+					};
+					destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - currentColor.A) + currentColor.R * currentColor.A) / DestPixFmt::MaxR;
+					destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - currentColor.A) + currentColor.G * currentColor.A) / DestPixFmt::MaxG;
+					destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - currentColor.A) + currentColor.B * currentColor.A) / DestPixFmt::MaxB;
+					destPtr->A = blendedDestColor.A;
+					++destPtr;
+					++coverage;
+				}
 			}
 		}
 
-		static inline void DrawLineToRgbOpaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, double gamma) {
-			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
-				destPtr->R = (bgColor.R * (Scaler - opacityScaled) + fgColor.R * opacityScaled) / Scaler;
-				destPtr->G = (bgColor.G * (Scaler - opacityScaled) + fgColor.G * opacityScaled) / Scaler;
-				destPtr->B = (bgColor.B * (Scaler - opacityScaled) + fgColor.B * opacityScaled) / Scaler;
-				destPtr->A = DestPixFmt::MaxA;
-				++destPtr;
-				++srcPtr;
+		static inline void DrawLineToRgbOpaque(DestPixFmt* destPtr, const uint8_t* coverage, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor) {
+			if constexpr (UseRgba8888Kernels) {
+				BlendGlyphRgba8888Opaque(destPtr, coverage, regionWidth, fgColor, bgColor);
+			} else {
+				while (regionWidth--) {
+					const uint32_t opacityScaled = *coverage;
+					destPtr->R = (bgColor.R * (Scaler - opacityScaled) + fgColor.R * opacityScaled) / Scaler;
+					destPtr->G = (bgColor.G * (Scaler - opacityScaled) + fgColor.G * opacityScaled) / Scaler;
+					destPtr->B = (bgColor.B * (Scaler - opacityScaled) + fgColor.B * opacityScaled) / Scaler;
+					destPtr->A = DestPixFmt::MaxA;
+					++destPtr;
+					++coverage;
+				}
 			}
 		}
 
 		template<bool ColorIsForeground>
-		static inline void DrawLineToRgbBinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
-			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
-				const auto opacity = DestPixFmt::MaxA * (ColorIsForeground ? opacityScaled : Scaler - opacityScaled) / Scaler;
-				if (opacity) {
-					const auto blendedDestColor = DestPixFmt{
-						(destPtr->R * destPtr->A + color.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-						(destPtr->G * destPtr->A + color.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-						(destPtr->B * destPtr->A + color.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
-						DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - opacity)) / DestPixFmt::MaxA,
-					};
-					destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - opacity) + color.R * opacity) / DestPixFmt::MaxR;
-					destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - opacity) + color.G * opacity) / DestPixFmt::MaxG;
-					destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - opacity) + color.B * opacity) / DestPixFmt::MaxB;
-					destPtr->A = blendedDestColor.A;
+		static inline void DrawLineToRgbBinaryOpacity(DestPixFmt* destPtr, const uint8_t* coverage, size_t regionWidth, const DestPixFmt& color) {
+			if constexpr (UseRgba8888Kernels) {
+				BlendGlyphRgba8888Binary(destPtr, coverage, regionWidth, color, ColorIsForeground);
+			} else {
+				while (regionWidth--) {
+					const uint32_t opacityScaled = *coverage;
+					const auto opacity = DestPixFmt::MaxA * (ColorIsForeground ? opacityScaled : Scaler - opacityScaled) / Scaler;
+					if (opacity) {
+						const auto blendedDestColor = DestPixFmt{
+							(destPtr->R * destPtr->A + color.R * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+							(destPtr->G * destPtr->A + color.G * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+							(destPtr->B * destPtr->A + color.B * (DestPixFmt::MaxA - destPtr->A)) / DestPixFmt::MaxA,
+							DestPixFmt::MaxA - ((DestPixFmt::MaxA - destPtr->A) * (DestPixFmt::MaxA - opacity)) / DestPixFmt::MaxA,
+						};
+						destPtr->R = (blendedDestColor.R * (DestPixFmt::MaxA - opacity) + color.R * opacity) / DestPixFmt::MaxR;
+						destPtr->G = (blendedDestColor.G * (DestPixFmt::MaxA - opacity) + color.G * opacity) / DestPixFmt::MaxG;
+						destPtr->B = (blendedDestColor.B * (DestPixFmt::MaxA - opacity) + color.B * opacity) / DestPixFmt::MaxB;
+						destPtr->A = blendedDestColor.A;
+					}
+					++destPtr;
+					++coverage;
 				}
-				++destPtr;
-				++srcPtr;
 			}
 		}
 
-		static inline void DrawLineToL8(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
-			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
-
-			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
-				const auto blendedBgColor = (1 * bgColor * bgOpacity + 1 * *destPtr * (MaxOpacity - bgOpacity)) / MaxOpacity;
-				const auto blendedFgColor = (1 * fgColor * fgOpacity + 1 * *destPtr * (MaxOpacity - fgOpacity)) / MaxOpacity;
-				*destPtr = static_cast<DestPixFmt>((blendedBgColor * (Scaler - opacityScaled) + blendedFgColor * opacityScaled) / Scaler);
-				++destPtr;
-				++srcPtr;
+		static inline void DrawLineToL8(DestPixFmt* destPtr, const uint8_t* coverage, size_t regionWidth, const DestPixFmt& fgColor, const DestPixFmt& bgColor, OpacityType fgOpacity, OpacityType bgOpacity) {
+			if constexpr (UseL8Kernels) {
+				BlendGlyphL8(destPtr, coverage, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity);
+			} else {
+				while (regionWidth--) {
+					const uint32_t opacityScaled = *coverage;
+					const auto blendedBgColor = (1 * bgColor * bgOpacity + 1 * *destPtr * (MaxOpacity - bgOpacity)) / MaxOpacity;
+					const auto blendedFgColor = (1 * fgColor * fgOpacity + 1 * *destPtr * (MaxOpacity - fgOpacity)) / MaxOpacity;
+					*destPtr = static_cast<DestPixFmt>((blendedBgColor * (Scaler - opacityScaled) + blendedFgColor * opacityScaled) / Scaler);
+					++destPtr;
+					++coverage;
+				}
 			}
 		}
 
-		static inline void DrawLineToL8Opaque(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, double gamma) {
-			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
-
-			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
-				*destPtr = static_cast<DestPixFmt>(MaxOpacity * opacityScaled / Scaler);
-				++destPtr;
-				++srcPtr;
+		static inline void DrawLineToL8Opaque(DestPixFmt* destPtr, const uint8_t* coverage, size_t regionWidth) {
+			if constexpr (UseL8Kernels) {
+				BlendGlyphL8Opaque(destPtr, coverage, regionWidth);
+			} else {
+				while (regionWidth--) {
+					const uint32_t opacityScaled = *coverage;
+					*destPtr = static_cast<DestPixFmt>(MaxOpacity * opacityScaled / Scaler);
+					++destPtr;
+					++coverage;
+				}
 			}
 		}
 
 		template<bool ColorIsForeground>
-		static inline void DrawLineToL8BinaryOpacity(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, size_t regionWidth, const DestPixFmt& color, double gamma) {
-			constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
-
-			while (regionWidth--) {
-				const auto opacityScaled = (uint32_t)(std::pow(1.0 * ResolverFunction(*srcPtr) / Scaler, gamma) * Scaler);
-				const auto opacityScaled2 = ColorIsForeground ? opacityScaled : Scaler - opacityScaled;
-				*destPtr = static_cast<DestPixFmt>((*destPtr * (Scaler - opacityScaled2) + 1 * color * opacityScaled2) / Scaler);
-				++destPtr;
-				++srcPtr;
+		static inline void DrawLineToL8BinaryOpacity(DestPixFmt* destPtr, const uint8_t* coverage, size_t regionWidth, const DestPixFmt& color) {
+			if constexpr (UseL8Kernels) {
+				BlendGlyphL8Binary(destPtr, coverage, regionWidth, color, ColorIsForeground);
+			} else {
+				while (regionWidth--) {
+					const uint32_t opacityScaled = *coverage;
+					const auto opacityScaled2 = ColorIsForeground ? opacityScaled : Scaler - opacityScaled;
+					*destPtr = static_cast<DestPixFmt>((*destPtr * (Scaler - opacityScaled2) + 1 * color * opacityScaled2) / Scaler);
+					++destPtr;
+					++coverage;
+				}
+			}
+		}
+
+		// Resolves and gamma corrects coverage of source pixels in chunks, and hands each chunk to drawLine.
+		template<typename DrawLine>
+		static inline void ForEachLine(DestPixFmt* destPtr, const SrcPixFmt* srcPtr, SSIZE_T destWidth, SSIZE_T srcPtrDelta, SSIZE_T regionWidth, SSIZE_T regionHeight, const GlyphGammaTable& gammaTable, const DrawLine& drawLine) {
+			uint8_t coverage[CoverageChunkSize];
+			for (SSIZE_T i = 0; i < regionHeight; ++i, destPtr += destWidth, srcPtr += srcPtrDelta) {
+				for (SSIZE_T x = 0; x < regionWidth; x += CoverageChunkSize) {
+					const auto count = std::min<size_t>(CoverageChunkSize, regionWidth - x);
+					for (size_t j = 0; j < count; ++j)
+						coverage[j] = gammaTable[ResolverFunction(srcPtr[x + j])];
+					drawLine(destPtr + x, coverage, count);
+				}
 			}
 		}
 
 	public:
 		static inline void CopyTo(const GlyphMeasurement& src, const GlyphMeasurement& dest, const SrcPixFmt* srcBuf, DestPixFmt* destBuf, SSIZE_T srcWidth, SSIZE_T srcHeight, SSIZE_T destWidth, DestPixFmt fgColor, DestPixFmt bgColor, OpacityType fgOpacity, OpacityType bgOpacity, double gamma) {
-			auto destPtrBegin = &destBuf[static_cast<size_t>(1) * dest.top * destWidth + dest.left];
-			auto srcPtrBegin = &srcBuf[static_cast<size_t>(1) * (VerticalDirection == 1 ? src.top : srcHeight - src.top - 1) * srcWidth + src.left];
+			const auto destPtrBegin = &destBuf[static_cast<size_t>(1) * dest.top * destWidth + dest.left];
+			const auto srcPtrBegin = &srcBuf[static_cast<size_t>(1) * (VerticalDirection == 1 ? src.top : srcHeight - src.top - 1) * srcWidth + src.left];
 			const auto srcPtrDelta = srcWidth * VerticalDirection;
 			const auto regionWidth = src.right - src.left;
 			const auto regionHeight = src.bottom - src.top;
-
-			gamma = 1.0 / gamma;
+			const auto& gammaTable = GlyphGammaTable::Get(gamma);
+			const auto forEachLine = [&](const auto& drawLine) {
+				ForEachLine(destPtrBegin, srcPtrBegin, destWidth, srcPtrDelta, regionWidth, regionHeight, gammaTable, drawLine);
+			};
 
 			if constexpr (std::is_integral_v<DestPixFmt>) {
 				constexpr auto DestPixFmtMax = std::numeric_limits<DestPixFmt>::max();
-
 				if (fgOpacity == MaxOpacity && bgOpacity == MaxOpacity && fgColor == DestPixFmtMax && bgColor == 0) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8Opaque(destPtrBegin, srcPtrBegin, regionWidth, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToL8Opaque(d, c, n); });
 				} else if (fgOpacity == MaxOpacity && bgOpacity == 0) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8BinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToL8BinaryOpacity<true>(d, c, n, fgColor); });
 				} else if (fgOpacity == 0 && bgOpacity == MaxOpacity) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8BinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToL8BinaryOpacity<false>(d, c, n, bgColor); });
 				} else {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToL8(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, fgOpacity, bgOpacity, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToL8(d, c, n, fgColor, bgColor, fgOpacity, bgOpacity); });
 				}
 			} else {
 				fgColor.A = fgColor.A * fgOpacity / std::numeric_limits<OpacityType>::max();
 				bgColor.A = bgColor.A * bgOpacity / std::numeric_limits<OpacityType>::max();
 				if (fgColor.A == DestPixFmt::MaxA && bgColor.A == DestPixFmt::MaxA) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgbOpaque(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToRgbOpaque(d, c, n, fgColor, bgColor); });
 				} else if (fgColor.A == DestPixFmt::MaxA && bgColor.A == 0) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgbBinaryOpacity<true>(destPtrBegin, srcPtrBegin, regionWidth, fgColor, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToRgbBinaryOpacity<true>(d, c, n, fgColor); });
 				} else if (fgColor.A == 0 && bgColor.A == DestPixFmt::MaxA) {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgbBinaryOpacity<false>(destPtrBegin, srcPtrBegin, regionWidth, bgColor, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToRgbBinaryOpacity<false>(d, c, n, bgColor); });
 				} else {
-					for (auto i = 0; i < regionHeight; ++i, destPtrBegin += destWidth, srcPtrBegin += srcPtrDelta)
-						DrawLineToRgb(destPtrBegin, srcPtrBegin, regionWidth, fgColor, bgColor, gamma);
+					forEachLine([&](DestPixFmt* d, const uint8_t* c, size_t n) { DrawLineToRgb(d, c, n, fgColor, bgColor); });
 				}
 			}
 		}
@@ -415,6 +415,36 @@ void Sqex::FontCsv::CreateConfig::from_json(const nlohmann::json& j, VerticalAli
 		throw std::invalid_argument(std::format("Unexpected value {} for vertical alignment (tried to interpret from {})", j.get<std::string>(), s));
 }
 
+void Sqex::FontCsv::to_json(nlohmann::json& j, const AtlasPackingPolicy& o) {
+	switch (o) {
+		case AtlasPackingPolicy::RowFill:
+			j = "rowFill";
+			break;
+
+		case AtlasPackingPolicy::Skyline:
+			j = "skyline";
+			break;
+
+		case AtlasPackingPolicy::MaxRects:
+			j = "maxRects";
+			break;
+	}
+}
+
+void Sqex::FontCsv::from_json(const nlohmann::json& j, AtlasPackingPolicy& o) {
+	auto s = j.get<std::string>();
+	CharUpperA(&s[0]);
+
+	if (s == "ROWFILL")
+		o = AtlasPackingPolicy::RowFill;
+	else if (s == "SKYLINE")
+		o = AtlasPackingPolicy::Skyline;
+	else if (s == "MAXRECTS")
+		o = AtlasPackingPolicy::MaxRects;
+	else
+		throw std::invalid_argument(std::format("Unexpected value {} for atlas packing policy", j.get<std::string>()));
+}
+
 void Sqex::FontCsv::CreateConfig::to_json(nlohmann::json& j, const SingleTargetComponent& o) {
 	j = nlohmann::json::object({
 		{"name", o.name},
@@ -526,6 +556,7 @@ void Sqex::FontCsv::CreateConfig::to_json(nlohmann::json& j, const FontCreateCon
 	j = nlohmann::json::object({
 		{"glyphGap", o.glyphGap},
 		{"compactLayout", o.compactLayout},
+		{"atlasPacking", o.atlasPacking},
 		{"textureWidth", o.textureWidth},
 		{"textureHeight", o.textureHeight},
 		{"textureFormat", o.textureFormat},
@@ -553,6 +584,7 @@ void Sqex::FontCsv::CreateConfig::from_json(const nlohmann::json& j, FontCreateC
 	try {
 		o.glyphGap = j.value<uint16_t>(lastAttempt = "glyphGap", 1);
 		o.compactLayout = j.value(lastAttempt = "compactLayout", false);
+		o.atlasPacking = j.value(lastAttempt = "atlasPacking", AtlasPackingPolicy::RowFill);
 		o.textureWidth = j.value<uint16_t>(lastAttempt = "textureWidth", 1024);
 		o.textureHeight = j.value<uint16_t>(lastAttempt = "textureHeight", 1024);
 		o.textureFormat = Texture::Format::A4R4G4B4;
@@ -8,6 +8,7 @@
 #include <nlohmann/json.hpp>
 
 #include "XivAlexanderCommon/Sqex/Texture.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/AtlasPacker.h"
 
 namespace Sqex::FontCsv::CreateConfig {
 	struct GameIndexFile {
@@ -161,6 +162,7 @@ namespace Sqex::FontCsv::CreateConfig {
 	struct FontCreateConfig {
 		uint16_t glyphGap{};
 		bool compactLayout{};
+		AtlasPackingPolicy atlasPacking{};
 		uint16_t textureWidth{};
 		uint16_t textureHeight{};
 		Texture::Format textureFormat{};
@@ -176,6 +178,11 @@ namespace Sqex::FontCsv::CreateConfig {
 	void from_json(const nlohmann::json& j, FontCreateConfig& o);
 }
 
+namespace Sqex::FontCsv {
+	void to_json(nlohmann::json& j, const AtlasPackingPolicy& o);
+	void from_json(const nlohmann::json& j, AtlasPackingPolicy& o);
+}
+
 void to_json(nlohmann::json& j, const DWRITE_RENDERING_MODE& o);
 void from_json(const nlohmann::json& j, DWRITE_RENDERING_MODE& o);
 
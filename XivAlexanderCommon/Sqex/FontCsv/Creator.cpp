@@ -21,7 +21,7 @@ inline void DebugThrowError(const std::exception& e) {
 
 struct Sqex::FontCsv::FontCsvCreator::CharacterPlan {
 private:
-	mutable GlyphMeasurement m_bbox;
+	mutable std::optional<GlyphMeasurement> m_bbox;
 	char32_t m_codePoint;
 	int m_offsetXModifier;
 	int m_offsetYModifier;
@@ -39,11 +39,23 @@ public:
 	}
 
 	const GlyphMeasurement& GetBbox() const {
-		if (m_bbox.empty) {
+		if (!m_bbox) {
 			m_bbox = Font->Base.Measure(0, 0, m_codePoint);
-			m_bbox.advanceX += m_offsetXModifier;
+			m_bbox->advanceX += m_offsetXModifier;
 		}
-		return m_bbox;
+		return *m_bbox;
+	}
+
+	// Measurement as returned from the font, without modifiers applied.
+	[[nodiscard]] GlyphMeasurement GetMeasurement() const {
+		auto res = GetBbox();
+		res.advanceX -= m_offsetXModifier;
+		return res;
+	}
+
+	void SetMeasurement(GlyphMeasurement measurement) {
+		measurement.advanceX += m_offsetXModifier;
+		m_bbox = measurement;
 	}
 
 	bool operator<(const CharacterPlan& r) const {
@@ -75,6 +87,50 @@ public:
 	}
 };
 
+// Layout of glyph measurements stored in GlyphCache.
+struct CachedGlyphMeasurement {
+	int32_t Left;
+	int32_t Top;
+	int32_t Right;
+	int32_t Bottom;
+	int32_t AdvanceX;
+	uint32_t Empty;
+
+	static CachedGlyphMeasurement From(const Sqex::FontCsv::GlyphMeasurement& m) {
+		return {
+			.Left = static_cast<int32_t>(m.left),
+			.Top = static_cast<int32_t>(m.top),
+			.Right = static_cast<int32_t>(m.right),
+			.Bottom = static_cast<int32_t>(m.bottom),
+			.AdvanceX = static_cast<int32_t>(m.advanceX),
+			.Empty = m.empty ? 1U : 0U,
+		};
+	}
+
+	[[nodiscard]] Sqex::FontCsv::GlyphMeasurement ToMeasurement() const {
+		return {
+			.empty = !!Empty,
+			.left = Left,
+			.top = Top,
+			.right = Right,
+			.bottom = Bottom,
+			.advanceX = AdvanceX,
+		};
+	}
+};
+
+// Layout of rasterized glyphs stored in GlyphCache, followed by Width * Height bytes of L8 pixels.
+struct CachedGlyphBitmapHeader {
+	// Position of the top left pixel, relative to where the glyph has been drawn.
+	int16_t Left;
+	int16_t Top;
+	uint16_t Width;
+	uint16_t Height;
+};
+
+// Bump when the layout of anything stored in GlyphCache or what gets hashed into keys changes.
+static constexpr uint32_t GlyphCacheVersion = 1;
+
 struct Sqex::FontCsv::FontCsvCreator::Implementation {
 	Win32::TpEnvironment WorkPool = { L"FontCsvCreator::Implementation::WorkPool" };
 	bool Cancelled = false;
@@ -128,6 +184,49 @@ struct Sqex::FontCsv::FontCsvCreator::Implementation {
 		});
 	}
 
+	struct PendingMeasurementCacheEntry {
+		GlyphCache::Digest Key;
+		std::vector<size_t> PlanIndices;
+	};
+
+	// Fills in measurements of plans from the cache, one entry per font, and returns the ones not found.
+	std::vector<PendingMeasurementCacheEntry> LoadCachedMeasurements(GlyphCache& cache) {
+		std::map<const BaseDrawableFont<uint8_t>*, std::vector<size_t>> planIndicesByFont;
+		for (size_t i = 0; i < Plans.size(); ++i)
+			planIndicesByFont[Plans[i].Font].emplace_back(i);
+
+		std::vector<PendingMeasurementCacheEntry> misses;
+		for (auto& [font, planIndices] : planIndicesByFont) {
+			const auto fontDigest = cache.GetFontDigest(font);
+			if (!fontDigest)
+				continue;
+
+			GlyphCache::DigestBuilder builder;
+			builder.UpdateValue(GlyphCacheVersion).Update(std::string("Measure")).UpdateValue(*fontDigest);
+			for (const auto i : planIndices)
+				builder.UpdateValue(Plans[i].Character());
+			const auto key = builder.Final();
+
+			if (const auto data = cache.Find(key); data && data->size() == planIndices.size() * sizeof(CachedGlyphMeasurement)) {
+				const auto measurements = span_cast<CachedGlyphMeasurement>(*data);
+				for (size_t i = 0; i < planIndices.size(); ++i)
+					Plans[planIndices[i]].SetMeasurement(measurements[i].ToMeasurement());
+			} else
+				misses.emplace_back(PendingMeasurementCacheEntry{key, std::move(planIndices)});
+		}
+		return misses;
+	}
+
+	void StoreCachedMeasurements(GlyphCache& cache, const std::vector<PendingMeasurementCacheEntry>& entries) {
+		for (const auto& [key, planIndices] : entries) {
+			std::vector<CachedGlyphMeasurement> measurements;
+			measurements.reserve(planIndices.size());
+			for (const auto i : planIndices)
+				measurements.emplace_back(CachedGlyphMeasurement::From(Plans[i].GetMeasurement()));
+			cache.Store(key, span_cast<uint8_t>(measurements));
+		}
+	}
+
 	struct ResolvedExtremaInfo {
 		SSIZE_T globalOffsetX = 0;
 		SSIZE_T globalOffsetY = 0;
@@ -199,16 +298,44 @@ void Sqex::FontCsv::FontCsvCreator::Cancel() {
 	m_pImpl->WorkPool.Cancel();
 }
 
+// Reads the whole font file that GDI would use for logfont.
+static std::vector<uint8_t> ReadGdiFontData(const LOGFONTW& logfont) {
+	const auto hdc = Utils::Win32::CreatedDC(CreateCompatibleDC(nullptr), nullptr, "CreateCompatibleDC");
+	const auto hFont = CreateFontIndirectW(&logfont);
+	if (!hFont)
+		throw Utils::Win32::Error("CreateFontIndirectW");
+	const auto fontRelease = Utils::CallOnDestruction([hFont]() { DeleteFont(hFont); });
+	const auto hPrevFont = SelectFont(hdc, hFont);
+	const auto prevFontRevert = Utils::CallOnDestruction([&hdc, hPrevFont]() { SelectFont(hdc, hPrevFont); });
+
+	// Read from the collection header first, so that the whole file is read for fonts in a collection.
+	for (const auto table : {0x66637474UL /* ttcf */, 0UL}) {
+		const auto size = GetFontData(hdc, table, 0, nullptr, 0);
+		if (size == GDI_ERROR)
+			continue;
+
+		std::vector<uint8_t> buf(size);
+		if (GetFontData(hdc, table, 0, &buf[0], size) == size)
+			return buf;
+	}
+	throw std::runtime_error("GetFontData failed");
+}
+
 struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 	const uint16_t TextureWidth;
 	const uint16_t TextureHeight;
 	const uint16_t GlyphGap;
+	const AtlasPackingPolicy PackingPolicy;
+	const std::shared_ptr<GlyphCache> Cache;
 	uint16_t CurrentX;
 	uint16_t CurrentY;
 	uint16_t CurrentLineHeight;
 
 	std::vector<std::shared_ptr<Texture::MemoryBackedMipmap>> Mipmaps;
+	std::vector<std::unique_ptr<AtlasPacker>> Packers;
 	std::map<std::tuple<char32_t, const BaseDrawableFont<uint8_t>*, uint8_t, uint8_t, uint8_t, uint8_t>, AllocatedSpace> DrawnGlyphs;
+	std::atomic_size_t PageCount;
+	std::atomic_uint64_t UsedPixels;
 
 	struct WorkItem {
 		Texture::MemoryBackedMipmap* mipmap;
@@ -218,15 +345,76 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 		const BaseDrawableFont<uint8_t>* font;
 		uint8_t borderThickness;
 		uint8_t borderOpacity;
+		std::optional<GlyphCache::Digest> cacheKey;
+
+		void Work(GlyphCache* cache) {
+			if (cache && cacheKey) {
+				if (const auto data = cache->Find(*cacheKey); data && PasteFromCache(*data))
+					return;
+			}
 
-		void Work() {
+			GlyphMeasurement drawn;
 			if (borderThickness) {
 				for (auto i = 0; i <= 2 * borderThickness; ++i)
 					for (auto j = 0; j <= 2 * borderThickness; ++j)
-						font->Draw(mipmap, x + i, y + j, c, borderOpacity, 0, 0xFF, 0);
-				font->Draw(mipmap, x + borderThickness, y + borderThickness, c, 0xFF, 0, 0xFF, 0);
+						drawn.ExpandToFit(font->Draw(mipmap, x + i, y + j, c, borderOpacity, 0, 0xFF, 0));
+				drawn.ExpandToFit(font->Draw(mipmap, x + borderThickness, y + borderThickness, c, 0xFF, 0, 0xFF, 0));
 			} else
-				font->Draw(mipmap, x, y, c, 0xFF, 0x00);
+				drawn = font->Draw(mipmap, x, y, c, 0xFF, 0x00);
+
+			if (cache && cacheKey)
+				StoreToCache(*cache, drawn);
+		}
+
+		// Glyphs are drawn onto a blank area reserved for each, so copying what has been drawn reproduces the result.
+		void StoreToCache(GlyphCache& cache, const GlyphMeasurement& drawn) const {
+			if (drawn.EffectivelyEmpty()) {
+				constexpr CachedGlyphBitmapHeader emptyHeader{};
+				cache.Store(*cacheKey, std::span(reinterpret_cast<const uint8_t*>(&emptyHeader), sizeof emptyHeader));
+				return;
+			}
+
+			// Parts outside the texture have not been drawn, so there is nothing to copy from.
+			if (drawn.left < 0 || drawn.top < 0 || drawn.right > static_cast<SSIZE_T>(mipmap->Width) || drawn.bottom > static_cast<SSIZE_T>(mipmap->Height))
+				return;
+
+			const auto header = CachedGlyphBitmapHeader{
+				.Left = static_cast<int16_t>(drawn.left - x),
+				.Top = static_cast<int16_t>(drawn.top - y),
+				.Width = static_cast<uint16_t>(drawn.Width()),
+				.Height = static_cast<uint16_t>(drawn.Height()),
+			};
+			std::vector<uint8_t> data(sizeof header + static_cast<size_t>(header.Width) * header.Height);
+			memcpy(&data[0], &header, sizeof header);
+
+			const auto view = mipmap->View<uint8_t>();
+			for (size_t row = 0; row < header.Height; ++row) {
+				memcpy(&data[sizeof header + row * header.Width],
+					&view[(drawn.top + row) * mipmap->Width + drawn.left],
+					header.Width);
+			}
+			cache.Store(*cacheKey, data);
+		}
+
+		bool PasteFromCache(const std::vector<uint8_t>& data) const {
+			if (data.size() < sizeof(CachedGlyphBitmapHeader))
+				return false;
+
+			const auto& header = *reinterpret_cast<const CachedGlyphBitmapHeader*>(&data[0]);
+			if (data.size() != sizeof header + static_cast<size_t>(header.Width) * header.Height)
+				return false;
+
+			const auto left = x + header.Left, top = y + header.Top;
+			if (left < 0 || top < 0 || left + header.Width > static_cast<SSIZE_T>(mipmap->Width) || top + header.Height > static_cast<SSIZE_T>(mipmap->Height))
+				return false;
+
+			const auto view = mipmap->View<uint8_t>();
+			for (size_t row = 0; row < header.Height; ++row) {
+				memcpy(&view[(top + row) * mipmap->Width + left],
+					&data[sizeof header + row * header.Width],
+					header.Width);
+			}
+			return true;
 		}
 	};
 
@@ -237,7 +425,11 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 		const auto actualGlyphGap = static_cast<uint16_t>(GlyphGap + borderThickness);
 
 		const auto [it, isNewEntry] = DrawnGlyphs.emplace(std::make_tuple(c, font, borderThickness, borderOpacity, boundingWidth, boundingHeight), AllocatedSpace{});
-		if (isNewEntry) {
+		if (isNewEntry && PackingPolicy != AtlasPackingPolicy::RowFill) {
+			it->second = AllocateSpaceFromPacker(boundingWidth, boundingHeight, borderThickness);
+			UsedPixels += static_cast<uint64_t>(boundingWidth) * boundingHeight;
+
+		} else if (isNewEntry) {
 			auto newTargetRequired = false;
 			if (Mipmaps.empty())
 				newTargetRequired = true;
@@ -253,6 +445,7 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 
 			if (newTargetRequired) {
 				Mipmaps.emplace_back(std::make_shared<Texture::MemoryBackedMipmap>(TextureWidth, TextureHeight, 1, Texture::Format::L8));
+				PageCount = Mipmaps.size();
 				CurrentX = CurrentY = GlyphGap;
 				CurrentLineHeight = 0;
 			}
@@ -271,11 +464,44 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 
 			CurrentX += boundingWidth + GlyphGap;
 			CurrentLineHeight = std::max<uint16_t>(CurrentLineHeight, boundingHeight);
+			UsedPixels += static_cast<uint64_t>(boundingWidth) * boundingHeight;
 		}
 
 		return std::make_pair(it->second, isNewEntry);
 	}
 
+	AllocatedSpace AllocateSpaceFromPacker(uint8_t boundingWidth, uint8_t boundingHeight, uint8_t borderThickness) {
+		// Reserve the gap on the right and bottom side of each glyph, and the extra gap for borders on all sides.
+		const auto actualGlyphGap = GlyphGap + borderThickness;
+		const auto reservedWidth = static_cast<uint16_t>(borderThickness + boundingWidth + actualGlyphGap);
+		const auto reservedHeight = static_cast<uint16_t>(borderThickness + boundingHeight + actualGlyphGap + 1);  // Account for rounding errors
+
+		// First fit across pages, so that later glyphs can fill the space left in earlier pages.
+		for (size_t i = 0; i < Packers.size(); ++i) {
+			if (const auto pos = Packers[i]->Allocate(reservedWidth, reservedHeight)) {
+				return AllocatedSpace{
+					.Index = static_cast<uint16_t>(i),
+					.X = static_cast<uint16_t>(pos->X + borderThickness),
+					.Y = static_cast<uint16_t>(pos->Y + borderThickness),
+					.BoundingHeight = boundingHeight,
+				};
+			}
+		}
+
+		Mipmaps.emplace_back(std::make_shared<Texture::MemoryBackedMipmap>(TextureWidth, TextureHeight, 1, Texture::Format::L8));
+		Packers.emplace_back(AtlasPacker::New(PackingPolicy, GlyphGap, GlyphGap, TextureWidth, TextureHeight));
+		PageCount = Mipmaps.size();
+		const auto pos = Packers.back()->Allocate(reservedWidth, reservedHeight);
+		if (!pos)
+			throw std::runtime_error(std::format("Glyph of size {}x{} does not fit in a texture of size {}x{}", boundingWidth, boundingHeight, TextureWidth, TextureHeight));
+		return AllocatedSpace{
+			.Index = static_cast<uint16_t>(Mipmaps.size() - 1),
+			.X = static_cast<uint16_t>(pos->X + borderThickness),
+			.Y = static_cast<uint16_t>(pos->Y + borderThickness),
+			.BoundingHeight = boundingHeight,
+		};
+	}
+
 	template<typename TextureTypeSupportingRGBA = Texture::RGBA4444, Texture::Format TextureFormat = Texture::Format::A4R4G4B4>
 	void Finalize() {
 		auto mipmaps{std::move(Mipmaps)};
@@ -301,8 +527,8 @@ struct Sqex::FontCsv::FontCsvCreator::RenderTarget::Implementation {
 	}
 };
 
-Sqex::FontCsv::FontCsvCreator::RenderTarget::RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap)
-	: m_pImpl(std::make_unique<Implementation>(textureWidth, textureHeight, glyphGap, glyphGap, glyphGap, 0)) {
+Sqex::FontCsv::FontCsvCreator::RenderTarget::RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap, AtlasPackingPolicy packingPolicy, std::shared_ptr<GlyphCache> cache)
+	: m_pImpl(std::make_unique<Implementation>(textureWidth, textureHeight, glyphGap, packingPolicy, std::move(cache), glyphGap, glyphGap, 0)) {
 }
 
 Sqex::FontCsv::FontCsvCreator::RenderTarget::~RenderTarget() = default;
@@ -350,6 +576,20 @@ Sqex::FontCsv::FontCsvCreator::RenderTarget::AllocatedSpace Sqex::FontCsv::FontC
 	const auto [space, drawRequired] = m_pImpl->AllocateSpace(c, font, boundingWidth, boundingHeight, borderThickness, borderOpacity);
 
 	if (drawRequired) {
+		std::optional<GlyphCache::Digest> cacheKey;
+		if (m_pImpl->Cache) {
+			if (const auto fontDigest = m_pImpl->Cache->GetFontDigest(font)) {
+				cacheKey = GlyphCache::DigestBuilder()
+					.UpdateValue(GlyphCacheVersion)
+					.Update(std::string("Draw"))
+					.UpdateValue(*fontDigest)
+					.UpdateValue(c)
+					.UpdateValue(borderThickness)
+					.UpdateValue(borderOpacity)
+					.Final();
+			}
+		}
+
 		m_pImpl->WorkItems.emplace_back(Implementation::WorkItem{
 			.mipmap = m_pImpl->Mipmaps[space.Index].get(),
 			.x = space.X + drawOffsetX,
@@ -358,6 +598,7 @@ Sqex::FontCsv::FontCsvCreator::RenderTarget::AllocatedSpace Sqex::FontCsv::FontC
 			.font = font,
 			.borderThickness = borderThickness,
 			.borderOpacity = borderOpacity,
+			.cacheKey = cacheKey,
 		});
 	}
 
@@ -369,7 +610,7 @@ bool Sqex::FontCsv::FontCsvCreator::RenderTarget::WorkOnNextItem() {
 	if (index >= m_pImpl->WorkItems.size())
 		return false;
 
-	m_pImpl->WorkItems[index].Work();
+	m_pImpl->WorkItems[index].Work(m_pImpl->Cache.get());
 
 	return true;
 }
@@ -383,6 +624,8 @@ void Sqex::FontCsv::FontCsvCreator::Step0_CalcMax() {
 
 void Sqex::FontCsv::FontCsvCreator::Step1_CalcBbox() {
 	const auto borderThickness = static_cast<uint8_t>(this->BorderOpacity ? this->BorderThickness : 0);
+	const auto measurementCacheMisses = Cache ? m_pImpl->LoadCachedMeasurements(*Cache) : std::vector<Implementation::PendingMeasurementCacheEntry>();
+
 	GlyphMeasurement maxBbox;
 	uint32_t maxAscent = 0, maxLineHeight = 0;
 	{
@@ -424,6 +667,9 @@ void Sqex::FontCsv::FontCsvCreator::Step1_CalcBbox() {
 			maxLineHeight = std::max(n, maxLineHeight);
 	}
 
+	if (Cache)
+		m_pImpl->StoreCachedMeasurements(*Cache, measurementCacheMisses);
+
 	m_pImpl->Result->Ascent((AscentPixels == AutoVerticalValues ? maxAscent : AscentPixels) + borderThickness);
 	m_pImpl->Result->LineHeight((LineHeightPixels == AutoVerticalValues ? maxLineHeight : LineHeightPixels) + 2 * borderThickness);
 
@@ -444,6 +690,18 @@ uint16_t Sqex::FontCsv::FontCsvCreator::RenderTarget::TextureHeight() const {
 	return m_pImpl->TextureHeight;
 }
 
+Sqex::FontCsv::AtlasPackingPolicy Sqex::FontCsv::FontCsvCreator::RenderTarget::PackingPolicy() const {
+	return m_pImpl->PackingPolicy;
+}
+
+size_t Sqex::FontCsv::FontCsvCreator::RenderTarget::PageCount() const {
+	return m_pImpl->PageCount;
+}
+
+uint64_t Sqex::FontCsv::FontCsvCreator::RenderTarget::UsedPixels() const {
+	return m_pImpl->UsedPixels;
+}
+
 void Sqex::FontCsv::FontCsvCreator::Step2_Layout(RenderTarget& renderTarget) {
 	try {
 		const auto borderThickness = static_cast<uint8_t>(this->BorderOpacity ? this->BorderThickness : 0);
@@ -453,15 +711,27 @@ void Sqex::FontCsv::FontCsvCreator::Step2_Layout(RenderTarget& renderTarget) {
 		m_pImpl->Result->TextureHeight(renderTarget.TextureHeight());
 		m_pImpl->Result->Points(SizePoints);
 		m_pImpl->Result->ReserveStorage(m_pImpl->Plans.size(), m_pImpl->Kernings.size());
+
+		struct PendingGlyph {
+			const CharacterPlan* Plan;
+			SSIZE_T DrawOffsetY;
+			uint8_t BoundingWidth;
+			uint8_t BoundingHeight;
+			int8_t NextOffsetX;
+			int8_t CurrentOffsetY;
+		};
+		std::vector<PendingGlyph> pendingGlyphs;
+		pendingGlyphs.reserve(m_pImpl->Plans.size());
+
 		for (auto& plan : m_pImpl->Plans) {
 			if (m_pImpl->Cancelled)
 				return;
 
-			m_pImpl->Progress.Progress_Layout++;
-
 			const auto& bbox = plan.GetBbox();
-			if (bbox.empty)
+			if (bbox.empty) {
+				m_pImpl->Progress.Progress_Layout++;
 				continue;
+			}
 
 			const auto leftExtension = std::max<SSIZE_T>(bbox.left, 0);
 			const auto boundingWidth = static_cast<uint8_t>(bbox.Width() + m_pImpl->Step0Result.globalOffsetX + bbox.left + borderThickness + borderThickness);
@@ -523,12 +793,43 @@ void Sqex::FontCsv::FontCsvCreator::Step2_Layout(RenderTarget& renderTarget) {
 			currentOffsetY += static_cast<int8_t>(plan.OffsetYModifier());
 
 			boundingHeight += static_cast<SSIZE_T>(2) * borderThickness;
-			const auto space = renderTarget.QueueDraw(plan.Character(), plan.Font,
-				m_pImpl->Step0Result.globalOffsetX, drawOffsetY,
-				boundingWidth, boundingHeight, borderThickness, borderOpacity);
+			pendingGlyphs.emplace_back(PendingGlyph{
+				.Plan = &plan,
+				.DrawOffsetY = drawOffsetY,
+				.BoundingWidth = boundingWidth,
+				.BoundingHeight = boundingHeight,
+				.NextOffsetX = nextOffsetX,
+				.CurrentOffsetY = currentOffsetY,
+			});
+		}
+
+		// Packers other than row fill work best with tall glyphs placed first.
+		// Ties are broken by the code point order in plans, so that the layout stays the same across runs.
+		if (renderTarget.PackingPolicy() != AtlasPackingPolicy::RowFill) {
+			std::ranges::stable_sort(pendingGlyphs, [](const PendingGlyph& l, const PendingGlyph& r) {
+				if (l.BoundingHeight != r.BoundingHeight)
+					return l.BoundingHeight > r.BoundingHeight;
+				return l.BoundingWidth > r.BoundingWidth;
+			});
+		}
+
+		// Font entries are kept sorted by code point, so add them in that order after every glyph has been placed.
+		std::vector<std::pair<const PendingGlyph*, RenderTarget::AllocatedSpace>> placedGlyphs;
+		placedGlyphs.reserve(pendingGlyphs.size());
+		for (const auto& glyph : pendingGlyphs) {
+			if (m_pImpl->Cancelled)
+				return;
+
+			placedGlyphs.emplace_back(&glyph, renderTarget.QueueDraw(glyph.Plan->Character(), glyph.Plan->Font,
+				m_pImpl->Step0Result.globalOffsetX, glyph.DrawOffsetY,
+				glyph.BoundingWidth, glyph.BoundingHeight, borderThickness, borderOpacity));
+			m_pImpl->Progress.Progress_Layout++;
+		}
+		std::ranges::sort(placedGlyphs, [](const auto& l, const auto& r) { return *l.first->Plan < *r.first->Plan; });
 
-			boundingHeight = std::min(space.BoundingHeight, boundingHeight);
-			m_pImpl->Result->AddFontEntry(plan.Character(), space.Index, space.X, space.Y, boundingWidth, boundingHeight, nextOffsetX, currentOffsetY);
+		for (const auto& [glyph, space] : placedGlyphs) {
+			const auto boundingHeight = std::min(space.BoundingHeight, glyph->BoundingHeight);
+			m_pImpl->Result->AddFontEntry(glyph->Plan->Character(), space.Index, space.X, space.Y, glyph->BoundingWidth, boundingHeight, glyph->NextOffsetX, glyph->CurrentOffsetY);
 		}
 	} catch (const std::exception& e) {
 		OnError(e);
@@ -604,6 +905,8 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 	ResultFontSets Result;
 	std::mutex ResultMtx;
 	std::map<std::string, std::map<std::string, std::unique_ptr<FontCsvCreator>>> ResultWork;
+	std::map<std::string, std::unique_ptr<FontCsvCreator::RenderTarget>> RenderTargets;
+	std::shared_ptr<GlyphCache> Cache;
 
 	Win32::TpEnvironment WorkPool = { L"FontSetsCreator::Implementation::WorkPool" };
 	std::map<std::string, std::unique_ptr<Win32::TpEnvironment>> TextureGroupWorkPools;
@@ -650,6 +953,11 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 
 			std::shared_ptr<BaseDrawableFont<uint8_t>> newFont;
 			const auto& inputFontSource = Config.sources.at(name);
+
+			// Digest of everything that affects how glyphs look, including the font data itself.
+			std::optional<GlyphCache::DigestBuilder> digest;
+			if (Cache)
+				digest.emplace().UpdateValue(GlyphCacheVersion).Update(name);
 			if (inputFontSource.gameSource) {
 				const auto& source = *inputFontSource.gameSource;
 				std::filesystem::path indexFilePath;
@@ -687,8 +995,15 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 					}
 				}
 
-				auto font = std::make_shared<FdtDrawableFont<Texture::RGBA4444, uint8_t>>(
-					std::make_shared<ModifiableFontCsvStream>(Sqpack::EntryRawStream(reader->second->GetEntryProvider(source.fdtPath))), 0, textures->second);
+				auto fdt = std::make_shared<ModifiableFontCsvStream>(Sqpack::EntryRawStream(reader->second->GetEntryProvider(source.fdtPath)));
+				if (digest) {
+					digest->Update(nlohmann::json(source).dump());
+					digest->Update(fdt->ReadStreamIntoVector<uint8_t>(0));
+					for (const auto& texture : textures->second)
+						digest->Update(texture->ReadStreamIntoVector<uint8_t>(0));
+				}
+
+				auto font = std::make_shared<FdtDrawableFont<Texture::RGBA4444, uint8_t>>(std::move(fdt), 0, textures->second);
 				if (source.leftSideBearing)
 					font->SetLeftSideBearing(*source.leftSideBearing);
 				else
@@ -701,6 +1016,11 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 
 			} else if (inputFontSource.gdiSource) {
 				auto source{ *inputFontSource.gdiSource };
+				if (digest) {
+					digest->Update(nlohmann::json(source).dump());
+					digest->Update(ReadGdiFontData(source));
+				}
+
 				source.lfHeight *= source.oversampleScale;
 				newFont = std::make_shared<GdiDrawingFont<uint8_t>>(source);
 				newFont->Base.AdvanceWidthDelta(source.advanceWidthDelta);
@@ -744,6 +1064,11 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 				if (!dfont)
 					throw std::invalid_argument(accumulatedError);
 
+				if (digest) {
+					const auto [path, faceIndex] = dfont->GetFontFile();
+					digest->Update(nlohmann::json(source).dump()).UpdateValue(faceIndex).UpdateFile(path);
+				}
+
 				if (source.measureUsingFreeType)
 					dfont->SetMeasureWithFreeType();
 				newFont = std::move(dfont);
@@ -786,6 +1111,17 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 				if (!newFont)
 					throw std::invalid_argument(accumulatedError);
 
+				if (digest) {
+					digest->Update(nlohmann::json(source).dump());
+					if (accumulatedError.empty() && !source.fontFile.empty()) {
+						digest->UpdateValue(source.faceIndex).UpdateFile(source.fontFile);
+					} else {
+						// Resolve the same way as FreeTypeFont does.
+						const auto [path, faceIndex] = DirectWriteFont(FromUtf8(source.familyName).c_str(), static_cast<float>(source.height), static_cast<DWRITE_FONT_WEIGHT>(source.weight), source.stretch, source.style).GetFontFile();
+						digest->UpdateValue(faceIndex).UpdateFile(path);
+					}
+				}
+
 				newFont->Base.AdvanceWidthDelta(source.advanceWidthDelta* source.oversampleScale);
 				newFont->Gamma(source.gamma);
 
@@ -799,6 +1135,9 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 			void(newFont->Base.GetAllCharacters());
 			void(newFont->Base.GetKerningTable());
 
+			if (digest)
+				Cache->SetFontDigest(newFont.get(), digest->Final());
+
 			const auto lockAccess = std::lock_guard(SourceFontMapAccessMtx);
 			const auto newFontRawPtr = newFont.get();
 			SourceFonts.emplace(name, std::move(newFont));
@@ -807,16 +1146,19 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 	}
 
 	void Compile() {
-		std::map<std::string, std::unique_ptr<FontCsvCreator::RenderTarget>> renderTargets;
 		for (const auto& target : Config.targets) {
 			const auto& textureGroupFilenamePattern = target.first;
 			const auto& fonts = target.second;
-			renderTargets.emplace(textureGroupFilenamePattern, std::make_unique<FontCsvCreator::RenderTarget>(Config.textureWidth, Config.textureHeight, Config.glyphGap));
+			{
+				const auto lock = std::lock_guard(ResultMtx);
+				RenderTargets.emplace(textureGroupFilenamePattern, std::make_unique<FontCsvCreator::RenderTarget>(Config.textureWidth, Config.textureHeight, Config.glyphGap, Config.atlasPacking, Cache));
+			}
 			TextureGroupWorkPools.emplace(textureGroupFilenamePattern, std::make_unique<Win32::TpEnvironment>(L"FontCsvCreator::Implementation::TextureGroupWorkPools"));
 			Result.Result.emplace(textureGroupFilenamePattern, ResultFontSet{});
 			auto& remainingFonts = ResultWork.emplace(textureGroupFilenamePattern, std::map<std::string, std::unique_ptr<FontCsvCreator>>()).first->second;
 			for (const auto& fontName : fonts.fontTargets | std::views::keys) {
 				auto creator = std::make_unique<FontCsvCreator>();
+				creator->Cache = Cache;
 				Cleanup += creator->OnError([this](const std::exception& e) {
 					if (LastErrorMessage.empty()) {
 						if (e.what() && *e.what())
@@ -838,7 +1180,7 @@ struct Sqex::FontCsv::FontSetsCreator::Implementation {
 					return;
 
 				auto& resultSet = Result.Result.at(textureGroupFilenamePattern);
-				auto& target = *renderTargets.at(textureGroupFilenamePattern);
+				auto& target = *RenderTargets.at(textureGroupFilenamePattern);
 				auto& remainingFonts = ResultWork.at(textureGroupFilenamePattern);
 				auto& textureGroupWorkPool = *TextureGroupWorkPools.at(textureGroupFilenamePattern);
 				std::vector<std::string> sortedRemainingFontList;
@@ -1047,6 +1389,12 @@ void Sqex::FontCsv::FontSetsCreator::ProvideGameDirectory(Sqex::GameReleaseRegio
 	m_pImpl->GameRootDirectories.emplace(region, std::move(path));
 }
 
+void Sqex::FontCsv::FontSetsCreator::SetGlyphCache(std::shared_ptr<GlyphCache> cache) {
+	if (m_pImpl->WorkerThread)
+		throw std::runtime_error("Already started");
+	m_pImpl->Cache = std::move(cache);
+}
+
 void Sqex::FontCsv::FontSetsCreator::VerifyRequirements(
 	const std::function<std::filesystem::path(const CreateConfig::GameIndexFile&)>& promptGameIndexFile,
 	const std::function<bool(const CreateConfig::FontRequirement&)>& promptFontRequirement
@@ -1189,5 +1537,11 @@ Sqex::FontCsv::FontGenerateProcess Sqex::FontCsv::FontSetsCreator::GetProgress()
 			result += v2->GetProgress();
 		}
 	}
+	for (const auto& target : m_pImpl->RenderTargets | std::views::values) {
+		const auto pages = target->PageCount();
+		result.Pages += pages;
+		result.UsedPixels += target->UsedPixels();
+		result.PagePixels += static_cast<uint64_t>(pages) * target->TextureWidth() * target->TextureHeight();
+	}
 	return result;
 }
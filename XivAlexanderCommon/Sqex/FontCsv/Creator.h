@@ -5,6 +5,7 @@
 
 #include "XivAlexanderCommon/Sqex/FontCsv/CreateConfig.h"
 #include "XivAlexanderCommon/Sqex/FontCsv/BaseDrawableFont.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/GlyphCache.h"
 #include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
 #include "XivAlexanderCommon/Sqex/Texture/ModifiableTextureStream.h"
 #include "XivAlexanderCommon/Utils/ListenerManager.h"
@@ -16,14 +17,30 @@ namespace Sqex::FontCsv {
 		bool Finished = false;
 		int Indeterminate = 1;
 
+		// Number of glyph pages allocated so far. Every four pages are packed into a texture, one per channel.
+		size_t Pages = 0;
+
+		// Pixels covered by glyphs, and pixels of all allocated pages.
+		uint64_t UsedPixels = 0;
+		uint64_t PagePixels = 0;
+
 		FontGenerateProcess& operator+=(const FontGenerateProcess& p) {
 			Finished &= p.Finished;
 			Indeterminate += p.Indeterminate;
 			Max += p.Max;
 			Progress += p.Progress;
+			Pages += p.Pages;
+			UsedPixels += p.UsedPixels;
+			PagePixels += p.PagePixels;
 			return *this;
 		}
 
+		[[nodiscard]] double FillRatio() const {
+			if (PagePixels == 0)
+				return 0;
+			return static_cast<double>(UsedPixels) / static_cast<double>(PagePixels);
+		}
+
 		template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
 		[[nodiscard]] T Scale(T max) const {
 			if (Max == 0)
@@ -51,6 +68,9 @@ namespace Sqex::FontCsv {
 		uint8_t BorderOpacity = 0;
 		bool CompactLayout = false;
 
+		// If set, glyph measurements are looked up from and stored into this cache.
+		std::shared_ptr<GlyphCache> Cache;
+
 		FontCsvCreator(const Win32::Semaphore& semaphore = nullptr);
 		~FontCsvCreator();
 
@@ -69,7 +89,7 @@ namespace Sqex::FontCsv {
 			const std::unique_ptr<Implementation> m_pImpl;
 
 		public:
-			RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap);
+			RenderTarget(uint16_t textureWidth, uint16_t textureHeight, uint16_t glyphGap, AtlasPackingPolicy packingPolicy = AtlasPackingPolicy::RowFill, std::shared_ptr<GlyphCache> cache = nullptr);
 			~RenderTarget();
 
 			void Finalize(Texture::Format textureFormat = Texture::Format::A4R4G4B4);
@@ -79,6 +99,11 @@ namespace Sqex::FontCsv {
 
 			[[nodiscard]] uint16_t TextureWidth() const;
 			[[nodiscard]] uint16_t TextureHeight() const;
+			[[nodiscard]] AtlasPackingPolicy PackingPolicy() const;
+
+			// Can be called while glyphs are being laid out from another thread.
+			[[nodiscard]] size_t PageCount() const;
+			[[nodiscard]] uint64_t UsedPixels() const;
 
 		protected:
 			struct AllocatedSpace {
@@ -122,6 +147,9 @@ namespace Sqex::FontCsv {
 		};
 		
 		void ProvideGameDirectory(Sqex::GameReleaseRegion, std::filesystem::path);
+
+		// Reuse glyphs rasterized by previous runs. Must be called before Start.
+		void SetGlyphCache(std::shared_ptr<GlyphCache> cache);
 		void VerifyRequirements(
 			const std::function<std::filesystem::path(const CreateConfig::GameIndexFile&)>& promptGameIndexFile,
 			const std::function<bool(const CreateConfig::FontRequirement&)>& promptFontRequirement
@@ -0,0 +1,231 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/FontCsv/GlyphCache.h"
+
+#include <charconv>
+
+#include "XivAlexanderCommon/Utils/Win32/Handle.h"
+
+struct Sqex::FontCsv::GlyphCache::DigestBuilder::Implementation {
+	CryptoPP::SHA256 Hash;
+};
+
+Sqex::FontCsv::GlyphCache::DigestBuilder::DigestBuilder()
+	: m_pImpl(std::make_unique<Implementation>()) {
+	static_assert(CryptoPP::SHA256::DIGESTSIZE == std::tuple_size_v<Digest>);
+}
+
+Sqex::FontCsv::GlyphCache::DigestBuilder::~DigestBuilder() = default;
+
+Sqex::FontCsv::GlyphCache::DigestBuilder& Sqex::FontCsv::GlyphCache::DigestBuilder::Update(std::span<const uint8_t> data) {
+	m_pImpl->Hash.Update(data.data(), data.size());
+	return *this;
+}
+
+Sqex::FontCsv::GlyphCache::DigestBuilder& Sqex::FontCsv::GlyphCache::DigestBuilder::Update(const std::string& s) {
+	// Prefix with the length, so that consecutive strings cannot be confused with each other.
+	UpdateValue(static_cast<uint64_t>(s.size()));
+	return Update(std::span(reinterpret_cast<const uint8_t*>(s.data()), s.size()));
+}
+
+Sqex::FontCsv::GlyphCache::DigestBuilder& Sqex::FontCsv::GlyphCache::DigestBuilder::UpdateFile(const std::filesystem::path& path) {
+	const auto file = Utils::Win32::Handle::FromCreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0);
+	const auto size = file.GetFileSize();
+	UpdateValue(size);
+
+	std::vector<uint8_t> buf(static_cast<size_t>(std::min<uint64_t>(size, 1048576)));
+	for (uint64_t offset = 0; offset < size; ) {
+		const auto read = file.Read(offset, std::span(buf).subspan(0, static_cast<size_t>(std::min<uint64_t>(buf.size(), size - offset))));
+		Update(std::span(buf).subspan(0, read));
+		offset += read;
+	}
+	return *this;
+}
+
+Sqex::FontCsv::GlyphCache::Digest Sqex::FontCsv::GlyphCache::DigestBuilder::Final() {
+	Digest res;
+	m_pImpl->Hash.Final(&res[0]);
+	return res;
+}
+
+static std::string DigestToString(const Sqex::FontCsv::GlyphCache::Digest& digest) {
+	std::string res;
+	res.reserve(digest.size() * 2);
+	for (const auto b : digest)
+		res += std::format("{:02x}", b);
+	return res;
+}
+
+static std::optional<Sqex::FontCsv::GlyphCache::Digest> DigestFromString(const std::string& s) {
+	Sqex::FontCsv::GlyphCache::Digest res;
+	if (s.size() != res.size() * 2)
+		return std::nullopt;
+
+	for (size_t i = 0; i < res.size(); ++i) {
+		const auto [ptr, ec] = std::from_chars(&s[i * 2], &s[i * 2 + 2], res[i], 16);
+		if (ec != std::errc() || ptr != &s[i * 2 + 2])
+			return std::nullopt;
+	}
+	return res;
+}
+
+Sqex::FontCsv::GlyphCache::GlyphCache(std::filesystem::path directory, uint64_t maxBytes)
+	: m_directory(std::move(directory))
+	, m_maxBytes(maxBytes) {
+	create_directories(m_directory);
+
+	std::vector<std::tuple<std::filesystem::file_time_type, Digest, uint64_t>> found;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(m_directory, std::filesystem::directory_options::skip_permission_denied)) {
+		if (!entry.is_regular_file())
+			continue;
+
+		std::error_code ec;
+		if (entry.path().extension() == L".tmp") {
+			// Left over from a process that did not finish writing an entry.
+			std::filesystem::remove(entry.path(), ec);
+			continue;
+		}
+
+		const auto digest = DigestFromString(entry.path().filename().string());
+		if (!digest)
+			continue;
+
+		const auto writeTime = entry.last_write_time(ec);
+		if (ec)
+			continue;
+		found.emplace_back(writeTime, *digest, entry.file_size(ec));
+	}
+	std::ranges::sort(found);
+
+	for (const auto& [writeTime, digest, size] : found) {
+		m_recency.emplace_back(digest);
+		m_items.emplace(digest, Item{
+			.Size = size,
+			.Recency = std::prev(m_recency.end()),
+			.Touched = false,
+		});
+		m_totalBytes += size;
+	}
+
+	const auto lock = std::lock_guard(m_mtx);
+	Evict();
+}
+
+Sqex::FontCsv::GlyphCache::~GlyphCache() {
+	// Last access times are kept as last write times, so that the recency order survives across sessions.
+	const auto now = std::filesystem::file_time_type::clock::now();
+	size_t order = 0;
+	for (const auto& digest : m_recency) {
+		if (!m_items.at(digest).Touched)
+			continue;
+
+		std::error_code ec;
+		last_write_time(PathOf(digest), now + std::chrono::microseconds(order++), ec);
+	}
+}
+
+void Sqex::FontCsv::GlyphCache::SetFontDigest(const void* font, const Digest& digest) {
+	const auto lock = std::lock_guard(m_mtx);
+	m_fontDigests.insert_or_assign(font, digest);
+}
+
+std::optional<Sqex::FontCsv::GlyphCache::Digest> Sqex::FontCsv::GlyphCache::GetFontDigest(const void* font) const {
+	const auto lock = std::lock_guard(m_mtx);
+	if (const auto it = m_fontDigests.find(font); it != m_fontDigests.end())
+		return it->second;
+	return std::nullopt;
+}
+
+std::optional<std::vector<uint8_t>> Sqex::FontCsv::GlyphCache::Find(const Digest& key) {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		const auto it = m_items.find(key);
+		if (it == m_items.end()) {
+			++m_misses;
+			return std::nullopt;
+		}
+
+		m_recency.splice(m_recency.end(), m_recency, it->second.Recency);
+		it->second.Touched = true;
+	}
+
+	try {
+		const auto file = Utils::Win32::Handle::FromCreateFile(PathOf(key), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 0);
+		auto data = file.Read<uint8_t>(0, static_cast<size_t>(file.GetFileSize()));
+		++m_hits;
+		return data;
+	} catch (...) {
+		// Removed from outside, or evicted from another thread.
+		const auto lock = std::lock_guard(m_mtx);
+		Remove(key);
+		++m_misses;
+		return std::nullopt;
+	}
+}
+
+void Sqex::FontCsv::GlyphCache::Store(const Digest& key, std::span<const uint8_t> data) {
+	const auto path = PathOf(key);
+	auto tempPath = path;
+	tempPath.replace_extension(std::format(L".{}.tmp", GetCurrentThreadId()));
+
+	try {
+		create_directories(path.parent_path());
+		{
+			const auto file = Utils::Win32::Handle::FromCreateFile(tempPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, 0);
+			file.Write(0, data);
+		}
+		if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+			throw Utils::Win32::Error("MoveFileExW");
+	} catch (...) {
+		// Failing to write a cache entry only means that it will be rasterized again next time.
+		std::error_code ec;
+		std::filesystem::remove(tempPath, ec);
+		return;
+	}
+
+	const auto lock = std::lock_guard(m_mtx);
+	if (const auto it = m_items.find(key); it != m_items.end()) {
+		m_totalBytes -= it->second.Size;
+		it->second.Size = data.size();
+		it->second.Touched = false;
+		m_recency.splice(m_recency.end(), m_recency, it->second.Recency);
+	} else {
+		m_recency.emplace_back(key);
+		m_items.emplace(key, Item{
+			.Size = data.size(),
+			.Recency = std::prev(m_recency.end()),
+			.Touched = false,
+		});
+	}
+	m_totalBytes += data.size();
+	Evict();
+}
+
+uint64_t Sqex::FontCsv::GlyphCache::TotalBytes() const {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_totalBytes;
+}
+
+std::filesystem::path Sqex::FontCsv::GlyphCache::PathOf(const Digest& key) const {
+	const auto name = DigestToString(key);
+	return m_directory / name.substr(0, 2) / name;
+}
+
+void Sqex::FontCsv::GlyphCache::Evict() {
+	while (m_totalBytes > m_maxBytes && !m_recency.empty()) {
+		const auto key = m_recency.front();
+		Remove(key);
+
+		std::error_code ec;
+		std::filesystem::remove(PathOf(key), ec);
+	}
+}
+
+void Sqex::FontCsv::GlyphCache::Remove(const Digest& key) {
+	const auto it = m_items.find(key);
+	if (it == m_items.end())
+		return;
+
+	m_totalBytes -= it->second.Size;
+	m_recency.erase(it->second.Recency);
+	m_items.erase(it);
+}
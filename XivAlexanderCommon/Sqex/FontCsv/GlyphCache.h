@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Sqex::FontCsv {
+	/// \brief Content addressed on-disk store of rasterized glyphs and glyph metrics.
+	///
+	/// Each entry is a file named after the digest of everything that affects its content,
+	/// so that entries never have to be invalidated; entries that are no longer used are
+	/// evicted in least recently used order once the total size exceeds the limit.
+	class GlyphCache {
+	public:
+		using Digest = std::array<uint8_t, 32>;
+
+		class DigestBuilder {
+			struct Implementation;
+			const std::unique_ptr<Implementation> m_pImpl;
+
+		public:
+			DigestBuilder();
+			~DigestBuilder();
+
+			DigestBuilder& Update(std::span<const uint8_t> data);
+			DigestBuilder& Update(const std::string& s);
+			DigestBuilder& UpdateFile(const std::filesystem::path& path);
+
+			template<typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T>>>
+			DigestBuilder& UpdateValue(const T& value) {
+				return Update(std::span(reinterpret_cast<const uint8_t*>(&value), sizeof value));
+			}
+
+			template<typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T>>>
+			DigestBuilder& UpdateValues(std::span<const T> values) {
+				return Update(std::span(reinterpret_cast<const uint8_t*>(values.data()), values.size_bytes()));
+			}
+
+			[[nodiscard]] Digest Final();
+		};
+
+	private:
+		const std::filesystem::path m_directory;
+		const uint64_t m_maxBytes;
+
+		struct Item {
+			uint64_t Size;
+			std::list<Digest>::iterator Recency;
+			bool Touched;
+		};
+
+		mutable std::mutex m_mtx;
+		std::map<Digest, Item> m_items;
+		std::list<Digest> m_recency;  // Least recently used first
+		uint64_t m_totalBytes = 0;
+
+		std::map<const void*, Digest> m_fontDigests;
+
+		std::atomic_uint64_t m_hits = 0;
+		std::atomic_uint64_t m_misses = 0;
+
+	public:
+		/// \brief Opens or creates a cache at directory.
+		/// \param maxBytes Total size of entries to keep. Least recently used entries are removed when exceeded.
+		GlyphCache(std::filesystem::path directory, uint64_t maxBytes);
+		~GlyphCache();
+
+		/// \brief Associates a loaded font with the digest of its source data and rendering parameters.
+		/// Glyphs from fonts without a digest are not cached.
+		void SetFontDigest(const void* font, const Digest& digest);
+		[[nodiscard]] std::optional<Digest> GetFontDigest(const void* font) const;
+
+		[[nodiscard]] std::optional<std::vector<uint8_t>> Find(const Digest& key);
+		void Store(const Digest& key, std::span<const uint8_t> data);
+
+		/// \brief Number of lookups that found an entry, and that did not.
+		[[nodiscard]] uint64_t HitCount() const { return m_hits; }
+		[[nodiscard]] uint64_t MissCount() const { return m_misses; }
+
+		[[nodiscard]] uint64_t TotalBytes() const;
+
+	private:
+		[[nodiscard]] std::filesystem::path PathOf(const Digest& key) const;
+
+		// Following functions must be called with m_mtx held.
+		void Evict();
+		void Remove(const Digest& key);
+	};
+}
@@ -0,0 +1,345 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Network/TimingTrace.h"
+
+#include "XivAlexanderCommon/Utils/Utils.h"
+
+namespace Sqex::Network::TimingTrace {
+	static constexpr int64_t SecondToMicrosecondMultiplier = 1000000;
+
+	struct SerializedHeader {
+		char Signature[8];
+		uint32_t Version;
+		uint32_t EventSize;
+		int64_t QpcToEpochOffsetUs;
+		uint64_t OverwrittenCount;
+		uint64_t EventCount;
+	};
+
+	static std::string FormatOptional(int64_t value) {
+		return value == INT64_MAX ? std::string() : std::format("{}", value);
+	}
+}
+
+int64_t Sqex::Network::TimingTrace::Event::AppliedWaitUs() const {
+	if (Type != EventType::ActionEffect || WaitUs == INT64_MAX || PreviewMode || CastInProgress || WaitUs >= OriginalWaitUs)
+		return OriginalWaitUs;
+	return (std::max<int64_t>)(WaitUs, 0);
+}
+
+const char* Sqex::Network::TimingTrace::EventTypeName(EventType type) {
+	switch (type) {
+		case EventType::ActionRequest:
+			return "ActionRequest";
+		case EventType::ActionRequestIgnored:
+			return "ActionRequestIgnored";
+		case EventType::ActionEffect:
+			return "ActionEffect";
+		case EventType::ActionRejected:
+			return "ActionRejected";
+		case EventType::CancelCast:
+			return "CancelCast";
+		case EventType::ActorCast:
+			return "ActorCast";
+		case EventType::Cooldown:
+			return "Cooldown";
+		default:
+			return "Unset";
+	}
+}
+
+int64_t Sqex::Network::TimingTrace::CurrentQpcToEpochOffsetUs() {
+	const auto epochUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	return epochUs - Utils::QpcUs();
+}
+
+std::string Sqex::Network::TimingTrace::FormatEvent(const Event& event, int64_t qpcToEpochOffsetUs) {
+	switch (event.Type) {
+		case EventType::ActionRequest:
+			return std::format("{:x}: C2S_ActionRequest({:04x}): actionId={:04x} sequence={:04x}{}{}",
+				event.Socket,
+				event.SubType,
+				event.ActionId,
+				event.Sequence,
+				event.DelayUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" delay={}s", static_cast<double>(event.DelayUs) / SecondToMicrosecondMultiplier),
+				event.DurationUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" prevRelative={}s", static_cast<double>(event.DurationUs) / SecondToMicrosecondMultiplier));
+
+		case EventType::ActionRequestIgnored:
+			// \xe2\x94\x8e: U+250E in UTF-8
+			return std::format("\t\xe2\x94\x8e ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
+				event.ActionId, event.Sequence);
+
+		case EventType::ActionEffect: {
+			auto res = std::format("{:x}: S2C_ActionEffect({:04x}): actionId={:04x} sourceSequence={:04x}",
+				event.Socket,
+				event.SubType,
+				event.ActionId,
+				event.Sequence);
+
+			if (event.ServerOriginated)
+				res += " serverOriginated";
+
+			if (event.UsedRtt) {
+				res += std::format(" rtt={}us mode={} latency={}us{}", event.RttUs, event.Mode, event.LatencyUs, event.EstimatedLatency ? "*" : "");
+				if (event.AdjustedLatencyUs != INT64_MAX && event.AdjustedLatencyUs != event.LatencyUs)
+					res += std::format("->{}us", event.AdjustedLatencyUs);
+				res += std::format(" delay={}us", event.DelayUs);
+			}
+
+			if (event.WaitUs == event.OriginalWaitUs || event.CastInProgress)
+				res += std::format(" wait={}us", event.OriginalWaitUs);
+			else if (event.WaitClamped)
+				res += std::format(" wait={}us->{}us->{}us (ping/jitter too high)", event.OriginalWaitUs, event.WaitUs, 0);
+			else if (event.WaitUs < event.OriginalWaitUs)
+				res += std::format(" wait={}us->{}us", event.OriginalWaitUs, event.WaitUs);
+
+			const auto nextEpochUs = event.TimestampUs + (std::max<int64_t>)(event.WaitUs, 0) + qpcToEpochOffsetUs;
+			res += std::format(" next={:%H:%M:%S}", std::chrono::system_clock::time_point(std::chrono::microseconds(nextEpochUs)));
+			return res;
+		}
+
+		case EventType::ActionRejected:
+			return std::format("{:x}: S2C_ActorControlSelf/ActionRejected: actionId={:04x} sourceSequence={:04x}",
+				event.Socket,
+				event.ActionId,
+				event.Sequence);
+
+		case EventType::CancelCast:
+			return std::format("{:x}: S2C_ActorControl/CancelCast: actionId={:04x}",
+				event.Socket,
+				event.ActionId);
+
+		case EventType::ActorCast:
+			return std::format("{:x}: S2C_ActorCast: actionId={:04x} time={:.3f} target={:08x}",
+				event.Socket,
+				event.ActionId,
+				static_cast<double>(event.DurationUs) / SecondToMicrosecondMultiplier,
+				event.Sequence);
+
+		case EventType::Cooldown:
+			return std::format("{:x}: S2C_ActorControlSelf/Cooldown: actionId={:04x} group={:04x} duration={:.02f}s",
+				event.Socket,
+				event.ActionId,
+				event.Sequence,
+				static_cast<double>(event.DurationUs) / SecondToMicrosecondMultiplier);
+
+		default:
+			return std::format("{:x}: Unknown event type {}", event.Socket, static_cast<int>(event.Type));
+	}
+}
+
+std::string Sqex::Network::TimingTrace::Analysis::ToString() const {
+	std::string res;
+	res += std::format("Action requests: {} ({} ignored)\n", ActionRequestCount, IgnoredActionRequestCount);
+	res += std::format("Action effects: {} ({} server originated, {} adjusted, {} clamped to zero, {} using estimated latency, {} without matching request)\n",
+		ActionEffectCount, ServerOriginatedCount, AdjustedCount, WaitClampedCount, EstimatedLatencyCount, UnmatchedActionEffectCount);
+	res += std::format("Rejected: {}, Cancelled: {}\n", RejectedCount, CancelledCount);
+
+	const auto describe = [&res](const char* name, const Utils::LatencyHistogram::Snapshot& snapshot) {
+		if (!snapshot.Count()) {
+			res += std::format("{}: -\n", name);
+			return;
+		}
+		res += std::format("{}: count={} min={}us mean={}us p50={}us p90={}us p99={}us max={}us\n",
+			name, snapshot.Count(), snapshot.Min(), snapshot.Mean(),
+			snapshot.Percentile(50), snapshot.Percentile(90), snapshot.Percentile(99), snapshot.Max());
+	};
+	describe("Rtt", RttUs);
+	describe("Latency", LatencyUs);
+	describe("Server extra delay", ServerExtraDelayUs);
+	describe("Applied delay", AppliedDelayUs);
+	describe("Wait reduction", WaitReductionUs);
+	describe("Idle before request", IdleBeforeRequestUs);
+	return res;
+}
+
+std::vector<uint8_t> Sqex::Network::TimingTrace::Trace::Serialize() const {
+	SerializedHeader header{};
+	std::copy_n(Signature, sizeof Signature, header.Signature);
+	header.Version = Version;
+	header.EventSize = sizeof(Event);
+	header.QpcToEpochOffsetUs = QpcToEpochOffsetUs;
+	header.OverwrittenCount = OverwrittenCount;
+	header.EventCount = Events.size();
+
+	std::vector<uint8_t> res(sizeof header + Events.size() * sizeof(Event));
+	memcpy(&res[0], &header, sizeof header);
+	if (!Events.empty())
+		memcpy(&res[sizeof header], &Events[0], Events.size() * sizeof(Event));
+	return res;
+}
+
+Sqex::Network::TimingTrace::Trace Sqex::Network::TimingTrace::Trace::Deserialize(std::span<const uint8_t> data) {
+	SerializedHeader header;
+	if (data.size() < sizeof header)
+		throw std::runtime_error("Timing trace is too short");
+	memcpy(&header, data.data(), sizeof header);
+	if (!std::equal(std::begin(Signature), std::end(Signature), header.Signature))
+		throw std::runtime_error("Not a timing trace");
+	if (header.Version != Version)
+		throw std::runtime_error(std::format("Unsupported timing trace version {}", header.Version));
+	if (header.EventSize != sizeof(Event))
+		throw std::runtime_error(std::format("Unexpected event size {} (expected {})", header.EventSize, sizeof(Event)));
+	if ((data.size() - sizeof header) / sizeof(Event) < header.EventCount)
+		throw std::runtime_error("Timing trace is truncated");
+
+	Trace res;
+	res.QpcToEpochOffsetUs = header.QpcToEpochOffsetUs;
+	res.OverwrittenCount = header.OverwrittenCount;
+	res.Events.resize(static_cast<size_t>(header.EventCount));
+	if (!res.Events.empty())
+		memcpy(&res.Events[0], data.data() + sizeof header, res.Events.size() * sizeof(Event));
+	return res;
+}
+
+std::string Sqex::Network::TimingTrace::Trace::ToText() const {
+	std::string res;
+	if (OverwrittenCount)
+		res += std::format("({} older events have been overwritten)\n", OverwrittenCount);
+	for (const auto& event : Events) {
+		const auto st = Utils::EpochToLocalSystemTime((event.TimestampUs + QpcToEpochOffsetUs) / 1000);
+		res += std::format("{:04}-{:02}-{:02} {:02}:{:02}:{:02}.{:03}\t{}\n",
+			st.wYear, st.wMonth, st.wDay,
+			st.wHour, st.wMinute, st.wSecond,
+			st.wMilliseconds,
+			FormatEvent(event, QpcToEpochOffsetUs));
+	}
+	return res;
+}
+
+std::string Sqex::Network::TimingTrace::Trace::ToCsv() const {
+	std::string res = "timestamp_us,epoch_us,socket,type,subtype,action_id,sequence,request_us,rtt_us,latency_us,adjusted_latency_us,delay_us,original_wait_us,wait_us,applied_wait_us,duration_us,mode,server_originated,used_rtt,estimated_latency,cast_in_progress,wait_clamped,preview_mode\n";
+	for (const auto& event : Events) {
+		res += std::format("{},{},{:x},{},{:04x},{:04x},{:x},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+			event.TimestampUs, event.TimestampUs + QpcToEpochOffsetUs, event.Socket,
+			EventTypeName(event.Type), event.SubType, event.ActionId, event.Sequence,
+			FormatOptional(event.RequestUs), FormatOptional(event.RttUs),
+			FormatOptional(event.LatencyUs), FormatOptional(event.AdjustedLatencyUs),
+			FormatOptional(event.DelayUs), FormatOptional(event.OriginalWaitUs),
+			FormatOptional(event.WaitUs), FormatOptional(event.AppliedWaitUs()),
+			FormatOptional(event.DurationUs),
+			event.Mode,
+			event.ServerOriginated ? 1 : 0, event.UsedRtt ? 1 : 0, event.EstimatedLatency ? 1 : 0,
+			event.CastInProgress ? 1 : 0, event.WaitClamped ? 1 : 0, event.PreviewMode ? 1 : 0);
+	}
+	return res;
+}
+
+Sqex::Network::TimingTrace::Analysis Sqex::Network::TimingTrace::Trace::Analyze() const {
+	Analysis res;
+	Utils::LatencyHistogram rtt, latency, serverExtraDelay, appliedDelay, waitReduction, idleBeforeRequest;
+
+	// Requests seen so far, that have not been answered yet.
+	std::set<std::pair<uint64_t, uint32_t>> pendingRequests;
+
+	for (const auto& event : Events) {
+		switch (event.Type) {
+			case EventType::ActionRequest:
+				res.ActionRequestCount++;
+				pendingRequests.emplace(event.Socket, event.Sequence);
+				if (event.DelayUs >= 0 && event.DelayUs <= 10 * SecondToMicrosecondMultiplier)
+					idleBeforeRequest.Record(event.DelayUs);
+				break;
+
+			case EventType::ActionRequestIgnored:
+				res.IgnoredActionRequestCount++;
+				pendingRequests.erase({event.Socket, event.Sequence});
+				break;
+
+			case EventType::ActionEffect: {
+				res.ActionEffectCount++;
+				if (event.ServerOriginated)
+					res.ServerOriginatedCount++;
+				else if (!pendingRequests.erase({event.Socket, event.Sequence}))
+					res.UnmatchedActionEffectCount++;
+
+				if (event.UsedRtt) {
+					const auto latencyUs = event.AdjustedLatencyUs != INT64_MAX ? event.AdjustedLatencyUs : event.LatencyUs;
+					rtt.Record(event.RttUs);
+					latency.Record(latencyUs);
+					serverExtraDelay.Record(event.RttUs - latencyUs);
+					appliedDelay.Record(event.DelayUs);
+					if (event.EstimatedLatency)
+						res.EstimatedLatencyCount++;
+				}
+
+				if (event.WaitClamped)
+					res.WaitClampedCount++;
+
+				if (event.OriginalWaitUs != INT64_MAX) {
+					const auto reductionUs = event.OriginalWaitUs - event.AppliedWaitUs();
+					if (reductionUs > 0)
+						res.AdjustedCount++;
+					waitReduction.Record(reductionUs);
+				}
+				break;
+			}
+
+			case EventType::ActionRejected:
+				res.RejectedCount++;
+				pendingRequests.erase({event.Socket, event.Sequence});
+				break;
+
+			case EventType::CancelCast:
+				res.CancelledCount++;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	res.RttUs = rtt.TakeSnapshot();
+	res.LatencyUs = latency.TakeSnapshot();
+	res.ServerExtraDelayUs = serverExtraDelay.TakeSnapshot();
+	res.AppliedDelayUs = appliedDelay.TakeSnapshot();
+	res.WaitReductionUs = waitReduction.TakeSnapshot();
+	res.IdleBeforeRequestUs = idleBeforeRequest.TakeSnapshot();
+	return res;
+}
+
+Sqex::Network::TimingTrace::Recorder::Recorder(size_t capacity)
+	: m_capacity(capacity)
+	, m_slots(std::make_unique<Slot[]>(capacity)) {
+	if (!capacity)
+		throw std::invalid_argument("capacity must be a positive number");
+}
+
+Sqex::Network::TimingTrace::Recorder::~Recorder() = default;
+
+void Sqex::Network::TimingTrace::Recorder::Record(const Event& event) {
+	const auto index = m_next.fetch_add(1, std::memory_order_relaxed);
+	auto& slot = m_slots[index % m_capacity];
+
+	// Odd sequence number marks the slot as being written to.
+	slot.Sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.Data = event;
+	slot.Sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+Sqex::Network::TimingTrace::Trace Sqex::Network::TimingTrace::Recorder::TakeSnapshot() const {
+	Trace res;
+	res.QpcToEpochOffsetUs = CurrentQpcToEpochOffsetUs();
+
+	const auto end = m_next.load(std::memory_order_acquire);
+	const auto begin = end > m_capacity ? end - m_capacity : 0;
+	res.OverwrittenCount = begin;
+	res.Events.reserve(static_cast<size_t>(end - begin));
+	for (auto index = begin; index < end; ++index) {
+		const auto& slot = m_slots[index % m_capacity];
+		const auto sequence = slot.Sequence.load(std::memory_order_acquire);
+		if (sequence != index * 2 + 2) {
+			res.OverwrittenCount++;
+			continue;
+		}
+
+		const auto event = slot.Data;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.Sequence.load(std::memory_order_relaxed) != sequence) {
+			res.OverwrittenCount++;
+			continue;
+		}
+		res.Events.emplace_back(event);
+	}
+	return res;
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "XivAlexanderCommon/Utils/LatencyHistogram.h"
+
+namespace Sqex::Network::TimingTrace {
+	enum class EventType : uint8_t {
+		Unset,
+		ActionRequest,
+		ActionRequestIgnored,
+		ActionEffect,
+		ActionRejected,
+		CancelCast,
+		ActorCast,
+		Cooldown,
+	};
+
+	/// \brief A decision made while adjusting animation lock timings, stored without any formatting.
+	///
+	/// Fields that do not apply to an event type, or were not available, are left as INT64_MAX.
+	struct Event {
+		EventType Type = EventType::Unset;
+
+		// ActionEffect: HighLatencyMitigationMode + 1, if UsedRtt is set.
+		uint8_t Mode = 0;
+
+		uint16_t SubType = 0;
+
+		uint32_t ServerOriginated : 1 = 0;
+		uint32_t UsedRtt : 1 = 0;
+		uint32_t EstimatedLatency : 1 = 0;
+		uint32_t CastInProgress : 1 = 0;
+		uint32_t WaitClamped : 1 = 0;
+		uint32_t PreviewMode : 1 = 0;
+		uint32_t Reserved : 26 = 0;
+
+		uint64_t Socket = 0;
+
+		// Utils::QpcUs() at the time of the decision.
+		int64_t TimestampUs = 0;
+
+		uint32_t ActionId = 0;
+
+		// ActorCast: target actor ID; Cooldown: cooldown group ID; others: sequence number.
+		uint32_t Sequence = 0;
+
+		// ActionEffect: when the matching action request has been sent.
+		int64_t RequestUs = INT64_MAX;
+
+		// ActionEffect: time between the action request and the action effect.
+		int64_t RttUs = INT64_MAX;
+
+		// ActionEffect: network latency used for the decision.
+		int64_t LatencyUs = INT64_MAX;
+
+		// ActionEffect: network latency after being adjusted using estimated latency.
+		int64_t AdjustedLatencyUs = INT64_MAX;
+
+		// ActionEffect: artificial delay added to the animation lock.
+		// ActionRequest: time since the last animation lock ended.
+		int64_t DelayUs = INT64_MAX;
+
+		// ActionEffect: animation lock duration sent from the server.
+		int64_t OriginalWaitUs = INT64_MAX;
+
+		// ActionEffect: resolved animation lock duration, before clamping to zero.
+		int64_t WaitUs = INT64_MAX;
+
+		// ActorCast: cast time; Cooldown: cooldown duration.
+		// ActionRequest: time since the last successful action request.
+		int64_t DurationUs = INT64_MAX;
+
+		[[nodiscard]] int64_t AppliedWaitUs() const;
+	};
+	static_assert(std::is_trivially_copyable_v<Event>);
+
+	[[nodiscard]] const char* EventTypeName(EventType type);
+
+	/// \brief Offset to add to a Utils::QpcUs() value to get microseconds since epoch, as of now.
+	[[nodiscard]] int64_t CurrentQpcToEpochOffsetUs();
+
+	/// \brief Formats an event in the same format as NetworkTimingHandler logs.
+	[[nodiscard]] std::string FormatEvent(const Event& event, int64_t qpcToEpochOffsetUs);
+
+	/// \brief Extra delay statistics, computed by replaying a trace.
+	struct Analysis {
+		uint64_t ActionRequestCount = 0;
+		uint64_t IgnoredActionRequestCount = 0;
+		uint64_t ActionEffectCount = 0;
+		uint64_t ServerOriginatedCount = 0;
+		uint64_t AdjustedCount = 0;
+		uint64_t EstimatedLatencyCount = 0;
+		uint64_t WaitClampedCount = 0;
+		uint64_t RejectedCount = 0;
+		uint64_t CancelledCount = 0;
+		uint64_t UnmatchedActionEffectCount = 0;
+
+		// Time between action request and action effect.
+		Utils::LatencyHistogram::Snapshot RttUs;
+
+		// Network latency used for decisions.
+		Utils::LatencyHistogram::Snapshot LatencyUs;
+
+		// Time the server took to respond, in addition to network latency; rtt - latency.
+		Utils::LatencyHistogram::Snapshot ServerExtraDelayUs;
+
+		// Artificial delay added back to animation locks.
+		Utils::LatencyHistogram::Snapshot AppliedDelayUs;
+
+		// Animation lock time removed; original wait - applied wait.
+		Utils::LatencyHistogram::Snapshot WaitReductionUs;
+
+		// Time between an animation lock ending and the next action request.
+		Utils::LatencyHistogram::Snapshot IdleBeforeRequestUs;
+
+		[[nodiscard]] std::string ToString() const;
+	};
+
+	/// \brief Copy of recorded events, in the order they were recorded.
+	struct Trace {
+		static constexpr char Signature[8]{'X', 'A', 'T', 'I', 'M', 'T', 'R', 'C'};
+		static constexpr uint32_t Version = 1;
+
+		int64_t QpcToEpochOffsetUs = 0;
+		uint64_t OverwrittenCount = 0;
+		std::vector<Event> Events;
+
+		[[nodiscard]] std::vector<uint8_t> Serialize() const;
+		[[nodiscard]] static Trace Deserialize(std::span<const uint8_t> data);
+
+		[[nodiscard]] std::string ToText() const;
+		[[nodiscard]] std::string ToCsv() const;
+		[[nodiscard]] Analysis Analyze() const;
+	};
+
+	/// \brief Fixed-size ring of events; once full, the oldest events are overwritten.
+	///
+	/// Recording copies the event into a slot guarded by a sequence number, without locking or allocating.
+	/// Snapshots skip slots that are being written to.
+	class Recorder {
+		struct Slot {
+			std::atomic_uint64_t Sequence = 0;
+			Event Data;
+		};
+
+		const size_t m_capacity;
+		const std::unique_ptr<Slot[]> m_slots;
+		std::atomic_uint64_t m_next = 0;
+
+	public:
+		static constexpr size_t DefaultCapacity = 16384;
+
+		explicit Recorder(size_t capacity = DefaultCapacity);
+		Recorder(const Recorder&) = delete;
+		Recorder(Recorder&&) = delete;
+		Recorder& operator=(const Recorder&) = delete;
+		Recorder& operator=(Recorder&&) = delete;
+		~Recorder();
+
+		void Record(const Event& event);
+
+		[[nodiscard]] Trace TakeSnapshot() const;
+	};
+}
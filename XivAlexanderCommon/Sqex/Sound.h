@@ -1,5 +1,7 @@
 #pragma once
-#include "XivAlexanderCommon/Utils/Utils.h"
+#include <cstdint>
+
+#include "XivAlexanderCommon/Utils/Endian.h"
 
 namespace Sqex::Sound {
 	using namespace Utils;
@@ -25,7 +27,7 @@ namespace Sqex::Sound {
 		uint8_t Padding_0x014[0x1C]{};
 	};
 
-	static_assert(sizeof ScdHeader == 0x30);
+	static_assert(sizeof(ScdHeader) == 0x30);
 
 	struct Offsets {
 		LE<uint16_t> Table1And4EntryCount;
@@ -39,7 +41,7 @@ namespace Sqex::Sound {
 		LE<uint32_t> Table5Offset;
 		LE<uint32_t> Unknown_0x01C;
 	};
-	static_assert(sizeof Offsets == 0x20);
+	static_assert(sizeof(Offsets) == 0x20);
 
 	struct SoundEntryHeader {
 		enum EntryFormat : uint32_t {
@@ -60,7 +62,7 @@ namespace Sqex::Sound {
 		LE<uint16_t> Unknown_0x02E;
 	};
 
-	static_assert(sizeof SoundEntryHeader == 0x20);
+	static_assert(sizeof(SoundEntryHeader) == 0x20);
 
 	struct SoundEntryAuxChunk {
 		static const char Name_Mark[4];
@@ -94,15 +96,39 @@ namespace Sqex::Sound {
 		uint8_t Padding_0x01C[4]{};
 	};
 
+#pragma pack(push, 1)
+	// Same layout as WAVEFORMATEX of mmreg.h.
+	struct WaveFormatEx {
+		static constexpr uint16_t FormatTag_Pcm = 0x0001;
+		static constexpr uint16_t FormatTag_MsAdpcm = 0x0002;
+		static constexpr uint16_t FormatTag_IeeeFloat = 0x0003;
+		static constexpr uint16_t FormatTag_Extensible = 0xFFFE;
+
+		LE<uint16_t> wFormatTag;
+		LE<uint16_t> nChannels;
+		LE<uint32_t> nSamplesPerSec;
+		LE<uint32_t> nAvgBytesPerSec;
+		LE<uint16_t> nBlockAlign;
+		LE<uint16_t> wBitsPerSample;
+		LE<uint16_t> cbSize;
+	};
+
+	static_assert(sizeof(WaveFormatEx) == 0x12);
+
 	struct ADPCMCOEFSET {
-		short iCoef1;
-		short iCoef2;
+		LE<int16_t> iCoef1;
+		LE<int16_t> iCoef2;
 	};
 
+	static_assert(sizeof(ADPCMCOEFSET) == 0x04);
+
 	struct ADPCMWAVEFORMAT {
-		WAVEFORMATEX wfx;
-		short wSamplesPerBlock;
-		short wNumCoef;
+		WaveFormatEx wfx;
+		LE<int16_t> wSamplesPerBlock;
+		LE<int16_t> wNumCoef;
 		ADPCMCOEFSET aCoef[32];
 	};
+
+	static_assert(sizeof(ADPCMWAVEFORMAT) == 0x96);
+#pragma pack(pop)
 }
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Sound/MusicImporter.h"
 
+#include <condition_variable>
+
+#include "XivAlexanderCommon/Sqex/Sound/PcmDecoder.h"
 #include "XivAlexanderCommon/Sqex/Sound/Writer.h"
 #include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
 
@@ -208,6 +211,13 @@ static Utils::Win32::Thread StderrRelayer(Utils::Win32::Handle hStderrRead, std:
 
 struct Sqex::Sound::MusicImporter::Implementation {
 	class FloatPcmSource {
+	public:
+		virtual ~FloatPcmSource() = default;
+
+		virtual std::span<float> operator()(size_t len, bool throwOnIncompleteRead) = 0;
+	};
+
+	class FfmpegFloatPcmSource : public FloatPcmSource {
 		Utils::Win32::Process m_hReaderProcess;
 		Utils::Win32::Handle m_hStdoutReader;
 		Utils::Win32::Thread m_hStdinWriterThread;
@@ -217,7 +227,7 @@ struct Sqex::Sound::MusicImporter::Implementation {
 		size_t m_unusedBytes = 0;
 
 	public:
-		FloatPcmSource(
+		FfmpegFloatPcmSource(
 			const MusicImportSourceItem& sourceItem,
 			std::vector<std::filesystem::path> resolvedPaths,
 			std::function<std::span<uint8_t>(size_t len, bool throwOnIncompleteRead)> linearReader, const char* linearReaderType,
@@ -226,15 +236,46 @@ struct Sqex::Sound::MusicImporter::Implementation {
 			int forceSamplingRate = 0, std::string audioFilters = {}
 		);
 
-		~FloatPcmSource();
+		~FfmpegFloatPcmSource() override;
+
+		std::span<float> operator()(size_t len, bool throwOnIncompleteRead) override;
+	};
+
+	// Decodes in-process, a chunk ahead of what has been asked for, so that decoding overlaps with encoding
+	// like it does when ffmpeg runs in its own process.
+	class DecodedFloatPcmSource : public FloatPcmSource {
+		static constexpr size_t DecodeAheadBlockCount = 65536;
+
+		const std::unique_ptr<PcmDecoder> m_decoder;
+		Utils::Win32::TpEnvironment& m_pool;
+
+		std::mutex m_mtx;
+		std::condition_variable m_cv;
+		bool m_decoding = false;
+		bool m_eof = false;
+		std::vector<float> m_decoded;
+		std::exception_ptr m_error;
+
+		std::vector<float> m_buffer;
+		size_t m_bufferPtr = 0;
+
+	public:
+		DecodedFloatPcmSource(std::unique_ptr<PcmDecoder> decoder, Utils::Win32::TpEnvironment& pool);
+		~DecodedFloatPcmSource() override;
+
+		std::span<float> operator()(size_t len, bool throwOnIncompleteRead) override;
 
-		std::span<float> operator()(size_t len, bool throwOnIncompleteRead);
+	private:
+		void DecodeAhead();
 	};
 
 	static nlohmann::json RunProbe(const std::filesystem::path& path, const std::filesystem::path& ffprobePath, std::function<void(const std::string&)> stderrCallback);
 
 	static nlohmann::json RunProbe(const char* originalFormat, std::function<std::span<uint8_t>(size_t len, bool throwOnIncompleteRead)> linearReader, const std::filesystem::path& ffprobePath, std::function<void(const std::string&)> stderrCallback);
 
+	/// \returns Decoder for the stream, or nullptr if it has to be left to ffmpeg.
+	static std::unique_ptr<PcmDecoder> TryCreateDecoder(std::shared_ptr<const RandomAccessStream> stream);
+
 	MusicImporter& this_;
 
 	std::map<std::string, MusicImportSourceItem> SourceItems;
@@ -244,6 +285,9 @@ struct Sqex::Sound::MusicImporter::Implementation {
 	std::map<std::string, std::vector<std::filesystem::path>> SourcePaths;
 	std::vector<std::shared_ptr<Sqex::Sound::ScdReader>> TargetOriginals;
 
+	// Must outlive sources in SourceInfo, which decode on it.
+	Utils::Win32::TpEnvironment DecoderPool{ L"MusicImporter::Decoder" };
+
 	struct SourceSet {
 		uint32_t Rate{};
 		uint32_t Channels{};
@@ -286,10 +330,12 @@ struct Sqex::Sound::MusicImporter::Implementation {
 
 	bool ResolveSources(std::string dirName, const std::filesystem::path& dir);
 
-	void Merge(const std::function<void(const std::filesystem::path& path, std::vector<uint8_t>)>& cb);
+	std::unique_ptr<FloatPcmSource> OpenSource(const std::string& name, const std::shared_ptr<const RandomAccessStream>& originalDataStream, const char* originalEntryFormat, uint32_t targetRate, const std::string& audioFilters);
+
+	void Merge(const std::function<void(const std::filesystem::path& path, const RandomAccessStream& data)>& cb);
 };
 
-Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::FloatPcmSource(
+Sqex::Sound::MusicImporter::Implementation::FfmpegFloatPcmSource::FfmpegFloatPcmSource(
 	const MusicImportSourceItem& sourceItem,
 	std::vector<std::filesystem::path> resolvedPaths,
 	std::function<std::span<uint8_t>(size_t len, bool throwOnIncompleteRead)> linearReader, const char* linearReaderType,
@@ -367,7 +413,7 @@ Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::FloatPcmSource(
 	});
 }
 
-Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::~FloatPcmSource() {
+Sqex::Sound::MusicImporter::Implementation::FfmpegFloatPcmSource::~FfmpegFloatPcmSource() {
 	if (m_hReaderProcess)
 		m_hReaderProcess.Terminate(0);
 	if (m_hStdinWriterThread)
@@ -376,7 +422,7 @@ Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::~FloatPcmSource() {
 		m_hStderrReaderThread.Wait();
 }
 
-std::span<float> Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::operator()(size_t len, bool throwOnIncompleteRead) {
+std::span<float> Sqex::Sound::MusicImporter::Implementation::FfmpegFloatPcmSource::operator()(size_t len, bool throwOnIncompleteRead) {
 	std::move(m_buffer.end() - m_unusedBytes, m_buffer.end(), m_buffer.begin());
 	m_buffer.resize(std::max(m_unusedBytes, len * sizeof(float)));
 	try {
@@ -400,6 +446,82 @@ std::span<float> Sqex::Sound::MusicImporter::Implementation::FloatPcmSource::ope
 	return span_cast<float>(m_buffer, 0, availableSampleCount);
 }
 
+Sqex::Sound::MusicImporter::Implementation::DecodedFloatPcmSource::DecodedFloatPcmSource(std::unique_ptr<PcmDecoder> decoder, Utils::Win32::TpEnvironment& pool)
+	: m_decoder(std::move(decoder))
+	, m_pool(pool) {
+	DecodeAhead();
+}
+
+Sqex::Sound::MusicImporter::Implementation::DecodedFloatPcmSource::~DecodedFloatPcmSource() {
+	auto lock = std::unique_lock(m_mtx);
+	m_cv.wait(lock, [this]() { return !m_decoding; });
+}
+
+std::span<float> Sqex::Sound::MusicImporter::Implementation::DecodedFloatPcmSource::operator()(size_t len, bool throwOnIncompleteRead) {
+	m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<ptrdiff_t>(m_bufferPtr));
+	m_bufferPtr = 0;
+
+	while (m_buffer.size() < len) {
+		auto lock = std::unique_lock(m_mtx);
+		m_cv.wait(lock, [this]() { return !m_decoding; });
+		if (m_error)
+			std::rethrow_exception(m_error);
+		if (m_decoded.empty() && m_eof)
+			break;
+
+		m_buffer.insert(m_buffer.end(), m_decoded.begin(), m_decoded.end());
+		m_decoded.clear();
+		if (!m_eof) {
+			lock.unlock();
+			DecodeAhead();
+		}
+	}
+
+	m_bufferPtr = std::min(len, m_buffer.size());
+	if (m_bufferPtr != len && throwOnIncompleteRead)
+		throw std::runtime_error("EOF");
+	return std::span(m_buffer).subspan(0, m_bufferPtr);
+}
+
+void Sqex::Sound::MusicImporter::Implementation::DecodedFloatPcmSource::DecodeAhead() {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		m_decoding = true;
+	}
+
+	try {
+		m_pool.SubmitWork([this]() {
+			const auto channels = m_decoder->GetChannels();
+			std::vector<float> decoded;
+			auto eof = false;
+			std::exception_ptr error;
+			try {
+				while (decoded.size() < DecodeAheadBlockCount * channels) {
+					const auto read = m_decoder->Read(DecodeAheadBlockCount - decoded.size() / channels);
+					if (read.empty()) {
+						eof = true;
+						break;
+					}
+					decoded.insert(decoded.end(), read.begin(), read.end());
+				}
+			} catch (...) {
+				error = std::current_exception();
+			}
+
+			const auto lock = std::lock_guard(m_mtx);
+			m_decoded = std::move(decoded);
+			m_eof = eof || error;
+			m_error = error;
+			m_decoding = false;
+			m_cv.notify_all();
+		});
+	} catch (...) {
+		const auto lock = std::lock_guard(m_mtx);
+		m_decoding = false;
+		throw;
+	}
+}
+
 nlohmann::json Sqex::Sound::MusicImporter::Implementation::RunProbe(const std::filesystem::path& path, const std::filesystem::path& ffprobePath, std::function<void(const std::string&)> stderrCallback) {
 	auto [hStdoutRead, hStdoutWrite] = Utils::Win32::Handle::FromCreatePipe();
 	auto [hStderrRead, hStderrWrite] = Utils::Win32::Handle::FromCreatePipe();
@@ -492,6 +614,14 @@ nlohmann::json Sqex::Sound::MusicImporter::Implementation::RunProbe(const char*
 	return nlohmann::json::parse(str);
 }
 
+std::unique_ptr<Sqex::Sound::PcmDecoder> Sqex::Sound::MusicImporter::Implementation::TryCreateDecoder(std::shared_ptr<const RandomAccessStream> stream) {
+	try {
+		return PcmDecoder::CreateNew(std::move(stream));
+	} catch (const std::exception&) {
+		return nullptr;
+	}
+}
+
 void Sqex::Sound::MusicImporter::Implementation::AppendReader(std::shared_ptr<Sqex::Sound::ScdReader> reader) {
 	TargetOriginals.emplace_back(std::move(reader));
 }
@@ -522,11 +652,18 @@ bool Sqex::Sound::MusicImporter::Implementation::ResolveSources(std::string dirN
 			auto found = false;
 			if (occurrences.size() == 1) {
 				try {
-					const auto probe(RunProbe(*occurrences.begin(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
-					SourceInfo[sourceName] = {
-						.Rate = static_cast<uint32_t>(std::strtoul(probe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
-						.Channels = probe.at("channels").get<uint32_t>(),
-					};
+					if (const auto decoder = TryCreateDecoder(std::make_shared<Sqex::FileRandomAccessStream>(*occurrences.begin()))) {
+						SourceInfo[sourceName] = {
+							.Rate = decoder->GetSamplingRate(),
+							.Channels = decoder->GetChannels(),
+						};
+					} else {
+						const auto probe(RunProbe(*occurrences.begin(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
+						SourceInfo[sourceName] = {
+							.Rate = static_cast<uint32_t>(std::strtoul(probe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
+							.Channels = probe.at("channels").get<uint32_t>(),
+						};
+					}
 					SourcePaths[sourceName][i] = *occurrences.begin();
 					found = true;
 				} catch (const std::exception& e) {
@@ -548,7 +685,30 @@ bool Sqex::Sound::MusicImporter::Implementation::ResolveSources(std::string dirN
 	return allFound;
 }
 
-void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(const std::filesystem::path& path, std::vector<uint8_t>)>& cb) {
+std::unique_ptr<Sqex::Sound::MusicImporter::Implementation::FloatPcmSource> Sqex::Sound::MusicImporter::Implementation::OpenSource(
+	const std::string& name,
+	const std::shared_ptr<const RandomAccessStream>& originalDataStream, const char* originalEntryFormat,
+	uint32_t targetRate, const std::string& audioFilters
+) {
+	const auto& sourceItem = SourceItems.at(name);
+	const auto& resolvedPaths = SourcePaths.at(name);
+
+	// Filters, and mixing multiple input files together, are left to ffmpeg.
+	if (sourceItem.filterComplex.empty() && audioFilters.empty() && sourceItem.inputFiles.size() == 1) {
+		auto decoder = TryCreateDecoder(sourceItem.inputFiles[0].empty()
+			? originalDataStream
+			: std::make_shared<Sqex::FileRandomAccessStream>(resolvedPaths[0]));
+		if (decoder) {
+			if (decoder->GetSamplingRate() != targetRate)
+				decoder = std::make_unique<ResampledPcmDecoder>(std::move(decoder), targetRate);
+			return std::make_unique<DecodedFloatPcmSource>(std::move(decoder), DecoderPool);
+		}
+	}
+
+	return std::make_unique<FfmpegFloatPcmSource>(sourceItem, resolvedPaths, originalDataStream->AsLinearReader<uint8_t>(), originalEntryFormat, FFmpeg, [this](const std::string& msg) { this_.OnWarningLog(msg); }, targetRate, audioFilters);
+}
+
+void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(const std::filesystem::path& path, const RandomAccessStream& data)>& cb) {
 	std::string lastStepDescription;
 
 	try {
@@ -571,25 +731,36 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 				originalEntryFormat = "ogg";
 				break;
 		}
-		const auto originalDataStream = Sqex::MemoryRandomAccessStream(originalData);
+		const auto originalDataStream = std::make_shared<Sqex::MemoryRandomAccessStream>(std::move(originalData));
 
 		lastStepDescription = "ProbeOriginal";
 		uint32_t loopStartBlockIndex = 0;
 		uint32_t loopEndBlockIndex = 0;
 		{
-			const auto originalProbe(RunProbe(originalEntryFormat, originalDataStream.AsLinearReader<uint8_t>(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
-			originalInfo = {
-				.Rate = static_cast<uint32_t>(std::strtoul(originalProbe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
-				.Channels = originalProbe.at("channels").get<uint32_t>(),
-			};
-			if (const auto it = originalProbe.find("tags"); it != originalProbe.end()) {
-				for (const auto& item : it->get<nlohmann::json::object_t>()) {
-					if (_strnicmp(item.first.c_str(), "LoopStart", 9) == 0)
-						loopStartBlockIndex = std::strtoul(item.second.get<std::string>().c_str(), nullptr, 10);
-					else if (_strnicmp(item.first.c_str(), "LoopEnd", 7) == 0)
-						loopEndBlockIndex = std::strtoul(item.second.get<std::string>().c_str(), nullptr, 10);
+			std::vector<std::pair<std::string, std::string>> tags;
+			if (const auto decoder = TryCreateDecoder(originalDataStream)) {
+				originalInfo = {
+					.Rate = decoder->GetSamplingRate(),
+					.Channels = decoder->GetChannels(),
+				};
+				tags = decoder->GetTags();
+			} else {
+				const auto originalProbe(RunProbe(originalEntryFormat, originalDataStream->AsLinearReader<uint8_t>(), FFprobe, [this](const std::string& msg) { this_.OnWarningLog(msg); }).at("streams").at(0));
+				originalInfo = {
+					.Rate = static_cast<uint32_t>(std::strtoul(originalProbe.at("sample_rate").get<std::string>().c_str(), nullptr, 10)),
+					.Channels = originalProbe.at("channels").get<uint32_t>(),
+				};
+				if (const auto it = originalProbe.find("tags"); it != originalProbe.end()) {
+					for (const auto& item : it->get<nlohmann::json::object_t>())
+						tags.emplace_back(item.first, item.second.get<std::string>());
 				}
 			}
+			for (const auto& [key, value] : tags) {
+				if (_strnicmp(key.c_str(), "LoopStart", 9) == 0)
+					loopStartBlockIndex = std::strtoul(value.c_str(), nullptr, 10);
+				else if (_strnicmp(key.c_str(), "LoopEnd", 7) == 0)
+					loopEndBlockIndex = std::strtoul(value.c_str(), nullptr, 10);
+			}
 		}
 
 		lastStepDescription = "ResolveSampleRate";
@@ -722,7 +893,7 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 				const auto ffmpegFilter = segment.sourceFilters.contains(name) ? segment.sourceFilters.at(name) : std::string();
 				uint32_t minBlockIndex = 0;
 				double threshold = 0.1;
-				info.Reader = std::make_unique<FloatPcmSource>(SourceItems.at(name), SourcePaths.at(name), originalDataStream.AsLinearReader<uint8_t>(), originalEntryFormat, FFmpeg, [this](const std::string& msg) { this_.OnWarningLog(msg); }, targetRate, ffmpegFilter);
+				info.Reader = OpenSource(name, originalDataStream, originalEntryFormat, targetRate, ffmpegFilter);
 				if (segment.sourceOffsets.contains(name))
 					minBlockIndex = static_cast<uint32_t>(targetRate * segment.sourceOffsets.at(name));
 				else if (name == OriginalSource)
@@ -1064,6 +1235,9 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 		for (auto& info : SourceInfo | std::views::values)
 			info.Reader = nullptr;
 
+		// Every target gets the same sample data; keep one copy of it.
+		soundEntry.ShareData();
+
 		lastStepDescription = std::format("ToScd");
 		for (size_t pathIndex = 0; pathIndex < Target.path.size(); pathIndex++) {
 			const auto& path = Target.path.at(pathIndex);
@@ -1073,7 +1247,7 @@ void Sqex::Sound::MusicImporter::Implementation::Merge(const std::function<void(
 			writer.SetTable4(scdReader->ReadTable4Entries());
 			writer.SetTable2(scdReader->ReadTable2Entries());
 			writer.SetSoundEntry(0, soundEntry);
-			cb(path, writer.Export());
+			cb(path, *writer.ExportStream());
 		}
 	} catch (const std::runtime_error& e) {
 		throw std::runtime_error(std::format("Failed to encode: {} (step: {})", e.what(), lastStepDescription));
@@ -1098,6 +1272,6 @@ bool Sqex::Sound::MusicImporter::ResolveSources(std::string dirName, const std::
 	return m_pImpl->ResolveSources(std::move(dirName), dir);
 }
 
-void Sqex::Sound::MusicImporter::Merge(const std::function<void(const std::filesystem::path& path, std::vector<uint8_t>)>&cb) {
+void Sqex::Sound::MusicImporter::Merge(const std::function<void(const std::filesystem::path& path, const RandomAccessStream& data)>&cb) {
 	return m_pImpl->Merge(cb);
 }
@@ -98,7 +98,7 @@ namespace Sqex::Sound {
 
 		bool ResolveSources(std::string dirName, const std::filesystem::path& dir);
 
-		void Merge(const std::function<void(const std::filesystem::path& path, std::vector<uint8_t>)>& cb);
+		void Merge(const std::function<void(const std::filesystem::path& path, const RandomAccessStream& data)>& cb);
 
 		Utils::ListenerManager<Implementation, void, const std::string&> OnWarningLog;
 	};
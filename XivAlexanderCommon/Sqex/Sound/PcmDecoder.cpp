@@ -0,0 +1,463 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sound/PcmDecoder.h"
+
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+std::unique_ptr<Sqex::Sound::PcmDecoder> Sqex::Sound::PcmDecoder::CreateNew(std::shared_ptr<const RandomAccessStream> stream) {
+	char magic[12]{};
+	if (stream->ReadStreamPartial(0, magic, sizeof magic) == sizeof magic) {
+		if (memcmp(magic, "RIFF", 4) == 0 && memcmp(magic + 8, "WAVE", 4) == 0)
+			return std::make_unique<WavePcmDecoder>(std::move(stream));
+		if (memcmp(magic, "OggS", 4) == 0)
+			return std::make_unique<OggVorbisPcmDecoder>(std::move(stream));
+	}
+	throw std::invalid_argument("unsupported format");
+}
+
+Sqex::Sound::WavePcmDecoder::WavePcmDecoder(std::shared_ptr<const RandomAccessStream> stream)
+	: m_stream(std::move(stream)) {
+	struct CodeAndLen {
+		LE<uint32_t> Code;
+		LE<uint32_t> Len;
+	};
+
+	const auto streamSize = m_stream->StreamSize();
+	for (uint64_t pos = 12; pos + sizeof(CodeAndLen) <= streamSize;) {
+		const auto chunk = m_stream->ReadStream<CodeAndLen>(pos);
+		pos += sizeof chunk;
+
+		if (chunk.Code == 0x20746D66U) {  // "fmt "
+			m_format.resize(std::max<size_t>(sizeof(WaveFormatEx), chunk.Len));
+			m_stream->ReadStream(pos, &m_format[0], std::min<uint64_t>(chunk.Len, streamSize - pos));
+
+		} else if (chunk.Code == 0x61746164U) {  // "data"
+			m_dataOffset = pos;
+			m_dataSize = std::min<uint64_t>(chunk.Len, streamSize - pos);
+			break;
+		}
+
+		pos += chunk.Len + (chunk.Len & 1);
+	}
+	if (m_format.empty())
+		throw CorruptDataException("No fmt section found");
+	if (!m_dataOffset)
+		throw CorruptDataException("No data section found");
+
+	const auto& wfex = GetFormat();
+	m_samplingRate = wfex.nSamplesPerSec;
+	m_channels = wfex.nChannels;
+	if (!m_samplingRate || !m_channels || !wfex.nBlockAlign)
+		throw CorruptDataException("Bad wave format");
+
+	auto formatTag = wfex.wFormatTag;
+	if (formatTag == WaveFormatEx::FormatTag_Extensible) {
+		// WAVEFORMATEXTENSIBLE::SubFormat; the first two bytes are the format tag of what it is an extension of.
+		if (m_format.size() < sizeof(WaveFormatEx) + 22)
+			throw CorruptDataException("WAVEFORMATEXTENSIBLE too small");
+		formatTag = *reinterpret_cast<const LE<uint16_t>*>(&m_format[sizeof(WaveFormatEx) + 6]);
+	}
+
+	switch (formatTag) {
+		case WaveFormatEx::FormatTag_Pcm:
+			if (wfex.wBitsPerSample != 8 && wfex.wBitsPerSample != 16 && wfex.wBitsPerSample != 24 && wfex.wBitsPerSample != 32)
+				throw std::invalid_argument(std::format("{}-bit integer PCM not supported", wfex.wBitsPerSample.Value()));
+			break;
+
+		case WaveFormatEx::FormatTag_IeeeFloat:
+			if (wfex.wBitsPerSample != 32 && wfex.wBitsPerSample != 64)
+				throw std::invalid_argument(std::format("{}-bit floating point PCM not supported", wfex.wBitsPerSample.Value()));
+			break;
+
+		case WaveFormatEx::FormatTag_MsAdpcm:
+			if (wfex.wFormatTag != WaveFormatEx::FormatTag_MsAdpcm)
+				throw std::invalid_argument("MS-ADPCM in WAVEFORMATEXTENSIBLE not supported");
+			if (wfex.nBlockAlign < 7 * m_channels)
+				throw CorruptDataException("MS-ADPCM block too small");
+			break;
+
+		default:
+			throw std::invalid_argument(std::format("wave format 0x{:04x} not supported", formatTag));
+	}
+
+	if (formatTag == WaveFormatEx::FormatTag_MsAdpcm) {
+		// 7 bytes of header per channel, which yields 2 samples; every 4 bits after that is a sample.
+		const auto samplesPerBlock = (wfex.nBlockAlign - 7ULL * m_channels) * 2 / m_channels + 2;
+		const auto lastBlockSize = m_dataSize % wfex.nBlockAlign;
+		m_blockCount = m_dataSize / wfex.nBlockAlign * samplesPerBlock;
+		if (lastBlockSize >= 7ULL * m_channels)
+			m_blockCount += (lastBlockSize - 7ULL * m_channels) * 2 / m_channels + 2;
+	} else {
+		if (wfex.nBlockAlign != m_channels * wfex.wBitsPerSample / 8)
+			throw CorruptDataException("Bad block alignment");
+		m_blockCount = m_dataSize / wfex.nBlockAlign;
+	}
+}
+
+std::span<float> Sqex::Sound::WavePcmDecoder::Read(size_t blockCount) {
+	m_result.erase(m_result.begin(), m_result.begin() + static_cast<ptrdiff_t>(m_resultPtr));
+	m_resultPtr = 0;
+
+	const auto& wfex = GetFormat();
+	const auto isAdpcm = wfex.wFormatTag == WaveFormatEx::FormatTag_MsAdpcm;
+	while (m_result.size() < blockCount * m_channels && m_dataPtr < m_dataSize) {
+		const auto remainingBlocks = blockCount - m_result.size() / m_channels;
+		uint64_t readSize = isAdpcm
+			? (remainingBlocks + 1) / 2 * m_channels + 7ULL * m_channels  // lower bound of bytes required for as many samples
+			: remainingBlocks * wfex.nBlockAlign;
+		readSize = Align<uint64_t>(readSize, wfex.nBlockAlign).Alloc;
+		readSize = std::min(readSize, m_dataSize - m_dataPtr);
+
+		m_readBuffer.resize(static_cast<size_t>(readSize));
+		m_stream->ReadStream(m_dataOffset + m_dataPtr, std::span(m_readBuffer));
+		m_dataPtr += readSize;
+
+		if (isAdpcm)
+			DecodeMsAdpcm(m_readBuffer);
+		else
+			DecodePcm(m_readBuffer, wfex.wBitsPerSample, wfex.wFormatTag == WaveFormatEx::FormatTag_IeeeFloat
+				|| (wfex.wFormatTag == WaveFormatEx::FormatTag_Extensible && m_format[sizeof(WaveFormatEx) + 6] == WaveFormatEx::FormatTag_IeeeFloat));
+	}
+
+	m_resultPtr = std::min(m_result.size(), blockCount * m_channels);
+	return std::span(m_result).subspan(0, m_resultPtr);
+}
+
+void Sqex::Sound::WavePcmDecoder::DecodePcm(std::span<const uint8_t> data, uint16_t bitsPerSample, bool isFloat) {
+	const auto bytesPerSample = bitsPerSample / 8U;
+	const auto count = data.size() / bytesPerSample;
+	m_result.reserve(m_result.size() + count);
+	for (size_t i = 0; i < count; ++i) {
+		const auto p = &data[i * bytesPerSample];
+		if (isFloat && bitsPerSample == 32)
+			m_result.push_back(*reinterpret_cast<const float*>(p));
+		else if (isFloat)
+			m_result.push_back(static_cast<float>(*reinterpret_cast<const double*>(p)));
+		else if (bitsPerSample == 8)
+			m_result.push_back((static_cast<int>(p[0]) - 0x80) / 128.f);
+		else if (bitsPerSample == 16)
+			m_result.push_back(*reinterpret_cast<const int16_t*>(p) / 32768.f);
+		else if (bitsPerSample == 24)
+			m_result.push_back(static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (p[2] << 24)) / 2147483648.f);
+		else
+			m_result.push_back(static_cast<float>(*reinterpret_cast<const int32_t*>(p) / 2147483648.));
+	}
+}
+
+void Sqex::Sound::WavePcmDecoder::DecodeMsAdpcm(std::span<const uint8_t> data) {
+	static constexpr int AdaptationTable[16]{
+		230, 230, 230, 230, 307, 409, 512, 614,
+		768, 614, 512, 409, 307, 230, 230, 230,
+	};
+	static const ADPCMCOEFSET StandardCoefficients[7]{
+		{256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208}, {392, -232},
+	};
+
+	const auto& format = *reinterpret_cast<const ADPCMWAVEFORMAT*>(&m_format[0]);
+	const auto channels = static_cast<size_t>(m_channels);
+	std::span<const ADPCMCOEFSET> coefficients = StandardCoefficients;
+	if (m_format.size() >= offsetof(ADPCMWAVEFORMAT, aCoef) && format.wNumCoef > 0
+		&& m_format.size() >= offsetof(ADPCMWAVEFORMAT, aCoef) + sizeof(ADPCMCOEFSET) * format.wNumCoef)
+		coefficients = std::span(format.aCoef, format.wNumCoef);
+
+	std::vector<int> coef1(channels), coef2(channels), delta(channels), sample1(channels), sample2(channels);
+	for (size_t blockOffset = 0; blockOffset + 7 * channels <= data.size(); blockOffset += format.wfx.nBlockAlign) {
+		const auto block = data.subspan(blockOffset, std::min<size_t>(format.wfx.nBlockAlign, data.size() - blockOffset));
+		const auto readInt16 = [&block](size_t offset) { return static_cast<int>(static_cast<int16_t>(block[offset] | (block[offset + 1] << 8))); };
+
+		for (size_t c = 0; c < channels; ++c) {
+			const auto predictor = block[c];
+			if (predictor >= coefficients.size())
+				throw CorruptDataException(std::format("MS-ADPCM predictor {} out of range", predictor));
+			coef1[c] = coefficients[predictor].iCoef1;
+			coef2[c] = coefficients[predictor].iCoef2;
+			delta[c] = readInt16(channels + 2 * c);
+			sample1[c] = readInt16(3 * channels + 2 * c);
+			sample2[c] = readInt16(5 * channels + 2 * c);
+		}
+
+		// The older sample comes first.
+		for (size_t c = 0; c < channels; ++c)
+			m_result.push_back(sample2[c] / 32768.f);
+		for (size_t c = 0; c < channels; ++c)
+			m_result.push_back(sample1[c] / 32768.f);
+
+		size_t c = 0;
+		for (const auto b : block.subspan(7 * channels)) {
+			for (const auto nibble : { b >> 4, b & 0xF }) {
+				auto predicted = (sample1[c] * coef1[c] + sample2[c] * coef2[c]) / 256;
+				predicted += (nibble >= 8 ? nibble - 16 : nibble) * delta[c];
+				predicted = std::clamp(predicted, -32768, 32767);
+				sample2[c] = sample1[c];
+				sample1[c] = predicted;
+				delta[c] = std::max(16, AdaptationTable[nibble] * delta[c] / 256);
+				m_result.push_back(predicted / 32768.f);
+				c = (c + 1) % channels;
+			}
+		}
+	}
+}
+
+Sqex::Sound::OggVorbisPcmDecoder::OggVorbisPcmDecoder(std::shared_ptr<const RandomAccessStream> stream)
+	: m_stream(std::move(stream)) {
+	ogg_sync_init(&m_oy);
+	m_cleanup += Utils::CallOnDestruction([this] { ogg_sync_clear(&m_oy); });
+	vorbis_info_init(&m_vi);
+	m_cleanup += Utils::CallOnDestruction([this] { vorbis_info_clear(&m_vi); });
+	vorbis_comment_init(&m_vc);
+	m_cleanup += Utils::CallOnDestruction([this] { vorbis_comment_clear(&m_vc); });
+
+	ogg_page og{};
+	while (ogg_sync_pageout(&m_oy, &og) != 1) {
+		if (m_eof || m_streamPtr >= 65536)
+			throw std::invalid_argument("not an ogg file");
+		const auto buf = ogg_sync_buffer(&m_oy, 8192);
+		const auto read = static_cast<long>(m_stream->ReadStreamPartial(m_streamPtr, buf, 8192));
+		m_streamPtr += read;
+		ogg_sync_wrote(&m_oy, read);
+		m_eof = read == 0;
+	}
+
+	if (const auto res = ogg_stream_init(&m_os, ogg_page_serialno(&og)))
+		throw std::runtime_error(std::format("ogg_stream_init: {}", res));
+	m_cleanup += Utils::CallOnDestruction([this] { ogg_stream_clear(&m_os); });
+	ogg_stream_pagein(&m_os, &og);
+
+	for (size_t i = 0; i < 3; ++i) {
+		ogg_packet op{};
+		if (!ReadPacket(op))
+			throw CorruptDataException("Incomplete vorbis header");
+		if (const auto res = vorbis_synthesis_headerin(&m_vi, &m_vc, &op); res < 0)
+			throw std::invalid_argument(std::format("vorbis_synthesis_headerin: {}", res));
+	}
+
+	if (const auto res = vorbis_synthesis_init(&m_vd, &m_vi))
+		throw std::runtime_error(std::format("vorbis_synthesis_init: {}", res));
+	m_cleanup += Utils::CallOnDestruction([this] { vorbis_dsp_clear(&m_vd); });
+	if (const auto res = vorbis_block_init(&m_vd, &m_vb))
+		throw std::runtime_error(std::format("vorbis_block_init: {}", res));
+	m_cleanup += Utils::CallOnDestruction([this] { vorbis_block_clear(&m_vb); });
+
+	m_samplingRate = static_cast<uint32_t>(m_vi.rate);
+	m_channels = static_cast<uint32_t>(m_vi.channels);
+	m_blockCount = FindLastGranulePosition();
+	for (int i = 0; i < m_vc.comments; ++i) {
+		const auto comment = std::string_view(m_vc.user_comments[i], m_vc.comment_lengths[i]);
+		if (const auto sep = comment.find('='); sep != std::string_view::npos)
+			m_tags.emplace_back(comment.substr(0, sep), comment.substr(sep + 1));
+	}
+}
+
+std::span<float> Sqex::Sound::OggVorbisPcmDecoder::Read(size_t blockCount) {
+	m_result.clear();
+	while (m_result.size() < blockCount * m_channels) {
+		float** pcm = nullptr;
+		if (const auto available = vorbis_synthesis_pcmout(&m_vd, &pcm); available > 0) {
+			const auto count = std::min<size_t>(available, blockCount - m_result.size() / m_channels);
+			for (size_t i = 0; i < count; ++i) {
+				for (size_t c = 0; c < m_channels; ++c)
+					m_result.push_back(pcm[c][i]);
+			}
+			vorbis_synthesis_read(&m_vd, static_cast<int>(count));
+			continue;
+		}
+
+		ogg_packet op{};
+		if (!ReadPacket(op))
+			break;
+		if (vorbis_synthesis(&m_vb, &op) == 0)
+			vorbis_synthesis_blockin(&m_vd, &m_vb);
+	}
+	return m_result;
+}
+
+bool Sqex::Sound::OggVorbisPcmDecoder::ReadPacket(ogg_packet& op) {
+	while (true) {
+		if (const auto res = ogg_stream_packetout(&m_os, &op); res == 1)
+			return true;
+		else if (res < 0)
+			continue;  // hole in data; the packet after it is usable
+
+		ogg_page og{};
+		while (ogg_sync_pageout(&m_oy, &og) != 1) {
+			if (m_eof)
+				return false;
+			const auto buf = ogg_sync_buffer(&m_oy, 65536);
+			const auto read = static_cast<long>(m_stream->ReadStreamPartial(m_streamPtr, buf, 65536));
+			m_streamPtr += read;
+			ogg_sync_wrote(&m_oy, read);
+			m_eof = read == 0;
+		}
+
+		// Pages from other logical bitstreams are of no interest.
+		if (ogg_page_serialno(&og) == m_os.serialno)
+			ogg_stream_pagein(&m_os, &og);
+	}
+}
+
+uint64_t Sqex::Sound::OggVorbisPcmDecoder::FindLastGranulePosition() const {
+	// Granule position of a vorbis page is the number of sample blocks decoded by the end of the page.
+	constexpr uint64_t SearchSize = 65536 + 27 + 255;
+	const auto streamSize = m_stream->StreamSize();
+	const auto searchFrom = streamSize > SearchSize ? streamSize - SearchSize : 0;
+	const auto buf = m_stream->ReadStreamIntoVector<uint8_t>(searchFrom, static_cast<size_t>(streamSize - searchFrom));
+	for (auto i = static_cast<ptrdiff_t>(buf.size()) - 27; i >= 0; --i) {
+		if (memcmp(&buf[i], "OggS", 4) != 0 || buf[i + 4] != 0)
+			continue;
+		// Page headers are not aligned.
+		LE<int32_t> serialNumber;
+		LE<int64_t> granule;
+		memcpy(&serialNumber, &buf[i + 14], sizeof serialNumber);
+		memcpy(&granule, &buf[i + 6], sizeof granule);
+		if (serialNumber != m_os.serialno)
+			continue;
+		if (granule >= 0)
+			return static_cast<uint64_t>(granule.Value());
+	}
+	return UnknownBlockCount;
+}
+
+static double BesselI0(double x) {
+	double sum = 1, term = 1;
+	for (int k = 1; term > sum * 1e-12; ++k) {
+		term *= x * x / (4. * k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static float DotProduct(const float* a, const float* b, size_t count) {
+	float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		s0 += a[i] * b[i];
+		s1 += a[i + 1] * b[i + 1];
+		s2 += a[i + 2] * b[i + 2];
+		s3 += a[i + 3] * b[i + 3];
+	}
+	for (; i < count; ++i)
+		s0 += a[i] * b[i];
+	return (s0 + s1) + (s2 + s3);
+}
+
+Sqex::Sound::ResampledPcmDecoder::ResampledPcmDecoder(std::unique_ptr<PcmDecoder> source, uint32_t targetSamplingRate, size_t zeroCrossings)
+	: m_source(std::move(source))
+	, m_upFactor(targetSamplingRate / std::gcd(targetSamplingRate, m_source->GetSamplingRate()))
+	, m_downFactor(m_source->GetSamplingRate() / std::gcd(targetSamplingRate, m_source->GetSamplingRate()))
+	, m_halfTaps(static_cast<size_t>(std::ceil(static_cast<double>(zeroCrossings) * static_cast<double>(std::max(m_upFactor, m_downFactor)) / static_cast<double>(m_upFactor))))
+	, m_phaseCount(static_cast<size_t>(std::min<uint64_t>(m_upFactor, 1024))) {
+	// Kaiser window of beta 8.6 attenuates sidelobes by about 86dB, and needs a transition band about
+	// 5.4/zeroCrossings wide in units of the lower Nyquist frequency; place all of it below that frequency.
+	constexpr auto Beta = 8.6;
+	const auto scale = static_cast<double>(std::min(m_upFactor, m_downFactor)) / static_cast<double>(m_downFactor);
+	const auto cutoff = scale * (1. - 2.7 / static_cast<double>(zeroCrossings));
+	const auto width = static_cast<double>(m_halfTaps);
+	const auto i0Beta = BesselI0(Beta);
+
+	m_samplingRate = targetSamplingRate;
+	m_channels = m_source->GetChannels();
+	m_tags = m_source->GetTags();
+	if (const auto count = m_source->GetBlockCount(); count != UnknownBlockCount)
+		m_blockCount = (count * m_upFactor + m_downFactor - 1) / m_downFactor;
+
+	// Row p is for when the output sample lies p / m_phaseCount of the way between source samples;
+	// coefficient j is for the source sample (m_halfTaps - 1 - j) before the one preceding the output sample.
+	const auto taps = 2 * m_halfTaps;
+	m_filter.resize((m_phaseCount + 1) * taps);
+	for (size_t p = 0; p <= m_phaseCount; ++p) {
+		const auto row = std::span(m_filter).subspan(p * taps, taps);
+		double sum = 0;
+		std::vector<double> values(taps);
+		for (size_t j = 0; j < taps; ++j) {
+			const auto t = static_cast<double>(p) / static_cast<double>(m_phaseCount) + width - 1. - static_cast<double>(j);
+			const auto x = t / width;
+			if (x <= -1 || x >= 1)
+				continue;
+			const auto sinc = t == 0 ? 1. : std::sin(std::numbers::pi * cutoff * t) / (std::numbers::pi * cutoff * t);
+			values[j] = cutoff * sinc * BesselI0(Beta * std::sqrt(1 - x * x)) / i0Beta;
+			sum += values[j];
+		}
+		// Keep the gain of each phase at exactly 1 for DC.
+		for (size_t j = 0; j < taps; ++j)
+			row[j] = static_cast<float>(values[j] / sum);
+	}
+
+	// Samples before the first one are taken as silence.
+	m_input.resize(m_channels);
+	for (auto& channel : m_input)
+		channel.resize(m_halfTaps - 1);
+	m_inputFirstBlock = 1 - static_cast<int64_t>(m_halfTaps);
+}
+
+std::span<float> Sqex::Sound::ResampledPcmDecoder::Read(size_t blockCount) {
+	m_result.clear();
+	m_result.reserve(blockCount * m_channels);
+
+	const auto taps = 2 * m_halfTaps;
+	for (size_t i = 0; i < blockCount; ++i) {
+		if (m_outputIndex >= m_outputCount)
+			break;
+
+		const auto position = m_outputIndex * m_downFactor;
+		const auto base = static_cast<int64_t>(position / m_upFactor);
+		const auto phase = position % m_upFactor;
+		FillInput(base + static_cast<int64_t>(m_halfTaps));
+		if (m_outputIndex >= m_outputCount)
+			break;
+
+		const auto offset = static_cast<size_t>(base + 1 - static_cast<int64_t>(m_halfTaps) - m_inputFirstBlock);
+		if (m_phaseCount == m_upFactor) {
+			const auto row = &m_filter[static_cast<size_t>(phase) * taps];
+			for (const auto& channel : m_input)
+				m_result.push_back(DotProduct(row, &channel[offset], taps));
+		} else {
+			const auto rowPosition = static_cast<double>(phase) * static_cast<double>(m_phaseCount) / static_cast<double>(m_upFactor);
+			const auto rowIndex = static_cast<size_t>(rowPosition);
+			const auto weight = static_cast<float>(rowPosition - static_cast<double>(rowIndex));
+			const auto row1 = &m_filter[rowIndex * taps];
+			const auto row2 = row1 + taps;
+			for (const auto& channel : m_input)
+				m_result.push_back(DotProduct(row1, &channel[offset], taps) * (1 - weight) + DotProduct(row2, &channel[offset], taps) * weight);
+		}
+		++m_outputIndex;
+	}
+
+	// Drop source samples that no further output sample needs.
+	const auto nextBase = static_cast<int64_t>(m_outputIndex * m_downFactor / m_upFactor);
+	if (const auto unused = nextBase + 1 - static_cast<int64_t>(m_halfTaps) - m_inputFirstBlock; unused > 0) {
+		for (auto& channel : m_input)
+			channel.erase(channel.begin(), channel.begin() + std::min<ptrdiff_t>(unused, static_cast<ptrdiff_t>(channel.size())));
+		m_inputFirstBlock += unused;
+	}
+
+	return m_result;
+}
+
+void Sqex::Sound::ResampledPcmDecoder::FillInput(int64_t lastRequiredBlock) {
+	while (m_inputFirstBlock + static_cast<int64_t>(m_input[0].size()) <= lastRequiredBlock) {
+		if (m_sourceEof) {
+			// Samples after the last one are taken as silence.
+			for (auto& channel : m_input)
+				channel.resize(static_cast<size_t>(lastRequiredBlock + 1 - m_inputFirstBlock));
+			return;
+		}
+
+		const auto read = m_source->Read(std::max<size_t>(8192, static_cast<size_t>(lastRequiredBlock + 1 - m_inputFirstBlock) - m_input[0].size()));
+		if (read.empty()) {
+			m_sourceEof = true;
+			m_outputCount = (m_sourceBlockCount * m_upFactor + m_downFactor - 1) / m_downFactor;
+			continue;
+		}
+
+		const auto blocks = read.size() / m_channels;
+		for (size_t c = 0; c < m_channels; ++c) {
+			auto& channel = m_input[c];
+			const auto from = channel.size();
+			channel.resize(from + blocks);
+			for (size_t i = 0; i < blocks; ++i)
+				channel[from + i] = read[i * m_channels + c];
+		}
+		m_sourceBlockCount += blocks;
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vorbis/codec.h>
+
+#include "XivAlexanderCommon/Sqex/RandomAccessStream.h"
+#include "XivAlexanderCommon/Sqex/Sound.h"
+#include "XivAlexanderCommon/Utils/CallOnDestruction.h"
+
+namespace Sqex::Sound {
+	/// \brief Decodes sound data into interleaved float samples in [-1, 1], without help of external programs.
+	class PcmDecoder {
+	public:
+		static constexpr uint64_t UnknownBlockCount = UINT64_MAX;
+
+	protected:
+		uint32_t m_samplingRate{};
+		uint32_t m_channels{};
+		uint64_t m_blockCount = UnknownBlockCount;
+		std::vector<std::pair<std::string, std::string>> m_tags;
+
+	public:
+		virtual ~PcmDecoder() = default;
+
+		[[nodiscard]] uint32_t GetSamplingRate() const { return m_samplingRate; }
+		[[nodiscard]] uint32_t GetChannels() const { return m_channels; }
+
+		/// \returns Number of sample blocks in the stream, or UnknownBlockCount if it can't be told without decoding.
+		[[nodiscard]] uint64_t GetBlockCount() const { return m_blockCount; }
+
+		/// \brief Metadata stored along the samples, such as LoopStart and LoopEnd of vorbis comments.
+		[[nodiscard]] const std::vector<std::pair<std::string, std::string>>& GetTags() const { return m_tags; }
+
+		/// \brief Decodes up to blockCount sample blocks.
+		/// \returns Interleaved samples, valid until the next call; empty once the end of stream has been reached.
+		virtual std::span<float> Read(size_t blockCount) = 0;
+
+		/// \brief Opens a RIFF WAVE file or an Ogg Vorbis file.
+		/// \throws std::invalid_argument if the stream is in a format that can't be decoded in-process.
+		static std::unique_ptr<PcmDecoder> CreateNew(std::shared_ptr<const RandomAccessStream> stream);
+	};
+
+	/// \brief Decodes integer and floating point PCM, and MS-ADPCM, from a RIFF WAVE file.
+	class WavePcmDecoder : public PcmDecoder {
+		const std::shared_ptr<const RandomAccessStream> m_stream;
+		std::vector<uint8_t> m_format;
+		uint64_t m_dataOffset{};
+		uint64_t m_dataSize{};
+		uint64_t m_dataPtr{};
+
+		std::vector<uint8_t> m_readBuffer;
+		std::vector<float> m_result;
+		size_t m_resultPtr{};
+
+	public:
+		WavePcmDecoder(std::shared_ptr<const RandomAccessStream> stream);
+
+		std::span<float> Read(size_t blockCount) override;
+
+	private:
+		[[nodiscard]] const WaveFormatEx& GetFormat() const { return *reinterpret_cast<const WaveFormatEx*>(&m_format[0]); }
+
+		void DecodePcm(std::span<const uint8_t> data, uint16_t bitsPerSample, bool isFloat);
+		void DecodeMsAdpcm(std::span<const uint8_t> data);
+	};
+
+	/// \brief Decodes the first logical bitstream of an Ogg Vorbis file.
+	class OggVorbisPcmDecoder : public PcmDecoder {
+		const std::shared_ptr<const RandomAccessStream> m_stream;
+		uint64_t m_streamPtr{};
+		bool m_eof = false;
+
+		ogg_sync_state m_oy{};
+		ogg_stream_state m_os{};
+		vorbis_info m_vi{};
+		vorbis_comment m_vc{};
+		vorbis_dsp_state m_vd{};
+		vorbis_block m_vb{};
+		Utils::CallOnDestruction::Multiple m_cleanup;
+
+		std::vector<float> m_result;
+
+	public:
+		OggVorbisPcmDecoder(std::shared_ptr<const RandomAccessStream> stream);
+
+		std::span<float> Read(size_t blockCount) override;
+
+	private:
+		bool ReadPacket(ogg_packet& op);
+		[[nodiscard]] uint64_t FindLastGranulePosition() const;
+	};
+
+	/// \brief Converts samples from another decoder to a different sampling rate, using a windowed sinc filter.
+	///
+	/// Output sample block n corresponds to source position n * sourceRate / targetRate exactly; no delay is introduced,
+	/// so sample block indices such as loop points convert by the ratio of sampling rates.
+	class ResampledPcmDecoder : public PcmDecoder {
+		const std::unique_ptr<PcmDecoder> m_source;
+		const uint64_t m_upFactor;  // L
+		const uint64_t m_downFactor;  // M
+		const size_t m_halfTaps;
+		const size_t m_phaseCount;
+		std::vector<float> m_filter;  // (m_phaseCount + 1) rows of (2 * m_halfTaps) coefficients
+
+		std::vector<std::vector<float>> m_input;  // per channel; m_input[c][0] is source block m_inputFirstBlock
+		int64_t m_inputFirstBlock{};
+		uint64_t m_sourceBlockCount{};
+		bool m_sourceEof = false;
+
+		uint64_t m_outputIndex{};
+		uint64_t m_outputCount = UnknownBlockCount;
+		std::vector<float> m_result;
+
+	public:
+		/// \param zeroCrossings Number of zero crossings of the sinc on each side; higher values give sharper cutoff.
+		ResampledPcmDecoder(std::unique_ptr<PcmDecoder> source, uint32_t targetSamplingRate, size_t zeroCrossings = 64);
+
+		std::span<float> Read(size_t blockCount) override;
+
+	private:
+		void FillInput(int64_t lastRequiredBlock);
+	};
+}
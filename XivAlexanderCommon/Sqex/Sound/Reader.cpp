@@ -2,11 +2,14 @@
 
 #include "XivAlexanderCommon/Sqex/Sound/Reader.h"
 
+uint32_t Sqex::Sound::ScdReader::GetEntryEndOffset(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) {
+	return index == offsets.size() - 1 || offsets[index + 1] == 0 ? endOffset : offsets[index + 1];
+}
+
 std::vector<uint8_t> Sqex::Sound::ScdReader::ReadEntry(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const {
 	if (!offsets[index])
 		return {};
-	const auto next = index == offsets.size() - 1 || offsets[index + 1] == 0 ? endOffset : offsets[index + 1];
-	return m_stream->ReadStreamIntoVector<uint8_t>(offsets[index], next - offsets[index]);
+	return m_stream->ReadStreamIntoVector<uint8_t>(offsets[index], GetEntryEndOffset(offsets, endOffset, index) - offsets[index]);
 }
 
 std::vector<std::vector<uint8_t>> Sqex::Sound::ScdReader::ReadEntries(const std::span<const uint32_t>& offsets, uint32_t endOffset) const {
@@ -76,6 +79,7 @@ const Sqex::Sound::ADPCMWAVEFORMAT& Sqex::Sound::ScdReader::SoundEntry::GetMsAdp
 std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntry::GetMsAdpcmWavFile() const {
 	const auto& hdr = GetMsAdpcmHeader();
 	const auto headerSpan = ExtraData.subspan(0, sizeof hdr.wfx + hdr.wfx.cbSize);
+	const auto dataSize = static_cast<size_t>(Data->StreamSize());
 	std::vector<uint8_t> res;
 	const auto insert = [&res](const auto& v) {
 		res.insert(res.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof v);
@@ -83,7 +87,7 @@ std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntry::GetMsAdpcmWavFile() con
 	const auto totalLength = static_cast<uint32_t>(0
 		+ 12  // "RIFF"####"WAVE"
 		+ 8 + headerSpan.size() // "fmt "####<header>
-		+ 8 + Data.size()  // "data"####<data>
+		+ 8 + dataSize  // "data"####<data>
 		);
 	res.reserve(totalLength);
 	insert(LE(0x46464952U));  // "RIFF"
@@ -93,8 +97,9 @@ std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntry::GetMsAdpcmWavFile() con
 	insert(LE(static_cast<uint32_t>(headerSpan.size())));
 	res.insert(res.end(), headerSpan.begin(), headerSpan.end());
 	insert(LE(0x61746164U));  // "data"
-	insert(LE(static_cast<uint32_t>(Data.size())));
-	res.insert(res.end(), Data.begin(), Data.end());
+	insert(LE(static_cast<uint32_t>(dataSize)));
+	res.resize(res.size() + dataSize);
+	Data->ReadStream(0, std::span(res).subspan(res.size() - dataSize));
 	return res;
 }
 
@@ -118,10 +123,10 @@ std::span<const uint32_t> Sqex::Sound::ScdReader::SoundEntry::GetOggSeekTable()
 std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntry::GetOggFile() const {
 	const auto& tbl = GetOggSeekTableHeader();
 	const auto header = ExtraData.subspan(tbl.HeaderSize + tbl.SeekTableSize, tbl.VorbisHeaderSize);
-	std::vector<uint8_t> res;
-	res.reserve(header.size() + Data.size());
-	res.insert(res.end(), header.begin(), header.end());
-	res.insert(res.end(), Data.begin(), Data.end());
+	const auto dataSize = static_cast<size_t>(Data->StreamSize());
+	std::vector<uint8_t> res(header.size() + dataSize);
+	std::ranges::copy(header, res.begin());
+	Data->ReadStream(0, std::span(res).subspan(header.size()));
 
 	if (tbl.Version == 0x2) {
 		if (tbl.EncodeByte) {
@@ -129,8 +134,8 @@ std::vector<uint8_t> Sqex::Sound::ScdReader::SoundEntry::GetOggFile() const {
 				c ^= tbl.EncodeByte;
 		}
 	} else if (tbl.Version == 0x3) {
-		const auto byte1 = static_cast<uint8_t>(Data.size() & 0x7F);
-		const auto byte2 = static_cast<uint8_t>(Data.size() & 0x3F);
+		const auto byte1 = static_cast<uint8_t>(dataSize & 0x7F);
+		const auto byte2 = static_cast<uint8_t>(dataSize & 0x3F);
 		for (size_t i = 0; i < res.size(); i++)
 			res[i] ^= SoundEntryOggHeader::Version3XorTable[(byte2 + i) & 0xFF] ^ byte1;
 	} else {
@@ -143,16 +148,31 @@ Sqex::Sound::ScdReader::SoundEntry Sqex::Sound::ScdReader::GetSoundEntry(size_t
 	if (entryIndex >= m_soundEntryOffsets.size())
 		throw std::out_of_range("entry index >= sound entry count");
 
-	SoundEntry res{
-		.Buffer = ReadEntry(m_soundEntryOffsets, m_endOfSoundEntries, static_cast<uint32_t>(entryIndex)),
-		.Header = reinterpret_cast<SoundEntryHeader*>(&res.Buffer[0]),
-	};
+	const auto offset = m_soundEntryOffsets[entryIndex];
+	if (!offset)
+		throw CorruptDataException(std::format("sound entry #{} does not exist", entryIndex));
+	const auto size = static_cast<uint64_t>(GetEntryEndOffset(m_soundEntryOffsets, m_endOfSoundEntries, entryIndex)) - offset;
+
+	// Read everything up to where sample data begins, which usually is a few kilobytes at most.
+	SoundEntry res{ .Buffer = m_stream->ReadStreamIntoVector<uint8_t>(offset, sizeof(SoundEntryHeader)) };
+	const auto streamOffset = reinterpret_cast<const SoundEntryHeader*>(&res.Buffer[0])->StreamOffset.Value();
+	const auto streamSize = reinterpret_cast<const SoundEntryHeader*>(&res.Buffer[0])->StreamSize.Value();
+	if (sizeof(SoundEntryHeader) + static_cast<uint64_t>(streamOffset) + streamSize > size)
+		throw CorruptDataException(std::format("sound entry #{} extends past its end", entryIndex));
+	res.Buffer.resize(sizeof(SoundEntryHeader) + streamOffset);
+	m_stream->ReadStream(offset + sizeof(SoundEntryHeader), std::span(res.Buffer).subspan(sizeof(SoundEntryHeader)));
+
+	res.Header = reinterpret_cast<SoundEntryHeader*>(&res.Buffer[0]);
 	auto pos = sizeof * res.Header;
 	for (size_t i = 0; i < res.Header->AuxChunkCount; ++i) {
+		if (pos + offsetof(SoundEntryAuxChunk, Data) > res.Buffer.size())
+			throw CorruptDataException(std::format("aux chunk #{} of sound entry #{} extends past its end", i, entryIndex));
 		res.AuxChunks.emplace_back(reinterpret_cast<SoundEntryAuxChunk*>(&res.Buffer[pos]));
+		if (res.AuxChunks.back()->ChunkSize < offsetof(SoundEntryAuxChunk, Data) || pos + res.AuxChunks.back()->ChunkSize > res.Buffer.size())
+			throw CorruptDataException(std::format("aux chunk #{} of sound entry #{} extends past its end", i, entryIndex));
 		pos += res.AuxChunks.back()->ChunkSize;
 	}
-	res.ExtraData = std::span(res.Buffer).subspan(pos, res.Header->StreamOffset + sizeof * res.Header - pos);
-	res.Data = std::span(res.Buffer).subspan(sizeof * res.Header + res.Header->StreamOffset, res.Header->StreamSize);
+	res.ExtraData = std::span(res.Buffer).subspan(pos);
+	res.Data = std::make_shared<RandomAccessStreamPartialView>(m_stream, offset + res.Buffer.size(), streamSize);
 	return res;
 }
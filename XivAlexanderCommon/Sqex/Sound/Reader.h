@@ -22,6 +22,7 @@ namespace Sqex::Sound {
 		const uint32_t m_endOfTable1;
 		const uint32_t m_endOfTable4;
 
+		[[nodiscard]] static uint32_t GetEntryEndOffset(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index);
 		[[nodiscard]] std::vector<uint8_t> ReadEntry(const std::span<const uint32_t>& offsets, uint32_t endOffset, size_t index) const;
 		[[nodiscard]] std::vector<std::vector<uint8_t>> ReadEntries(const std::span<const uint32_t>& offsets, uint32_t endOffset) const;
 
@@ -30,12 +31,15 @@ namespace Sqex::Sound {
 	public:
 		ScdReader(std::shared_ptr<RandomAccessStream> stream);
 
+		/// \brief Header, aux chunks, and extra data of a sound entry, read when the entry is obtained.
+		///
+		/// Sample data is not read until asked for through Data.
 		struct SoundEntry {
 			std::vector<uint8_t> Buffer;
 			SoundEntryHeader* Header;
 			std::vector<SoundEntryAuxChunk*> AuxChunks;
 			std::span<uint8_t> ExtraData;
-			std::span<uint8_t> Data;
+			std::shared_ptr<const RandomAccessStream> Data;
 
 			[[nodiscard]] std::set<uint32_t> GetMarkedSampleBlockIndices() const;
 
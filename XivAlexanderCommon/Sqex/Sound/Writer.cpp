@@ -212,26 +212,38 @@ Sqex::Sound::ScdWriter::SoundEntry Sqex::Sound::ScdWriter::SoundEntry::EmptyEntr
 	};
 }
 
+void Sqex::Sound::ScdWriter::SoundEntry::ShareData() {
+	if (DataStream || Data.empty())
+		return;
+	DataStream = std::make_shared<MemoryRandomAccessStream>(std::move(Data));
+	Data.clear();
+}
+
+size_t Sqex::Sound::ScdWriter::SoundEntry::GetDataSize() const {
+	return DataStream ? static_cast<size_t>(DataStream->StreamSize()) : Data.size();
+}
+
 size_t Sqex::Sound::ScdWriter::SoundEntry::CalculateEntrySize() const {
 	size_t auxLength = 0;
 	for (const auto& aux : AuxChunks | std::views::values)
 		auxLength += 8 + aux.size();
 
-	return sizeof SoundEntryHeader + auxLength + ExtraData.size() + Data.size();
+	return sizeof SoundEntryHeader + auxLength + ExtraData.size() + GetDataSize();
 }
 
-void Sqex::Sound::ScdWriter::SoundEntry::ExportTo(std::vector<uint8_t>& res) const {
+void Sqex::Sound::ScdWriter::SoundEntry::ExportHeaderTo(std::vector<uint8_t>& res) const {
 	const auto insert = [&res](const auto& v) {
 		res.insert(res.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + sizeof v);
 	};
 
 	const auto entrySize = CalculateEntrySize();
+	const auto dataSize = GetDataSize();
 	auto hdr = Header;
-	hdr.StreamOffset = static_cast<uint32_t>(entrySize - Data.size() - sizeof hdr);
-	hdr.StreamSize = static_cast<uint32_t>(Data.size());
+	hdr.StreamOffset = static_cast<uint32_t>(entrySize - dataSize - sizeof hdr);
+	hdr.StreamSize = static_cast<uint32_t>(dataSize);
 	hdr.AuxChunkCount = static_cast<uint16_t>(AuxChunks.size());
 
-	res.reserve(res.size() + entrySize);
+	res.reserve(res.size() + entrySize - dataSize);
 	insert(hdr);
 	for (const auto& [name, aux] : AuxChunks) {
 		if (name.size() != 4)
@@ -241,7 +253,17 @@ void Sqex::Sound::ScdWriter::SoundEntry::ExportTo(std::vector<uint8_t>& res) con
 		res.insert(res.end(), aux.begin(), aux.end());
 	}
 	res.insert(res.end(), ExtraData.begin(), ExtraData.end());
-	res.insert(res.end(), Data.begin(), Data.end());
+}
+
+void Sqex::Sound::ScdWriter::SoundEntry::ExportTo(std::vector<uint8_t>& res) const {
+	res.reserve(res.size() + CalculateEntrySize());
+	ExportHeaderTo(res);
+	if (DataStream) {
+		const auto offset = res.size();
+		res.resize(offset + GetDataSize());
+		DataStream->ReadStream(0, std::span(res).subspan(offset));
+	} else
+		res.insert(res.end(), Data.begin(), Data.end());
 }
 
 void Sqex::Sound::ScdWriter::SetTable1(std::vector<std::vector<uint8_t>> t) {
@@ -265,10 +287,65 @@ void Sqex::Sound::ScdWriter::SetTable5(std::vector<std::vector<uint8_t>> t) {
 void Sqex::Sound::ScdWriter::SetSoundEntry(size_t index, SoundEntry entry) {
 	if (m_soundEntries.size() <= index)
 		m_soundEntries.resize(index + 1);
+	entry.ShareData();
 	m_soundEntries[index] = std::move(entry);
 }
 
+class Sqex::Sound::ScdWriter::ExportedStream : public RandomAccessStream {
+public:
+	struct Part {
+		uint64_t Offset;
+		std::shared_ptr<const RandomAccessStream> Stream;  // nullptr if the part comes from m_buffer
+		size_t BufferOffset;
+	};
+
+private:
+	const std::vector<uint8_t> m_buffer;
+	const std::vector<Part> m_parts;
+	const uint64_t m_size;
+
+public:
+	ExportedStream(std::vector<uint8_t> buffer, std::vector<Part> parts, uint64_t size)
+		: m_buffer(std::move(buffer))
+		, m_parts(std::move(parts))
+		, m_size(size) {
+	}
+
+	[[nodiscard]] uint64_t StreamSize() const override {
+		return m_size;
+	}
+
+	uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+		if (offset >= m_size)
+			return 0;
+		length = std::min(length, m_size - offset);
+
+		auto out = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(length));
+		auto it = std::ranges::upper_bound(m_parts, offset, {}, &Part::Offset) - 1;
+		for (; !out.empty(); ++it) {
+			const auto partEnd = it + 1 == m_parts.end() ? m_size : (it + 1)->Offset;
+			const auto relativeOffset = offset - it->Offset;
+			const auto available = static_cast<size_t>(std::min<uint64_t>(out.size(), partEnd - offset));
+			if (it->Stream)
+				it->Stream->ReadStream(relativeOffset, out.data(), available);
+			else
+				std::copy_n(&m_buffer[it->BufferOffset + static_cast<size_t>(relativeOffset)], available, out.begin());
+			out = out.subspan(available);
+			offset += available;
+		}
+		return length;
+	}
+
+	std::string DescribeState() const override {
+		return std::format("ScdWriter::ExportedStream({} parts, {})", m_parts.size(), m_size);
+	}
+};
+
 std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
+	return ExportStream()->ReadStreamIntoVector<uint8_t>(0);
+}
+
+std::shared_ptr<Sqex::RandomAccessStream> Sqex::Sound::ScdWriter::ExportStream() const {
 	if (m_table1.size() != m_table4.size())
 		throw std::invalid_argument("table1.size != table4.size");
 
@@ -278,20 +355,21 @@ std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
 	const auto table4OffsetsOffset = Sqex::Align<size_t>(soundEntryOffsetsOffset + sizeof uint32_t * (1 + m_soundEntries.size()), 0x10).Alloc;
 	const auto table5OffsetsOffset = Sqex::Align<size_t>(table4OffsetsOffset + sizeof uint32_t * (1 + m_table4.size()), 0x10).Alloc;
 
+	// Everything but sample data goes into res; parts tell where each piece of it, and each sample data, goes.
 	std::vector<uint8_t> res;
-	size_t requiredSize = table5OffsetsOffset + sizeof uint32_t * 4;
+	std::vector<ExportedStream::Part> parts{ { 0, nullptr, 0 } };
+	size_t requiredBufferSize = table5OffsetsOffset + sizeof uint32_t * 4 + 0x10;
 	for (const auto& item : m_table4)
-		requiredSize += item.size();
+		requiredBufferSize += item.size();
 	for (const auto& item : m_table1)
-		requiredSize += item.size();
+		requiredBufferSize += item.size();
 	for (const auto& item : m_table2)
-		requiredSize += item.size();
+		requiredBufferSize += item.size();
 	for (const auto& item : m_table5)
-		requiredSize += item.size();
+		requiredBufferSize += item.size();
 	for (const auto& item : m_soundEntries)
-		requiredSize += item.CalculateEntrySize();
-	requiredSize = Sqex::Align<size_t>(requiredSize, 0x10).Alloc;
-	res.reserve(requiredSize);
+		requiredBufferSize += item.CalculateEntrySize() - item.GetDataSize();
+	res.reserve(requiredBufferSize);
 
 	res.resize(table5OffsetsOffset + sizeof uint32_t * 4);
 
@@ -313,9 +391,30 @@ std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
 		reinterpret_cast<uint32_t*>(&res[table5OffsetsOffset])[i] = static_cast<uint32_t>(res.size());
 		res.insert(res.end(), m_table5[i].begin(), m_table5[i].end());
 	}
+
+	uint64_t fileSize = res.size();
 	for (size_t i = 0; i < m_soundEntries.size(); ++i) {
-		reinterpret_cast<uint32_t*>(&res[soundEntryOffsetsOffset])[i] = static_cast<uint32_t>(res.size());
-		m_soundEntries[i].ExportTo(res);
+		const auto& entry = m_soundEntries[i];
+		reinterpret_cast<uint32_t*>(&res[soundEntryOffsetsOffset])[i] = static_cast<uint32_t>(fileSize);
+
+		if (parts.back().Stream)
+			parts.push_back({ fileSize, nullptr, res.size() });
+		const auto headerOffset = res.size();
+		entry.ExportHeaderTo(res);
+		fileSize += res.size() - headerOffset;
+
+		if (const auto dataSize = entry.GetDataSize()) {
+			// Entries given to SetSoundEntry always have their sample data in DataStream.
+			parts.push_back({ fileSize, entry.DataStream, 0 });
+			fileSize += dataSize;
+		}
+	}
+
+	const auto requiredSize = Sqex::Align<uint64_t>(fileSize, 0x10).Alloc;
+	if (requiredSize != fileSize) {
+		if (parts.back().Stream)
+			parts.push_back({ fileSize, nullptr, res.size() });
+		res.resize(res.size() + static_cast<size_t>(requiredSize - fileSize));
 	}
 
 	*reinterpret_cast<ScdHeader*>(&res[0]) = {
@@ -344,7 +443,5 @@ std::vector<uint8_t> Sqex::Sound::ScdWriter::Export() const {
 		.Unknown_0x01C = 0,  // ?
 	};
 
-	res.resize(requiredSize);
-
-	return res;
+	return std::make_shared<ExportedStream>(std::move(res), std::move(parts), requiredSize);
 }
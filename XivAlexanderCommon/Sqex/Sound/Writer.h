@@ -14,6 +14,9 @@ namespace Sqex::Sound {
 			std::vector<uint8_t> ExtraData;
 			std::vector<uint8_t> Data;
 
+			/// \brief Sample data to use in place of Data, so that copies of this entry share it.
+			std::shared_ptr<const RandomAccessStream> DataStream;
+
 			[[nodiscard]] WAVEFORMATEX& AsWaveFormatEx() {
 				return *reinterpret_cast<WAVEFORMATEX*>(&ExtraData[0]);
 			}
@@ -35,11 +38,20 @@ namespace Sqex::Sound {
 			);
 			static SoundEntry EmptyEntry();
 
+			/// \brief Moves Data into DataStream.
+			void ShareData();
+
+			[[nodiscard]] size_t GetDataSize() const;
 			[[nodiscard]] size_t CalculateEntrySize() const;
+
+			/// \brief Appends everything but the sample data.
+			void ExportHeaderTo(std::vector<uint8_t>& res) const;
 			void ExportTo(std::vector<uint8_t>& res) const;
 		};
 
 	private:
+		class ExportedStream;
+
 		std::vector<std::vector<uint8_t>> m_table1;
 		std::vector<std::vector<uint8_t>> m_table2;
 		std::vector<SoundEntry> m_soundEntries;
@@ -54,6 +66,9 @@ namespace Sqex::Sound {
 		void SetSoundEntry(size_t index, SoundEntry entry);
 
 		[[nodiscard]] std::vector<uint8_t> Export() const;
+
+		/// \brief Lays out the file without assembling it; sample data is read from the sound entries when asked for.
+		[[nodiscard]] std::shared_ptr<RandomAccessStream> ExportStream() const;
 	};
 
 }
@@ -23,6 +23,8 @@ void Sqex::Texture::to_json(nlohmann::json& j, const Format& o) {
 			break;
 		case Format::DXT5: j = "DXT5";
 			break;
+		case Format::BC7: j = "BC7";
+			break;
 		case Format::R32F: j = "R32F";
 			break;
 		case Format::G16R16F: j = "G16R16F";
@@ -63,6 +65,8 @@ void Sqex::Texture::from_json(const nlohmann::json& j, Format& o) {
 			o = Format::DXT3;
 		else if (s == "DXT5")
 			o = Format::DXT5;
+		else if (s == "BC7")
+			o = Format::BC7;
 		else if (s == "R32F")
 			o = Format::R32F;
 		else if (s == "G16R16F")
@@ -109,6 +113,7 @@ size_t Sqex::Texture::RawDataLength(Format type, size_t width, size_t height, si
 
 		case Format::DXT3:
 		case Format::DXT5:
+		case Format::BC7:
 			return depth * std::max<size_t>(1, ((width + 3) / 4)) * std::max<size_t>(1, ((height + 3) / 4)) * 16;
 
 		case Format::D16:
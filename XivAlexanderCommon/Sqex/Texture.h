@@ -18,6 +18,7 @@ namespace Sqex::Texture {
 		DXT1 = 13344,
 		DXT3 = 13360,
 		DXT5 = 13361,
+		BC7 = 25650,
 		D16 = 16704,
 	};
 
@@ -0,0 +1,239 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Texture/Encoder.h"
+
+#include <bit>
+#include <numbers>
+
+#include "XivAlexanderCommon/Utils/DxtEncoder.h"
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
+
+static constexpr size_t MinimumPixelsPerFilterTask = 64 * 1024;
+static constexpr size_t MinimumPixelsPerEncodeTask = 16 * 1024;
+
+static std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> DownsampleBox(const Sqex::Texture::MemoryBackedMipmap& source) {
+	using namespace Sqex::Texture;
+
+	const size_t sw = source.Width, sh = source.Height;
+	const auto dw = std::max<size_t>(1, sw / 2), dh = std::max<size_t>(1, sh / 2);
+	auto res = std::make_shared<MemoryBackedMipmap>(dw, dh, 1, Format::A8R8G8B8);
+	const auto src = source.View<RGBA8888>();
+	const auto dst = res->View<RGBA8888>();
+
+	Utils::Win32::ParallelForRanges(L"Sqex::Texture::GenerateMipmaps", dh, MinimumPixelsPerFilterTask / dw, [&](size_t from, size_t to) {
+		for (auto y = from; y < to; ++y) {
+			const auto y0 = std::min(2 * y, sh - 1), y1 = std::min(2 * y + 1, sh - 1);
+			for (size_t x = 0; x < dw; ++x) {
+				const auto x0 = std::min(2 * x, sw - 1), x1 = std::min(2 * x + 1, sw - 1);
+				const auto& p00 = src[y0 * sw + x0];
+				const auto& p01 = src[y0 * sw + x1];
+				const auto& p10 = src[y1 * sw + x0];
+				const auto& p11 = src[y1 * sw + x1];
+				dst[y * dw + x].SetFrom(
+					(p00.R + p01.R + p10.R + p11.R + 2) / 4,
+					(p00.G + p01.G + p10.G + p11.G + 2) / 4,
+					(p00.B + p01.B + p10.B + p11.B + 2) / 4,
+					(p00.A + p01.A + p10.A + p11.A + 2) / 4);
+			}
+		}
+	});
+	return res;
+}
+
+// Weights for source pixels at offsets [-2, 3] from 2 * (destination pixel index).
+static const std::array<float, 6>& KaiserWeights() {
+	static const auto weights = [] {
+		static constexpr auto Alpha = 4.;
+		static constexpr auto Radius = 3.;
+
+		// Modified Bessel function of the first kind, order 0.
+		const auto besselI0 = [](double x) {
+			double sum = 1, term = 1;
+			for (int k = 1; k < 32; ++k) {
+				term *= x * x / 4 / k / k;
+				sum += term;
+			}
+			return sum;
+		};
+
+		std::array<float, 6> res{};
+		double total = 0;
+		for (int i = 0; i < 6; ++i) {
+			// Distance between centers of source pixel and destination pixel, in source pixels.
+			const auto d = i - 2.5;
+			const auto x = d / 2 * std::numbers::pi;
+			const auto sinc = std::sin(x) / x;
+			const auto window = besselI0(Alpha * std::sqrt(1 - d / Radius * (d / Radius))) / besselI0(Alpha);
+			res[i] = static_cast<float>(sinc * window);
+			total += res[i];
+		}
+		for (auto& w : res)
+			w = static_cast<float>(w / total);
+		return res;
+	}();
+	return weights;
+}
+
+static std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> DownsampleKaiser(const Sqex::Texture::MemoryBackedMipmap& source) {
+	using namespace Sqex::Texture;
+
+	const size_t sw = source.Width, sh = source.Height;
+	const auto dw = std::max<size_t>(1, sw / 2), dh = std::max<size_t>(1, sh / 2);
+	auto res = std::make_shared<MemoryBackedMipmap>(dw, dh, 1, Format::A8R8G8B8);
+	const auto src = source.View<RGBA8888>();
+	const auto dst = res->View<RGBA8888>();
+	const auto& weights = KaiserWeights();
+
+	// Dimensions of size 1 are not downsampled, and pass through the filter unchanged.
+	const auto sample = [](size_t dstIndex, size_t srcSize, size_t tap) {
+		if (srcSize == 1)
+			return size_t();
+		return static_cast<size_t>(std::clamp<ptrdiff_t>(static_cast<ptrdiff_t>(2 * dstIndex + tap) - 2, 0, static_cast<ptrdiff_t>(srcSize) - 1));
+	};
+
+	// Horizontal pass: sw x sh -> dw x sh, in floats.
+	std::vector<std::array<float, 4>> horizontal(dw * sh);
+	Utils::Win32::ParallelForRanges(L"Sqex::Texture::GenerateMipmaps", sh, MinimumPixelsPerFilterTask / sw, [&](size_t from, size_t to) {
+		for (auto y = from; y < to; ++y) {
+			for (size_t x = 0; x < dw; ++x) {
+				auto& acc = horizontal[y * dw + x];
+				acc = {};
+				for (size_t tap = 0; tap < weights.size(); ++tap) {
+					const auto& p = src[y * sw + sample(x, sw, tap)];
+					acc[0] += weights[tap] * static_cast<float>(p.R);
+					acc[1] += weights[tap] * static_cast<float>(p.G);
+					acc[2] += weights[tap] * static_cast<float>(p.B);
+					acc[3] += weights[tap] * static_cast<float>(p.A);
+				}
+			}
+		}
+	});
+
+	// Vertical pass: dw x sh -> dw x dh.
+	Utils::Win32::ParallelForRanges(L"Sqex::Texture::GenerateMipmaps", dh, MinimumPixelsPerFilterTask / dw, [&](size_t from, size_t to) {
+		for (auto y = from; y < to; ++y) {
+			for (size_t x = 0; x < dw; ++x) {
+				std::array<float, 4> acc{};
+				for (size_t tap = 0; tap < weights.size(); ++tap) {
+					const auto& p = horizontal[sample(y, sh, tap) * dw + x];
+					for (size_t c = 0; c < 4; ++c)
+						acc[c] += weights[tap] * p[c];
+				}
+				const auto toByte = [](float v) { return static_cast<uint32_t>(std::clamp(v + .5f, 0.f, 255.f)); };
+				dst[y * dw + x].SetFrom(toByte(acc[0]), toByte(acc[1]), toByte(acc[2]), toByte(acc[3]));
+			}
+		}
+	});
+	return res;
+}
+
+static void EncodeBlockRows(const Sqex::Texture::MemoryBackedMipmap& source, Sqex::Texture::Format type, Sqex::Texture::EncodePreset preset, uint8_t* blockStorage, size_t blockRowFrom, size_t blockRowTo) {
+	using namespace Sqex::Texture;
+
+	const auto quality = preset == EncodePreset::Quality ? Utils::DxtEncoderQuality::Quality : Utils::DxtEncoderQuality::Fast;
+	const auto image = &source.View<RGBA8888>()[0].Value;
+	const auto from = static_cast<uint32_t>(blockRowFrom), to = static_cast<uint32_t>(blockRowTo);
+	switch (type) {
+		case Format::DXT1:
+			return Utils::CompressBlockRowsDXT1(source.Width, source.Height, from, to, image, blockStorage, quality);
+		case Format::DXT5:
+			return Utils::CompressBlockRowsDXT5(source.Width, source.Height, from, to, image, blockStorage, quality);
+		case Format::BC7:
+			return Utils::CompressBlockRowsBC7(source.Width, source.Height, from, to, image, blockStorage, quality);
+		default:
+			throw std::invalid_argument("Unsupported type");
+	}
+}
+
+static bool IsBlockCompressed(Sqex::Texture::Format type) {
+	using namespace Sqex::Texture;
+
+	switch (type) {
+		case Format::DXT1:
+		case Format::DXT5:
+		case Format::BC7:
+			return true;
+		case Format::A8R8G8B8:
+		case Format::X8R8G8B8:
+			return false;
+		default:
+			throw std::invalid_argument("Unsupported type");
+	}
+}
+
+std::vector<std::shared_ptr<Sqex::Texture::MemoryBackedMipmap>> Sqex::Texture::GenerateMipmaps(const MipmapStream& source, size_t mipmapCount, MipmapFilter filter) {
+	if (source.Depth != 1)
+		throw std::invalid_argument("Only 2D textures are supported");
+	if (!source.Width || !source.Height)
+		throw std::invalid_argument("Texture is empty");
+
+	const auto maxMipmapCount = static_cast<size_t>(std::bit_width(static_cast<uint32_t>(std::max(source.Width, source.Height))));
+	if (!mipmapCount || mipmapCount > maxMipmapCount)
+		mipmapCount = maxMipmapCount;
+
+	std::vector<std::shared_ptr<MemoryBackedMipmap>> res;
+	res.reserve(mipmapCount);
+	res.emplace_back(MemoryBackedMipmap::NewARGB8888From(&source, Format::A8R8G8B8));
+	while (res.size() < mipmapCount) {
+		switch (filter) {
+			case MipmapFilter::Box:
+				res.emplace_back(DownsampleBox(*res.back()));
+				break;
+			case MipmapFilter::Kaiser:
+				res.emplace_back(DownsampleKaiser(*res.back()));
+				break;
+			default:
+				throw std::invalid_argument("Unsupported filter");
+		}
+	}
+	return res;
+}
+
+std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> Sqex::Texture::EncodeMipmap(const MemoryBackedMipmap& source, Format type, EncodePreset preset) {
+	if (source.Type != Format::A8R8G8B8 && source.Type != Format::X8R8G8B8)
+		throw std::invalid_argument("source must be in A8R8G8B8");
+
+	if (!IsBlockCompressed(type))
+		return std::make_shared<MemoryBackedMipmap>(source.Width, source.Height, source.Depth, type, source.ReadStreamIntoVector<uint8_t>(0));
+
+	auto res = std::make_shared<MemoryBackedMipmap>(source.Width, source.Height, 1, type);
+	const auto blockStorage = res->View<uint8_t>().data();
+	Utils::Win32::ParallelForRanges(L"Sqex::Texture::EncodeMipmap", (source.Height + 3) / 4, MinimumPixelsPerEncodeTask / std::max<size_t>(1, 4 * source.Width), [&](size_t from, size_t to) {
+		EncodeBlockRows(source, type, preset, blockStorage, from, to);
+	});
+	return res;
+}
+
+std::shared_ptr<Sqex::Texture::ModifiableTextureStream> Sqex::Texture::EncodeTexture(const MipmapStream& source, const EncodeOptions& options) {
+	const auto blockCompressed = IsBlockCompressed(options.Type);
+	const auto mipmaps = GenerateMipmaps(source, options.MipmapCount, options.Filter);
+
+	auto res = std::make_shared<ModifiableTextureStream>(options.Type, source.Width, source.Height, 1, static_cast<uint16_t>(mipmaps.size()));
+	if (!blockCompressed) {
+		for (size_t i = 0; i < mipmaps.size(); ++i)
+			res->SetMipmap(i, 0, EncodeMipmap(*mipmaps[i], options.Type, options.Preset));
+		return res;
+	}
+
+	// Submit block rows of every mipmap level to a single pool, so that small levels do not leave threads idle.
+	std::vector<std::shared_ptr<MemoryBackedMipmap>> encoded;
+	{
+		Utils::Win32::TpEnvironment pool(L"Sqex::Texture::EncodeTexture");
+		for (const auto& mipmap : mipmaps) {
+			auto& target = encoded.emplace_back(std::make_shared<MemoryBackedMipmap>(mipmap->Width, mipmap->Height, 1, options.Type));
+			const auto blockStorage = target->View<uint8_t>().data();
+			const size_t blockRowCount = (mipmap->Height + 3) / 4;
+			const auto blockRowsPerTask = std::max<size_t>(1, MinimumPixelsPerEncodeTask / (4 * mipmap->Width));
+			for (size_t from = 0; from < blockRowCount; from += blockRowsPerTask) {
+				const auto to = std::min(blockRowCount, from + blockRowsPerTask);
+				pool.SubmitWork([&mipmap, &options, blockStorage, from, to]() {
+					EncodeBlockRows(*mipmap, options.Type, options.Preset, blockStorage, from, to);
+				});
+			}
+		}
+		pool.WaitOutstanding();
+	}
+
+	for (size_t i = 0; i < encoded.size(); ++i)
+		res->SetMipmap(i, 0, std::move(encoded[i]));
+	return res;
+}
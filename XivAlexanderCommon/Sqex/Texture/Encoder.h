@@ -0,0 +1,40 @@
+#pragma once
+
+#include "XivAlexanderCommon/Sqex/Texture.h"
+#include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
+#include "XivAlexanderCommon/Sqex/Texture/ModifiableTextureStream.h"
+
+namespace Sqex::Texture {
+	enum class MipmapFilter {
+		// Average of 2x2 pixels.
+		Box,
+
+		// Kaiser-windowed sinc over 6x6 pixels; keeps more detail, at the cost of slight ringing.
+		Kaiser,
+	};
+
+	enum class EncodePreset {
+		Fast,
+		Quality,
+	};
+
+	struct EncodeOptions {
+		// One of A8R8G8B8, X8R8G8B8, DXT1, DXT5, or BC7.
+		Format Type = Format::DXT5;
+		EncodePreset Preset = EncodePreset::Fast;
+		MipmapFilter Filter = MipmapFilter::Box;
+
+		// 0 to generate mipmaps down to 1x1.
+		size_t MipmapCount = 0;
+	};
+
+	/// \brief Generates a chain of A8R8G8B8 mipmaps, each half the size of the previous one.
+	/// \param mipmapCount Number of mipmaps including the source itself, or 0 to continue down to 1x1.
+	[[nodiscard]] std::vector<std::shared_ptr<MemoryBackedMipmap>> GenerateMipmaps(const MipmapStream& source, size_t mipmapCount, MipmapFilter filter);
+
+	/// \brief Encodes an A8R8G8B8 mipmap into given type.
+	[[nodiscard]] std::shared_ptr<MemoryBackedMipmap> EncodeMipmap(const MemoryBackedMipmap& source, Format type, EncodePreset preset);
+
+	/// \brief Generates mipmaps from source and encodes all of them, in parallel across blocks and mipmap levels.
+	[[nodiscard]] std::shared_ptr<ModifiableTextureStream> EncodeTexture(const MipmapStream& source, const EncodeOptions& options);
+}
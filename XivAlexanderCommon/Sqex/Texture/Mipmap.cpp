@@ -1,7 +1,8 @@
 #include "pch.h"
 #include "XivAlexanderCommon/Sqex/Texture/Mipmap.h"
 
-#include "XivAlexanderCommon/Utils/Dxt.h"
+#include "XivAlexanderCommon/Utils/DxtDecoder.h"
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
 
 Sqex::Texture::MipmapStream::MipmapStream(size_t width, size_t height, size_t layers, Format type)
 	: Width(static_cast<uint16_t>(width))
@@ -387,6 +388,13 @@ void Sqex::Texture::MipmapStream::Show(std::string title) const {
 		PostQuitMessage(0);
 }
 
+// Calls fn(rowFrom, rowTo) over [0, rowCount), splitting the range across a thread pool if there is enough work.
+template<typename Fn>
+static void ForEachRowRange(size_t rowCount, size_t pixelsPerRow, const Fn& fn) {
+	static constexpr size_t MinimumPixelsPerTask = 64 * 1024;
+	Utils::Win32::ParallelForRanges(L"MemoryBackedMipmap::NewARGB8888From", rowCount, MinimumPixelsPerTask / std::max<size_t>(1, pixelsPerRow), fn);
+}
+
 std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> Sqex::Texture::MemoryBackedMipmap::NewARGB8888From(const MipmapStream* stream, Format type) {
 	if (type != Format::A8R8G8B8 && type != Format::X8R8G8B8)
 		throw std::invalid_argument("invalid argb8888 compression type");
@@ -398,150 +406,115 @@ std::shared_ptr<Sqex::Texture::MemoryBackedMipmap> Sqex::Texture::MemoryBackedMi
 
 	std::vector<uint8_t> result(pixelCount * sizeof RGBA8888);
 	const auto rgba8888view = span_cast<RGBA8888>(result);
-	uint32_t pos = 0, read = 0;
-	uint8_t buf8[8192];
+
+	if (!pixelCount)
+		return std::make_shared<MemoryBackedMipmap>(stream->Width, stream->Height, stream->Depth, type, std::move(result));
+
+	if (stream->Type == Format::A8R8G8B8 || stream->Type == Format::X8R8G8B8) {
+		if (cbSource < pixelCount * sizeof RGBA8888)
+			throw std::runtime_error("Truncated data detected");
+		stream->ReadStream(0, std::span(rgba8888view));
+		return std::make_shared<MemoryBackedMipmap>(stream->Width, stream->Height, stream->Depth, type, std::move(result));
+	}
+
 	switch (stream->Type) {
 		case Format::L8:
 		case Format::A8:
-		{
-			if (cbSource < pixelCount)
-				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0; i < len; ++pos, ++i) {
-					rgba8888view[pos].Value = buf8[i] * 0x10101UL | 0xFF000000UL;
+		case Format::A4R4G4B4:
+		case Format::A1R5G5B5:
+		case Format::A16B16G16R16F:
+		case Format::A32B32G32R32F:
+		case Format::DXT1:
+		case Format::DXT3:
+		case Format::DXT5:
+		case Format::BC7:
+			break;
+
+		case Format::Unknown:
+		default:
+			throw std::runtime_error("Unsupported type");
+	}
+
+	const auto cbRequired = RawDataLength(stream->Type, width, height, 1);
+	if (cbSource < cbRequired)
+		throw std::runtime_error("Truncated data detected");
+	const auto source = stream->ReadStreamIntoVector<uint8_t>(0, cbRequired);
+
+	// Convert in bands of rows (or rows of 4x4 blocks), so that each task writes into its own part of the result.
+	switch (stream->Type) {
+		case Format::L8:
+		case Format::A8:
+			ForEachRowRange(height, width, [&](size_t from, size_t to) {
+				for (auto i = from * width, i_ = to * width; i < i_; ++i) {
+					rgba8888view[i].Value = source[i] * 0x10101UL | 0xFF000000UL;
 					// result[pos].R = result[pos].G = result[pos].B = result[pos].A = buf8[i];
 				}
-			}
+			});
 			break;
-		}
 
 		case Format::A4R4G4B4:
 		{
-			if (cbSource < pixelCount * sizeof RGBA4444)
-				throw std::runtime_error("Truncated data detected");
-			const auto view = span_cast<RGBA4444>(buf8);
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len / sizeof RGBA4444; i < count; ++pos, ++i)
-					rgba8888view[pos].SetFrom(view[i].R * 17, view[i].G * 17, view[i].B * 17, view[i].A * 17);
-			}
+			const auto view = span_cast<RGBA4444>(source);
+			ForEachRowRange(height, width, [&](size_t from, size_t to) {
+				for (auto i = from * width, i_ = to * width; i < i_; ++i)
+					rgba8888view[i].SetFrom(view[i].R * 17, view[i].G * 17, view[i].B * 17, view[i].A * 17);
+			});
 			break;
 		}
 
 		case Format::A1R5G5B5:
 		{
-			if (cbSource < pixelCount * sizeof RGBA5551)
-				throw std::runtime_error("Truncated data detected");
-			const auto view = span_cast<RGBA5551>(buf8);
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len / sizeof RGBA5551; i < count; ++pos, ++i)
-					rgba8888view[pos].SetFrom(view[i].R * 255 / 31, view[i].G * 255 / 31, view[i].B * 255 / 31, view[i].A * 255);
-			}
+			const auto view = span_cast<RGBA5551>(source);
+			ForEachRowRange(height, width, [&](size_t from, size_t to) {
+				for (auto i = from * width, i_ = to * width; i < i_; ++i)
+					rgba8888view[i].SetFrom(view[i].R * 255 / 31, view[i].G * 255 / 31, view[i].B * 255 / 31, view[i].A * 255);
+			});
 			break;
 		}
 
-		case Format::A8R8G8B8:
-		case Format::X8R8G8B8:
-			if (cbSource < pixelCount * sizeof RGBA8888)
-				throw std::runtime_error("Truncated data detected");
-			stream->ReadStream(0, std::span(rgba8888view));
-			break;
-
 		case Format::A16B16G16R16F:
 		{
-			if (cbSource < pixelCount * sizeof RGBAHHHH)
-				throw std::runtime_error("Truncated data detected");
-			stream->ReadStream(0, std::span(rgba8888view));
-			const auto view = span_cast<RGBAHHHH>(buf8);
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len / sizeof RGBAHHHH; i < count; ++pos, ++i)
-					rgba8888view[pos].SetFromF(view[i]);
-			}
+			const auto view = span_cast<RGBAHHHH>(source);
+			ForEachRowRange(height, width, [&](size_t from, size_t to) {
+				for (auto i = from * width, i_ = to * width; i < i_; ++i)
+					rgba8888view[i].SetFromF(view[i]);
+			});
 			break;
 		}
 
 		case Format::A32B32G32R32F:
 		{
-			if (cbSource < pixelCount * sizeof RGBAFFFF)
-				throw std::runtime_error("Truncated data detected");
-			stream->ReadStream(0, std::span(rgba8888view));
-			const auto view = span_cast<RGBAFFFF>(buf8);
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len / sizeof RGBAFFFF; i < count; ++pos, ++i)
-					rgba8888view[pos].SetFromF(view[i]);
-			}
+			const auto view = span_cast<RGBAFFFF>(source);
+			ForEachRowRange(height, width, [&](size_t from, size_t to) {
+				for (auto i = from * width, i_ = to * width; i < i_; ++i)
+					rgba8888view[i].SetFromF(view[i]);
+			});
 			break;
 		}
 
 		case Format::DXT1:
-		{
-			if (cbSource < pixelCount * 8)
-				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len; i < count; i += 8, pos += 8) {
-					DecompressBlockDXT1(
-						pos / 2 % width,
-						pos / 2 / width * 4,
-						width, &buf8[i], reinterpret_cast<uint32_t*>(&rgba8888view[0]));
-				}
-			}
+			ForEachRowRange((height + 3) / 4, static_cast<size_t>(width) * 4, [&](size_t from, size_t to) {
+				Utils::DecompressBlockRowsDXT1(width, height, static_cast<uint32_t>(from), static_cast<uint32_t>(to), &source[0], &rgba8888view[0].Value);
+			});
 			break;
-		}
 
 		case Format::DXT3:
-		{
-			if (cbSource < pixelCount * 16)
-				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len; i < count; i += 16, pos += 16) {
-					DecompressBlockDXT1(
-						pos / 4 % width,
-						pos / 4 / width * 4,
-						width, &buf8[i], reinterpret_cast<uint32_t*>(&rgba8888view[0]));
-					for (size_t dy = 0; dy < 4; dy += 1) {
-						for (size_t dx = 0; dx < 4; dx += 2) {
-							rgba8888view[dy * width + dx].A = 17 * (buf8[i + dy * 2 + dx / 2] & 0xF);
-							rgba8888view[dy * width + dx + 1].A = 17 * (buf8[i + dy * 2 + dx / 2] >> 4);
-						}
-					}
-				}
-			}
+			ForEachRowRange((height + 3) / 4, static_cast<size_t>(width) * 4, [&](size_t from, size_t to) {
+				Utils::DecompressBlockRowsDXT3(width, height, static_cast<uint32_t>(from), static_cast<uint32_t>(to), &source[0], &rgba8888view[0].Value);
+			});
 			break;
-		}
 
 		case Format::DXT5:
-		{
-			if (cbSource < pixelCount * 16)
-				throw std::runtime_error("Truncated data detected");
-			while (const auto len = static_cast<uint32_t>(std::min<uint64_t>(cbSource - read, sizeof buf8))) {
-				stream->ReadStream(read, buf8, len);
-				read += len;
-				for (size_t i = 0, count = len; i < count; i += 16, pos += 16) {
-					DecompressBlockDXT5(
-						pos / 4 % width,
-						pos / 4 / width * 4,
-						width, &buf8[i], reinterpret_cast<uint32_t*>(&rgba8888view[0]));
-				}
-			}
+			ForEachRowRange((height + 3) / 4, static_cast<size_t>(width) * 4, [&](size_t from, size_t to) {
+				Utils::DecompressBlockRowsDXT5(width, height, static_cast<uint32_t>(from), static_cast<uint32_t>(to), &source[0], &rgba8888view[0].Value);
+			});
 			break;
-		}
 
-		case Format::Unknown:
-		default:
-			throw std::runtime_error("Unsupported type");
+		case Format::BC7:
+			ForEachRowRange((height + 3) / 4, static_cast<size_t>(width) * 4, [&](size_t from, size_t to) {
+				Utils::DecompressBlockRowsBC7(width, height, static_cast<uint32_t>(from), static_cast<uint32_t>(to), &source[0], &rgba8888view[0].Value);
+			});
+			break;
 	}
 
 	return std::make_shared<MemoryBackedMipmap>(stream->Width, stream->Height, stream->Depth, type, std::move(result));
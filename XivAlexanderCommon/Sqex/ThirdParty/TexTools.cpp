@@ -362,6 +362,16 @@ void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEqdpEdits(std::function<Sqex
 	}
 }
 
+void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEqdpEdits(Sqex::Eqdp::ExpandedFile& eqdp, uint32_t race) const {
+	for (const auto& v : Get<EqdpEntry>(MetaDataType::Eqdp)) {
+		if (v.RaceCode != race)
+			continue;
+		auto& target = eqdp.Set(PrimaryId);
+		target &= ~(0b11 << (SlotIndex * 2));
+		target |= v.Value << (SlotIndex * 2);
+	}
+}
+
 void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEqpEdits(Sqex::EqpGmp::ExpandedFile& eqp) const {
 	if (const auto eqpedit = Get<uint8_t>(Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType::Eqp); !eqpedit.empty()) {
 		if (eqpedit.size() != EqpEntrySize)
@@ -381,13 +391,112 @@ void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyGmpEdits(Sqex::EqpGmp::Expan
 void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEstEdits(Sqex::Est::File& est) const {
 	if (const auto estedit = Get<Sqex::ThirdParty::TexTools::ItemMetadata::EstEntry>(Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType::Est); !estedit.empty()) {
 		auto estpairs = est.ToPairs();
-		for (const auto& v : estedit) {
-			const auto key = Sqex::Est::EntryDescriptor{ .SetId = v.SetId, .RaceCode = v.RaceCode };
-			if (v.SkelId == 0)
-				estpairs.erase(key);
-			else
-				estpairs.insert_or_assign(key, v.SkelId);
-		}
+		ApplyEstEdits(estpairs);
 		est.Update(estpairs);
 	}
 }
+
+void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEstEdits(std::map<Sqex::Est::EntryDescriptor, uint16_t>& estPairs) const {
+	for (const auto& v : Get<Sqex::ThirdParty::TexTools::ItemMetadata::EstEntry>(Sqex::ThirdParty::TexTools::ItemMetadata::MetaDataType::Est)) {
+		const auto key = Sqex::Est::EntryDescriptor{ .SetId = v.SetId, .RaceCode = v.RaceCode };
+		if (v.SkelId == 0)
+			estPairs.erase(key);
+		else
+			estPairs.insert_or_assign(key, v.SkelId);
+	}
+}
+
+Sqex::ThirdParty::TexTools::ItemMetadataComposer::ItemMetadataComposer(OriginalFileReader originalFileReader)
+	: m_originalFileReader(std::move(originalFileReader)) {
+}
+
+std::vector<std::string> Sqex::ThirdParty::TexTools::ItemMetadataComposer::Update(const std::vector<std::shared_ptr<const ItemMetadata>>& metadata) {
+	std::map<std::string, Target> targets;
+	for (const auto& m : metadata) {
+		const auto addSource = [&](const std::string& path, ItemMetadata::MetaDataType type, uint32_t eqdpRace = 0) {
+			auto& target = targets[path];
+			target.Type = type;
+			target.EqdpRace = eqdpRace;
+			if (target.Sources.empty() || target.Sources.back() != m)
+				target.Sources.emplace_back(m);
+		};
+
+		if (!m->Get<Imc::Entry>(ItemMetadata::MetaDataType::Imc).empty())
+			addSource(m->TargetImcPath, ItemMetadata::MetaDataType::Imc);
+		for (const auto& v : m->Get<ItemMetadata::EqdpEntry>(ItemMetadata::MetaDataType::Eqdp))
+			addSource(ItemMetadata::EqdpPath(m->ItemType, v.RaceCode), ItemMetadata::MetaDataType::Eqdp, v.RaceCode);
+		if (!m->Get<uint8_t>(ItemMetadata::MetaDataType::Eqp).empty())
+			addSource(ItemMetadata::EqpPath, ItemMetadata::MetaDataType::Eqp);
+		if (!m->Get<uint8_t>(ItemMetadata::MetaDataType::Gmp).empty())
+			addSource(ItemMetadata::GmpPath, ItemMetadata::MetaDataType::Gmp);
+		if (const auto estPath = ItemMetadata::EstPath(m->EstType); estPath && !m->Get<ItemMetadata::EstEntry>(ItemMetadata::MetaDataType::Est).empty())
+			addSource(estPath, ItemMetadata::MetaDataType::Est);
+	}
+
+	// Compose everything first, so that nothing changes if any of it fails.
+	std::vector<std::string> changed;
+	for (auto& [path, target] : targets) {
+		if (const auto it = m_targets.find(path); it != m_targets.end() && it->second.Sources == target.Sources)
+			continue;
+		target.Data = Compose(path, target);
+		changed.emplace_back(path);
+	}
+
+	for (auto& [path, target] : m_targets) {
+		if (const auto it = targets.find(path); it == targets.end())
+			changed.emplace_back(path);
+		else if (it->second.Sources == target.Sources)
+			it->second.Data = std::move(target.Data);
+	}
+	m_targets = std::move(targets);
+	return changed;
+}
+
+const std::vector<uint8_t>* Sqex::ThirdParty::TexTools::ItemMetadataComposer::Get(const std::string& path) const {
+	const auto it = m_targets.find(path);
+	return it == m_targets.end() ? nullptr : &it->second.Data;
+}
+
+std::vector<uint8_t> Sqex::ThirdParty::TexTools::ItemMetadataComposer::Compose(const std::string& path, const Target& target) const {
+	switch (target.Type) {
+		case ItemMetadata::MetaDataType::Imc: {
+			// The first item metadata decides where the original file is read from.
+			auto imc = Imc::File(*m_originalFileReader(target.Sources.front()->SourceImcPath));
+			for (const auto& source : target.Sources)
+				source->ApplyImcEdits([&imc]() -> Imc::File& { return imc; });
+			return imc.Data();
+		}
+
+		case ItemMetadata::MetaDataType::Eqdp: {
+			auto eqdp = Eqdp::ExpandedFile(*m_originalFileReader(path));
+			for (const auto& source : target.Sources)
+				source->ApplyEqdpEdits(eqdp, target.EqdpRace);
+			return eqdp.Data();
+		}
+
+		case ItemMetadata::MetaDataType::Eqp:
+		case ItemMetadata::MetaDataType::Gmp: {
+			auto file = EqpGmp::ExpandedFile(EqpGmp::CollapsedFile(*m_originalFileReader(path)));
+			for (const auto& source : target.Sources) {
+				if (target.Type == ItemMetadata::MetaDataType::Eqp)
+					source->ApplyEqpEdits(file);
+				else
+					source->ApplyGmpEdits(file);
+			}
+			return file.DataBytes();
+		}
+
+		case ItemMetadata::MetaDataType::Est: {
+			// Convert to and from pairs only once, rather than once per item metadata.
+			auto est = Est::File(*m_originalFileReader(path));
+			auto estPairs = est.ToPairs();
+			for (const auto& source : target.Sources)
+				source->ApplyEstEdits(estPairs);
+			est.Update(estPairs);
+			return est.Data();
+		}
+
+		default:
+			throw std::logic_error("invalid target type");
+	}
+}
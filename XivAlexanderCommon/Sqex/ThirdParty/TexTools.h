@@ -229,8 +229,43 @@ namespace Sqex::ThirdParty::TexTools {
 
 		void ApplyImcEdits(std::function<Sqex::Imc::File&()> reader) const;
 		void ApplyEqdpEdits(std::function<Sqex::Eqdp::ExpandedFile& (TargetItemType, uint32_t)> reader) const;
+		void ApplyEqdpEdits(Sqex::Eqdp::ExpandedFile& eqdp, uint32_t race) const;
 		void ApplyEqpEdits(Sqex::EqpGmp::ExpandedFile& eqp) const;
 		void ApplyGmpEdits(Sqex::EqpGmp::ExpandedFile& gmp) const;
 		void ApplyEstEdits(Sqex::Est::File& est) const;
+		void ApplyEstEdits(std::map<Sqex::Est::EntryDescriptor, uint16_t>& estPairs) const;
+	};
+
+	/// \brief Applies edits of item metadata over the original game files they target.
+	///
+	/// Remembers which item metadata went into each target file, so that only the target files whose list of
+	/// contributing item metadata has changed get recomputed. Item metadata are told apart by identity, so an
+	/// unchanged item metadata should be passed as the same object every time.
+	class ItemMetadataComposer {
+	public:
+		typedef std::function<std::shared_ptr<RandomAccessStream>(const std::string& path)> OriginalFileReader;
+
+	private:
+		struct Target {
+			ItemMetadata::MetaDataType Type = ItemMetadata::MetaDataType::Invalid;
+			uint32_t EqdpRace = 0;
+			std::vector<std::shared_ptr<const ItemMetadata>> Sources;
+			std::vector<uint8_t> Data;
+		};
+
+		const OriginalFileReader m_originalFileReader;
+		std::map<std::string, Target> m_targets;
+
+		[[nodiscard]] std::vector<uint8_t> Compose(const std::string& path, const Target& target) const;
+
+	public:
+		ItemMetadataComposer(OriginalFileReader originalFileReader);
+
+		/// \brief Sets item metadata to apply, in the order they should be applied.
+		/// \returns Paths of target files that have been recomputed, or that are no longer edited by anything.
+		std::vector<std::string> Update(const std::vector<std::shared_ptr<const ItemMetadata>>& metadata);
+
+		/// \returns Content of the target file, or nullptr if no item metadata edits it.
+		[[nodiscard]] const std::vector<uint8_t>* Get(const std::string& path) const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/ZiPatch.h"
+
+#include "XivAlexanderCommon/Sqex/Sqpack.h"
+
+const uint8_t Sqex::ZiPatch::Header::Signature_Value[12]{ 0x91, 0x5a, 0x49, 0x50, 0x41, 0x54, 0x43, 0x48, 0x0d, 0x0a, 0x1a, 0x0a };
+
+const char Sqex::ZiPatch::Chunk::PlatformNames[3][6]{
+	"win32", "ps3\0\0", "ps4\0\0",
+};
+
+static const char* GetPlatformName(Sqex::ZiPatch::Chunk::Platform platform) {
+	const auto index = static_cast<size_t>(platform);
+	if (index >= std::size(Sqex::ZiPatch::Chunk::PlatformNames))
+		throw Sqex::CorruptDataException(std::format("unknown platform {}", index));
+	return Sqex::ZiPatch::Chunk::PlatformNames[index];
+}
+
+std::string Sqex::ZiPatch::Chunk::BaseSqpkDataTargetedCommand::ToPath(Platform platform) const {
+	if (ExpacId)
+		return std::format("sqpack/ex{}/{:02x}{:04x}.{}.dat{}", ExpacId, MainId.Value(), SubId.Value(), GetPlatformName(platform), FileId.Value());
+	else
+		return std::format("sqpack/ffxiv/{:02x}{:04x}.{}.dat{}", MainId.Value(), SubId.Value(), GetPlatformName(platform), FileId.Value());
+}
+
+std::string Sqex::ZiPatch::Chunk::BaseSqpkIndexTargetedCommand::ToPath(Platform platform) const {
+	const auto suffix = FileId.Value() ? std::format("{}", FileId.Value()) : std::string();
+	if (ExpacId)
+		return std::format("sqpack/ex{}/{:02x}{:04x}.{}.index{}", ExpacId, MainId.Value(), SubId.Value(), GetPlatformName(platform), suffix);
+	else
+		return std::format("sqpack/ffxiv/{:02x}{:04x}.{}.index{}", MainId.Value(), SubId.Value(), GetPlatformName(platform), suffix);
+}
+
+std::span<const uint8_t> Sqex::ZiPatch::FilePart::MakeEmptyBlock(std::span<uint8_t, 256> buf) const {
+	if (SplitFrom + TargetSize > buf.size())
+		throw CorruptDataException("empty block part out of range");
+
+	std::ranges::fill(buf, 0);
+	*reinterpret_cast<Sqpack::SqData::FileEntryHeader*>(buf.data()) = {
+		.HeaderSize = EntryAlignment,
+		.Type = Sqpack::SqData::FileEntryType::None,
+		.AllocatedSpaceUnitCount = SourceSize,
+	};
+	return std::span<const uint8_t>(buf).subspan(SplitFrom, static_cast<size_t>(TargetSize));
+}
+
+void Sqex::ZiPatch::FilePartMap::Replace(const FilePart& part) {
+	if (part.TargetSize == 0)
+		return;
+
+	const auto from = part.TargetOffset;
+	const auto to = part.TargetOffset + part.TargetSize;
+
+	if (const auto size = Size(); from > size) {
+		if (!m_parts.empty() && m_parts.rbegin()->second.SourceIndex == FilePart::SourceIndex_Zeros) {
+			auto& last = m_parts.rbegin()->second;
+			last.TargetSize += from - size;
+			last.Crc32 = 0;
+			last.CrcAvailable = 0;
+		} else {
+			Append(FilePart{
+				.TargetOffset = size,
+				.TargetSize = from - size,
+				.SourceIndex = FilePart::SourceIndex_Zeros,
+			});
+		}
+	}
+
+	// Make sure that parts begin at both ends of the new part.
+	for (const auto splitOffset : { from, to }) {
+		auto it = m_parts.upper_bound(splitOffset);
+		if (it == m_parts.begin())
+			continue;
+
+		--it;
+		auto& head = it->second;
+		if (head.TargetOffset == splitOffset || head.TargetOffset + head.TargetSize <= splitOffset)
+			continue;
+
+		auto tail = head;
+		tail.TargetOffset = splitOffset;
+		tail.TargetSize = head.TargetOffset + head.TargetSize - splitOffset;
+		tail.SplitFrom = static_cast<uint32_t>(head.SplitFrom + splitOffset - head.TargetOffset);
+		tail.Crc32 = 0;
+		tail.CrcAvailable = 0;
+
+		head.TargetSize = splitOffset - head.TargetOffset;
+		head.Crc32 = 0;
+		head.CrcAvailable = 0;
+		m_parts.emplace_hint(std::next(it), splitOffset, tail);
+	}
+
+	auto it = m_parts.emplace_hint(m_parts.erase(m_parts.lower_bound(from), m_parts.lower_bound(to)), from, part);
+	if (part.SourceIndex != FilePart::SourceIndex_Zeros)
+		return;
+
+	if (const auto next = std::next(it); next != m_parts.end() && next->second.SourceIndex == FilePart::SourceIndex_Zeros) {
+		it->second.TargetSize += next->second.TargetSize;
+		it->second.Crc32 = 0;
+		it->second.CrcAvailable = 0;
+		m_parts.erase(next);
+	}
+
+	if (it != m_parts.begin()) {
+		if (const auto prev = std::prev(it); prev->second.SourceIndex == FilePart::SourceIndex_Zeros) {
+			prev->second.TargetSize += it->second.TargetSize;
+			prev->second.Crc32 = 0;
+			prev->second.CrcAvailable = 0;
+			m_parts.erase(it);
+		}
+	}
+}
+
+void Sqex::ZiPatch::FilePartMap::Append(const FilePart& part) {
+	if (part.TargetOffset != Size())
+		throw std::invalid_argument("part does not begin at the end of the file");
+	if (part.TargetSize)
+		m_parts.emplace_hint(m_parts.end(), part.TargetOffset, part);
+}
+
+uint64_t Sqex::ZiPatch::FilePartMap::Size() const {
+	if (m_parts.empty())
+		return 0;
+	const auto& last = m_parts.rbegin()->second;
+	return last.TargetOffset + last.TargetSize;
+}
+
+const Sqex::ZiPatch::FilePart* Sqex::ZiPatch::FilePartMap::Find(uint64_t offset) const {
+	auto it = m_parts.upper_bound(offset);
+	if (it == m_parts.begin())
+		return nullptr;
+
+	--it;
+	if (offset >= it->second.TargetOffset + it->second.TargetSize)
+		return nullptr;
+	return &it->second;
+}
+
+struct FilePartIndexHeader {
+	static constexpr char Signature_Value[8]{ 'X', 'A', 'Z', 'P', 'I', 'D', 'X', '1' };
+
+	char Signature[8];
+	Sqex::LE<uint32_t> SourceCount;
+	Sqex::LE<uint32_t> FileCount;
+	Sqex::LE<uint64_t> PartCount;
+	Sqex::LE<uint64_t> NamesSize;
+};
+
+struct FilePartIndexName {
+	Sqex::LE<uint32_t> Offset;
+	Sqex::LE<uint32_t> Size;
+};
+
+struct FilePartIndexFile {
+	FilePartIndexName Name;
+	Sqex::LE<uint64_t> PartCount;
+};
+
+// TargetOffset is omitted, as parts of a file are consecutive.
+struct FilePartIndexPart {
+	static constexpr uint32_t Flag_SourceIsDeflated = 1 << 0;
+	static constexpr uint32_t Flag_CrcAvailable = 1 << 1;
+
+	Sqex::LE<uint64_t> TargetSize;
+	Sqex::LE<uint32_t> SourceIndex;
+	Sqex::LE<uint32_t> SourceOffset;
+	Sqex::LE<uint32_t> SourceSize;
+	Sqex::LE<uint32_t> SplitFrom;
+	Sqex::LE<uint32_t> Crc32;
+	Sqex::LE<uint32_t> Flags;
+};
+
+template<typename T>
+static std::span<const T> ConsumeArray(std::span<const uint8_t>& data, uint64_t count) {
+	if (count > data.size() / sizeof(T))
+		throw Sqex::CorruptDataException("file part index is truncated");
+	const auto result = std::span(reinterpret_cast<const T*>(data.data()), static_cast<size_t>(count));
+	data = data.subspan(result.size_bytes());
+	return result;
+}
+
+std::vector<uint8_t> Sqex::ZiPatch::FilePartIndex::Serialize() const {
+	std::string names;
+	const auto addName = [&names](const std::string& name) {
+		const auto offset = names.size();
+		names += name;
+		return FilePartIndexName{
+			.Offset = static_cast<uint32_t>(offset),
+			.Size = static_cast<uint32_t>(name.size()),
+		};
+	};
+
+	std::vector<FilePartIndexName> sources;
+	sources.reserve(SourceNames.size());
+	for (const auto& name : SourceNames)
+		sources.emplace_back(addName(name));
+
+	std::vector<FilePartIndexFile> files;
+	std::vector<FilePartIndexPart> parts;
+	files.reserve(Files.size());
+	for (const auto& [path, partMap] : Files) {
+		files.emplace_back(FilePartIndexFile{
+			.Name = addName(path),
+			.PartCount = partMap.Count(),
+		});
+		for (const auto& part : partMap.Parts()) {
+			parts.emplace_back(FilePartIndexPart{
+				.TargetSize = part.TargetSize,
+				.SourceIndex = part.SourceIndex,
+				.SourceOffset = part.SourceOffset,
+				.SourceSize = part.SourceSize,
+				.SplitFrom = part.SplitFrom,
+				.Crc32 = part.Crc32,
+				.Flags = (part.SourceIsDeflated ? FilePartIndexPart::Flag_SourceIsDeflated : 0U)
+					| (part.CrcAvailable ? FilePartIndexPart::Flag_CrcAvailable : 0U),
+			});
+		}
+	}
+	if (names.size() > UINT32_MAX)
+		throw std::runtime_error("too many names");
+
+	FilePartIndexHeader header{
+		.SourceCount = static_cast<uint32_t>(sources.size()),
+		.FileCount = static_cast<uint32_t>(files.size()),
+		.PartCount = parts.size(),
+		.NamesSize = names.size(),
+	};
+	memcpy(header.Signature, FilePartIndexHeader::Signature_Value, sizeof(header.Signature));
+
+	std::vector<uint8_t> result;
+	result.reserve(sizeof(header) + std::span(sources).size_bytes() + std::span(files).size_bytes() + std::span(parts).size_bytes() + names.size());
+	const auto append = [&result](const void* data, size_t size) {
+		result.insert(result.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+	};
+	append(&header, sizeof(header));
+	append(sources.data(), std::span(sources).size_bytes());
+	append(files.data(), std::span(files).size_bytes());
+	append(parts.data(), std::span(parts).size_bytes());
+	append(names.data(), names.size());
+	return result;
+}
+
+Sqex::ZiPatch::FilePartIndex Sqex::ZiPatch::FilePartIndex::Deserialize(std::span<const uint8_t> data) {
+	const auto& header = ConsumeArray<FilePartIndexHeader>(data, 1)[0];
+	if (0 != memcmp(header.Signature, FilePartIndexHeader::Signature_Value, sizeof(header.Signature)))
+		throw CorruptDataException("bad file part index signature");
+
+	const auto sources = ConsumeArray<FilePartIndexName>(data, header.SourceCount);
+	const auto files = ConsumeArray<FilePartIndexFile>(data, header.FileCount);
+	const auto parts = ConsumeArray<FilePartIndexPart>(data, header.PartCount);
+	const auto names = ConsumeArray<char>(data, header.NamesSize);
+	const auto getName = [&names](const FilePartIndexName& name) {
+		if (name.Offset > names.size() || name.Size > names.size() - name.Offset)
+			throw CorruptDataException("name out of range");
+		return std::string(&names[name.Offset], name.Size);
+	};
+
+	FilePartIndex result;
+	result.SourceNames.reserve(sources.size());
+	for (const auto& source : sources)
+		result.SourceNames.emplace_back(getName(source));
+
+	auto partIterator = parts.begin();
+	for (const auto& file : files) {
+		if (file.PartCount > static_cast<uint64_t>(parts.end() - partIterator))
+			throw CorruptDataException("part count out of range");
+
+		auto& partMap = result.Files.emplace_hint(result.Files.end(), getName(file.Name), FilePartMap())->second;
+		for (const auto partIteratorTo = partIterator + static_cast<ptrdiff_t>(file.PartCount); partIterator != partIteratorTo; ++partIterator) {
+			partMap.Append(FilePart{
+				.TargetOffset = partMap.Size(),
+				.TargetSize = partIterator->TargetSize,
+				.SourceIndex = partIterator->SourceIndex,
+				.SourceOffset = partIterator->SourceOffset,
+				.SourceSize = partIterator->SourceSize,
+				.SplitFrom = partIterator->SplitFrom,
+				.Crc32 = partIterator->Crc32,
+				.SourceIsDeflated = partIterator->Flags & FilePartIndexPart::Flag_SourceIsDeflated ? 1U : 0U,
+				.CrcAvailable = partIterator->Flags & FilePartIndexPart::Flag_CrcAvailable ? 1U : 0U,
+			});
+		}
+	}
+
+	return result;
+}
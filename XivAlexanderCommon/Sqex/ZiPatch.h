@@ -0,0 +1,259 @@
+#pragma once
+
+#include <map>
+
+#include "XivAlexanderCommon/Sqex.h"
+
+namespace Sqex::ZiPatch {
+	static constexpr uint32_t FromChars(char c1 = 0, char c2 = 0, char c3 = 0, char c4 = 0) {
+		return static_cast<uint32_t>(static_cast<uint8_t>(c1)) << 24
+			| static_cast<uint32_t>(static_cast<uint8_t>(c2)) << 16
+			| static_cast<uint32_t>(static_cast<uint8_t>(c3)) << 8
+			| static_cast<uint32_t>(static_cast<uint8_t>(c4)) << 0;
+	}
+
+	struct Header {
+		static const uint8_t Signature_Value[12];
+
+		char Signature[12];
+	};
+
+	namespace Chunk {
+		enum class TypeValues : uint32_t {
+			AddDirectory = FromChars('A', 'D', 'I', 'R'),
+			ApplyOption = FromChars('A', 'P', 'L', 'Y'),
+			DeleteDirectory = FromChars('D', 'E', 'L', 'D'),
+			EndOfFile = FromChars('E', 'O', 'F', '_'),
+			FileHeader = FromChars('F', 'H', 'D', 'R'),
+			Sqpk = FromChars('S', 'Q', 'P', 'K'),
+		};
+
+		struct ChunkHeader {
+			BE<uint32_t> Size;
+			BE<TypeValues> Type;
+		};
+
+		// CRC32 of Type and the chunk data following ChunkHeader.
+		struct ChunkFooter {
+			BE<uint32_t> Crc32;
+		};
+
+		struct AddDirectory : ChunkHeader {
+			BE<uint32_t> DirNameSize;
+			char DirName[1];
+		};
+
+		struct ApplyOption : ChunkHeader {
+			enum class OptionType : uint32_t {
+				IgnoreMissing = 1,
+				IgnoreOldMismatch = 2,
+			};
+
+			BE<OptionType> Type;
+			BE<uint32_t> Unknown_0x004;
+			BE<uint32_t> Value;
+		};
+
+		struct DeleteDirectory : ChunkHeader {
+			BE<uint32_t> DirNameSize;
+			char DirName[1];
+		};
+
+		struct EndOfFile : ChunkHeader {
+		};
+
+		struct FileHeader : ChunkHeader {
+			BE<uint16_t> Unknown_0x000;
+			uint8_t Version;
+			uint8_t Unknown_0x003;
+			char PatchType[4];
+			BE<uint32_t> EntryFiles;
+		};
+
+		struct FileHeaderV3 : ChunkHeader {
+			BE<uint32_t> AddDirectories;
+			BE<uint32_t> DeleteDirectories;
+			BE<uint64_t> DeleteDataSize;
+			BE<uint32_t> MinorVersion;
+			BE<uint32_t> RepositoryName;
+			BE<uint32_t> Commands;
+			BE<uint32_t> SqpkAddCommands;
+			BE<uint32_t> SqpkDeleteCommands;
+			BE<uint32_t> SqpkExpandCommands;
+			BE<uint32_t> SqpkHeaderCommands;
+			BE<uint32_t> SqpkFileCommands;
+		};
+
+		enum class SqpkChunkTypeValues : uint32_t {
+			FileAdd = FromChars('F', 'A'),
+			FileRemoveAll = FromChars('F', 'R'),
+			FileDelete = FromChars('F', 'D'),
+			FileMakeTree = FromChars('F', 'M'),
+			IndexAdd = FromChars('I', 'A'),
+			IndexDelete = FromChars('I', 'D'),
+			PatchInfo = FromChars('X'),
+			TargetInfo = FromChars('T'),
+			DataAdd = FromChars('A'),
+			DataDelete = FromChars('D'),
+			DataExpand = FromChars('E'),
+			DatHeaderVersion = FromChars('H', 'D', 'V'),
+			DatHeaderSqpack = FromChars('H', 'D', 'D'),
+			IndexHeaderVersion = FromChars('H', 'I', 'V'),
+			IndexHeaderSqpack = FromChars('H', 'I', 'I'),
+		};
+
+		struct SqpkBase : ChunkHeader {
+			BE<uint32_t> Size;
+			BE<SqpkChunkTypeValues> SqpkChunkType;
+		};
+
+		struct SqpkFile : SqpkBase {
+			BE<uint64_t> TargetOffset;
+			BE<uint64_t> TargetSize;
+			BE<uint32_t> PathSize;
+			BE<uint16_t> ExpacId;
+			BE<uint16_t> Padding_0x016;
+			char Path[1];
+		};
+
+		enum class Platform : uint16_t {
+			Win32 = 0,
+			Ps3 = 1,
+			Ps4 = 2,
+		};
+
+		extern const char PlatformNames[3][6];
+
+		struct SqpkTargetInfo : SqpkBase {
+			BE<Platform> Platform;
+			BE<uint16_t> Region;
+			BE<uint16_t> IsDebug;
+			BE<uint16_t> Version;
+			BE<uint64_t> DeletedDataSize;
+			BE<uint64_t> SeekCount;
+		};
+
+		struct BaseSqpkTargetedCommand : SqpkBase {
+			BE<uint16_t> MainId;
+			union {
+				uint8_t ExpacId;
+				BE<uint16_t> SubId;
+			};
+			BE<uint32_t> FileId;
+		};
+
+		struct BaseSqpkDataTargetedCommand : BaseSqpkTargetedCommand {
+			[[nodiscard]] std::string ToPath(Platform platform) const;
+		};
+
+		struct BaseSqpkIndexTargetedCommand : BaseSqpkTargetedCommand {
+			[[nodiscard]] std::string ToPath(Platform platform) const;
+		};
+
+		struct SqpkDataAdd : BaseSqpkDataTargetedCommand {
+			BE<uint32_t> TargetBlockIndex;
+			BE<uint32_t> TargetDataBlockCount;
+			BE<uint32_t> TargetClearBlockCount;
+		};
+
+		struct SqpkDataExpandDelete : BaseSqpkDataTargetedCommand {
+			BE<uint32_t> TargetBlockIndex;
+			BE<uint32_t> TargetDataBlockCount;
+		};
+
+		struct SqpkDatHeader : BaseSqpkDataTargetedCommand {
+		};
+
+		struct SqpkIndexHeader : BaseSqpkIndexTargetedCommand {
+		};
+	}
+
+	/// \brief Describes where a range of a target file comes from.
+	struct FilePart {
+		static constexpr uint16_t SourceIndex_Zeros = UINT16_MAX;
+		static constexpr uint16_t SourceIndex_EmptyBlock = UINT16_MAX - 1;
+
+		uint64_t TargetOffset;
+		uint64_t TargetSize;
+
+		// Index of the patch file, or one of SourceIndex_*.
+		uint32_t SourceIndex;
+		uint32_t SourceOffset;
+		uint32_t SourceSize;
+
+		// Offset into the (decompressed) source data, if this part is what remains of a larger one.
+		uint32_t SplitFrom;
+
+		uint32_t Crc32;
+		uint32_t SourceIsDeflated : 1;
+		uint32_t CrcAvailable : 1;
+		uint32_t Reserved : 30;
+
+		bool operator <(const FilePart& r) const {
+			return TargetOffset < r.TargetOffset;
+		}
+
+		bool operator >(const FilePart& r) const {
+			return TargetOffset > r.TargetOffset;
+		}
+
+		bool operator <(const uint64_t& r) const {
+			return TargetOffset < r;
+		}
+
+		bool operator >(const uint64_t& r) const {
+			return TargetOffset > r;
+		}
+
+		/// \brief Writes the sqpack entry header that an SQPK DataDelete or DataExpand command puts in place of the first block.
+		/// \returns Span of buf holding the data of this part.
+		[[nodiscard]] std::span<const uint8_t> MakeEmptyBlock(std::span<uint8_t, 256> buf) const;
+	};
+
+	/// \brief Describes a target file as consecutive parts beginning from offset 0.
+	///
+	/// Parts are kept in a balanced tree keyed by TargetOffset, so that replacing a range only touches the parts
+	/// overlapping it, and looking up the part containing an offset takes logarithmic time.
+	class FilePartMap {
+		std::map<uint64_t, FilePart> m_parts;
+
+	public:
+		/// \brief Makes part the content of [part.TargetOffset, part.TargetOffset + part.TargetSize).
+		///
+		/// Existing parts overlapping the range are trimmed, and the file is extended with zeros if part begins past its end.
+		/// Adjacent runs of zeros are merged into one part.
+		void Replace(const FilePart& part);
+
+		void Clear() { m_parts.clear(); }
+
+		/// \brief Appends part, which must begin at the current end of the file.
+		void Append(const FilePart& part);
+
+		/// \returns Size of the file.
+		[[nodiscard]] uint64_t Size() const;
+
+		/// \returns Number of parts.
+		[[nodiscard]] size_t Count() const { return m_parts.size(); }
+
+		/// \returns Part containing offset, or nullptr if offset is past the end of the file.
+		[[nodiscard]] const FilePart* Find(uint64_t offset) const;
+
+		/// \returns Parts in order. Anything but Crc32 and CrcAvailable should not be modified through this.
+		[[nodiscard]] auto Parts() { return m_parts | std::views::values; }
+		[[nodiscard]] auto Parts() const { return m_parts | std::views::values; }
+	};
+
+	/// \brief Parts of every target file resulting from a chain of patch files, storable in a single file.
+	struct FilePartIndex {
+		/// \brief Names of patch files, in the order of FilePart::SourceIndex.
+		std::vector<std::string> SourceNames;
+
+		std::map<std::string, FilePartMap> Files;
+
+		/// \returns Serialized form, which holds a header, fixed size entries, and then names, in a single buffer.
+		[[nodiscard]] std::vector<uint8_t> Serialize() const;
+
+		/// \brief Parses data returned from Serialize.
+		static FilePartIndex Deserialize(std::span<const uint8_t> data);
+	};
+}
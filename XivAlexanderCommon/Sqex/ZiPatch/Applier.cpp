@@ -0,0 +1,649 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/ZiPatch/Applier.h"
+
+#include <fstream>
+
+#include "XivAlexanderCommon/Sqex/Sqpack.h"
+#include "XivAlexanderCommon/Utils/StringUtils.h"
+#include "XivAlexanderCommon/Utils/ZlibWrapper.h"
+
+// Size of pieces passed to PatchApplier::WriteCallback, and of reads made only to check CRC32.
+static constexpr size_t WriteBufferSize = 1048576;
+
+struct PatchFileOperation {
+	enum class OperationType {
+		ReplacePart,
+		TruncateFile,
+		DeleteFile,
+		DeleteExpac,
+		AddDirectory,
+		DeleteDirectory,
+	};
+
+	OperationType Type;
+	std::string Path;
+	Sqex::ZiPatch::FilePart Part{};
+};
+
+template<typename T>
+static const T& ChunkAs(std::span<const uint8_t> chunk, size_t size = sizeof(T)) {
+	if (chunk.size() < size)
+		throw Sqex::CorruptDataException("chunk too small");
+	return *reinterpret_cast<const T*>(chunk.data());
+}
+
+static std::string FixedLengthString(const char* data, size_t maxLength) {
+	return std::string(data, std::find(data, data + maxLength, '\0'));
+}
+
+static uint32_t ToSourceOffset(uint64_t offset) {
+	if (offset > UINT32_MAX)
+		throw std::runtime_error("patch files larger than 4GB are not supported");
+	return static_cast<uint32_t>(offset);
+}
+
+static Sqex::ZiPatch::Chunk::SqpkChunkTypeValues SqpkCommandOf(const Sqex::ZiPatch::Chunk::SqpkBase& chunk) {
+	using namespace Sqex::ZiPatch::Chunk;
+
+	const auto sqpkChunkType = chunk.SqpkChunkType.Value();
+
+	// Only the first byte identifies these commands; the rest is either padding or command specific.
+	switch (static_cast<uint32_t>(sqpkChunkType) >> 24) {
+		case 'A':
+		case 'D':
+		case 'E':
+		case 'T':
+		case 'X':
+			return static_cast<SqpkChunkTypeValues>(static_cast<uint32_t>(sqpkChunkType) & 0xFF000000);
+	}
+	return sqpkChunkType;
+}
+
+// Size of what comes before target file data in a SQPK chunk, or 0 if the chunk does not carry any.
+static size_t SqpkDataOffset(const Sqex::RandomAccessStream& stream, uint64_t chunkOffset, uint64_t chunkSize) {
+	using namespace Sqex::ZiPatch::Chunk;
+
+	if (chunkSize < sizeof(SqpkBase))
+		throw Sqex::CorruptDataException(std::format("chunk at {} too small", chunkOffset));
+
+	size_t dataOffset;
+	switch (SqpkCommandOf(stream.ReadStream<SqpkBase>(chunkOffset))) {
+		case SqpkChunkTypeValues::FileAdd:
+			if (chunkSize < offsetof(SqpkFile, Path))
+				throw Sqex::CorruptDataException(std::format("chunk at {} too small", chunkOffset));
+			dataOffset = offsetof(SqpkFile, Path) + stream.ReadStream<Sqex::BE<uint32_t>>(chunkOffset + offsetof(SqpkFile, PathSize)).Value();
+			break;
+
+		case SqpkChunkTypeValues::DataAdd:
+			dataOffset = sizeof(SqpkDataAdd);
+			break;
+
+		case SqpkChunkTypeValues::DatHeaderVersion:
+		case SqpkChunkTypeValues::DatHeaderSqpack:
+		case SqpkChunkTypeValues::IndexHeaderVersion:
+		case SqpkChunkTypeValues::IndexHeaderSqpack:
+			dataOffset = sizeof(SqpkDatHeader);
+			break;
+
+		default:
+			return 0;
+	}
+
+	if (dataOffset + sizeof(ChunkFooter) > chunkSize)
+		throw Sqex::CorruptDataException(std::format("chunk at {} too small", chunkOffset));
+	return dataOffset;
+}
+
+// chunk is the whole chunk, or only what comes before target file data if SqpkDataOffset says there is any.
+static void ReadSqpkChunk(std::vector<PatchFileOperation>& operations, const Sqex::RandomAccessStream& stream, std::span<const uint8_t> chunk, uint64_t chunkOffset, uint64_t chunkSize, uint32_t sourceIndex, Sqex::ZiPatch::Chunk::Platform& platform) {
+	using namespace Sqex::ZiPatch;
+	using namespace Sqex::ZiPatch::Chunk;
+
+	const auto sqpkChunkType = SqpkCommandOf(ChunkAs<SqpkBase>(chunk));
+
+	switch (sqpkChunkType) {
+		case SqpkChunkTypeValues::FileAdd: {
+			const auto& data = ChunkAs<SqpkFile>(chunk, offsetof(SqpkFile, Path));
+			const auto pathSize = data.PathSize.Value();
+			ChunkAs<SqpkFile>(chunk, offsetof(SqpkFile, Path) + pathSize);
+			const auto path = FixedLengthString(data.Path, pathSize);
+
+			if (data.TargetOffset == 0)
+				operations.emplace_back(PatchFileOperation{ .Type = PatchFileOperation::OperationType::TruncateFile, .Path = path });
+
+			// Block headers sit between blocks of data, which is not read here.
+			const auto dataEnd = chunkSize - sizeof(ChunkFooter);
+			uint64_t offset = offsetof(SqpkFile, Path) + pathSize;
+			for (auto targetOffset = data.TargetOffset.Value();
+				targetOffset < data.TargetOffset + data.TargetSize && offset + sizeof(Sqex::Sqpack::SqData::BlockHeader) <= dataEnd;) {
+				const auto blockHeader = stream.ReadStream<Sqex::Sqpack::SqData::BlockHeader>(chunkOffset + offset);
+				const auto isDeflated = blockHeader.CompressedSize != Sqex::Sqpack::SqData::BlockHeader::CompressedSizeNotCompressed;
+				const auto blockDataSize = isDeflated ? blockHeader.CompressedSize.Value() : blockHeader.DecompressedSize.Value();
+				if (offset + blockHeader.HeaderSize + blockDataSize > dataEnd)
+					throw Sqex::CorruptDataException(std::format("block of {} at {} goes past the end of chunk", path, targetOffset));
+
+				operations.emplace_back(PatchFileOperation{
+					.Type = PatchFileOperation::OperationType::ReplacePart,
+					.Path = path,
+					.Part = {
+						.TargetOffset = targetOffset,
+						.TargetSize = blockHeader.DecompressedSize,
+						.SourceIndex = sourceIndex,
+						.SourceOffset = ToSourceOffset(chunkOffset + offset + blockHeader.HeaderSize),
+						.SourceSize = blockDataSize,
+						.SourceIsDeflated = isDeflated ? 1U : 0U,
+					},
+				});
+
+				targetOffset += blockHeader.DecompressedSize;
+				offset += Sqex::Align(blockHeader.HeaderSize + blockDataSize).Alloc;
+			}
+			break;
+		}
+
+		case SqpkChunkTypeValues::FileRemoveAll: {
+			const auto& data = ChunkAs<SqpkFile>(chunk, offsetof(SqpkFile, Path));
+			operations.emplace_back(PatchFileOperation{
+				.Type = PatchFileOperation::OperationType::DeleteExpac,
+				.Path = data.ExpacId == 0 ? std::string("ffxiv") : std::format("ex{}", data.ExpacId.Value()),
+			});
+			break;
+		}
+
+		case SqpkChunkTypeValues::FileDelete:
+		case SqpkChunkTypeValues::FileMakeTree: {
+			const auto& data = ChunkAs<SqpkFile>(chunk, offsetof(SqpkFile, Path));
+			ChunkAs<SqpkFile>(chunk, offsetof(SqpkFile, Path) + data.PathSize);
+			operations.emplace_back(PatchFileOperation{
+				.Type = sqpkChunkType == SqpkChunkTypeValues::FileDelete ? PatchFileOperation::OperationType::DeleteFile : PatchFileOperation::OperationType::AddDirectory,
+				.Path = FixedLengthString(data.Path, data.PathSize),
+			});
+			break;
+		}
+
+		case SqpkChunkTypeValues::TargetInfo:
+			platform = ChunkAs<SqpkTargetInfo>(chunk).Platform;
+			break;
+
+		case SqpkChunkTypeValues::DataAdd: {
+			const auto& data = ChunkAs<SqpkDataAdd>(chunk);
+			const auto dataSize = 1ULL * data.TargetDataBlockCount * Sqex::EntryAlignment;
+			if (sizeof(SqpkDataAdd) + dataSize + sizeof(ChunkFooter) > chunkSize)
+				throw Sqex::CorruptDataException(std::format("chunk at {} too small", chunkOffset));
+
+			const auto path = data.ToPath(platform);
+			operations.emplace_back(PatchFileOperation{
+				.Type = PatchFileOperation::OperationType::ReplacePart,
+				.Path = path,
+				.Part = {
+					.TargetOffset = 1ULL * data.TargetBlockIndex * Sqex::EntryAlignment,
+					.TargetSize = dataSize,
+					.SourceIndex = sourceIndex,
+					.SourceOffset = ToSourceOffset(chunkOffset + sizeof(SqpkDataAdd)),
+					.SourceSize = static_cast<uint32_t>(dataSize),
+				},
+			});
+			if (data.TargetClearBlockCount) {
+				operations.emplace_back(PatchFileOperation{
+					.Type = PatchFileOperation::OperationType::ReplacePart,
+					.Path = path,
+					.Part = {
+						.TargetOffset = (1ULL * data.TargetBlockIndex + data.TargetDataBlockCount) * Sqex::EntryAlignment,
+						.TargetSize = 1ULL * data.TargetClearBlockCount * Sqex::EntryAlignment,
+						.SourceIndex = FilePart::SourceIndex_Zeros,
+						.SourceSize = data.TargetClearBlockCount - 1,
+					},
+				});
+			}
+			break;
+		}
+
+		case SqpkChunkTypeValues::DataDelete:
+		case SqpkChunkTypeValues::DataExpand: {
+			const auto& data = ChunkAs<SqpkDataExpandDelete>(chunk);
+			if (!data.TargetDataBlockCount)
+				break;
+
+			const auto path = data.ToPath(platform);
+			operations.emplace_back(PatchFileOperation{
+				.Type = PatchFileOperation::OperationType::ReplacePart,
+				.Path = path,
+				.Part = {
+					.TargetOffset = 1ULL * data.TargetBlockIndex * Sqex::EntryAlignment,
+					.TargetSize = Sqex::EntryAlignment,
+					.SourceIndex = FilePart::SourceIndex_EmptyBlock,
+					.SourceSize = data.TargetDataBlockCount - 1,
+				},
+			});
+			operations.emplace_back(PatchFileOperation{
+				.Type = PatchFileOperation::OperationType::ReplacePart,
+				.Path = path,
+				.Part = {
+					.TargetOffset = (1ULL * data.TargetBlockIndex + 1) * Sqex::EntryAlignment,
+					.TargetSize = (1ULL * data.TargetDataBlockCount - 1) * Sqex::EntryAlignment,
+					.SourceIndex = FilePart::SourceIndex_Zeros,
+				},
+			});
+			break;
+		}
+
+		case SqpkChunkTypeValues::DatHeaderVersion:
+		case SqpkChunkTypeValues::DatHeaderSqpack:
+		case SqpkChunkTypeValues::IndexHeaderVersion:
+		case SqpkChunkTypeValues::IndexHeaderSqpack: {
+			static constexpr uint32_t HeaderSize = 1024;
+			const auto& data = ChunkAs<SqpkDatHeader>(chunk);
+			if (sizeof(SqpkDatHeader) + HeaderSize + sizeof(ChunkFooter) > chunkSize)
+				throw Sqex::CorruptDataException(std::format("chunk at {} too small", chunkOffset));
+			const auto isDat = sqpkChunkType == SqpkChunkTypeValues::DatHeaderVersion || sqpkChunkType == SqpkChunkTypeValues::DatHeaderSqpack;
+			const auto isVersion = sqpkChunkType == SqpkChunkTypeValues::DatHeaderVersion || sqpkChunkType == SqpkChunkTypeValues::IndexHeaderVersion;
+			operations.emplace_back(PatchFileOperation{
+				.Type = PatchFileOperation::OperationType::ReplacePart,
+				.Path = isDat ? data.ToPath(platform) : reinterpret_cast<const SqpkIndexHeader&>(data).ToPath(platform),
+				.Part = {
+					.TargetOffset = isVersion ? 0ULL : HeaderSize,
+					.TargetSize = HeaderSize,
+					.SourceIndex = sourceIndex,
+					.SourceOffset = ToSourceOffset(chunkOffset + sizeof(SqpkDatHeader)),
+					.SourceSize = HeaderSize,
+				},
+			});
+			break;
+		}
+
+		default:
+			// IndexAdd and IndexDelete only describe changes already made to .index files with FileAdd, and PatchInfo is informational.
+			break;
+	}
+}
+
+static std::vector<PatchFileOperation> ReadPatchFile(const Sqex::RandomAccessStream& stream, uint32_t sourceIndex, std::vector<Sqex::ZiPatch::PatchApplier::DataChunk>* pDataChunks) {
+	using namespace Sqex::ZiPatch;
+	using namespace Sqex::ZiPatch::Chunk;
+
+	const auto streamSize = stream.StreamSize();
+	if (streamSize < sizeof(Header))
+		throw Sqex::CorruptDataException("file too small");
+	if (const auto header = stream.ReadStream<Header>(0); 0 != memcmp(header.Signature, Header::Signature_Value, sizeof(Header::Signature_Value)))
+		throw Sqex::CorruptDataException("bad zipatch signature");
+
+	std::vector<PatchFileOperation> operations;
+	auto platform = Platform::Win32;
+	std::vector<uint8_t> chunk;
+	for (uint64_t chunkOffset = sizeof(Header); chunkOffset < streamSize;) {
+		if (chunkOffset + sizeof(ChunkHeader) > streamSize)
+			throw Sqex::CorruptDataException(std::format("truncated chunk header at {}", chunkOffset));
+
+		const auto chunkHeader = stream.ReadStream<ChunkHeader>(chunkOffset);
+		const auto chunkSize = sizeof(ChunkHeader) + chunkHeader.Size + sizeof(ChunkFooter);
+		if (chunkOffset + chunkSize > streamSize)
+			throw Sqex::CorruptDataException(std::format("truncated chunk at {}", chunkOffset));
+
+		// Chunks carrying target file data are read only up to where the data begins; WriteFile reads the rest, and checks
+		// their CRC32 on the way. Other chunks are read as a whole, and checked and parsed from memory.
+		const auto dataOffset = chunkHeader.Type == TypeValues::Sqpk ? SqpkDataOffset(stream, chunkOffset, chunkSize) : 0;
+		chunk.resize(static_cast<size_t>(dataOffset ? dataOffset : chunkSize));
+		stream.ReadStream(chunkOffset, std::span(chunk));
+
+		if (!pDataChunks) {
+			// pass
+		} else if (dataOffset) {
+			pDataChunks->emplace_back(Sqex::ZiPatch::PatchApplier::DataChunk{
+				.CrcFrom = chunkOffset + offsetof(ChunkHeader, Type),
+				.CrcTo = chunkOffset + chunkSize - sizeof(ChunkFooter),
+				.Crc32 = stream.ReadStream<ChunkFooter>(chunkOffset + chunkSize - sizeof(ChunkFooter)).Crc32,
+			});
+		} else {
+			const auto crcFrom = offsetof(ChunkHeader, Type);
+			const auto crcTo = chunk.size() - sizeof(ChunkFooter);
+			const auto expected = reinterpret_cast<const ChunkFooter*>(&chunk[crcTo])->Crc32.Value();
+			if (const auto actual = crc32_z(0, &chunk[crcFrom], crcTo - crcFrom); actual != expected)
+				throw Sqex::CorruptDataException(std::format("chunk at {} has CRC32 {:08x}, expected {:08x}", chunkOffset, actual, expected));
+		}
+
+		switch (chunkHeader.Type.Value()) {
+			case TypeValues::AddDirectory:
+			case TypeValues::DeleteDirectory: {
+				const auto& data = ChunkAs<AddDirectory>(chunk, offsetof(AddDirectory, DirName));
+				ChunkAs<AddDirectory>(chunk, offsetof(AddDirectory, DirName) + data.DirNameSize);
+				operations.emplace_back(PatchFileOperation{
+					.Type = chunkHeader.Type == TypeValues::AddDirectory ? PatchFileOperation::OperationType::AddDirectory : PatchFileOperation::OperationType::DeleteDirectory,
+					.Path = FixedLengthString(data.DirName, data.DirNameSize),
+				});
+				break;
+			}
+
+			case TypeValues::Sqpk:
+				ReadSqpkChunk(operations, stream, chunk, chunkOffset, chunkSize, sourceIndex, platform);
+				break;
+
+			case TypeValues::EndOfFile:
+				return operations;
+
+			default:
+				// FileHeader and ApplyOption do not change any file.
+				break;
+		}
+
+		chunkOffset += chunkSize;
+	}
+
+	return operations;
+}
+
+static void ForRanges(const Sqex::ZiPatch::PatchApplier::ParallelForRangesFunction& parallelForRanges, size_t count, uint32_t threadCount, const std::function<void(size_t from, size_t to)>& fn) {
+	if (parallelForRanges)
+		parallelForRanges(count, threadCount, fn);
+	else if (count)
+		fn(0, count);
+}
+
+// Reads from patch files for one target file, and checks CRC32 of the chunks the data comes from as it goes.
+// Every data chunk is for exactly one target file, so nothing here is shared between WriteFile calls.
+class Sqex::ZiPatch::PatchApplier::SourceReader {
+	struct Progress {
+		uint32_t SourceIndex;
+		uint64_t Next;
+		uint32_t Crc32;
+	};
+
+	const PatchApplier& m_applier;
+	const std::string& m_path;
+	std::map<const DataChunk*, Progress> m_progress;
+	std::vector<uint8_t> m_skipped;
+
+public:
+	SourceReader(const PatchApplier& applier, const std::string& path)
+		: m_applier(applier)
+		, m_path(path) {
+	}
+
+	void Read(uint32_t sourceIndex, uint64_t offset, std::span<uint8_t> buf) {
+		m_applier.m_patchFiles[sourceIndex]->ReadStream(offset, buf);
+
+		const auto pChunk = FindChunk(sourceIndex, offset);
+		if (!pChunk || offset + buf.size() > pChunk->CrcTo)
+			return;
+
+		auto& progress = m_progress.try_emplace(pChunk, Progress{ sourceIndex, pChunk->CrcFrom, 0 }).first->second;
+
+		// Block headers, and data replaced by later chunks, are only read for CRC32.
+		if (progress.Next < offset)
+			Skip(*pChunk, progress, offset);
+
+		// Parts split from the same block may read the same range again.
+		if (const auto end = offset + buf.size(); progress.Next >= offset && progress.Next < end) {
+			progress.Crc32 = crc32_z(progress.Crc32, &buf[static_cast<size_t>(progress.Next - offset)], static_cast<size_t>(end - progress.Next));
+			progress.Next = end;
+			if (end == pChunk->CrcTo)
+				Verify(*pChunk, progress);
+		}
+	}
+
+	// Reads the rest of the chunk that offset belongs to, and checks it.
+	void Complete(uint32_t sourceIndex, uint64_t offset) {
+		if (const auto pChunk = FindChunk(sourceIndex, offset)) {
+			auto& progress = m_progress.try_emplace(pChunk, Progress{ sourceIndex, pChunk->CrcFrom, 0 }).first->second;
+			if (progress.Next < pChunk->CrcTo)
+				Skip(*pChunk, progress, pChunk->CrcTo);
+		}
+	}
+
+	// Reads the rest of every chunk that has been read from, and checks them.
+	void CompleteAll() {
+		for (auto& [pChunk, progress] : m_progress) {
+			if (progress.Next < pChunk->CrcTo)
+				Skip(*pChunk, progress, pChunk->CrcTo);
+		}
+	}
+
+private:
+	const DataChunk* FindChunk(uint32_t sourceIndex, uint64_t offset) const {
+		if (!m_applier.VerifyChunkCrc32 || sourceIndex >= m_applier.m_dataChunks.size())
+			return nullptr;
+
+		const auto& chunks = m_applier.m_dataChunks[sourceIndex];
+		auto it = std::ranges::upper_bound(chunks, offset, {}, &DataChunk::CrcFrom);
+		if (it == chunks.begin())
+			return nullptr;
+		--it;
+		return offset < it->CrcTo ? &*it : nullptr;
+	}
+
+	void Skip(const DataChunk& chunk, Progress& progress, uint64_t to) {
+		m_skipped.resize(static_cast<size_t>(std::min<uint64_t>(WriteBufferSize, to - progress.Next)));
+		while (progress.Next < to) {
+			const auto skipped = std::span(m_skipped).subspan(0, static_cast<size_t>(std::min<uint64_t>(m_skipped.size(), to - progress.Next)));
+			m_applier.m_patchFiles[progress.SourceIndex]->ReadStream(progress.Next, skipped);
+			progress.Crc32 = crc32_z(progress.Crc32, skipped.data(), skipped.size());
+			progress.Next += skipped.size();
+		}
+		if (progress.Next == chunk.CrcTo)
+			Verify(chunk, progress);
+	}
+
+	void Verify(const DataChunk& chunk, const Progress& progress) const {
+		if (progress.Crc32 != chunk.Crc32)
+			throw CorruptDataException(std::format("{}: chunk at {} of patch file #{} has CRC32 {:08x}, expected {:08x}",
+				m_path, chunk.CrcFrom - offsetof(Chunk::ChunkHeader, Type), progress.SourceIndex, progress.Crc32, chunk.Crc32));
+	}
+};
+
+Sqex::ZiPatch::PatchApplier::PatchApplier(std::vector<std::shared_ptr<const RandomAccessStream>> patchFiles)
+	: m_patchFiles(std::move(patchFiles)) {
+	if (m_patchFiles.size() >= FilePart::SourceIndex_EmptyBlock)
+		throw std::invalid_argument("too many patch files");
+}
+
+void Sqex::ZiPatch::PatchApplier::ReadPatchFiles() {
+	std::vector<std::vector<PatchFileOperation>> operations(m_patchFiles.size());
+	std::vector<std::exception_ptr> errors(m_patchFiles.size());
+	m_dataChunks.clear();
+	m_dataChunks.resize(m_patchFiles.size());
+	ForRanges(ParallelForRanges, m_patchFiles.size(), MaxThreadCount, [&](size_t from, size_t to) {
+		for (auto i = from; i < to; ++i) {
+			try {
+				operations[i] = ReadPatchFile(*m_patchFiles[i], static_cast<uint32_t>(i), VerifyChunkCrc32 ? &m_dataChunks[i] : nullptr);
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+		}
+	});
+
+	for (const auto& error : errors) {
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	m_files.clear();
+	m_removedFiles.clear();
+	m_directories.clear();
+	for (auto& patchFileOperations : operations) {
+		for (auto& operation : patchFileOperations) {
+			switch (operation.Type) {
+				case PatchFileOperation::OperationType::ReplacePart:
+					m_removedFiles.erase(operation.Path);
+					m_files[operation.Path].Replace(operation.Part);
+					break;
+
+				case PatchFileOperation::OperationType::TruncateFile:
+					m_removedFiles.erase(operation.Path);
+					m_files[operation.Path].Clear();
+					break;
+
+				case PatchFileOperation::OperationType::DeleteFile:
+					if (m_files.erase(operation.Path))
+						m_removedFiles.insert(std::move(operation.Path));
+					break;
+
+				case PatchFileOperation::OperationType::DeleteExpac: {
+					const auto sqpackPrefix = std::format("sqpack/{}/", operation.Path);
+					const auto moviePrefix = std::format("movie/{}/", operation.Path);
+					for (auto it = m_files.begin(); it != m_files.end();) {
+						if (it->first.starts_with(sqpackPrefix) || it->first.starts_with(moviePrefix)) {
+							m_removedFiles.insert(it->first);
+							it = m_files.erase(it);
+						} else
+							++it;
+					}
+					break;
+				}
+
+				case PatchFileOperation::OperationType::AddDirectory:
+					m_directories.insert(std::move(operation.Path));
+					break;
+
+				case PatchFileOperation::OperationType::DeleteDirectory:
+					m_directories.erase(operation.Path);
+					break;
+			}
+		}
+		patchFileOperations = {};
+	}
+}
+
+void Sqex::ZiPatch::PatchApplier::WriteFile(const std::string& path, const WriteCallback& write) {
+	auto& partMap = m_files.at(path);
+	SourceReader reader(*this, path);
+
+	std::vector<uint8_t> buffer;
+	buffer.reserve(WriteBufferSize);
+	uint64_t bufferOffset = 0;
+	const auto flush = [&]() {
+		if (buffer.empty())
+			return;
+		write(bufferOffset, buffer);
+		bufferOffset += buffer.size();
+		buffer.clear();
+	};
+
+	std::optional<ZlibReusableInflater> inflater;
+	std::vector<uint8_t> deflated;
+	std::span<const uint8_t> inflated;
+	uint32_t inflatedSourceIndex = UINT32_MAX, inflatedSourceOffset = 0;
+
+	uint8_t emptyBlock[256];
+
+	for (auto& part : partMap.Parts()) {
+		uint32_t crc32 = 0;
+		for (uint64_t pieceOffset = 0; pieceOffset < part.TargetSize;) {
+			const auto pieceSize = static_cast<size_t>(std::min<uint64_t>(part.TargetSize - pieceOffset, WriteBufferSize - buffer.size()));
+			const auto bufferFrom = buffer.size();
+			buffer.resize(bufferFrom + pieceSize);
+			const auto piece = std::span(buffer).subspan(bufferFrom);
+
+			if (part.SourceIndex == FilePart::SourceIndex_Zeros) {
+				std::ranges::fill(piece, 0);
+
+			} else if (part.SourceIndex == FilePart::SourceIndex_EmptyBlock) {
+				const auto src = part.MakeEmptyBlock(emptyBlock).subspan(static_cast<size_t>(pieceOffset), pieceSize);
+				std::ranges::copy(src, piece.begin());
+
+			} else if (part.SourceIndex >= m_patchFiles.size()) {
+				throw std::out_of_range(std::format("{}: part at {} refers to patch file #{}", path, part.TargetOffset, part.SourceIndex));
+
+			} else if (part.SourceIsDeflated) {
+				// A block that has been split is read in one piece per part; keep the last one inflated.
+				if (inflatedSourceIndex != part.SourceIndex || inflatedSourceOffset != part.SourceOffset) {
+					deflated.resize(part.SourceSize);
+					reader.Read(part.SourceIndex, part.SourceOffset, std::span(deflated));
+					if (!inflater)
+						inflater.emplace(-MAX_WBITS);
+					try {
+						inflated = (*inflater)(deflated);
+					} catch (...) {
+						// Report a damaged chunk as such, rather than as whatever zlib makes of it.
+						reader.Complete(part.SourceIndex, part.SourceOffset);
+						throw;
+					}
+					inflatedSourceIndex = part.SourceIndex;
+					inflatedSourceOffset = part.SourceOffset;
+				}
+				if (part.SplitFrom + part.TargetSize > inflated.size()) {
+					reader.Complete(part.SourceIndex, part.SourceOffset);
+					throw CorruptDataException(std::format("{}: block at {} inflates to {} bytes, which is too short", path, part.TargetOffset, inflated.size()));
+				}
+				std::ranges::copy(inflated.subspan(static_cast<size_t>(part.SplitFrom + pieceOffset), pieceSize), piece.begin());
+
+			} else {
+				reader.Read(part.SourceIndex, 0ULL + part.SourceOffset + part.SplitFrom + pieceOffset, piece);
+			}
+
+			crc32 = crc32_z(crc32, piece.data(), piece.size());
+			pieceOffset += pieceSize;
+			if (buffer.size() == WriteBufferSize)
+				flush();
+		}
+
+		if (part.CrcAvailable && part.Crc32 != crc32)
+			throw CorruptDataException(std::format("{}: part at {} has CRC32 {:08x}, expected {:08x}", path, part.TargetOffset, crc32, part.Crc32));
+		part.Crc32 = crc32;
+		part.CrcAvailable = 1;
+	}
+	reader.CompleteAll();
+	flush();
+}
+
+void Sqex::ZiPatch::PatchApplier::Apply(ApplyTarget& target) {
+	for (const auto& directory : m_directories)
+		target.AddDirectory(directory);
+
+	for (const auto& path : m_removedFiles)
+		target.RemoveFile(path);
+
+	std::vector<const std::string*> paths;
+	paths.reserve(m_files.size());
+	for (const auto& path : m_files | std::views::keys)
+		paths.emplace_back(&path);
+
+	std::mutex errorMtx;
+	std::exception_ptr error;
+	ForRanges(ParallelForRanges, paths.size(), MaxThreadCount, [&](size_t from, size_t to) {
+		for (auto i = from; i < to; ++i) {
+			try {
+				WriteFile(*paths[i], target.Create(*paths[i]));
+			} catch (...) {
+				const auto lock = std::lock_guard(errorMtx);
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+	});
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void Sqex::ZiPatch::PatchApplier::Apply(const std::filesystem::path& targetDirectory) {
+	DirectoryApplyTarget target(targetDirectory);
+	Apply(target);
+}
+
+Sqex::ZiPatch::DirectoryApplyTarget::DirectoryApplyTarget(std::filesystem::path directory)
+	: m_directory(std::move(directory)) {
+}
+
+void Sqex::ZiPatch::DirectoryApplyTarget::AddDirectory(const std::string& path) {
+	create_directories(m_directory / FromUtf8(path));
+}
+
+void Sqex::ZiPatch::DirectoryApplyTarget::RemoveFile(const std::string& path) {
+	std::error_code ec;
+	remove(m_directory / FromUtf8(path), ec);
+}
+
+Sqex::ZiPatch::ApplyTarget::WriteCallback Sqex::ZiPatch::DirectoryApplyTarget::Create(const std::string& path) {
+	const auto targetPath = m_directory / FromUtf8(path);
+	create_directories(targetPath.parent_path());
+
+	auto file = std::make_shared<std::ofstream>(targetPath, std::ios::binary | std::ios::trunc);
+	if (!*file)
+		throw std::runtime_error(std::format("failed to create {}", path));
+
+	return [file, path](uint64_t offset, std::span<const uint8_t> data) {
+		file->seekp(static_cast<std::streamoff>(offset));
+		file->write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		if (!*file)
+			throw std::runtime_error(std::format("failed to write to {}", path));
+	};
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <map>
+#include <set>
+
+#include "XivAlexanderCommon/Sqex/ZiPatch.h"
+
+namespace Sqex::ZiPatch {
+	/// \brief Where PatchApplier::Apply puts target files. Called from multiple threads at once, for different paths.
+	class ApplyTarget {
+	public:
+		using WriteCallback = std::function<void(uint64_t offset, std::span<const uint8_t> data)>;
+
+		virtual ~ApplyTarget() = default;
+
+		virtual void AddDirectory(const std::string& path) = 0;
+
+		/// \brief Deletes a file, if it exists.
+		virtual void RemoveFile(const std::string& path) = 0;
+
+		/// \brief Creates an empty file, replacing an existing one.
+		/// \returns Callback writing into the file, which is closed once the callback is destroyed.
+		virtual WriteCallback Create(const std::string& path) = 0;
+	};
+
+	/// \brief Puts target files under a directory in the file system.
+	class DirectoryApplyTarget : public ApplyTarget {
+		const std::filesystem::path m_directory;
+
+	public:
+		DirectoryApplyTarget(std::filesystem::path directory);
+
+		void AddDirectory(const std::string& path) override;
+		void RemoveFile(const std::string& path) override;
+		WriteCallback Create(const std::string& path) override;
+	};
+
+	/// \brief Applies a chain of patch files.
+	///
+	/// Works out which range of which patch file ends up where in each target file, and then writes the target files.
+	/// Target files are made from the patch files alone, so the chain should begin from the first patch of the repository.
+	class PatchApplier {
+	public:
+		/// \brief Range of a patch file covered by the CRC32 of a chunk carrying target file data.
+		struct DataChunk {
+			uint64_t CrcFrom;
+			uint64_t CrcTo;
+			uint32_t Crc32;
+		};
+
+	private:
+		class SourceReader;
+
+		const std::vector<std::shared_ptr<const RandomAccessStream>> m_patchFiles;
+
+		std::map<std::string, FilePartMap> m_files;
+		std::set<std::string> m_removedFiles;
+		std::set<std::string> m_directories;
+
+		// Chunks carrying target file data, in the order of their offsets, by patch file.
+		std::vector<std::vector<DataChunk>> m_dataChunks;
+
+	public:
+		using WriteCallback = ApplyTarget::WriteCallback;
+
+		/// \brief Runs fn over ranges covering [0, count) from up to threadCount threads, and returns once every range is done.
+		using ParallelForRangesFunction = std::function<void(size_t count, uint32_t threadCount, const std::function<void(size_t from, size_t to)>& fn)>;
+
+		/// \brief Used to read patch files, and write target files, several at a time. Everything runs on the calling thread if empty.
+		ParallelForRangesFunction ParallelForRanges;
+
+		/// \brief Maximum number of patch files read, or target files written, at the same time.
+		uint32_t MaxThreadCount = UINT32_MAX;
+
+		/// \brief Whether to check the CRC32 of chunks.
+		///
+		/// Chunks that do not carry target file data are checked by ReadPatchFiles. The rest are checked by WriteFile as their
+		/// data is read, so that they are read only once; ones whose data is entirely replaced by later chunks are never read.
+		bool VerifyChunkCrc32 = true;
+
+		/// \param patchFiles Patch files, in the order they should be applied.
+		PatchApplier(std::vector<std::shared_ptr<const RandomAccessStream>> patchFiles);
+
+		/// \brief Reads chunk headers of every patch file, several files at a time, and merges what they do in order.
+		void ReadPatchFiles();
+
+		/// \returns Parts of every target file, by path relative to the game directory.
+		[[nodiscard]] const std::map<std::string, FilePartMap>& Files() const { return m_files; }
+
+		/// \returns Paths of files that have been deleted by the patch files, and not created again afterwards.
+		[[nodiscard]] const std::set<std::string>& RemovedFiles() const { return m_removedFiles; }
+
+		/// \returns Paths of directories that should exist.
+		[[nodiscard]] const std::set<std::string>& Directories() const { return m_directories; }
+
+		/// \brief Produces the content of a target file from the beginning to the end, passing it to write in pieces.
+		///
+		/// Chunks the data comes from are checked on the way, if VerifyChunkCrc32 is set. CRC32 of every part is computed too;
+		/// it is checked against the one computed before, if any, and remembered otherwise, to be kept in a FilePartIndex.
+		void WriteFile(const std::string& path, const WriteCallback& write);
+
+		/// \brief Writes every target file, several files at a time, and deletes removed ones.
+		void Apply(ApplyTarget& target);
+
+		/// \brief Writes every target file under targetDirectory, several files at a time, and deletes removed ones.
+		void Apply(const std::filesystem::path& targetDirectory);
+	};
+}
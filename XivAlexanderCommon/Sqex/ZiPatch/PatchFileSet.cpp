@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/ZiPatch/PatchFileSet.h"
+
+#include "XivAlexanderCommon/Utils/ZlibWrapper.h"
+
+static Utils::ZlibReusableInflater& GetThreadInflater() {
+	thread_local Utils::ZlibReusableInflater s_inflater(-MAX_WBITS);
+	return s_inflater;
+}
+
+Sqex::ZiPatch::PatchFileSet::PatchFileSet(std::vector<std::shared_ptr<const RandomAccessStream>> patchFiles, size_t cacheCapacity)
+	: m_patchFiles(std::move(patchFiles))
+	, m_cacheShardCapacity(cacheCapacity / CacheShardCount)
+	, m_cacheShards(std::make_unique<CacheShard[]>(CacheShardCount)) {
+}
+
+Sqex::ZiPatch::PatchFileSet::~PatchFileSet() = default;
+
+std::shared_ptr<const std::vector<uint8_t>> Sqex::ZiPatch::PatchFileSet::GetInflatedBlock(uint32_t sourceIndex, uint32_t sourceOffset, uint32_t sourceSize) const {
+	if (sourceIndex >= m_patchFiles.size())
+		throw std::out_of_range(std::format("patch file #{} does not exist", sourceIndex));
+
+	const auto key = static_cast<uint64_t>(sourceIndex) << 32 | sourceOffset;
+	auto& shard = m_cacheShards[(sourceOffset / EntryAlignment + sourceIndex) % CacheShardCount];
+
+	if (m_cacheShardCapacity) {
+		const auto lock = std::lock_guard(shard.Mtx);
+		if (const auto it = shard.Entries.find(key); it != shard.Entries.end()) {
+			shard.Lru.splice(shard.Lru.begin(), shard.Lru, it->second);
+			return it->second->Data;
+		}
+	}
+
+	// Inflate without holding the lock; another thread inflating the same block at the same time is harmless.
+	std::vector<uint8_t> deflated(sourceSize);
+	m_patchFiles[sourceIndex]->ReadStream(sourceOffset, std::span(deflated));
+	const auto inflated = GetThreadInflater()(deflated);
+	auto data = std::make_shared<const std::vector<uint8_t>>(inflated.begin(), inflated.end());
+
+	if (m_cacheShardCapacity && data->size() <= m_cacheShardCapacity) {
+		const auto lock = std::lock_guard(shard.Mtx);
+		if (const auto it = shard.Entries.find(key); it != shard.Entries.end())
+			return it->second->Data;
+
+		shard.Lru.emplace_front(CacheEntry{ .Key = key, .Data = data });
+		shard.Entries.emplace(key, shard.Lru.begin());
+		shard.Size += data->size();
+		while (shard.Size > m_cacheShardCapacity) {
+			shard.Size -= shard.Lru.back().Data->size();
+			shard.Entries.erase(shard.Lru.back().Key);
+			shard.Lru.pop_back();
+		}
+	}
+
+	return data;
+}
+
+void Sqex::ZiPatch::PatchFileSet::ReadPart(const FilePart& part, uint64_t offset, std::span<uint8_t> buf) const {
+	if (offset > part.TargetSize || buf.size() > part.TargetSize - offset)
+		throw std::out_of_range("read past the end of part");
+
+	if (part.SourceIndex == FilePart::SourceIndex_Zeros) {
+		std::ranges::fill(buf, 0);
+
+	} else if (part.SourceIndex == FilePart::SourceIndex_EmptyBlock) {
+		uint8_t emptyBlock[256];
+		std::ranges::copy(part.MakeEmptyBlock(emptyBlock).subspan(static_cast<size_t>(offset), buf.size()), buf.begin());
+
+	} else if (part.SourceIsDeflated) {
+		const auto inflated = GetInflatedBlock(part.SourceIndex, part.SourceOffset, part.SourceSize);
+		if (part.SplitFrom + part.TargetSize > inflated->size())
+			throw CorruptDataException(std::format("block at {} of patch file #{} inflates to {} bytes, which is too short", part.SourceOffset, part.SourceIndex, inflated->size()));
+		std::copy_n(inflated->begin() + static_cast<ptrdiff_t>(part.SplitFrom + offset), buf.size(), buf.begin());
+
+	} else if (part.SourceIndex >= m_patchFiles.size()) {
+		throw std::out_of_range(std::format("patch file #{} does not exist", part.SourceIndex));
+
+	} else {
+		m_patchFiles[part.SourceIndex]->ReadStream(0ULL + part.SourceOffset + part.SplitFrom + offset, buf);
+	}
+}
+
+Sqex::ZiPatch::PatchedFileStream::PatchedFileStream(std::shared_ptr<const PatchFileSet> patchFileSet, FilePartMap parts)
+	: m_patchFileSet(std::move(patchFileSet))
+	, m_parts(std::move(parts)) {
+}
+
+uint64_t Sqex::ZiPatch::PatchedFileStream::StreamSize() const {
+	return m_parts.Size();
+}
+
+uint64_t Sqex::ZiPatch::PatchedFileStream::ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const {
+	const auto size = m_parts.Size();
+	if (offset >= size)
+		return 0;
+
+	auto out = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(std::min(length, size - offset)));
+	const auto read = out.size();
+	while (!out.empty()) {
+		const auto& part = *m_parts.Find(offset);
+		const auto relativeOffset = offset - part.TargetOffset;
+		const auto available = static_cast<size_t>(std::min<uint64_t>(out.size(), part.TargetSize - relativeOffset));
+		m_patchFileSet->ReadPart(part, relativeOffset, out.subspan(0, available));
+		out = out.subspan(available);
+		offset += available;
+	}
+	return read;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+
+#include "XivAlexanderCommon/Sqex/ZiPatch.h"
+
+namespace Sqex::ZiPatch {
+	/// \brief Patch files of a chain, from which target files can be read without extracting them.
+	///
+	/// Deflated blocks are inflated on the calling thread, and recently inflated ones are kept in a cache shared by
+	/// every stream reading from the same set.
+	class PatchFileSet {
+		struct CacheEntry {
+			uint64_t Key;
+			std::shared_ptr<const std::vector<uint8_t>> Data;
+		};
+
+		struct CacheShard {
+			std::mutex Mtx;
+			std::list<CacheEntry> Lru;
+			std::map<uint64_t, std::list<CacheEntry>::iterator> Entries;
+			size_t Size = 0;
+		};
+
+		const std::vector<std::shared_ptr<const RandomAccessStream>> m_patchFiles;
+		const size_t m_cacheShardCapacity;
+		const std::unique_ptr<CacheShard[]> m_cacheShards;
+
+	public:
+		static constexpr size_t CacheShardCount = 16;
+		static constexpr size_t DefaultCacheCapacity = 64 * 1048576;
+
+		/// \param patchFiles Patch files, in the order of FilePart::SourceIndex.
+		/// \param cacheCapacity Number of bytes of inflated blocks to keep.
+		PatchFileSet(std::vector<std::shared_ptr<const RandomAccessStream>> patchFiles, size_t cacheCapacity = DefaultCacheCapacity);
+		~PatchFileSet();
+
+		/// \returns Whole content of a deflated block, from cache if possible.
+		[[nodiscard]] std::shared_ptr<const std::vector<uint8_t>> GetInflatedBlock(uint32_t sourceIndex, uint32_t sourceOffset, uint32_t sourceSize) const;
+
+		/// \brief Reads data of part, beginning from offset relative to the beginning of the part.
+		void ReadPart(const FilePart& part, uint64_t offset, std::span<uint8_t> buf) const;
+	};
+
+	/// \brief Target file read from a PatchFileSet.
+	class PatchedFileStream : public RandomAccessStream {
+		const std::shared_ptr<const PatchFileSet> m_patchFileSet;
+		const FilePartMap m_parts;
+
+	public:
+		PatchedFileStream(std::shared_ptr<const PatchFileSet> patchFileSet, FilePartMap parts);
+
+		[[nodiscard]] uint64_t StreamSize() const override;
+		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override;
+	};
+}
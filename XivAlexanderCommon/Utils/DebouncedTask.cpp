@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/DebouncedTask.h"
+
+Utils::DebouncedTask::DebouncedTask(std::wstring name, std::function<void()> task, Clock::duration delay, Clock::duration maxDelay)
+	: m_name(std::move(name))
+	, m_task(std::move(task))
+	, m_delay(delay)
+	, m_maxDelay(std::max(delay, maxDelay)) {
+}
+
+Utils::DebouncedTask::~DebouncedTask() {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		m_stopping = true;
+	}
+	m_cv.notify_all();
+	if (m_thread)
+		m_thread.Wait();
+}
+
+void Utils::DebouncedTask::Schedule() {
+	{
+		const auto lock = std::lock_guard(m_mtx);
+		if (m_stopping)
+			return;
+
+		m_lastRequest = Clock::now();
+		if (!m_pending) {
+			m_pending = true;
+			m_firstRequest = m_lastRequest;
+		}
+
+		// The thread is only started once there is something to do.
+		if (!m_thread)
+			m_thread = Win32::Thread(m_name, [this]() { WorkerBody(); });
+	}
+	m_cv.notify_all();
+}
+
+void Utils::DebouncedTask::Flush() {
+	auto lock = std::unique_lock(m_mtx);
+	m_cv.wait(lock, [this]() { return !m_running; });
+	if (m_pending)
+		RunWhileLocked(lock);
+}
+
+void Utils::DebouncedTask::Run() {
+	auto lock = std::unique_lock(m_mtx);
+	m_cv.wait(lock, [this]() { return !m_running; });
+	RunWhileLocked(lock);
+}
+
+void Utils::DebouncedTask::Cancel() {
+	auto lock = std::unique_lock(m_mtx);
+	m_cv.wait(lock, [this]() { return !m_running; });
+	m_pending = false;
+}
+
+bool Utils::DebouncedTask::Pending() {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_pending;
+}
+
+size_t Utils::DebouncedTask::RunCount() {
+	const auto lock = std::lock_guard(m_mtx);
+	return m_runCount;
+}
+
+void Utils::DebouncedTask::WorkerBody() {
+	auto lock = std::unique_lock(m_mtx);
+	while (!m_stopping) {
+		if (!m_pending) {
+			m_cv.wait(lock);
+			continue;
+		}
+
+		const auto due = std::min(m_lastRequest + m_delay, m_firstRequest + m_maxDelay);
+		if (Clock::now() < due) {
+			m_cv.wait_until(lock, due);
+			continue;
+		}
+
+		if (m_running) {
+			m_cv.wait(lock);
+			continue;
+		}
+
+		try {
+			RunWhileLocked(lock);
+		} catch (...) {
+			// The task is responsible for reporting its own failures; nobody is waiting for this run.
+		}
+	}
+}
+
+void Utils::DebouncedTask::RunWhileLocked(std::unique_lock<std::mutex>& lock) {
+	m_pending = false;
+	m_running = true;
+	++m_runCount;
+	lock.unlock();
+
+	const auto release = CallOnDestruction([this, &lock]() {
+		lock.lock();
+		m_running = false;
+		m_cv.notify_all();
+	});
+	m_task();
+}
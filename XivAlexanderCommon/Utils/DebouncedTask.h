@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "XivAlexanderCommon/Utils/Win32/Handle.h"
+
+namespace Utils {
+	/// \brief Runs a task on a background thread once requests for it stop coming in for a while.
+	///
+	/// A burst of requests results in one run, which happens after delay has passed since the last request,
+	/// or after maxDelay has passed since the first request not yet served, whichever comes first.
+	/// Requests made while the task is running are served by another run after that one.
+	class DebouncedTask {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+	private:
+		const std::wstring m_name;
+		const std::function<void()> m_task;
+		const Clock::duration m_delay;
+		const Clock::duration m_maxDelay;
+
+		std::mutex m_mtx;
+		std::condition_variable m_cv;
+		bool m_pending = false;
+		bool m_running = false;
+		bool m_stopping = false;
+		Clock::time_point m_firstRequest;
+		Clock::time_point m_lastRequest;
+		size_t m_runCount = 0;
+
+		Win32::Thread m_thread;
+
+	public:
+		DebouncedTask(std::wstring name, std::function<void()> task, Clock::duration delay, Clock::duration maxDelay);
+		DebouncedTask(const DebouncedTask&) = delete;
+		DebouncedTask& operator=(const DebouncedTask&) = delete;
+
+		/// \brief Stops the background thread. A pending run is dropped; call Flush first to keep it.
+		~DebouncedTask();
+
+		/// \brief Requests the task to be run.
+		void Schedule();
+
+		/// \brief Runs the task from the current thread if a run is pending, after waiting for an ongoing run.
+		void Flush();
+
+		/// \brief Runs the task from the current thread, after waiting for an ongoing run; serves pending requests.
+		void Run();
+
+		/// \brief Drops a pending run, after waiting for an ongoing run.
+		void Cancel();
+
+		[[nodiscard]] bool Pending();
+
+		/// \returns Number of times the task has been run, from any thread.
+		[[nodiscard]] size_t RunCount();
+
+	private:
+		void WorkerBody();
+		void RunWhileLocked(std::unique_lock<std::mutex>& lock);
+	};
+}
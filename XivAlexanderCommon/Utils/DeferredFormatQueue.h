@@ -0,0 +1,368 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include "XivAlexanderCommon/Utils/StringUtils.h"
+
+namespace Utils {
+	/// \brief Format string that stays valid for as long as the program runs, such as a string literal.
+	/// \remarks Converts implicitly only from constant expressions, so that passing a string that may be freed before
+	/// the consumer gets to it, such as what() of an exception, fails to compile.
+	template<typename CharT>
+	class StaticFormatString {
+		struct AssumedTag {};
+
+		const CharT* m_format;
+
+		constexpr StaticFormatString(const CharT* format, AssumedTag)
+			: m_format(format) {
+		}
+
+	public:
+		consteval StaticFormatString(const CharT* format)
+			: m_format(format) {
+		}
+
+		/// \brief Wraps a format string that is not a constant expression, but is known to stay valid.
+		static constexpr StaticFormatString AssumeStatic(const CharT* format) {
+			return { format, AssumedTag{} };
+		}
+
+		[[nodiscard]] constexpr const CharT* Get() const {
+			return m_format;
+		}
+	};
+
+	/// \brief Bounded multi-producer single-consumer queue of messages, which get formatted by the consumer.
+	///
+	/// Each record takes two cache lines, holding a THeader, a pointer to the format string, which must stay valid until
+	/// the message is consumed, and the arguments captured by value.
+	/// Strings are copied into the same record after the arguments, so short ones do not allocate on the producer.
+	/// Arguments of other types may refer to memory the caller owns, so those messages, along with the ones that do
+	/// not fit in a record, get formatted by the producer instead. Messages are dropped and counted when full.
+	template<typename THeader>
+	class DeferredFormatQueue {
+	public:
+		static constexpr size_t RecordSize = 128;
+
+	private:
+		using MaterializeFunction = void(*)(std::byte* pStorage, std::string* pResult);
+
+		// If pResult is nullptr, Materialize only destroys what is in Storage.
+		struct RecordHead {
+			std::atomic_uint64_t Sequence;
+			MaterializeFunction Materialize;
+			THeader Header;
+		};
+
+		static constexpr size_t StorageOffset = (sizeof(RecordHead) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+	public:
+		static constexpr size_t StorageSize = RecordSize - StorageOffset;
+
+	private:
+		struct alignas(64) Record {
+			RecordHead Head;
+			alignas(std::max_align_t) std::byte Storage[StorageSize];
+		};
+		static_assert(sizeof(Record) == RecordSize);
+		static_assert(StorageSize <= UINT16_MAX);
+
+		// String stored in Storage from Offset, Length characters long, handed to the formatter as T.
+		template<typename T>
+		struct InlineString {
+			uint16_t Offset;
+			uint16_t Length;
+		};
+
+		// Maps argument types to the types handed to the formatter.
+		template<typename T, typename D = std::decay_t<T>>
+		using FormattedType = std::conditional_t<
+			std::is_same_v<D, const char*> || std::is_same_v<D, char*> || std::is_same_v<D, std::string_view>,
+			std::string,
+			std::conditional_t<
+				std::is_same_v<D, const wchar_t*> || std::is_same_v<D, wchar_t*> || std::is_same_v<D, std::wstring_view>,
+				std::wstring,
+				D>>;
+
+		template<typename T>
+		static constexpr bool IsString = std::is_same_v<T, std::string>
+			|| std::is_same_v<T, std::wstring>
+			|| std::is_same_v<T, std::filesystem::path>;
+
+		template<typename T>
+		static constexpr bool IsDeferrable = IsString<T>
+			|| std::is_arithmetic_v<T>
+			|| std::is_same_v<T, const void*>
+			|| std::is_same_v<T, void*>;
+
+		template<typename T, typename F = FormattedType<T>>
+		using CapturedType = std::conditional_t<IsString<F>, InlineString<F>, F>;
+
+		template<typename CharT>
+		static constexpr CharT MessageFormat[]{ '{', '}', 0 };
+
+		template<typename T>
+		static auto Characters(const T& value) {
+			using D = std::decay_t<T>;
+			if constexpr (std::is_pointer_v<D>)
+				return std::basic_string_view<std::remove_cvref_t<std::remove_pointer_t<D>>>(value);
+			else if constexpr (std::is_same_v<D, std::filesystem::path>)
+				return std::basic_string_view<std::filesystem::path::value_type>(value.native());
+			else
+				return std::basic_string_view<typename D::value_type>(value);
+		}
+
+		template<typename T>
+		static size_t InlineSize(const T& value) {
+			if constexpr (IsString<FormattedType<T>>) {
+				using CharT = typename decltype(Characters(value))::value_type;
+				return alignof(CharT) - 1 + Characters(value).size() * sizeof(CharT);
+			} else
+				return 0;
+		}
+
+		template<typename T>
+		static CapturedType<T> Capture(const T& value, std::byte* pStorage, size_t& offset) {
+			if constexpr (IsString<FormattedType<T>>) {
+				const auto chars = Characters(value);
+				using CharT = typename decltype(chars)::value_type;
+				offset = (offset + alignof(CharT) - 1) / alignof(CharT) * alignof(CharT);
+				const auto result = CapturedType<T>{ static_cast<uint16_t>(offset), static_cast<uint16_t>(chars.size()) };
+				std::memcpy(pStorage + offset, chars.data(), chars.size() * sizeof(CharT));
+				offset += chars.size() * sizeof(CharT);
+				return result;
+			} else
+				return value;
+		}
+
+		template<typename T>
+		static const T& Restore(const T& value, const std::byte*) {
+			return value;
+		}
+
+		template<typename T>
+		static T Restore(const InlineString<T>& value, const std::byte* pStorage) {
+			const auto p = reinterpret_cast<const typename T::value_type*>(pStorage + value.Offset);
+			return T(p, p + value.Length);
+		}
+
+		template<typename CharT, typename ... Ts>
+		static std::string FormatToString(const CharT* format, const Ts&... args) {
+			if constexpr (std::is_same_v<CharT, wchar_t>)
+				return ToUtf8(std::vformat(format, std::make_wformat_args(args...)));
+			else
+				return std::vformat(format, std::make_format_args(args...));
+		}
+
+		template<typename CharT, typename ... Ts>
+		struct DeferredFormat {
+			const CharT* Format;
+			std::tuple<Ts...> Arguments;
+
+			static void Materialize(std::byte* pStorage, std::string* pResult) {
+				auto& self = *reinterpret_cast<DeferredFormat*>(pStorage);
+				if (pResult) {
+					try {
+						*pResult = std::apply([&](const auto&... args) {
+							return FormatToString(self.Format, Restore(args, pStorage)...);
+						}, self.Arguments);
+					} catch (const std::exception& e) {
+						*pResult = std::format("Failed to format message: {}", e.what());
+					}
+				}
+				self.~DeferredFormat();
+			}
+		};
+
+		template<typename CharT>
+		struct StoredMessage {
+			std::basic_string<CharT> Message;
+
+			static void Materialize(std::byte* pStorage, std::string* pResult) {
+				auto& self = *reinterpret_cast<StoredMessage*>(pStorage);
+				if (pResult) {
+					try {
+						if constexpr (std::is_same_v<CharT, wchar_t>)
+							*pResult = ToUtf8(self.Message);
+						else
+							*pResult = std::move(self.Message);
+					} catch (const std::exception& e) {
+						*pResult = std::format("Failed to convert message: {}", e.what());
+					}
+				}
+				self.~StoredMessage();
+			}
+		};
+
+		const size_t m_capacity;
+		const std::unique_ptr<Record[]> m_records;
+		std::atomic_uint64_t m_enqueuePosition = 0;
+		std::atomic_uint64_t m_droppedCount = 0;
+		uint64_t m_dequeuePosition = 0;
+
+	public:
+		/// \param capacity Number of records, which must be a power of 2.
+		explicit DeferredFormatQueue(size_t capacity)
+			: m_capacity(capacity)
+			, m_records(std::make_unique<Record[]>(capacity)) {
+			if (!capacity || (capacity & (capacity - 1)))
+				throw std::invalid_argument("capacity must be a power of 2");
+			for (size_t i = 0; i < capacity; ++i)
+				m_records[i].Head.Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		DeferredFormatQueue(DeferredFormatQueue&&) = delete;
+		DeferredFormatQueue(const DeferredFormatQueue&) = delete;
+		DeferredFormatQueue& operator=(DeferredFormatQueue&&) = delete;
+		DeferredFormatQueue& operator=(const DeferredFormatQueue&) = delete;
+
+		~DeferredFormatQueue() {
+			Discard();
+		}
+
+		/// \brief Queues a message to be formatted from format and args by the consumer.
+		/// \remarks Text that is not known until run time goes in args, as in Push(header, "{}", e.what()).
+		/// \returns false if the queue was full.
+		template<typename ... Args>
+		bool Push(const THeader& header, StaticFormatString<char> format, const Args&... args) {
+			return PushFormat(header, format.Get(), args...);
+		}
+
+		template<typename ... Args>
+		bool Push(const THeader& header, StaticFormatString<wchar_t> format, const Args&... args) {
+			return PushFormat(header, format.Get(), args...);
+		}
+
+		/// \brief Queues a message as is.
+		/// \returns false if the queue was full.
+		template<typename CharT>
+		bool PushMessage(const THeader& header, std::basic_string_view<CharT> message) {
+			if (const auto queued = TryPushDeferred(header, MessageFormat<CharT>, message))
+				return *queued;
+			return PushStored(header, std::basic_string<CharT>(message));
+		}
+
+		template<typename CharT>
+		bool PushMessage(const THeader& header, std::basic_string<CharT>&& message) {
+			if (const auto queued = TryPushDeferred(header, MessageFormat<CharT>, std::basic_string_view<CharT>(message)))
+				return *queued;
+			return PushStored(header, std::move(message));
+		}
+
+		/// \brief Formats and removes queued messages in order, calling cb(const THeader&, std::string) for each.
+		/// \remarks Only one thread may consume at a time.
+		template<typename Fn>
+		void Consume(const Fn& cb) {
+			while (true) {
+				auto& record = m_records[m_dequeuePosition & (m_capacity - 1)];
+				if (record.Head.Sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1)
+					break;
+
+				std::string message;
+				record.Head.Materialize(record.Storage, &message);
+				const auto header = record.Head.Header;
+				record.Head.Sequence.store(m_dequeuePosition + m_capacity, std::memory_order_release);
+				++m_dequeuePosition;
+
+				cb(header, std::move(message));
+			}
+		}
+
+		/// \brief Removes queued messages without formatting them, and resets the dropped message count.
+		/// \remarks Only one thread may consume at a time.
+		void Discard() {
+			while (true) {
+				auto& record = m_records[m_dequeuePosition & (m_capacity - 1)];
+				if (record.Head.Sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1)
+					break;
+
+				record.Head.Materialize(record.Storage, nullptr);
+				record.Head.Sequence.store(m_dequeuePosition + m_capacity, std::memory_order_release);
+				++m_dequeuePosition;
+			}
+			m_droppedCount = 0;
+		}
+
+		/// \remarks Only one thread may consume at a time.
+		[[nodiscard]] bool HasPending() const {
+			return m_records[m_dequeuePosition & (m_capacity - 1)].Head.Sequence.load(std::memory_order_acquire) == m_dequeuePosition + 1;
+		}
+
+		/// \brief Returns the number of messages dropped since the last call, as the queue was full.
+		[[nodiscard]] uint64_t TakeDroppedCount() {
+			return m_droppedCount.exchange(0);
+		}
+
+	private:
+		// Returns nullptr if the queue is full.
+		Record* Claim() {
+			auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+			while (true) {
+				auto& record = m_records[position & (m_capacity - 1)];
+				const auto diff = static_cast<int64_t>(record.Head.Sequence.load(std::memory_order_acquire) - position);
+				if (diff == 0) {
+					if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+						return &record;
+				} else if (diff < 0) {
+					m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+					return nullptr;
+				} else
+					position = m_enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		void Publish(Record& record, const THeader& header, MaterializeFunction materialize) {
+			record.Head.Header = header;
+			record.Head.Materialize = materialize;
+			record.Head.Sequence.store(record.Head.Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		template<typename CharT, typename ... Args>
+		bool PushFormat(const THeader& header, const CharT* format, const Args&... args) {
+			if (const auto queued = TryPushDeferred(header, format, args...))
+				return *queued;
+			if constexpr (std::is_same_v<CharT, wchar_t>)
+				return PushStored(header, std::vformat(format, std::make_wformat_args(args...)));
+			else
+				return PushStored(header, std::vformat(format, std::make_format_args(args...)));
+		}
+
+		// Returns whether the message has been queued, or nothing if it cannot be deferred.
+		// format must stay valid until the message is consumed.
+		template<typename CharT, typename ... Args>
+		std::optional<bool> TryPushDeferred(const THeader& header, const CharT* format, const Args&... args) {
+			using Deferred = DeferredFormat<CharT, CapturedType<Args>...>;
+			if constexpr (sizeof(Deferred) <= StorageSize && (IsDeferrable<FormattedType<Args>> && ...)) {
+				if (sizeof(Deferred) + (InlineSize(args) + ... + size_t()) > StorageSize)
+					return std::nullopt;
+
+				const auto pRecord = Claim();
+				if (!pRecord)
+					return false;
+				auto offset = sizeof(Deferred);
+				new(pRecord->Storage) Deferred{ format, { Capture(args, pRecord->Storage, offset)... } };
+				Publish(*pRecord, header, &Deferred::Materialize);
+				return true;
+			} else
+				return std::nullopt;
+		}
+
+		template<typename CharT>
+		bool PushStored(const THeader& header, std::basic_string<CharT> message) {
+			static_assert(sizeof(StoredMessage<CharT>) <= StorageSize);
+			const auto pRecord = Claim();
+			if (!pRecord)
+				return false;
+			new(pRecord->Storage) StoredMessage<CharT>{ std::move(message) };
+			Publish(*pRecord, header, &StoredMessage<CharT>::Materialize);
+			return true;
+		}
+	};
+}
@@ -0,0 +1,663 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/DxtDecoder.h"
+
+#include <intrin.h>
+
+// Palettes are computed in scalar code, using the same arithmetic as DecompressBlockDXT1 and DecompressBlockDXT5;
+// vector code only expands per-pixel indices into palette entries, so every implementation produces identical pixels.
+
+// Same layout as Sqex::Texture::RGBA8888: R in the lowest byte, and A in the highest byte.
+static constexpr uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+static uint16_t LoadU16(const uint8_t* p) {
+	uint16_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static uint32_t LoadU32(const uint8_t* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static uint64_t LoadU48(const uint8_t* p) {
+	return static_cast<uint64_t>(LoadU16(p)) | static_cast<uint64_t>(LoadU32(p + 2)) << 16;
+}
+
+// Colors have alpha set to `alpha`; BC1 uses 255, and BC2/BC3 use 0 so that alpha can be combined afterwards.
+// The fourth color of three color mode, which only BC1 has, is transparent black.
+static void MakeColorPalette(const uint8_t* block, bool allowThreeColorMode, uint32_t alpha, uint32_t(&palette)[4]) {
+	const auto color0 = LoadU16(block);
+	const auto color1 = LoadU16(block + 2);
+
+	uint32_t temp;
+	temp = (color0 >> 11) * 255 + 16;
+	const auto r0 = (temp / 32 + temp) / 32;
+	temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
+	const auto g0 = (temp / 64 + temp) / 64;
+	temp = (color0 & 0x001F) * 255 + 16;
+	const auto b0 = (temp / 32 + temp) / 32;
+
+	temp = (color1 >> 11) * 255 + 16;
+	const auto r1 = (temp / 32 + temp) / 32;
+	temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
+	const auto g1 = (temp / 64 + temp) / 64;
+	temp = (color1 & 0x001F) * 255 + 16;
+	const auto b1 = (temp / 32 + temp) / 32;
+
+	palette[0] = PackRGBA(r0, g0, b0, alpha);
+	palette[1] = PackRGBA(r1, g1, b1, alpha);
+	if (!allowThreeColorMode || color0 > color1) {
+		palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, alpha);
+		palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, alpha);
+	} else {
+		palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, alpha);
+		palette[3] = PackRGBA(0, 0, 0, 0);
+	}
+}
+
+// Entries are already shifted into the alpha channel, so that they can be combined with colors using OR.
+static void MakeAlphaPalette(const uint8_t* block, uint32_t(&palette)[8]) {
+	const uint32_t alpha0 = block[0];
+	const uint32_t alpha1 = block[1];
+	palette[0] = PackRGBA(0, 0, 0, alpha0);
+	palette[1] = PackRGBA(0, 0, 0, alpha1);
+	if (alpha0 > alpha1) {
+		for (uint32_t i = 2; i < 8; ++i)
+			palette[i] = PackRGBA(0, 0, 0, ((8 - i) * alpha0 + (i - 1) * alpha1) / 7);
+	} else {
+		for (uint32_t i = 2; i < 6; ++i)
+			palette[i] = PackRGBA(0, 0, 0, ((6 - i) * alpha0 + (i - 1) * alpha1) / 5);
+		palette[6] = PackRGBA(0, 0, 0, 0);
+		palette[7] = PackRGBA(0, 0, 0, 255);
+	}
+}
+
+struct ScalarBlockDecoder {
+	static void DXT1(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t palette[4];
+		MakeColorPalette(block, true, 255, palette);
+		const auto code = LoadU32(block + 4);
+		for (size_t j = 0; j < 4; ++j)
+			for (size_t i = 0; i < 4; ++i)
+				dst[j * stride + i] = palette[(code >> (2 * (4 * j + i))) & 3];
+	}
+
+	static void DXT3(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t palette[4];
+		MakeColorPalette(block + 8, false, 0, palette);
+		const auto code = LoadU32(block + 12);
+		for (size_t j = 0; j < 4; ++j) {
+			const auto alphaRow = LoadU16(block + 2 * j);
+			for (size_t i = 0; i < 4; ++i)
+				dst[j * stride + i] = palette[(code >> (2 * (4 * j + i))) & 3] | PackRGBA(0, 0, 0, 17 * ((alphaRow >> (4 * i)) & 0xF));
+		}
+	}
+
+	static void DXT5(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t alphaPalette[8];
+		MakeAlphaPalette(block, alphaPalette);
+		const auto alphaCode = LoadU48(block + 2);
+		uint32_t palette[4];
+		MakeColorPalette(block + 8, false, 0, palette);
+		const auto code = LoadU32(block + 12);
+		for (size_t j = 0; j < 4; ++j)
+			for (size_t i = 0; i < 4; ++i)
+				dst[j * stride + i] = palette[(code >> (2 * (4 * j + i))) & 3] | alphaPalette[(alphaCode >> (3 * (4 * j + i))) & 7];
+	}
+};
+
+struct Sse2BlockDecoder {
+	static __m128i Select(__m128i mask, __m128i ifSet, __m128i ifUnset) {
+		return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifUnset));
+	}
+
+	// Looks up 4 pixels of a row, whose 2-bit indices are in the lowest 8 bits of rowCode.
+	static __m128i LookupColorRow(const uint32_t(&palette)[4], uint32_t rowCode) {
+		const auto bit0 = _mm_setr_epi32(1 << 0, 1 << 2, 1 << 4, 1 << 6);
+		const auto bit1 = _mm_slli_epi32(bit0, 1);
+		const auto code = _mm_set1_epi32(static_cast<int>(rowCode));
+		const auto isOdd = _mm_cmpeq_epi32(_mm_and_si128(code, bit0), bit0);
+		const auto isHigh = _mm_cmpeq_epi32(_mm_and_si128(code, bit1), bit1);
+		const auto low = Select(isOdd, _mm_set1_epi32(static_cast<int>(palette[1])), _mm_set1_epi32(static_cast<int>(palette[0])));
+		const auto high = Select(isOdd, _mm_set1_epi32(static_cast<int>(palette[3])), _mm_set1_epi32(static_cast<int>(palette[2])));
+		return Select(isHigh, high, low);
+	}
+
+	static void DXT1(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t palette[4];
+		MakeColorPalette(block, true, 255, palette);
+		const auto code = LoadU32(block + 4);
+		for (size_t j = 0; j < 4; ++j)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j * stride), LookupColorRow(palette, code >> (8 * j)));
+	}
+
+	static void DXT3(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t palette[4];
+		MakeColorPalette(block + 8, false, 0, palette);
+		const auto code = LoadU32(block + 12);
+
+		// Move each nibble to bits 12~15 of its lane using 16-bit multiplication, and then into bits 24~27.
+		const auto nibbleMask = _mm_setr_epi32(0x000F, 0x00F0, 0x0F00, 0xF000);
+		const auto nibbleAlign = _mm_setr_epi32(0x1000, 0x0100, 0x0010, 0x0001);
+		for (size_t j = 0; j < 4; ++j) {
+			const auto alphaRow = _mm_and_si128(_mm_set1_epi32(LoadU16(block + 2 * j)), nibbleMask);
+			const auto nibbles = _mm_slli_epi32(_mm_mullo_epi16(alphaRow, nibbleAlign), 12);
+			const auto alpha = _mm_or_si128(_mm_slli_epi32(nibbles, 4), nibbles);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j * stride), _mm_or_si128(LookupColorRow(palette, code >> (8 * j)), alpha));
+		}
+	}
+
+	static void DXT5(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t alphaPalette[8];
+		MakeAlphaPalette(block, alphaPalette);
+		const auto alphaCode = LoadU48(block + 2);
+		uint32_t palette[4];
+		MakeColorPalette(block + 8, false, 0, palette);
+		const auto code = LoadU32(block + 12);
+		for (size_t j = 0; j < 4; ++j) {
+			const auto rowAlphaCode = static_cast<uint32_t>(alphaCode >> (12 * j));
+			const auto alpha = _mm_setr_epi32(
+				static_cast<int>(alphaPalette[rowAlphaCode & 7]),
+				static_cast<int>(alphaPalette[(rowAlphaCode >> 3) & 7]),
+				static_cast<int>(alphaPalette[(rowAlphaCode >> 6) & 7]),
+				static_cast<int>(alphaPalette[(rowAlphaCode >> 9) & 7]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j * stride), _mm_or_si128(LookupColorRow(palette, code >> (8 * j)), alpha));
+		}
+	}
+};
+
+struct Avx2BlockDecoder {
+	// Stores 8 pixels into two consecutive rows of a block.
+	static void StoreRowPair(uint32_t* dst, size_t stride, __m256i pixels) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(pixels));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + stride), _mm256_extracti128_si256(pixels, 1));
+	}
+
+	// Looks up 8 pixels, whose 2-bit indices are in the lowest 16 bits of code.
+	static __m256i LookupColorRowPair(__m256i palette, uint32_t code) {
+		const auto shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+		const auto index = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(code)), shifts), _mm256_set1_epi32(3));
+		return _mm256_permutevar8x32_epi32(palette, index);
+	}
+
+	static __m256i BroadcastPalette(const uint32_t(&palette)[4]) {
+		return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(palette)));
+	}
+
+	static void DXT1(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t palette[4];
+		MakeColorPalette(block, true, 255, palette);
+		const auto colors = BroadcastPalette(palette);
+		const auto code = LoadU32(block + 4);
+		StoreRowPair(dst, stride, LookupColorRowPair(colors, code));
+		StoreRowPair(dst + 2 * stride, stride, LookupColorRowPair(colors, code >> 16));
+	}
+
+	static void DXT3(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t palette[4];
+		MakeColorPalette(block + 8, false, 0, palette);
+		const auto colors = BroadcastPalette(palette);
+		const auto code = LoadU32(block + 12);
+
+		const auto shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+		const auto nibbleMask = _mm256_set1_epi32(0xF);
+		for (size_t j = 0; j < 4; j += 2) {
+			const auto alphaCode = _mm256_set1_epi32(static_cast<int>(LoadU32(block + 2 * j)));
+			const auto nibbles = _mm256_slli_epi32(_mm256_and_si256(_mm256_srlv_epi32(alphaCode, shifts), nibbleMask), 24);
+			const auto alpha = _mm256_or_si256(_mm256_slli_epi32(nibbles, 4), nibbles);
+			StoreRowPair(dst + j * stride, stride, _mm256_or_si256(LookupColorRowPair(colors, code >> (8 * j)), alpha));
+		}
+	}
+
+	static void DXT5(const uint8_t* block, uint32_t* dst, size_t stride) {
+		uint32_t alphaPalette[8];
+		MakeAlphaPalette(block, alphaPalette);
+		const auto alphas = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(alphaPalette));
+		const auto alphaCode = LoadU48(block + 2);
+		uint32_t palette[4];
+		MakeColorPalette(block + 8, false, 0, palette);
+		const auto colors = BroadcastPalette(palette);
+		const auto code = LoadU32(block + 12);
+
+		const auto shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		const auto indexMask = _mm256_set1_epi32(7);
+		for (size_t j = 0; j < 4; j += 2) {
+			const auto rowAlphaCode = _mm256_set1_epi32(static_cast<int>(alphaCode >> (12 * j)));
+			const auto alpha = _mm256_permutevar8x32_epi32(alphas, _mm256_and_si256(_mm256_srlv_epi32(rowAlphaCode, shifts), indexMask));
+			StoreRowPair(dst + j * stride, stride, _mm256_or_si256(LookupColorRowPair(colors, code >> (8 * j)), alpha));
+		}
+	}
+};
+
+struct Bc7BlockDecoder {
+	struct ModeInfo {
+		uint8_t SubsetCount;
+		uint8_t PartitionBits;
+		uint8_t RotationBits;
+		uint8_t IndexSelectionBits;
+		uint8_t ColorBits;
+		uint8_t AlphaBits;
+		uint8_t EndpointPBits;
+		uint8_t SharedPBits;
+		uint8_t IndexBits;
+		uint8_t SecondaryIndexBits;
+	};
+
+	static constexpr ModeInfo Modes[8]{
+		{3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+		{2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+		{3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+		{2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+		{1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+		{1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+		{1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+		{2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+	};
+
+	static constexpr int Weights2[4]{0, 21, 43, 64};
+	static constexpr int Weights3[8]{0, 9, 18, 27, 37, 46, 55, 64};
+	static constexpr int Weights4[16]{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+	// Subset of each pixel, for each partition of 2 subsets.
+	static constexpr uint8_t Partitions2[64][16]{
+		{0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1},
+		{0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1},
+		{0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1},
+		{0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1},
+		{0, 0, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1},
+		{0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1},
+		{0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1},
+		{0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1},
+		{0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0},
+		{0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0},
+		{0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0},
+		{0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0},
+		{0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0},
+		{0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0},
+		{0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1},
+		{0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0},
+		{0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0},
+		{0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0},
+		{0, 0, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0, 0},
+		{0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0},
+		{0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0},
+		{0, 1, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 1, 0},
+		{0, 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0},
+		{0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1},
+		{0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1},
+		{0, 1, 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 0},
+		{0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0},
+		{0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0},
+		{0, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0},
+		{0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 0, 0, 1},
+		{0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1},
+		{0, 1, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 1, 0},
+		{0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0},
+		{0, 0, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 0, 0},
+		{0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 0, 1, 1, 1, 0, 0},
+		{0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0},
+		{0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 1},
+		{0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1},
+		{0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0},
+		{0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0},
+		{0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0},
+		{0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0},
+		{0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0},
+		{0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1},
+		{0, 0, 1, 1, 0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1},
+		{0, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 0},
+		{0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 0, 0, 1, 1, 0},
+		{0, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 0, 0, 1},
+		{0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0, 1},
+		{0, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1},
+		{0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1},
+		{0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1},
+		{0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0},
+		{0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0},
+		{0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1},
+	};
+
+	// Subset of each pixel, for each partition of 3 subsets.
+	static constexpr uint8_t Partitions3[64][16]{
+		{0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+		{0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+		{0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+		{0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+		{0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+		{0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+		{0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+		{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+		{0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+		{0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+		{0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+		{0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+		{0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+		{0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+		{0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+		{0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+		{0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+		{0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+		{0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+		{0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+		{0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+		{0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+		{0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+		{0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+		{0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+		{0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+		{0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+		{0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+		{0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+		{0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+		{0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+		{0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+		{0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+		{0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+		{0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+		{0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+		{0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+		{0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+		{0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+		{0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+		{0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+		{0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+		{0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+		{0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+		{0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+		{0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+		{0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+		{0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+		{0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+		{0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+		{0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+		{0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+		{0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+		{0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+		{0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+		{0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+		{0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+		{0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+		{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+		{0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+		{0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+		{0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+		{0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+	};
+
+	// Index of the pixel whose index omits its highest bit, for the second subset of each partition of 2 subsets.
+	static constexpr uint8_t Anchors2[64]{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+		15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+		6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+	};
+
+	// Same as Anchors2, for the second and the third subsets of each partition of 3 subsets.
+	static constexpr uint8_t Anchors3[64][2]{
+		{3, 15}, {3, 8}, {15, 8}, {15, 3}, {8, 15}, {3, 15}, {15, 3}, {15, 8},
+		{8, 15}, {8, 15}, {6, 15}, {6, 15}, {6, 15}, {5, 15}, {3, 15}, {3, 8},
+		{3, 15}, {3, 8}, {8, 15}, {15, 3}, {3, 15}, {3, 8}, {6, 15}, {10, 8},
+		{5, 3}, {8, 15}, {8, 6}, {6, 10}, {8, 15}, {5, 15}, {15, 10}, {15, 8},
+		{8, 15}, {15, 3}, {3, 15}, {5, 10}, {6, 10}, {10, 8}, {8, 9}, {15, 10},
+		{15, 6}, {3, 15}, {15, 8}, {5, 15}, {15, 3}, {15, 6}, {15, 6}, {15, 8},
+		{3, 15}, {15, 3}, {5, 15}, {5, 15}, {5, 15}, {8, 15}, {5, 15}, {10, 15},
+		{5, 15}, {10, 15}, {8, 15}, {13, 15}, {15, 3}, {12, 15}, {3, 15}, {3, 8},
+	};
+
+	class BitReader {
+		uint64_t m_low;
+		uint64_t m_high;
+		uint32_t m_offset = 0;
+
+	public:
+		BitReader(const uint8_t* block) {
+			memcpy(&m_low, block, sizeof m_low);
+			memcpy(&m_high, block + 8, sizeof m_high);
+		}
+
+		uint32_t Read(uint32_t bitCount) {
+			uint64_t res;
+			if (m_offset >= 64)
+				res = m_high >> (m_offset - 64);
+			else if (m_offset == 0)
+				res = m_low;
+			else
+				res = (m_low >> m_offset) | (m_high << (64 - m_offset));
+			m_offset += bitCount;
+			return static_cast<uint32_t>(res) & ((1U << bitCount) - 1);
+		}
+	};
+
+	static int Expand(uint32_t value, uint32_t bitCount) {
+		value <<= 8 - bitCount;
+		return static_cast<int>(value | (value >> bitCount));
+	}
+
+	static int Interpolate(int e0, int e1, int weight) {
+		return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+	}
+
+	static const int* Weights(uint32_t indexBits) {
+		return indexBits == 2 ? Weights2 : indexBits == 3 ? Weights3 : Weights4;
+	}
+
+	static void DecodeBlock(const uint8_t* block, uint32_t* dst, size_t stride) {
+		auto reader = BitReader(block);
+		uint32_t modeIndex = 0;
+		while (modeIndex < 8 && !reader.Read(1))
+			++modeIndex;
+
+		// Reserved mode; decodes into transparent black.
+		if (modeIndex == 8) {
+			for (size_t i = 0; i < 16; ++i)
+				dst[i / 4 * stride + i % 4] = 0;
+			return;
+		}
+
+		const auto& mode = Modes[modeIndex];
+		const auto partition = reader.Read(mode.PartitionBits);
+		const auto rotation = reader.Read(mode.RotationBits);
+		const auto indexSelection = reader.Read(mode.IndexSelectionBits);
+
+		// [subset * 2 + endpoint][R, G, B, A], before expanding into 8 bits.
+		uint32_t endpoints[6][4];
+		const auto endpointCount = 2U * mode.SubsetCount;
+		for (size_t c = 0; c < 3; ++c)
+			for (size_t e = 0; e < endpointCount; ++e)
+				endpoints[e][c] = reader.Read(mode.ColorBits);
+		for (size_t e = 0; e < endpointCount; ++e)
+			endpoints[e][3] = mode.AlphaBits ? reader.Read(mode.AlphaBits) : 255;
+
+		auto colorBits = static_cast<uint32_t>(mode.ColorBits), alphaBits = static_cast<uint32_t>(mode.AlphaBits);
+		if (mode.EndpointPBits || mode.SharedPBits) {
+			for (size_t e = 0; e < endpointCount; ++e) {
+				const auto pBit = mode.EndpointPBits || e % 2 == 0 ? reader.Read(1) : endpoints[e - 1][0] & 1;
+				for (size_t c = 0; c < (mode.AlphaBits ? 4U : 3U); ++c)
+					endpoints[e][c] = endpoints[e][c] << 1 | pBit;
+			}
+			++colorBits;
+			if (alphaBits)
+				++alphaBits;
+		}
+
+		int expanded[6][4];
+		for (size_t e = 0; e < endpointCount; ++e) {
+			for (size_t c = 0; c < 3; ++c)
+				expanded[e][c] = Expand(endpoints[e][c], colorBits);
+			expanded[e][3] = alphaBits ? Expand(endpoints[e][3], alphaBits) : 255;
+		}
+
+		const auto subsets = mode.SubsetCount == 2 ? Partitions2[partition] : mode.SubsetCount == 3 ? Partitions3[partition] : nullptr;
+		const auto isAnchor = [&](size_t i) {
+			switch (mode.SubsetCount) {
+				case 2:
+					return i == 0 || i == Anchors2[partition];
+				case 3:
+					return i == 0 || i == Anchors3[partition][0] || i == Anchors3[partition][1];
+				default:
+					return i == 0;
+			}
+		};
+
+		uint32_t indices[16], secondaryIndices[16];
+		for (size_t i = 0; i < 16; ++i)
+			indices[i] = reader.Read(isAnchor(i) ? mode.IndexBits - 1U : mode.IndexBits);
+		if (mode.SecondaryIndexBits) {
+			for (size_t i = 0; i < 16; ++i)
+				secondaryIndices[i] = reader.Read(i == 0 ? mode.SecondaryIndexBits - 1U : mode.SecondaryIndexBits);
+		}
+
+		for (size_t i = 0; i < 16; ++i) {
+			const auto& e0 = expanded[subsets ? 2 * subsets[i] : 0];
+			const auto& e1 = expanded[subsets ? 2 * subsets[i] + 1 : 1];
+
+			int c[4];
+			if (mode.SecondaryIndexBits) {
+				const auto colorIndex = indexSelection ? secondaryIndices[i] : indices[i];
+				const auto alphaIndex = indexSelection ? indices[i] : secondaryIndices[i];
+				const auto colorWeights = Weights(indexSelection ? mode.SecondaryIndexBits : mode.IndexBits);
+				const auto alphaWeights = Weights(indexSelection ? mode.IndexBits : mode.SecondaryIndexBits);
+				for (size_t ch = 0; ch < 3; ++ch)
+					c[ch] = Interpolate(e0[ch], e1[ch], colorWeights[colorIndex]);
+				c[3] = Interpolate(e0[3], e1[3], alphaWeights[alphaIndex]);
+			} else {
+				const auto weights = Weights(mode.IndexBits);
+				for (size_t ch = 0; ch < 4; ++ch)
+					c[ch] = Interpolate(e0[ch], e1[ch], weights[indices[i]]);
+			}
+			if (rotation)
+				std::swap(c[3], c[rotation - 1]);
+			dst[i / 4 * stride + i % 4] = PackRGBA(c[0], c[1], c[2], c[3]);
+		}
+	}
+};
+
+template<size_t BlockSize, void(*DecodeBlock)(const uint8_t*, uint32_t*, size_t)>
+static void DecompressBlockRows(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image) {
+	const auto blockCountX = (width + 3) / 4;
+	for (auto by = blockRowFrom; by < blockRowTo; ++by) {
+		const auto y = by * 4;
+		const auto rows = std::min<uint32_t>(4, height - y);
+		auto block = blockStorage + static_cast<size_t>(by) * blockCountX * BlockSize;
+		for (uint32_t x = 0; x < width; x += 4, block += BlockSize) {
+			const auto dst = &image[static_cast<size_t>(y) * width + x];
+			if (rows == 4 && x + 4 <= width) {
+				DecodeBlock(block, dst, width);
+			} else {
+				uint32_t buf[16];
+				DecodeBlock(block, buf, 4);
+				const auto cols = std::min<uint32_t>(4, width - x);
+				for (uint32_t j = 0; j < rows; ++j)
+					std::copy_n(&buf[j * 4], cols, &dst[static_cast<size_t>(j) * width]);
+			}
+		}
+	}
+}
+
+static bool IsAvx2Supported() {
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// AVX, and OSXSAVE: OS has to save YMM registers on context switches.
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+Utils::DxtDecoderIsa Utils::ResolveDxtDecoderIsa(DxtDecoderIsa preferred) {
+	static const auto Sse2Supported = !!IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+	static const auto Avx2Supported = Sse2Supported && IsAvx2Supported();
+
+	switch (preferred) {
+		case DxtDecoderIsa::Scalar:
+			return DxtDecoderIsa::Scalar;
+		case DxtDecoderIsa::Sse2:
+			if (Sse2Supported)
+				return DxtDecoderIsa::Sse2;
+			break;
+		case DxtDecoderIsa::Avx2:
+			if (Avx2Supported)
+				return DxtDecoderIsa::Avx2;
+			break;
+		default:
+			break;
+	}
+	if (Avx2Supported)
+		return DxtDecoderIsa::Avx2;
+	if (Sse2Supported)
+		return DxtDecoderIsa::Sse2;
+	return DxtDecoderIsa::Scalar;
+}
+
+const char* Utils::DxtDecoderIsaName(DxtDecoderIsa isa) {
+	switch (isa) {
+		case DxtDecoderIsa::Auto:
+			return "Auto";
+		case DxtDecoderIsa::Scalar:
+			return "Scalar";
+		case DxtDecoderIsa::Sse2:
+			return "SSE2";
+		case DxtDecoderIsa::Avx2:
+			return "AVX2";
+		default:
+			return "Unknown";
+	}
+}
+
+void Utils::DecompressBlockRowsDXT1(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image, DxtDecoderIsa isa) {
+	switch (ResolveDxtDecoderIsa(isa)) {
+		case DxtDecoderIsa::Avx2:
+			return DecompressBlockRows<8, Avx2BlockDecoder::DXT1>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+		case DxtDecoderIsa::Sse2:
+			return DecompressBlockRows<8, Sse2BlockDecoder::DXT1>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+		default:
+			return DecompressBlockRows<8, ScalarBlockDecoder::DXT1>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+	}
+}
+
+void Utils::DecompressBlockRowsDXT3(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image, DxtDecoderIsa isa) {
+	switch (ResolveDxtDecoderIsa(isa)) {
+		case DxtDecoderIsa::Avx2:
+			return DecompressBlockRows<16, Avx2BlockDecoder::DXT3>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+		case DxtDecoderIsa::Sse2:
+			return DecompressBlockRows<16, Sse2BlockDecoder::DXT3>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+		default:
+			return DecompressBlockRows<16, ScalarBlockDecoder::DXT3>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+	}
+}
+
+void Utils::DecompressBlockRowsDXT5(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image, DxtDecoderIsa isa) {
+	switch (ResolveDxtDecoderIsa(isa)) {
+		case DxtDecoderIsa::Avx2:
+			return DecompressBlockRows<16, Avx2BlockDecoder::DXT5>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+		case DxtDecoderIsa::Sse2:
+			return DecompressBlockRows<16, Sse2BlockDecoder::DXT5>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+		default:
+			return DecompressBlockRows<16, ScalarBlockDecoder::DXT5>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+	}
+}
+
+void Utils::DecompressBlockRowsBC7(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image) {
+	DecompressBlockRows<16, Bc7BlockDecoder::DecodeBlock>(width, height, blockRowFrom, blockRowTo, blockStorage, image);
+}
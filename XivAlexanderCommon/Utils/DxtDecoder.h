@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utils {
+	enum class DxtDecoderIsa : uint8_t {
+		Auto,
+		Scalar,
+		Sse2,
+		Avx2,
+	};
+
+	/// \brief Resolves which instruction set will be used for decoding.
+	/// \returns preferred if the processor supports it; otherwise, the best supported instruction set.
+	[[nodiscard]] DxtDecoderIsa ResolveDxtDecoderIsa(DxtDecoderIsa preferred = DxtDecoderIsa::Auto);
+
+	[[nodiscard]] const char* DxtDecoderIsaName(DxtDecoderIsa isa);
+
+	// Decodes block rows [blockRowFrom, blockRowTo) of a texture into pixels laid out as Sqex::Texture::RGBA8888, with R in the lowest byte.
+	// blockStorage and image point to the beginning of the whole texture, so that block rows can be decoded from multiple threads.
+	// Channel values are the same as what DecompressBlockDXT1 and DecompressBlockDXT5 compute, and pixels outside width x height are not written.
+
+	void DecompressBlockRowsDXT1(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image, DxtDecoderIsa isa = DxtDecoderIsa::Auto);
+	void DecompressBlockRowsDXT3(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image, DxtDecoderIsa isa = DxtDecoderIsa::Auto);
+	void DecompressBlockRowsDXT5(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image, DxtDecoderIsa isa = DxtDecoderIsa::Auto);
+
+	// Blocks in the reserved mode decode into transparent black.
+	void DecompressBlockRowsBC7(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint8_t* blockStorage, uint32_t* image);
+}
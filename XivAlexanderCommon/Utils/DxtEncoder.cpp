@@ -0,0 +1,534 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/DxtEncoder.h"
+
+#include <bit>
+
+// Every candidate is evaluated against the palette that DxtDecoder would produce for it, using the same integer arithmetic,
+// so that the error being minimized is the error of what will be actually displayed.
+
+struct BlockPixels {
+	// [pixel index][R, G, B, A]
+	int C[16][4];
+};
+
+static void LoadBlock(uint32_t width, uint32_t height, uint32_t x, uint32_t y, const uint32_t* image, BlockPixels& px) {
+	for (uint32_t j = 0; j < 4; ++j) {
+		const auto sy = std::min(y + j, height - 1);
+		for (uint32_t i = 0; i < 4; ++i) {
+			const auto sx = std::min(x + i, width - 1);
+			const auto v = image[static_cast<size_t>(sy) * width + sx];
+			auto& c = px.C[j * 4 + i];
+			c[0] = static_cast<int>(v & 0xFF);
+			c[1] = static_cast<int>((v >> 8) & 0xFF);
+			c[2] = static_cast<int>((v >> 16) & 0xFF);
+			c[3] = static_cast<int>(v >> 24);
+		}
+	}
+}
+
+template<size_t N>
+static uint32_t SquaredError(const int* a, const int* b) {
+	uint32_t res = 0;
+	for (size_t i = 0; i < N; ++i)
+		res += static_cast<uint32_t>((a[i] - b[i]) * (a[i] - b[i]));
+	return res;
+}
+
+// Finds the mean, and the direction along which the first N channels of pixels vary the most.
+template<size_t N>
+static void PrincipalAxis(const BlockPixels& px, float(&mean)[N], float(&axis)[N]) {
+	for (size_t c = 0; c < N; ++c) {
+		mean[c] = 0;
+		for (const auto& p : px.C)
+			mean[c] += static_cast<float>(p[c]);
+		mean[c] /= 16.f;
+	}
+
+	float cov[N][N]{};
+	for (const auto& p : px.C) {
+		for (size_t a = 0; a < N; ++a)
+			for (size_t b = a; b < N; ++b)
+				cov[a][b] += (p[a] - mean[a]) * (p[b] - mean[b]);
+	}
+	for (size_t a = 0; a < N; ++a)
+		for (size_t b = 0; b < a; ++b)
+			cov[a][b] = cov[b][a];
+
+	// Power iteration, starting from the row of the channel with the largest variance.
+	size_t largest = 0;
+	for (size_t c = 1; c < N; ++c)
+		if (cov[c][c] > cov[largest][largest])
+			largest = c;
+	std::copy_n(cov[largest], N, axis);
+	for (size_t iteration = 0; iteration < 8; ++iteration) {
+		float next[N]{};
+		auto maxAbs = 0.f;
+		for (size_t a = 0; a < N; ++a) {
+			for (size_t b = 0; b < N; ++b)
+				next[a] += cov[a][b] * axis[b];
+			maxAbs = std::max(maxAbs, std::abs(next[a]));
+		}
+		if (maxAbs < 1e-6f)
+			break;
+		for (size_t a = 0; a < N; ++a)
+			axis[a] = next[a] / maxAbs;
+	}
+
+	auto length = 0.f;
+	for (size_t c = 0; c < N; ++c)
+		length += axis[c] * axis[c];
+	length = std::sqrt(length);
+	for (size_t c = 0; c < N; ++c)
+		axis[c] = length < 1e-6f ? 0.f : axis[c] / length;
+}
+
+// Projects pixels onto the principal axis, and takes both ends of the projected range.
+template<size_t N>
+static void AxisEndpoints(const BlockPixels& px, float(&low)[N], float(&high)[N]) {
+	float mean[N], axis[N];
+	PrincipalAxis(px, mean, axis);
+
+	auto minT = 0.f, maxT = 0.f;
+	for (const auto& p : px.C) {
+		auto t = 0.f;
+		for (size_t c = 0; c < N; ++c)
+			t += (p[c] - mean[c]) * axis[c];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	for (size_t c = 0; c < N; ++c) {
+		low[c] = std::clamp(mean[c] + minT * axis[c], 0.f, 255.f);
+		high[c] = std::clamp(mean[c] + maxT * axis[c], 0.f, 255.f);
+	}
+}
+
+// Solves for the two endpoints minimizing sum((1 - t[i]) * e0 + t[i] * e1 - pixel[i])^2 over pixels with weight t[i] >= 0.
+template<size_t N>
+static bool LeastSquaresEndpoints(const BlockPixels& px, const float(&t)[16], float(&e0)[N], float(&e1)[N]) {
+	float a = 0, b = 0, c = 0, x0[N]{}, x1[N]{};
+	for (size_t i = 0; i < 16; ++i) {
+		if (t[i] < 0)
+			continue;
+		const auto u = 1.f - t[i];
+		a += u * u;
+		b += u * t[i];
+		c += t[i] * t[i];
+		for (size_t ch = 0; ch < N; ++ch) {
+			x0[ch] += u * static_cast<float>(px.C[i][ch]);
+			x1[ch] += t[i] * static_cast<float>(px.C[i][ch]);
+		}
+	}
+
+	const auto det = a * c - b * b;
+	if (std::abs(det) < 1e-6f)
+		return false;
+
+	for (size_t ch = 0; ch < N; ++ch) {
+		e0[ch] = std::clamp((c * x0[ch] - b * x1[ch]) / det, 0.f, 255.f);
+		e1[ch] = std::clamp((a * x1[ch] - b * x0[ch]) / det, 0.f, 255.f);
+	}
+	return true;
+}
+
+struct ColorBlock {
+	uint16_t Color0 = 0;
+	uint16_t Color1 = 0;
+	uint32_t Indices = 0;
+	uint32_t Error = UINT32_MAX;
+
+	void Write(uint8_t* block) const {
+		memcpy(block, &Color0, sizeof Color0);
+		memcpy(block + 2, &Color1, sizeof Color1);
+		memcpy(block + 4, &Indices, sizeof Indices);
+	}
+};
+
+static void Expand565(uint16_t color, int(&rgb)[3]) {
+	uint32_t temp;
+	temp = (color >> 11) * 255 + 16;
+	rgb[0] = static_cast<int>((temp / 32 + temp) / 32);
+	temp = ((color & 0x07E0) >> 5) * 255 + 32;
+	rgb[1] = static_cast<int>((temp / 64 + temp) / 64);
+	temp = (color & 0x001F) * 255 + 16;
+	rgb[2] = static_cast<int>((temp / 32 + temp) / 32);
+}
+
+static uint16_t Quantize565(const float(&rgb)[3]) {
+	const auto r = std::clamp(static_cast<int>(rgb[0] * 31.f / 255.f + .5f), 0, 31);
+	const auto g = std::clamp(static_cast<int>(rgb[1] * 63.f / 255.f + .5f), 0, 63);
+	const auto b = std::clamp(static_cast<int>(rgb[2] * 31.f / 255.f + .5f), 0, 31);
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// Pixels with alpha below this are transparent in BC1 blocks.
+static constexpr int Bc1AlphaCutoff = 128;
+
+static bool IsThreeColorMode(uint16_t color0, uint16_t color1, bool allowThreeColorMode) {
+	return allowThreeColorMode && color0 <= color1;
+}
+
+// Returns a bit for each pixel that is transparent in BC1.
+static uint16_t TransparentPixels(const BlockPixels& px) {
+	uint16_t res = 0;
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (px.C[i][3] < Bc1AlphaCutoff)
+			res |= 1 << i;
+	}
+	return res;
+}
+
+// Index 3 of a three color block is transparent black, so only pixels in transparent can use it, and they have to;
+// blocks with any transparent pixel therefore must be in three color mode, or Error is left at UINT32_MAX.
+static ColorBlock FitColorIndices(const BlockPixels& px, uint16_t color0, uint16_t color1, bool allowThreeColorMode, uint16_t transparent) {
+	const auto threeColorMode = IsThreeColorMode(color0, color1, allowThreeColorMode);
+	if (transparent && !threeColorMode)
+		return {color0, color1};
+
+	int palette[4][3];
+	Expand565(color0, palette[0]);
+	Expand565(color1, palette[1]);
+	if (!threeColorMode) {
+		for (size_t c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	} else {
+		for (size_t c = 0; c < 3; ++c)
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+	}
+
+	ColorBlock res{color0, color1, 0, 0};
+	for (uint32_t i = 0; i < 16; ++i) {
+		if (transparent & (1 << i)) {
+			res.Indices |= 3U << (2 * i);
+			continue;
+		}
+
+		uint32_t best = 0, bestError = UINT32_MAX;
+		for (uint32_t k = 0, k_ = threeColorMode ? 3 : 4; k < k_; ++k) {
+			if (const auto error = SquaredError<3>(px.C[i], palette[k]); error < bestError) {
+				best = k;
+				bestError = error;
+			}
+		}
+		res.Indices |= best << (2 * i);
+		res.Error += bestError;
+	}
+	return res;
+}
+
+static ColorBlock FitColorEndpoints(const BlockPixels& px, const float(&e0)[3], const float(&e1)[3], bool allowThreeColorMode, uint16_t transparent) {
+	auto color0 = Quantize565(e0), color1 = Quantize565(e1);
+	if (transparent ? color0 > color1 : color0 < color1)
+		std::swap(color0, color1);
+	return FitColorIndices(px, color0, color1, allowThreeColorMode, transparent);
+}
+
+// If allowThreeColorMode is set, pixels with alpha below Bc1AlphaCutoff are encoded as transparent.
+static ColorBlock EncodeColorBlock(const BlockPixels& px, bool allowThreeColorMode, Utils::DxtEncoderQuality quality) {
+	const auto transparent = allowThreeColorMode ? TransparentPixels(px) : uint16_t();
+	if (transparent == 0xFFFF)
+		return {0, 0, UINT32_MAX, 0};
+
+	// Colors of transparent pixels do not matter; take them out of the principal axis by repeating an opaque one.
+	auto opaque = px;
+	if (transparent) {
+		const auto& fill = px.C[std::countr_one(transparent)];
+		for (uint32_t i = 0; i < 16; ++i) {
+			if (transparent & (1 << i))
+				std::copy_n(fill, 4, opaque.C[i]);
+		}
+	}
+
+	float low[3], high[3];
+	AxisEndpoints(opaque, low, high);
+	auto best = FitColorEndpoints(px, high, low, allowThreeColorMode, transparent);
+	if (quality == Utils::DxtEncoderQuality::Fast || best.Error == 0)
+		return best;
+
+	for (size_t iteration = 0; iteration < 2; ++iteration) {
+		const auto threeColorMode = IsThreeColorMode(best.Color0, best.Color1, allowThreeColorMode);
+		float t[16];
+		for (size_t i = 0; i < 16; ++i) {
+			switch ((best.Indices >> (2 * i)) & 3) {
+				case 0: t[i] = 0.f; break;
+				case 1: t[i] = 1.f; break;
+				case 2: t[i] = threeColorMode ? 1.f / 2.f : 1.f / 3.f; break;
+				case 3: t[i] = threeColorMode ? -1.f : 2.f / 3.f; break;
+			}
+		}
+
+		float e0[3], e1[3];
+		if (!LeastSquaresEndpoints(px, t, e0, e1))
+			break;
+
+		const auto candidate = FitColorEndpoints(px, e0, e1, allowThreeColorMode, transparent);
+		if (candidate.Error >= best.Error)
+			break;
+		best = candidate;
+	}
+
+	// Nudge each quantized channel of each endpoint by one step.
+	static constexpr std::pair<int, int> Fields[]{{11, 31}, {5, 63}, {0, 31}};
+	for (size_t endpoint = 0; endpoint < 2; ++endpoint) {
+		for (const auto& [shift, maxValue] : Fields) {
+			for (const auto delta : {-1, 1}) {
+				auto colors = std::make_pair(best.Color0, best.Color1);
+				auto& color = endpoint == 0 ? colors.first : colors.second;
+				const auto value = ((color >> shift) & maxValue) + delta;
+				if (value < 0 || value > maxValue)
+					continue;
+				color = static_cast<uint16_t>((color & ~(maxValue << shift)) | (value << shift));
+				if (const auto candidate = FitColorIndices(px, colors.first, colors.second, allowThreeColorMode, transparent); candidate.Error < best.Error)
+					best = candidate;
+			}
+		}
+	}
+
+	// Three color mode has a midpoint, which can fit opaque blocks better than the two thirds of four color mode.
+	if (allowThreeColorMode && !transparent && best.Color0 != best.Color1) {
+		if (const auto candidate = FitColorIndices(px, best.Color1, best.Color0, true, transparent); candidate.Error < best.Error)
+			best = candidate;
+	}
+
+	return best;
+}
+
+struct AlphaBlock {
+	uint8_t Alpha0 = 0;
+	uint8_t Alpha1 = 0;
+	uint64_t Indices = 0;
+	uint32_t Error = UINT32_MAX;
+
+	void Write(uint8_t* block) const {
+		block[0] = Alpha0;
+		block[1] = Alpha1;
+		for (size_t i = 0; i < 6; ++i)
+			block[2 + i] = static_cast<uint8_t>(Indices >> (8 * i));
+	}
+};
+
+static AlphaBlock FitAlphaIndices(const BlockPixels& px, int alpha0, int alpha1) {
+	int palette[8]{alpha0, alpha1};
+	if (alpha0 > alpha1) {
+		for (int i = 2; i < 8; ++i)
+			palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+	} else {
+		for (int i = 2; i < 6; ++i)
+			palette[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	AlphaBlock res{static_cast<uint8_t>(alpha0), static_cast<uint8_t>(alpha1), 0, 0};
+	for (uint32_t i = 0; i < 16; ++i) {
+		uint32_t best = 0, bestError = UINT32_MAX;
+		for (uint32_t k = 0; k < 8; ++k) {
+			if (const auto error = SquaredError<1>(&px.C[i][3], &palette[k]); error < bestError) {
+				best = k;
+				bestError = error;
+			}
+		}
+		res.Indices |= static_cast<uint64_t>(best) << (3 * i);
+		res.Error += bestError;
+	}
+	return res;
+}
+
+static AlphaBlock EncodeAlphaBlock(const BlockPixels& px, Utils::DxtEncoderQuality quality) {
+	int minAlpha = 255, maxAlpha = 0;
+	int minInnerAlpha = 255, maxInnerAlpha = 0;
+	for (const auto& p : px.C) {
+		minAlpha = std::min(minAlpha, p[3]);
+		maxAlpha = std::max(maxAlpha, p[3]);
+		if (p[3] != 0 && p[3] != 255) {
+			minInnerAlpha = std::min(minInnerAlpha, p[3]);
+			maxInnerAlpha = std::max(maxInnerAlpha, p[3]);
+		}
+	}
+
+	auto best = FitAlphaIndices(px, maxAlpha, minAlpha);
+	if (quality == Utils::DxtEncoderQuality::Fast || best.Error == 0)
+		return best;
+
+	// Six level mode, with explicit 0 and 255 available for the remaining pixels.
+	if (minInnerAlpha <= maxInnerAlpha) {
+		if (const auto candidate = FitAlphaIndices(px, minInnerAlpha, maxInnerAlpha); candidate.Error < best.Error)
+			best = candidate;
+	}
+
+	for (const auto& [delta0, delta1] : {std::pair(-1, 0), std::pair(0, 1), std::pair(-1, 1), std::pair(1, 0), std::pair(0, -1)}) {
+		const auto alpha0 = best.Alpha0 + delta0, alpha1 = best.Alpha1 + delta1;
+		if (alpha0 < 0 || alpha0 > 255 || alpha1 < 0 || alpha1 > 255)
+			continue;
+		// Stay in the same mode.
+		if ((alpha0 > alpha1) != (best.Alpha0 > best.Alpha1))
+			continue;
+		if (const auto candidate = FitAlphaIndices(px, alpha0, alpha1); candidate.Error < best.Error)
+			best = candidate;
+	}
+	return best;
+}
+
+static constexpr int Bc7Weights4[16]{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct Bc7Mode6Block {
+	// 7-bit endpoint values, [endpoint][R, G, B, A]
+	int Endpoints[2][4]{};
+	int PBits[2]{};
+	uint8_t Indices[16]{};
+	uint32_t Error = UINT32_MAX;
+
+	void Write(uint8_t* block) const {
+		int endpoints[2][4], pBits[2];
+		uint8_t indices[16];
+		std::copy_n(&Endpoints[0][0], 8, &endpoints[0][0]);
+		std::copy_n(PBits, 2, pBits);
+		std::copy_n(Indices, 16, indices);
+
+		// Most significant bit of the index of the first pixel is implied to be zero.
+		if (indices[0] & 8) {
+			std::swap(endpoints[0], endpoints[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (auto& index : indices)
+				index = static_cast<uint8_t>(15 - index);
+		}
+
+		std::fill_n(block, 16, 0);
+		uint32_t bitOffset = 0;
+		const auto write = [&](uint32_t value, uint32_t bitCount) {
+			for (uint32_t i = 0; i < bitCount; ++i, ++bitOffset)
+				block[bitOffset / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (bitOffset % 8));
+		};
+
+		write(1 << 6, 7);
+		for (size_t channel = 0; channel < 4; ++channel) {
+			write(endpoints[0][channel], 7);
+			write(endpoints[1][channel], 7);
+		}
+		write(pBits[0], 1);
+		write(pBits[1], 1);
+		write(indices[0], 3);
+		for (size_t i = 1; i < 16; ++i)
+			write(indices[i], 4);
+	}
+};
+
+static Bc7Mode6Block FitBc7Mode6Indices(const BlockPixels& px, const int(&q0)[4], int p0, const int(&q1)[4], int p1) {
+	int palette[16][4];
+	for (size_t k = 0; k < 16; ++k)
+		for (size_t c = 0; c < 4; ++c)
+			palette[k][c] = ((64 - Bc7Weights4[k]) * (q0[c] << 1 | p0) + Bc7Weights4[k] * (q1[c] << 1 | p1) + 32) >> 6;
+
+	Bc7Mode6Block res;
+	std::copy_n(q0, 4, res.Endpoints[0]);
+	std::copy_n(q1, 4, res.Endpoints[1]);
+	res.PBits[0] = p0;
+	res.PBits[1] = p1;
+	res.Error = 0;
+	for (size_t i = 0; i < 16; ++i) {
+		uint32_t best = 0, bestError = UINT32_MAX;
+		for (uint32_t k = 0; k < 16; ++k) {
+			if (const auto error = SquaredError<4>(px.C[i], palette[k]); error < bestError) {
+				best = k;
+				bestError = error;
+			}
+		}
+		res.Indices[i] = static_cast<uint8_t>(best);
+		res.Error += bestError;
+	}
+	return res;
+}
+
+static void QuantizeBc7Endpoint(const float(&e)[4], int pBit, int(&q)[4], uint32_t* pError = nullptr) {
+	uint32_t error = 0;
+	for (size_t c = 0; c < 4; ++c) {
+		q[c] = std::clamp(static_cast<int>((e[c] - static_cast<float>(pBit)) / 2.f + .5f), 0, 127);
+		const auto diff = static_cast<int>(e[c] + .5f) - (q[c] << 1 | pBit);
+		error += static_cast<uint32_t>(diff * diff);
+	}
+	if (pError)
+		*pError = error;
+}
+
+static Bc7Mode6Block FitBc7Mode6Endpoints(const BlockPixels& px, const float(&e0)[4], const float(&e1)[4], bool tryEveryPBit) {
+	int q[2][2][4];  // [endpoint][p-bit][channel]
+	uint32_t errors[2][2];
+	for (int p = 0; p < 2; ++p) {
+		QuantizeBc7Endpoint(e0, p, q[0][p], &errors[0][p]);
+		QuantizeBc7Endpoint(e1, p, q[1][p], &errors[1][p]);
+	}
+
+	if (!tryEveryPBit) {
+		const auto p0 = errors[0][1] < errors[0][0] ? 1 : 0;
+		const auto p1 = errors[1][1] < errors[1][0] ? 1 : 0;
+		return FitBc7Mode6Indices(px, q[0][p0], p0, q[1][p1], p1);
+	}
+
+	Bc7Mode6Block best;
+	for (int p0 = 0; p0 < 2; ++p0) {
+		for (int p1 = 0; p1 < 2; ++p1) {
+			if (auto candidate = FitBc7Mode6Indices(px, q[0][p0], p0, q[1][p1], p1); candidate.Error < best.Error)
+				best = candidate;
+		}
+	}
+	return best;
+}
+
+static Bc7Mode6Block EncodeBc7Mode6Block(const BlockPixels& px, Utils::DxtEncoderQuality quality) {
+	float low[4], high[4];
+	AxisEndpoints(px, low, high);
+	const auto tryEveryPBit = quality == Utils::DxtEncoderQuality::Quality;
+	auto best = FitBc7Mode6Endpoints(px, low, high, tryEveryPBit);
+	if (quality == Utils::DxtEncoderQuality::Fast || best.Error == 0)
+		return best;
+
+	for (size_t iteration = 0; iteration < 2; ++iteration) {
+		float t[16];
+		for (size_t i = 0; i < 16; ++i)
+			t[i] = static_cast<float>(Bc7Weights4[best.Indices[i]]) / 64.f;
+
+		float e0[4], e1[4];
+		if (!LeastSquaresEndpoints(px, t, e0, e1))
+			break;
+
+		const auto candidate = FitBc7Mode6Endpoints(px, e0, e1, true);
+		if (candidate.Error >= best.Error)
+			break;
+		best = candidate;
+	}
+	return best;
+}
+
+template<size_t BlockSize, typename EncodeBlock>
+static void CompressBlockRows(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, const EncodeBlock& encodeBlock) {
+	const auto blockCountX = (width + 3) / 4;
+	BlockPixels px;
+	for (auto by = blockRowFrom; by < blockRowTo; ++by) {
+		auto block = blockStorage + static_cast<size_t>(by) * blockCountX * BlockSize;
+		for (uint32_t x = 0; x < width; x += 4, block += BlockSize) {
+			LoadBlock(width, height, x, by * 4, image, px);
+			encodeBlock(px, block);
+		}
+	}
+}
+
+void Utils::CompressBlockRowsDXT1(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, DxtEncoderQuality quality) {
+	CompressBlockRows<8>(width, height, blockRowFrom, blockRowTo, image, blockStorage, [quality](const BlockPixels& px, uint8_t* block) {
+		EncodeColorBlock(px, true, quality).Write(block);
+	});
+}
+
+void Utils::CompressBlockRowsDXT5(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, DxtEncoderQuality quality) {
+	CompressBlockRows<16>(width, height, blockRowFrom, blockRowTo, image, blockStorage, [quality](const BlockPixels& px, uint8_t* block) {
+		EncodeAlphaBlock(px, quality).Write(block);
+		EncodeColorBlock(px, false, quality).Write(block + 8);
+	});
+}
+
+void Utils::CompressBlockRowsBC7(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, DxtEncoderQuality quality) {
+	CompressBlockRows<16>(width, height, blockRowFrom, blockRowTo, image, blockStorage, [quality](const BlockPixels& px, uint8_t* block) {
+		EncodeBc7Mode6Block(px, quality).Write(block);
+	});
+}
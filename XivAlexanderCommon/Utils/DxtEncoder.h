@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utils {
+	enum class DxtEncoderQuality : uint8_t {
+		// Endpoints from the principal axis of each block, indices fit once.
+		Fast,
+
+		// Additionally refines endpoints using least squares and small perturbations, and tries every block mode the encoder supports.
+		Quality,
+	};
+
+	// Encodes block rows [blockRowFrom, blockRowTo) of a width x height image.
+	// image and blockStorage point to the beginning of the whole texture, so that block rows can be encoded from multiple threads.
+	// Pixels are in the layout of Sqex::Texture::RGBA8888, which has R in the lowest byte.
+	// Blocks crossing the right or bottom edge are filled by repeating the edge pixels.
+
+	// Pixels with alpha below 128 become transparent black, and the others opaque.
+	void CompressBlockRowsDXT1(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, DxtEncoderQuality quality = DxtEncoderQuality::Fast);
+	void CompressBlockRowsDXT5(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, DxtEncoderQuality quality = DxtEncoderQuality::Fast);
+
+	// Only emits BC7 mode 6 blocks; a single RGBA line with 7-bit endpoints, p-bits, and 4-bit indices.
+	void CompressBlockRowsBC7(uint32_t width, uint32_t height, uint32_t blockRowFrom, uint32_t blockRowTo, const uint32_t* image, uint8_t* blockStorage, DxtEncoderQuality quality = DxtEncoderQuality::Fast);
+}
@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/FramePacer.h"
+
+static int64_t FloorDiv(int64_t a, int64_t b) {
+	const auto q = a / b;
+	return q * b > a ? q - 1 : q;
+}
+
+static int64_t PositiveMod(int64_t a, int64_t b) {
+	return a - FloorDiv(a, b) * b;
+}
+
+Utils::FramePacer::FramePacer(Clock& clock)
+	: m_clock(clock) {
+}
+
+int64_t Utils::FramePacer::SleepOvershootUs() const {
+	return std::max(m_previousOvershootWindowMaxUs, m_currentOvershootWindowMaxUs);
+}
+
+int64_t Utils::FramePacer::NextGridPoint(int64_t nowUs, int64_t intervalUs, int64_t driftUs) {
+	return (1 + FloorDiv(nowUs - driftUs, intervalUs)) * intervalUs + driftUs;
+}
+
+int64_t Utils::FramePacer::ContinueDrift(int64_t nowUs, int64_t previousIntervalUs, int64_t previousDriftUs, int64_t newIntervalUs) {
+	// First points after nowUs of every grid of newIntervalUs cover (nowUs, nowUs + newIntervalUs] exactly once,
+	// and the point one new interval after the last previous frame is never after nowUs + newIntervalUs.
+	const auto lastFrameUs = NextGridPoint(nowUs, previousIntervalUs, previousDriftUs) - previousIntervalUs;
+	const auto nextFrameUs = std::max(nowUs + 1, lastFrameUs + newIntervalUs);
+	return PositiveMod(nextFrameUs, newIntervalUs);
+}
+
+int64_t Utils::FramePacer::NextFrameUs(int64_t nowUs, int64_t intervalUs, bool keepPhase) {
+	if (intervalUs <= 0)
+		return 0;
+
+	if (!keepPhase)
+		m_driftUs = 0;
+	else if (m_intervalUs && m_intervalUs != intervalUs)
+		m_driftUs = ContinueDrift(nowUs, m_intervalUs, m_driftUs, intervalUs);
+	m_intervalUs = intervalUs;
+
+	return NextGridPoint(nowUs, intervalUs, m_driftUs);
+}
+
+int64_t Utils::FramePacer::WaitUntil(int64_t targetUs, bool allowSleep, bool yieldWhileSpinning) {
+	auto nowUs = m_clock.NowUs();
+
+	while (allowSleep) {
+		const auto sleepUs = targetUs - nowUs - SpinBudgetUs - SleepOvershootUs();
+		if (sleepUs < MinimumSleepUs)
+			break;
+
+		const auto beforeUs = nowUs;
+		m_clock.SleepUs(sleepUs);
+		nowUs = m_clock.NowUs();
+
+		const auto overshootUs = std::max<int64_t>(0, nowUs - beforeUs - sleepUs);
+		m_currentOvershootWindowMaxUs = std::max(m_currentOvershootWindowMaxUs, overshootUs);
+		if (++m_currentOvershootWindowCount == OvershootWindowSize) {
+			m_previousOvershootWindowMaxUs = m_currentOvershootWindowMaxUs;
+			m_currentOvershootWindowMaxUs = 0;
+			m_currentOvershootWindowCount = 0;
+		}
+	}
+
+	while (nowUs < targetUs) {
+		m_clock.Spin(yieldWhileSpinning);
+		nowUs = m_clock.NowUs();
+	}
+	return nowUs;
+}
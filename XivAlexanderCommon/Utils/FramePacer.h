@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utils {
+	/// \brief Decides when the next frame should begin when frame rate is locked to a fixed interval, and waits until then.
+	///
+	/// Frames begin on a grid of points {drift + k * interval}. When the interval changes, drift is chosen so that the
+	/// first frame on the new grid comes one new interval after the last frame on the old grid, or as soon as possible.
+	/// Waiting sleeps while the remaining time is large enough that the sleep is not expected to return too late,
+	/// and then spins for the rest.
+	class FramePacer {
+	public:
+		/// \brief Source of time, and the way to spend it. Replaceable so that pacing can be simulated.
+		class Clock {
+		public:
+			virtual ~Clock() = default;
+
+			[[nodiscard]] virtual int64_t NowUs() = 0;
+
+			/// \brief Gives up the processor for about the given duration. May return late.
+			virtual void SleepUs(int64_t us) = 0;
+
+			/// \brief Called on every iteration of spin-waiting.
+			/// \param yield Whether other threads ready to run should be given the processor.
+			virtual void Spin(bool yield) = 0;
+		};
+
+		static constexpr int64_t MinimumSleepUs = 1000;
+		static constexpr size_t OvershootWindowSize = 128;
+
+	private:
+		Clock& m_clock;
+
+		int64_t m_intervalUs = 0;
+		int64_t m_driftUs = 0;
+
+		// How late SleepUs has been returning, as the maximum over the current and the previous window of sleeps.
+		int64_t m_previousOvershootWindowMaxUs = 0;
+		int64_t m_currentOvershootWindowMaxUs = 0;
+		size_t m_currentOvershootWindowCount = 0;
+
+	public:
+		/// \brief Time left to be spent spinning, after sleeping for the rest.
+		int64_t SpinBudgetUs = 2000;
+
+		FramePacer(Clock& clock);
+
+		/// \returns First point after nowUs of the grid {driftUs + k * intervalUs}.
+		[[nodiscard]] static int64_t NextGridPoint(int64_t nowUs, int64_t intervalUs, int64_t driftUs);
+
+		/// \returns Drift of the new grid, in range of [0, newIntervalUs), such that its first point after nowUs is the
+		/// earliest one not before one new interval after the last point of the previous grid at or before nowUs.
+		[[nodiscard]] static int64_t ContinueDrift(int64_t nowUs, int64_t previousIntervalUs, int64_t previousDriftUs, int64_t newIntervalUs);
+
+		/// \brief Computes when the next frame should begin.
+		/// \param keepPhase If true, the grid drifts so that frames stay evenly spaced when the interval changes;
+		///                  if false, the grid is aligned to multiples of intervalUs.
+		/// \returns Timestamp of the next frame, or 0 if intervalUs is 0.
+		[[nodiscard]] int64_t NextFrameUs(int64_t nowUs, int64_t intervalUs, bool keepPhase);
+
+		/// \brief Waits until targetUs.
+		/// \param allowSleep If false, only spins.
+		/// \param yieldWhileSpinning Whether to let other threads run while spinning.
+		/// \returns Time when the wait ended.
+		int64_t WaitUntil(int64_t targetUs, bool allowSleep, bool yieldWhileSpinning);
+
+		/// \returns The latest SleepUs has returned in the recent sleeps, which is left unslept before spinning.
+		[[nodiscard]] int64_t SleepOvershootUs() const;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+
+namespace Utils {
+	/// \brief Counts callers currently inside a section of code, without making concurrent callers contend for one cache line.
+	///
+	/// Each thread always enters and leaves through the same shard, so every shard stays nonnegative and the sum of
+	/// all shards is the number of callers inside.
+	class InFlightCounter {
+	public:
+		static constexpr size_t ShardCount = 16;
+
+	private:
+		struct alignas(64) Shard {
+			std::atomic_size_t Value{};
+		};
+
+		Shard m_shards[ShardCount];
+
+		static size_t CurrentShardIndex() {
+			static std::atomic_size_t s_nextIndex{};
+			thread_local const auto s_index = s_nextIndex++ % ShardCount;
+			return s_index;
+		}
+
+	public:
+		/// \brief Leaves the section on destruction.
+		class Scope {
+			std::atomic_size_t& m_value;
+
+		public:
+			explicit Scope(std::atomic_size_t& value)
+				: m_value(value) {
+				++m_value;
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+			~Scope() {
+				m_value.fetch_sub(1, std::memory_order_release);
+			}
+		};
+
+		InFlightCounter() = default;
+		InFlightCounter(const InFlightCounter&) = delete;
+		InFlightCounter& operator=(const InFlightCounter&) = delete;
+
+		/// \brief Enters the section until the returned object is destroyed.
+		[[nodiscard]] Scope Enter() {
+			return Scope(m_shards[CurrentShardIndex()].Value);
+		}
+
+		/// \returns Number of callers inside the section.
+		[[nodiscard]] size_t Count() const {
+			size_t count = 0;
+			for (const auto& shard : m_shards)
+				count += shard.Value.load(std::memory_order_acquire);
+			return count;
+		}
+
+		operator bool() const {
+			return Count() != 0;
+		}
+	};
+}
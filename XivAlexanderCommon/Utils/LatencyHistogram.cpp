@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/LatencyHistogram.h"
+#include "XivAlexanderCommon/Utils/Utils.h"
+
+#include <bit>
+
+int64_t Utils::LatencyHistogram::Snapshot::Min(int64_t emptyValue) const {
+	return m_totalCount ? m_min : emptyValue;
+}
+
+int64_t Utils::LatencyHistogram::Snapshot::Max(int64_t emptyValue) const {
+	return m_totalCount ? m_max : emptyValue;
+}
+
+int64_t Utils::LatencyHistogram::Snapshot::Mean(int64_t emptyValue) const {
+	return m_totalCount ? static_cast<int64_t>(m_sum / m_totalCount) : emptyValue;
+}
+
+int64_t Utils::LatencyHistogram::Snapshot::Percentile(double percentile, int64_t emptyValue) const {
+	if (!m_totalCount)
+		return emptyValue;
+
+	percentile = Clamp(percentile, 0., 100.);
+	const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100. * static_cast<double>(m_totalCount))));
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i < BucketCount; ++i) {
+		cumulative += m_counts[i];
+		if (cumulative >= rank)
+			return Clamp(HighestEquivalentValue(i), m_min, m_max);
+	}
+	return m_max;
+}
+
+Utils::LatencyHistogram::Snapshot& Utils::LatencyHistogram::Snapshot::Merge(const Snapshot& r) {
+	for (size_t i = 0; i < BucketCount; ++i)
+		m_counts[i] += r.m_counts[i];
+	m_totalCount += r.m_totalCount;
+	m_sum += r.m_sum;
+	m_min = std::min(m_min, r.m_min);
+	m_max = std::max(m_max, r.m_max);
+	return *this;
+}
+
+std::string Utils::LatencyHistogram::Snapshot::ToCsv(std::string_view name) const {
+	std::string res;
+	if (!name.empty())
+		res += std::format("# {}\n", name);
+	res += std::format("# count={} min={} mean={} max={}\n", m_totalCount, Min(), Mean(), Max());
+	res += std::format("# p50={} p90={} p99={} p99.9={} p99.99={}\n",
+		Percentile(50), Percentile(90), Percentile(99), Percentile(99.9), Percentile(99.99));
+	res += "lowest,highest,count,cumulative_fraction\n";
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i < BucketCount; ++i) {
+		if (!m_counts[i])
+			continue;
+		cumulative += m_counts[i];
+		res += std::format("{},{},{},{:.6f}\n",
+			LowestEquivalentValue(i), HighestEquivalentValue(i), m_counts[i],
+			static_cast<double>(cumulative) / static_cast<double>(m_totalCount));
+	}
+	return res;
+}
+
+Utils::LatencyHistogram::LatencyHistogram() = default;
+
+Utils::LatencyHistogram::~LatencyHistogram() = default;
+
+void Utils::LatencyHistogram::Record(int64_t value) {
+	value = Clamp<int64_t>(value, 0, MaxTrackableValue);
+	m_counts[BucketIndexOf(value)].fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(static_cast<uint64_t>(value), std::memory_order_relaxed);
+
+	auto prevMin = m_min.load(std::memory_order_relaxed);
+	while (value < prevMin && !m_min.compare_exchange_weak(prevMin, value, std::memory_order_relaxed)) {
+		// retry
+	}
+
+	auto prevMax = m_max.load(std::memory_order_relaxed);
+	while (value > prevMax && !m_max.compare_exchange_weak(prevMax, value, std::memory_order_relaxed)) {
+		// retry
+	}
+}
+
+void Utils::LatencyHistogram::Reset() {
+	for (auto& count : m_counts)
+		count.store(0, std::memory_order_relaxed);
+	m_sum.store(0, std::memory_order_relaxed);
+	m_min.store(INT64_MAX, std::memory_order_relaxed);
+	m_max.store(INT64_MIN, std::memory_order_relaxed);
+}
+
+Utils::LatencyHistogram::Snapshot Utils::LatencyHistogram::TakeSnapshot() const {
+	Snapshot res;
+	for (size_t i = 0; i < BucketCount; ++i) {
+		res.m_counts[i] = m_counts[i].load(std::memory_order_relaxed);
+		res.m_totalCount += res.m_counts[i];
+	}
+	res.m_sum = m_sum.load(std::memory_order_relaxed);
+	res.m_min = m_min.load(std::memory_order_relaxed);
+	res.m_max = m_max.load(std::memory_order_relaxed);
+	return res;
+}
+
+size_t Utils::LatencyHistogram::BucketIndexOf(int64_t value) {
+	const auto v = static_cast<uint64_t>(Clamp<int64_t>(value, 0, MaxTrackableValue));
+	if (v < 2 * SubBucketHalfCount)
+		return static_cast<size_t>(v);
+
+	const auto magnitude = static_cast<size_t>(std::bit_width(v)) - 1;
+	const auto shift = magnitude - SubBucketHalfCountBits;
+	const auto subBucket = static_cast<size_t>(v >> shift) - SubBucketHalfCount;
+	return 2 * SubBucketHalfCount + (magnitude - SubBucketHalfCountBits - 1) * SubBucketHalfCount + subBucket;
+}
+
+int64_t Utils::LatencyHistogram::LowestEquivalentValue(size_t bucketIndex) {
+	if (bucketIndex < 2 * SubBucketHalfCount)
+		return static_cast<int64_t>(bucketIndex);
+
+	const auto offset = bucketIndex - 2 * SubBucketHalfCount;
+	const auto shift = offset / SubBucketHalfCount + 1;
+	const auto subBucket = offset % SubBucketHalfCount + SubBucketHalfCount;
+	return static_cast<int64_t>(subBucket) << shift;
+}
+
+int64_t Utils::LatencyHistogram::HighestEquivalentValue(size_t bucketIndex) {
+	if (bucketIndex < 2 * SubBucketHalfCount)
+		return static_cast<int64_t>(bucketIndex);
+
+	const auto shift = (bucketIndex - 2 * SubBucketHalfCount) / SubBucketHalfCount + 1;
+	return LowestEquivalentValue(bucketIndex) + (int64_t{1} << shift) - 1;
+}
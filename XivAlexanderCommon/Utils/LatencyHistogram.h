@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace Utils {
+	/// \brief Log-linear histogram of non-negative latency values, in the spirit of HdrHistogram.
+	///
+	/// Values below 2 * SubBucketHalfCount are counted exactly; above that, every power-of-two range is divided into
+	/// SubBucketHalfCount buckets, so that the relative error of a reported value stays under 1 / SubBucketHalfCount.
+	/// Recording is lock-free and only touches a few relaxed atomics, so it can be done from hooked game threads.
+	class LatencyHistogram {
+	public:
+		static constexpr size_t SubBucketHalfCountBits = 6;
+		static constexpr size_t SubBucketHalfCount = size_t{1} << SubBucketHalfCountBits;
+		static constexpr size_t MaxMagnitude = 40;
+		static constexpr int64_t MaxTrackableValue = (int64_t{1} << MaxMagnitude) - 1;
+		static constexpr size_t BucketCount = 2 * SubBucketHalfCount + (MaxMagnitude - SubBucketHalfCountBits - 1) * SubBucketHalfCount;
+
+		/// \brief Point-in-time copy of a LatencyHistogram, which can be queried and merged.
+		class Snapshot {
+			friend class LatencyHistogram;
+
+			std::array<uint64_t, BucketCount> m_counts{};
+			uint64_t m_totalCount = 0;
+			uint64_t m_sum = 0;
+			int64_t m_min = INT64_MAX;
+			int64_t m_max = INT64_MIN;
+
+		public:
+			[[nodiscard]] uint64_t Count() const { return m_totalCount; }
+			[[nodiscard]] int64_t Min(int64_t emptyValue = 0) const;
+			[[nodiscard]] int64_t Max(int64_t emptyValue = 0) const;
+			[[nodiscard]] int64_t Mean(int64_t emptyValue = 0) const;
+
+			/// \brief Finds the value at given percentile.
+			/// \param percentile Percentile, in range of [0, 100].
+			/// \returns Highest value equivalent to the bucket the percentile falls into, clamped to [Min, Max].
+			[[nodiscard]] int64_t Percentile(double percentile, int64_t emptyValue = 0) const;
+
+			Snapshot& Merge(const Snapshot& r);
+
+			/// \brief Formats the snapshot as CSV, one line per non-empty bucket, preceded by a percentile summary.
+			[[nodiscard]] std::string ToCsv(std::string_view name = {}) const;
+		};
+
+	private:
+		std::array<std::atomic_uint64_t, BucketCount> m_counts{};
+		std::atomic_uint64_t m_sum = 0;
+		std::atomic_int64_t m_min = INT64_MAX;
+		std::atomic_int64_t m_max = INT64_MIN;
+
+	public:
+		LatencyHistogram();
+		LatencyHistogram(const LatencyHistogram&) = delete;
+		LatencyHistogram(LatencyHistogram&&) = delete;
+		LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+		LatencyHistogram& operator=(LatencyHistogram&&) = delete;
+		~LatencyHistogram();
+
+		void Record(int64_t value);
+		void Reset();
+
+		[[nodiscard]] Snapshot TakeSnapshot() const;
+
+		[[nodiscard]] static size_t BucketIndexOf(int64_t value);
+		[[nodiscard]] static int64_t LowestEquivalentValue(size_t bucketIndex);
+		[[nodiscard]] static int64_t HighestEquivalentValue(size_t bucketIndex);
+	};
+}
@@ -1,9 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
-#include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 #include "XivAlexanderCommon/Utils/CallOnDestruction.h"
 
 namespace Utils {
@@ -18,8 +19,17 @@ namespace Utils {
 
 		typedef std::function<R(T ...)> CallbackType;
 
+		struct Listener {
+			size_t Id;
+			CallbackType Callback;
+		};
+
+		// Never modified once published; adding or removing a callback publishes a new one, so firing an event only
+		// needs to load the current one.
+		typedef std::vector<std::shared_ptr<const Listener>> Snapshot;
+
 		size_t m_callbackId = 0;
-		std::map<size_t, std::function<R(T ...)>> m_callbacks;
+		std::atomic<std::shared_ptr<const Snapshot>> m_snapshot = std::make_shared<const Snapshot>();
 		std::shared_ptr<std::mutex> m_lock = std::make_shared<std::mutex>();
 		std::shared_ptr<bool> m_destructed = std::make_shared<bool>(false);
 
@@ -32,12 +42,12 @@ namespace Utils {
 
 		virtual ~ListenerManagerImplBase_() {
 			std::lock_guard lock(*m_lock);
-			m_callbacks.clear();
+			m_snapshot = std::make_shared<const Snapshot>();
 			*m_destructed = true;
 		}
 
 		bool Empty() const {
-			return m_callbacks.empty();
+			return m_snapshot.load()->empty();
 		}
 
 		/// \brief Adds a callback function to call when an event has been fired.
@@ -47,13 +57,27 @@ namespace Utils {
 			const auto callbackId = m_callbackId++;
 			if (m_onNewCallback)
 				m_onNewCallback(fn);
-			m_callbacks.emplace(callbackId, std::move(fn));
+
+			const auto prev = m_snapshot.load();
+			auto next = std::make_shared<Snapshot>();
+			next->reserve(prev->size() + 1);
+			next->insert(next->end(), prev->begin(), prev->end());
+			next->emplace_back(std::make_shared<const Listener>(Listener{ callbackId, std::move(fn) }));
+			m_snapshot = std::move(next);
 
 			return CallOnDestruction([destructed = m_destructed, onUnbind = std::move(onUnbind), mutex = m_lock, callbackId, this]() {
 				std::lock_guard lock(*mutex);
 
-				if (!*destructed)
-					m_callbacks.erase(callbackId);
+				if (!*destructed) {
+					const auto prev = m_snapshot.load();
+					auto next = std::make_shared<Snapshot>();
+					next->reserve(prev->size());
+					for (const auto& listener : *prev) {
+						if (listener->Id != callbackId)
+							next->emplace_back(listener);
+					}
+					m_snapshot = std::move(next);
+				}
 
 				if (onUnbind)
 					onUnbind();
@@ -65,16 +89,11 @@ namespace Utils {
 		/// \brief Fires an event.
 		/// \returns Number of callbacks called.
 		virtual size_t operator() (T ... t) {
-			std::vector<std::function<R(T ...)>> callbacks;
-			{
-				std::lock_guard lock(*m_lock);
-				for (const auto& cbp : m_callbacks)
-					callbacks.push_back(cbp.second);
-			}
+			const auto snapshot = m_snapshot.load();
 
 			size_t notified = 0;
-			for (const auto& cb : callbacks) {
-				cb(std::forward<T>(t)...);
+			for (const auto& listener : *snapshot) {
+				listener->Callback(std::forward<T>(t)...);
 				notified++;
 			}
 			return notified;
@@ -107,16 +126,11 @@ namespace Utils {
 		/// \brief Fires an event.
 		/// \returns Number of callbacks called.
 		size_t operator() (T ... t, const std::function<bool(size_t, R)>& stopNotifying) {
-			std::vector<std::function<R(T ...)>> callbacks;
-			{
-				std::lock_guard<std::mutex> lock(*this->m_lock);
-				for (const auto& cbp : this->m_callbacks)
-					callbacks.emplace(cbp.second);
-			}
+			const auto snapshot = this->m_snapshot.load();
 
 			size_t notified = 0;
-			for (const auto& cb : callbacks) {
-				const auto r = cb(std::forward<T>(t)...);
+			for (const auto& listener : *snapshot) {
+				const auto r = listener->Callback(std::forward<T>(t)...);
 				if (stopNotifying && stopNotifying(notified, r))
 					break;
 				notified++;
@@ -2,36 +2,304 @@
 #include "XivAlexanderCommon/Utils/NumericStatisticsTracker.h"
 #include "XivAlexanderCommon/Utils/Utils.h"
 
-Utils::NumericStatisticsTracker::Entry::Entry(int64_t value, int64_t maxAgeUs)
-	: Value(value)
-	, TimestampUs(Utils::QpcUs())
-	, ExpiryUs(maxAgeUs == INT64_MAX ? INT64_MAX : TimestampUs + maxAgeUs) {
+// Every value is in the treap of the whole window, and in the treap of each Fenwick tree node covering its slot.
+static size_t CountTreapNodes(size_t trackCount) {
+	auto count = trackCount;
+	for (size_t slot = 0; slot < trackCount; ++slot) {
+		for (auto i = slot + 1; i <= trackCount; i += i & (~i + 1))
+			++count;
+	}
+	return count;
+}
+
+Utils::NumericStatisticsTracker::TreapPool::TreapPool(size_t capacity)
+	: m_nodes(capacity + 1) {
+	m_free.reserve(capacity);
+	Clear();
+
+	// Fixed pseudo-random priorities; treaps stay balanced in expectation without a random number generator.
+	for (size_t i = 1; i < m_nodes.size(); ++i) {
+		auto z = static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		m_nodes[i].Priority = static_cast<uint32_t>(z ^ (z >> 31));
+	}
+}
+
+void Utils::NumericStatisticsTracker::TreapPool::Clear() {
+	m_free.clear();
+	for (auto i = m_nodes.size() - 1; i > 0; --i)
+		m_free.push_back(static_cast<uint32_t>(i));
+}
+
+void Utils::NumericStatisticsTracker::TreapPool::Insert(uint32_t& root, int64_t value, uint32_t slot) {
+	const auto node = m_free.back();
+	m_free.pop_back();
+	auto& n = m_nodes[node];
+	n.Value = value;
+	n.Slot = slot;
+
+	// Descend until the new node has the higher priority, and put it there with what was there split around it.
+	auto link = &root;
+	while (*link && m_nodes[*link].Priority > n.Priority) {
+		auto& parent = m_nodes[*link];
+		++parent.Size;
+		link = Less(*link, value, slot) ? &parent.Right : &parent.Left;
+	}
+	std::tie(n.Left, n.Right) = Split(*link, value, slot);
+	Update(node);
+	*link = node;
+}
+
+void Utils::NumericStatisticsTracker::TreapPool::Erase(uint32_t& root, int64_t value, uint32_t slot) {
+	// The node must exist, as every (value, slot) pair erased has been inserted before.
+	auto link = &root;
+	while (m_nodes[*link].Value != value || m_nodes[*link].Slot != slot) {
+		auto& parent = m_nodes[*link];
+		--parent.Size;
+		link = Less(*link, value, slot) ? &parent.Right : &parent.Left;
+	}
+	const auto node = *link;
+	*link = Merge(m_nodes[node].Left, m_nodes[node].Right);
+	m_free.push_back(node);
+}
+
+size_t Utils::NumericStatisticsTracker::TreapPool::CountNotGreaterThan(uint32_t root, int64_t value) const {
+	size_t count = 0;
+	while (root) {
+		const auto& n = m_nodes[root];
+		if (n.Value <= value) {
+			count += m_nodes[n.Left].Size + 1;
+			root = n.Right;
+		} else
+			root = n.Left;
+	}
+	return count;
+}
+
+int64_t Utils::NumericStatisticsTracker::TreapPool::At(uint32_t root, size_t index) const {
+	while (true) {
+		const auto& n = m_nodes[root];
+		const auto leftSize = m_nodes[n.Left].Size;
+		if (index < leftSize)
+			root = n.Left;
+		else if (index == leftSize)
+			return n.Value;
+		else {
+			index -= leftSize + 1;
+			root = n.Right;
+		}
+	}
+}
+
+bool Utils::NumericStatisticsTracker::TreapPool::Less(uint32_t node, int64_t value, uint32_t slot) const {
+	const auto& n = m_nodes[node];
+	return n.Value < value || (n.Value == value && n.Slot < slot);
+}
+
+void Utils::NumericStatisticsTracker::TreapPool::Update(uint32_t node) {
+	auto& n = m_nodes[node];
+	n.Size = m_nodes[n.Left].Size + m_nodes[n.Right].Size + 1;
+}
+
+std::pair<uint32_t, uint32_t> Utils::NumericStatisticsTracker::TreapPool::Split(uint32_t root, int64_t value, uint32_t slot) {
+	if (!root)
+		return {};
+
+	auto& n = m_nodes[root];
+	if (Less(root, value, slot)) {
+		const auto [left, right] = Split(n.Right, value, slot);
+		n.Right = left;
+		Update(root);
+		return {root, right};
+	} else {
+		const auto [left, right] = Split(n.Left, value, slot);
+		n.Left = right;
+		Update(root);
+		return {left, root};
+	}
+}
+
+uint32_t Utils::NumericStatisticsTracker::TreapPool::Merge(uint32_t left, uint32_t right) {
+	if (!left || !right)
+		return left ? left : right;
+
+	if (m_nodes[left].Priority > m_nodes[right].Priority) {
+		m_nodes[left].Right = Merge(m_nodes[left].Right, right);
+		Update(left);
+		return left;
+	} else {
+		m_nodes[right].Left = Merge(left, m_nodes[right].Left);
+		Update(right);
+		return right;
+	}
 }
 
 Utils::NumericStatisticsTracker::NumericStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs)
 	: m_trackCount(trackCount)
 	, m_emptyValue(emptyValue)
-	, m_maxAgeUs(maxAgeUs) {
+	, m_maxAgeUs(maxAgeUs)
+	, m_entries(trackCount)
+	, m_minQueue(trackCount)
+	, m_maxQueue(trackCount)
+	, m_treaps(CountTreapNodes(trackCount))
+	, m_fenwickTreaps(trackCount + 1) {
 }
 
 Utils::NumericStatisticsTracker::~NumericStatisticsTracker() = default;
 
 void Utils::NumericStatisticsTracker::AddValue(int64_t v) {
-	{
-		const auto lock = std::lock_guard(m_mtx);
-		m_values.emplace_back(v, m_maxAgeUs);
+	const auto lock = std::lock_guard(m_mtx);
+	if (!m_trackCount)
+		return;
+
+	const auto nowUs = Utils::QpcUs();
+	const auto [prevSum, prevSquaredSum] = m_head == m_tail
+		? std::make_pair(uint64_t(), uint64_t())
+		: std::make_pair(At(m_tail - 1).CumulativeSum, At(m_tail - 1).CumulativeSquaredSum);
+
+	if (m_tail - m_head == m_trackCount)
+		PopFront();
+
+	const auto uv = static_cast<uint64_t>(v);
+	m_entries[m_tail % m_trackCount] = Entry{
+		.Value = v,
+		.TimestampUs = nowUs,
+		.ExpiryUs = m_maxAgeUs == INT64_MAX ? INT64_MAX : nowUs + m_maxAgeUs,
+		.CumulativeSum = prevSum + uv,
+		.CumulativeSquaredSum = prevSquaredSum + uv * uv,
+	};
+
+	while (m_minQueueTail > m_minQueueHead && At(m_minQueue[(m_minQueueTail - 1) % m_trackCount]).Value >= v)
+		--m_minQueueTail;
+	m_minQueue[m_minQueueTail++ % m_trackCount] = m_tail;
+
+	while (m_maxQueueTail > m_maxQueueHead && At(m_maxQueue[(m_maxQueueTail - 1) % m_trackCount]).Value <= v)
+		--m_maxQueueTail;
+	m_maxQueue[m_maxQueueTail++ % m_trackCount] = m_tail;
+
+	const auto slot = static_cast<uint32_t>(m_tail % m_trackCount);
+	m_treaps.Insert(m_windowTreap, v, slot);
+	if (m_fenwickTreapsValid) {
+		for (auto i = static_cast<size_t>(slot) + 1; i <= m_trackCount; i += i & (~i + 1))
+			m_treaps.Insert(m_fenwickTreaps[i], v, slot);
 	}
-	void(RemoveExpired(m_values.back().TimestampUs));
+
+	++m_tail;
+
+	RemoveExpired(nowUs);
+}
+
+void Utils::NumericStatisticsTracker::Clear() {
+	const auto lock = std::lock_guard(m_mtx);
+	m_head = m_tail = 0;
+	m_minQueueHead = m_minQueueTail = 0;
+	m_maxQueueHead = m_maxQueueTail = 0;
+	m_treaps.Clear();
+	m_windowTreap = 0;
+	std::ranges::fill(m_fenwickTreaps, 0);
+	m_fenwickTreapsValid = false;
 }
 
-const std::deque<Utils::NumericStatisticsTracker::Entry>& Utils::NumericStatisticsTracker::RemoveExpired(int64_t nowUs) const {
+bool Utils::NumericStatisticsTracker::Empty() const {
 	const auto lock = std::lock_guard(m_mtx);
-	while (!m_values.empty() && (
-		m_values.size() > m_trackCount || 
-		m_values.front().ExpiryUs < nowUs
-	))
-		m_values.pop_front();
-	return m_values;
+	return m_head == m_tail;
+}
+
+void Utils::NumericStatisticsTracker::RemoveExpired(int64_t nowUs) const {
+	while (m_head != m_tail && At(m_head).ExpiryUs < nowUs)
+		PopFront();
+}
+
+void Utils::NumericStatisticsTracker::PopFront() const {
+	const auto value = At(m_head).Value;
+	if (m_minQueueHead != m_minQueueTail && m_minQueue[m_minQueueHead % m_trackCount] == m_head)
+		++m_minQueueHead;
+	if (m_maxQueueHead != m_maxQueueTail && m_maxQueue[m_maxQueueHead % m_trackCount] == m_head)
+		++m_maxQueueHead;
+	const auto slot = static_cast<uint32_t>(m_head % m_trackCount);
+	m_treaps.Erase(m_windowTreap, value, slot);
+	if (m_fenwickTreapsValid) {
+		for (auto i = static_cast<size_t>(slot) + 1; i <= m_trackCount; i += i & (~i + 1))
+			m_treaps.Erase(m_fenwickTreaps[i], value, slot);
+	}
+	++m_head;
+}
+
+uint64_t Utils::NumericStatisticsTracker::FirstSince(int64_t sinceUs) const {
+	// Timestamps come from QPC and thus are never decreasing.
+	auto from = m_head, to = m_tail;
+	while (from < to) {
+		const auto mid = from + (to - from) / 2;
+		if (At(mid).TimestampUs < sinceUs)
+			from = mid + 1;
+		else
+			to = mid;
+	}
+	return from;
+}
+
+uint64_t Utils::NumericStatisticsTracker::FirstInQueue(const std::vector<uint64_t>& queue, uint64_t head, uint64_t tail, uint64_t since) const {
+	while (head < tail) {
+		const auto mid = head + (tail - head) / 2;
+		if (queue[mid % m_trackCount] < since)
+			head = mid + 1;
+		else
+			tail = mid;
+	}
+	return queue[head % m_trackCount];
+}
+
+std::pair<uint64_t, uint64_t> Utils::NumericStatisticsTracker::SumsSince(uint64_t since) const {
+	const auto& first = At(since);
+	const auto& last = At(m_tail - 1);
+	const auto firstValue = static_cast<uint64_t>(first.Value);
+	return {
+		last.CumulativeSum - first.CumulativeSum + firstValue,
+		last.CumulativeSquaredSum - first.CumulativeSquaredSum + firstValue * firstValue,
+	};
+}
+
+size_t Utils::NumericStatisticsTracker::CountSlotsBeforeNotGreaterThan(size_t slotEnd, int64_t value) const {
+	size_t count = 0;
+	for (auto i = slotEnd; i > 0; i -= i & (~i + 1))
+		count += m_treaps.CountNotGreaterThan(m_fenwickTreaps[i], value);
+	return count;
+}
+
+size_t Utils::NumericStatisticsTracker::CountSinceNotGreaterThan(uint64_t since, int64_t value) const {
+	const auto first = static_cast<size_t>(since % m_trackCount);
+	const auto count = static_cast<size_t>(m_tail - since);
+	if (first + count <= m_trackCount)
+		return CountSlotsBeforeNotGreaterThan(first + count, value) - CountSlotsBeforeNotGreaterThan(first, value);
+	return CountSlotsBeforeNotGreaterThan(m_trackCount, value) - CountSlotsBeforeNotGreaterThan(first, value)
+		+ CountSlotsBeforeNotGreaterThan(first + count - m_trackCount, value);
+}
+
+int64_t Utils::NumericStatisticsTracker::NthSmallestSince(uint64_t since, size_t index) const {
+	if (since == m_head)
+		return m_treaps.At(m_windowTreap, index);
+
+	if (!m_fenwickTreapsValid) {
+		for (auto sequence = m_head; sequence < m_tail; ++sequence) {
+			const auto slot = static_cast<uint32_t>(sequence % m_trackCount);
+			for (auto i = static_cast<size_t>(slot) + 1; i <= m_trackCount; i += i & (~i + 1))
+				m_treaps.Insert(m_fenwickTreaps[i], At(sequence).Value, slot);
+		}
+		m_fenwickTreapsValid = true;
+	}
+
+	// The answer is one of the values being tracked; find the smallest one with more than index values since then
+	// not greater than it.
+	size_t from = 0, to = static_cast<size_t>(m_tail - m_head - 1);
+	while (from < to) {
+		const auto mid = from + (to - from) / 2;
+		if (CountSinceNotGreaterThan(since, m_treaps.At(m_windowTreap, mid)) > index)
+			to = mid;
+		else
+			from = mid + 1;
+	}
+	return m_treaps.At(m_windowTreap, from);
 }
 
 int64_t Utils::NumericStatisticsTracker::InvalidValue() const {
@@ -39,100 +307,76 @@ int64_t Utils::NumericStatisticsTracker::InvalidValue() const {
 }
 
 int64_t Utils::NumericStatisticsTracker::Latest() const {
-	const auto vals = RemoveExpired();
-	if (vals.empty())
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	if (m_head == m_tail)
 		return m_emptyValue;
-	return vals.back().Value;
+	return At(m_tail - 1).Value;
 }
 
 int64_t Utils::NumericStatisticsTracker::Min(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	auto found = false;
-	int64_t minValue{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		if (!found || minValue > v.Value)
-			minValue = v.Value;
-		found = true;
-	}
-	return found ? minValue : m_emptyValue;
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	const auto since = FirstSince(sinceUs);
+	if (since == m_tail)
+		return m_emptyValue;
+	return At(FirstInQueue(m_minQueue, m_minQueueHead, m_minQueueTail, since)).Value;
 }
 
 int64_t Utils::NumericStatisticsTracker::Max(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	auto found = false;
-	int64_t maxValue{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		if (!found || maxValue < v.Value)
-			maxValue = v.Value;
-		found = true;
-	}
-	return found ? maxValue : m_emptyValue;
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	const auto since = FirstSince(sinceUs);
+	if (since == m_tail)
+		return m_emptyValue;
+	return At(FirstInQueue(m_maxQueue, m_maxQueueHead, m_maxQueueTail, since)).Value;
 }
 
 int64_t Utils::NumericStatisticsTracker::Median(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-
-	std::vector<int64_t> sorted;
-	sorted.reserve(vals.size());
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		sorted.emplace_back(v.Value);
-	}
-	if (sorted.empty())
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	const auto since = FirstSince(sinceUs);
+	const auto count = static_cast<size_t>(m_tail - since);
+	if (!count)
 		return m_emptyValue;
-	std::ranges::sort(sorted);
 
-	if (sorted.size() % 2 == 0) {
+	if (count % 2 == 0) {
 		// even
-		return (sorted[sorted.size() / 2] + sorted[sorted.size() / 2 - 1]) / 2;
+		return (NthSmallestSince(since, count / 2) + NthSmallestSince(since, count / 2 - 1)) / 2;
 	} else {
 		// odd
-		return sorted[sorted.size() / 2];
+		return NthSmallestSince(since, count / 2);
 	}
 }
 
 int64_t Utils::NumericStatisticsTracker::Mean(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	int64_t count = 0;
-	int64_t acc{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		acc += v.Value;
-		++count;
-	}
-	return count ? acc / count : m_emptyValue;
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	const auto since = FirstSince(sinceUs);
+	const auto count = static_cast<int64_t>(m_tail - since);
+	if (!count)
+		return m_emptyValue;
+	return static_cast<int64_t>(SumsSince(since).first) / count;
 }
 
 std::pair<int64_t, int64_t> Utils::NumericStatisticsTracker::MeanAndDeviation(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-
-	int64_t count = 0;
-	int64_t acc{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		acc += v.Value;
-		++count;
-	}
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	const auto since = FirstSince(sinceUs);
+	const auto count = static_cast<int64_t>(m_tail - since);
 
 	if (count == 0)
 		return {m_emptyValue, 0};
+
+	const auto [sum, squaredSum] = SumsSince(since);
+	const auto acc = static_cast<int64_t>(sum);
 	if (count == 1)
 		return {acc, 0};
 	const auto mean = acc / count;
 
-	int64_t diffSquaredSum = 0;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		diffSquaredSum += (v.Value - mean) * (v.Value - mean);
-	}
+	// sum((v - mean)^2) = sum(v^2) - 2 * mean * sum(v) + count * mean^2, computed with wrapping arithmetic
+	const auto umean = static_cast<uint64_t>(mean);
+	const auto diffSquaredSum = static_cast<int64_t>(squaredSum - 2 * umean * sum + static_cast<uint64_t>(count) * umean * umean);
 
 	return {mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count))};
 }
@@ -142,45 +386,36 @@ int64_t Utils::NumericStatisticsTracker::Deviation(int64_t sinceUs) const {
 }
 
 size_t Utils::NumericStatisticsTracker::Count(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
 	if (!sinceUs)
-		return vals.size();
-
-	size_t count = 0;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		++count;
-	}
-	return count;
+		return static_cast<size_t>(m_tail - m_head);
+	return static_cast<size_t>(m_tail - FirstSince(sinceUs));
 }
 
 int64_t Utils::NumericStatisticsTracker::NextBlankInUs() const {
-	const auto s = RemoveExpired();
-	if (s.size() < m_trackCount)
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
+	if (m_head == m_tail || m_tail - m_head < m_trackCount)
 		return 0;
-	return s.front().Value - Entry(0, 0).Value;
+	return At(m_head).Value;
 }
 
 double Utils::NumericStatisticsTracker::CountFractional(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
+	const auto lock = std::lock_guard(m_mtx);
+	RemoveExpired();
 	if (!sinceUs)
-		return static_cast<double>(vals.size());
+		return static_cast<double>(m_tail - m_head);
 
-	size_t count = 0;
-	int64_t lastTimestamp = INT64_MIN;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs) {
-			if (lastTimestamp != INT64_MIN) {
-				const auto window = lastTimestamp - v.TimestampUs;
-				const auto elapsed = sinceUs - v.TimestampUs;
-				if (window > elapsed)
-					return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
-			}
-			break;
-		}
-		++count;
-		lastTimestamp = v.TimestampUs;
+	const auto since = FirstSince(sinceUs);
+	const auto count = static_cast<size_t>(m_tail - since);
+	if (count && since != m_head) {
+		const auto lastTimestamp = At(since).TimestampUs;
+		const auto& v = At(since - 1);
+		const auto window = lastTimestamp - v.TimestampUs;
+		const auto elapsed = sinceUs - v.TimestampUs;
+		if (window > elapsed)
+			return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
 	}
 	return static_cast<double>(count);
 }
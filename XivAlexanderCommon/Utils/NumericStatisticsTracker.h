@@ -1,35 +1,111 @@
 #pragma once
 
-#include <deque>
+#include <mutex>
+#include <vector>
 #include "XivAlexanderCommon/Utils/Utils.h"
 
 namespace Utils {
+	/// \brief Keeps track of the last few values, and answers statistics queries on them.
+	///
+	/// Values are kept in a fixed-capacity ring buffer; minimum and maximum are tracked using monotonic queues,
+	/// sums and squared sums are kept as prefix sums, and values are kept in treaps for median: one for every value
+	/// being tracked, and one for each node of a Fenwick tree over ring buffer slots, for medians of recent values.
+	/// Nothing allocates after construction. Adding a value takes O(log n), or O(log^2 n) once median of recent values
+	/// has been asked; median of every value takes O(log n), median of recent values takes O(log^3 n), and other
+	/// queries run in O(1) or O(log n).
 	class NumericStatisticsTracker {
 		const size_t m_trackCount;
 		const int64_t m_emptyValue;
 		const int64_t m_maxAgeUs;
 
 		struct Entry {
-			const int64_t Value;
-			const int64_t TimestampUs;
-			const int64_t ExpiryUs;
+			int64_t Value;
+			int64_t TimestampUs;
+			int64_t ExpiryUs;
 
-			Entry(int64_t value, int64_t maxAgeUs);
+			// Sums of every value added until this entry, inclusive. Wraps around on overflow.
+			uint64_t CumulativeSum;
+			uint64_t CumulativeSquaredSum;
 		};
 
 		mutable std::mutex m_mtx;
-		mutable std::deque<Entry> m_values;
+
+		// Ring buffer of entries, indexed by (sequence number % m_trackCount).
+		mutable std::vector<Entry> m_entries;
+		mutable uint64_t m_head = 0;
+		uint64_t m_tail = 0;
+
+		// Sequence numbers of entries that may become the minimum/maximum of some suffix of m_entries.
+		// Values are strictly increasing for m_minQueue, and strictly decreasing for m_maxQueue.
+		mutable std::vector<uint64_t> m_minQueue;
+		mutable uint64_t m_minQueueHead = 0;
+		uint64_t m_minQueueTail = 0;
+		mutable std::vector<uint64_t> m_maxQueue;
+		mutable uint64_t m_maxQueueHead = 0;
+		uint64_t m_maxQueueTail = 0;
+
+		// Treaps ordered by (value, slot), sharing a preallocated node pool.
+		class TreapPool {
+			struct Node {
+				int64_t Value;
+				uint32_t Slot;
+				uint32_t Priority;
+				uint32_t Left;
+				uint32_t Right;
+				uint32_t Size;
+			};
+
+			std::vector<Node> m_nodes;  // m_nodes[0] stands for an empty tree
+			std::vector<uint32_t> m_free;
+
+		public:
+			TreapPool(size_t capacity);
+
+			void Clear();
+			void Insert(uint32_t& root, int64_t value, uint32_t slot);
+			void Erase(uint32_t& root, int64_t value, uint32_t slot);
+
+			[[nodiscard]] size_t CountNotGreaterThan(uint32_t root, int64_t value) const;
+
+			/// \returns index-th smallest value.
+			[[nodiscard]] int64_t At(uint32_t root, size_t index) const;
+
+		private:
+			[[nodiscard]] bool Less(uint32_t node, int64_t value, uint32_t slot) const;
+			void Update(uint32_t node);
+			std::pair<uint32_t, uint32_t> Split(uint32_t root, int64_t value, uint32_t slot);
+			uint32_t Merge(uint32_t left, uint32_t right);
+		};
+
+		mutable TreapPool m_treaps;
+
+		// Values currently in m_entries.
+		mutable uint32_t m_windowTreap = 0;
+
+		// m_fenwickTreaps[i] holds values in slots [i - (i & -i), i), for i in [1, m_trackCount].
+		// Built on first median query of recent values only, and kept up to date from then on.
+		mutable std::vector<uint32_t> m_fenwickTreaps;
+		mutable bool m_fenwickTreapsValid = false;
 
 	public:
 		NumericStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs = INT64_MAX);
 		~NumericStatisticsTracker();
 
 		void AddValue(int64_t);
-		void Clear() { m_values.clear(); };
-		bool Empty() const { return m_values.empty(); }
+		void Clear();
+		bool Empty() const;
 
 	private:
-		[[nodiscard]] const std::deque<Entry>& RemoveExpired(int64_t nowUs = Utils::QpcUs()) const;
+		void RemoveExpired(int64_t nowUs = Utils::QpcUs()) const;
+		void PopFront() const;
+
+		[[nodiscard]] const Entry& At(uint64_t sequence) const { return m_entries[sequence % m_trackCount]; }
+		[[nodiscard]] uint64_t FirstSince(int64_t sinceUs) const;
+		[[nodiscard]] uint64_t FirstInQueue(const std::vector<uint64_t>& queue, uint64_t head, uint64_t tail, uint64_t since) const;
+		[[nodiscard]] std::pair<uint64_t, uint64_t> SumsSince(uint64_t since) const;
+		[[nodiscard]] size_t CountSlotsBeforeNotGreaterThan(size_t slotEnd, int64_t value) const;
+		[[nodiscard]] size_t CountSinceNotGreaterThan(uint64_t since, int64_t value) const;
+		[[nodiscard]] int64_t NthSmallestSince(uint64_t since, size_t index) const;
 
 	public:
 		[[nodiscard]] int64_t InvalidValue() const;
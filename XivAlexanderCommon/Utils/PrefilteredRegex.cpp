@@ -0,0 +1,226 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/PrefilteredRegex.h"
+
+static char ToLowerAscii(char c) {
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static bool IsAsciiDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static bool IsAsciiHexDigit(char c) {
+	return IsAsciiDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool IsAsciiAlphanumeric(char c) {
+	return IsAsciiDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static size_t Utf8SequenceLength(char c) {
+	const auto b = static_cast<uint8_t>(c);
+	if (b < 0x80)
+		return 1;
+	if ((b & 0xE0) == 0xC0)
+		return 2;
+	if ((b & 0xF0) == 0xE0)
+		return 3;
+	if ((b & 0xF8) == 0xF0)
+		return 4;
+	return 1;
+}
+
+Utils::PrefilteredRegex::PrefilteredRegex(const std::string& pattern, bool icase)
+	: m_regex(pattern, srell::regex_constants::ECMAScript | (icase ? srell::regex_constants::icase : srell::regex_constants::syntax_option_type()))
+	, m_requiredLiteral(FindRequiredLiteral(pattern, icase))
+	, m_icase(icase) {
+}
+
+bool Utils::PrefilteredRegex::Search(std::string_view s) const {
+	if (!m_requiredLiteral.empty()) {
+		if (m_icase) {
+			if (std::search(s.begin(), s.end(), m_requiredLiteral.begin(), m_requiredLiteral.end(), [](char l, char r) { return ToLowerAscii(l) == r; }) == s.end())
+				return false;
+		} else if (s.find(m_requiredLiteral) == std::string_view::npos)
+			return false;
+	}
+	return srell::regex_search(s.data(), s.data() + s.size(), m_regex);
+}
+
+std::string Utils::PrefilteredRegex::FindRequiredLiteral(std::string_view pattern, bool icase) {
+	std::string best, current;
+	const auto endRun = [&]() {
+		if (current.size() > best.size())
+			best = current;
+		current.clear();
+	};
+
+	// Skips to right after the ')' closing the group starting at i, taking escapes and classes into account.
+	const auto skipGroup = [&pattern](size_t i) {
+		size_t depth = 0;
+		auto inClass = false;
+		for (; i < pattern.size(); ++i) {
+			const auto c = pattern[i];
+			if (c == '\\')
+				++i;
+			else if (inClass)
+				inClass = c != ']';
+			else if (c == '[')
+				inClass = true;
+			else if (c == '(')
+				++depth;
+			else if (c == ')' && !--depth)
+				return i + 1;
+		}
+		return pattern.size();
+	};
+
+	// Skips to right after the ']' closing the class starting at i.
+	const auto skipClass = [&pattern](size_t i) {
+		for (++i; i < pattern.size(); ++i) {
+			if (pattern[i] == '\\')
+				++i;
+			else if (pattern[i] == ']')
+				return i + 1;
+		}
+		return pattern.size();
+	};
+
+	// Skips to right after the next c.
+	const auto skipPast = [&pattern](size_t i, char c) {
+		const auto end = pattern.find(c, i);
+		return end == std::string_view::npos ? pattern.size() : end + 1;
+	};
+
+	// Skips {n}, {n,}, or {n,m} if there is one at i.
+	const auto skipBraceQuantifier = [&pattern](size_t i) {
+		const auto end = pattern.find('}', i);
+		if (end == std::string_view::npos || end == i + 1)
+			return i + 1;
+		for (auto j = i + 1; j < end; ++j) {
+			if (!IsAsciiDigit(pattern[j]) && pattern[j] != ',')
+				return i + 1;
+		}
+		return end + 1;
+	};
+
+	for (size_t i = 0; i < pattern.size();) {
+		const auto c = pattern[i];
+		size_t literalOffset = i, literalLength = 0;
+
+		switch (c) {
+			case '|':
+				// Every alternative would have to be analyzed on its own.
+				return {};
+
+			case '(':
+				endRun();
+				i = skipGroup(i);
+				continue;
+
+			case '[':
+				endRun();
+				i = skipClass(i);
+				continue;
+
+			case '{':
+				endRun();
+				i = skipBraceQuantifier(i);
+				continue;
+
+			case '*':
+			case '+':
+			case '?':
+			case '.':
+			case '^':
+			case '$':
+			case ')':
+			case ']':
+			case '}':
+				endRun();
+				++i;
+				continue;
+
+			case '\\': {
+				if (i + 1 >= pattern.size())
+					return {};
+
+				const auto escaped = pattern[i + 1];
+				if (!IsAsciiAlphanumeric(escaped)) {
+					literalOffset = i + 1;
+					literalLength = Utf8SequenceLength(escaped);
+					break;
+				}
+
+				endRun();
+				i += 2;
+				switch (escaped) {
+					case 'u':
+						if (i < pattern.size() && pattern[i] == '{')
+							i = skipPast(i, '}');
+						else
+							for (size_t n = 0; n < 4 && i < pattern.size() && IsAsciiHexDigit(pattern[i]); ++n)
+								++i;
+						break;
+
+					case 'x':
+						for (size_t n = 0; n < 2 && i < pattern.size() && IsAsciiHexDigit(pattern[i]); ++n)
+							++i;
+						break;
+
+					case 'c':
+						i = std::min(pattern.size(), i + 1);
+						break;
+
+					case 'k':
+						if (i < pattern.size() && pattern[i] == '<')
+							i = skipPast(i, '>');
+						break;
+
+					case 'p':
+					case 'P':
+						if (i < pattern.size() && pattern[i] == '{')
+							i = skipPast(i, '}');
+						break;
+
+					default:
+						while (IsAsciiDigit(escaped) && i < pattern.size() && IsAsciiDigit(pattern[i]))
+							++i;
+				}
+				continue;
+			}
+
+			default:
+				literalLength = Utf8SequenceLength(c);
+		}
+
+		i = std::min(pattern.size(), literalOffset + literalLength);
+		const auto literal = pattern.substr(literalOffset, literalLength);
+
+		// Unicode case folding maps some non-ASCII characters into ASCII ones (e.g. U+212A KELVIN SIGN into k).
+		const auto usable = !icase || (literal.size() == 1
+			&& static_cast<uint8_t>(literal[0]) < 0x80
+			&& ToLowerAscii(literal[0]) != 'i'
+			&& ToLowerAscii(literal[0]) != 'k'
+			&& ToLowerAscii(literal[0]) != 's');
+
+		const auto next = i < pattern.size() ? pattern[i] : '\0';
+		auto afterPlus = i + 1 < pattern.size() ? pattern[i + 1] : '\0';
+		if (afterPlus == '?')
+			afterPlus = i + 2 < pattern.size() ? pattern[i + 2] : '\0';
+		if (!usable || next == '*' || next == '?' || next == '{'
+			|| (next == '+' && (afterPlus == '*' || afterPlus == '+' || afterPlus == '?' || afterPlus == '{'))) {
+			// Not required, or not usable; the quantifier itself gets skipped in the next iteration.
+			endRun();
+		} else if (next == '+') {
+			for (const auto ch : literal)
+				current.push_back(icase ? ToLowerAscii(ch) : ch);
+			endRun();
+		} else {
+			for (const auto ch : literal)
+				current.push_back(icase ? ToLowerAscii(ch) : ch);
+		}
+	}
+	endRun();
+	return best;
+}
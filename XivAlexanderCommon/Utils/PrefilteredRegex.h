@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <srell.hpp>
+
+namespace Utils {
+	/// \brief ECMAScript regular expression over UTF-8 strings, which rejects strings without running the regular expression
+	/// if they do not contain a literal that every match of the pattern must contain.
+	class PrefilteredRegex {
+		srell::u8cregex m_regex;
+		std::string m_requiredLiteral;
+		bool m_icase;
+
+	public:
+		PrefilteredRegex(const std::string& pattern, bool icase);
+
+		[[nodiscard]] const srell::u8cregex& Regex() const { return m_regex; }
+
+		/// \brief Literal contained in every string that the pattern matches, with ASCII letters lowercased if case insensitive.
+		/// Empty if none could be determined.
+		[[nodiscard]] const std::string& RequiredLiteral() const { return m_requiredLiteral; }
+
+		/// \brief Same result as srell::regex_search(s, Regex()).
+		[[nodiscard]] bool Search(std::string_view s) const;
+
+		/// \brief Finds the longest run of characters that every match of an ECMAScript pattern must contain.
+		///
+		/// Only patterns without top level alternatives are analyzed; groups, classes, assertions and quantified atoms end a run.
+		/// For case insensitive patterns, only ASCII characters that no other character folds into are taken.
+		[[nodiscard]] static std::string FindRequiredLiteral(std::string_view pattern, bool icase);
+	};
+}
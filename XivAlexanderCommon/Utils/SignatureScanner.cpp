@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/SignatureScanner.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define SIGNATURESCANNER_SSE2
+#endif
+
+size_t Utils::SignatureScanner::Add(std::string_view pattern, std::string_view mask) {
+	if (pattern.size() != mask.size())
+		throw std::invalid_argument("pattern and mask must be of same length");
+	if (pattern.empty())
+		throw std::invalid_argument("pattern must not be empty");
+
+	Pattern p{
+		.MaskedBytes = std::string(pattern),
+		.Mask = std::string(mask),
+		.AnchorOffset = 0,
+		.AnchorLength = 0,
+	};
+	for (size_t i = 0; i < pattern.size(); ++i)
+		p.MaskedBytes[i] = static_cast<char>(pattern[i] & mask[i]);
+
+	for (size_t i = 0; i < mask.size();) {
+		if (static_cast<uint8_t>(mask[i]) != 0xFF) {
+			++i;
+			continue;
+		}
+		auto j = i;
+		while (j < mask.size() && static_cast<uint8_t>(mask[j]) == 0xFF)
+			++j;
+		if (j - i > p.AnchorLength) {
+			p.AnchorOffset = i;
+			p.AnchorLength = j - i;
+		}
+		i = j;
+	}
+
+	m_patterns.emplace_back(std::move(p));
+	return m_patterns.size() - 1;
+}
+
+std::vector<std::vector<size_t>> Utils::SignatureScanner::Scan(std::span<const uint8_t> data) const {
+	std::vector<std::vector<size_t>> result(m_patterns.size());
+	for (size_t blockFrom = 0; blockFrom < data.size(); blockFrom += BlockSize) {
+		const auto blockTo = std::min(data.size(), blockFrom + BlockSize);
+
+		for (size_t patternIndex = 0; patternIndex < m_patterns.size(); ++patternIndex) {
+			const auto& pattern = m_patterns[patternIndex];
+			auto& matches = result[patternIndex];
+			if (pattern.Mask.size() > data.size())
+				continue;
+
+			// Match starting positions in this block.
+			const auto from = blockFrom;
+			const auto to = std::min(blockTo, data.size() - pattern.Mask.size() + 1);
+			if (from >= to)
+				continue;
+
+			if (!pattern.AnchorLength) {
+				for (auto i = from; i < to; ++i) {
+					if (Matches(pattern, &data[i]))
+						matches.push_back(i);
+				}
+				continue;
+			}
+
+			const auto firstOffset = pattern.AnchorOffset;
+			const auto lastOffset = pattern.AnchorOffset + pattern.AnchorLength - 1;
+			const auto first = static_cast<char>(pattern.MaskedBytes[firstOffset]);
+			const auto last = static_cast<char>(pattern.MaskedBytes[lastOffset]);
+
+			auto i = from;
+#ifdef SIGNATURESCANNER_SSE2
+			const auto firstVec = _mm_set1_epi8(first);
+			const auto lastVec = _mm_set1_epi8(last);
+
+			// Every load stays in bounds: the last byte read is at (to - 1) + lastOffset, which is within the pattern at the last start position.
+			for (; i + 16 <= to; i += 16) {
+				const auto firstEq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&data[i + firstOffset])), firstVec);
+				const auto lastEq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&data[i + lastOffset])), lastVec);
+				for (auto candidates = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(firstEq, lastEq))); candidates; candidates &= candidates - 1) {
+					const auto offset = i + std::countr_zero(candidates);
+					if (Matches(pattern, &data[offset]))
+						matches.push_back(offset);
+				}
+			}
+#endif
+			for (; i < to; ++i) {
+				if (static_cast<char>(data[i + firstOffset]) == first && static_cast<char>(data[i + lastOffset]) == last && Matches(pattern, &data[i]))
+					matches.push_back(i);
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<std::vector<size_t>> Utils::SignatureScanner::ScanNaive(std::span<const uint8_t> data) const {
+	std::vector<std::vector<size_t>> result(m_patterns.size());
+	for (size_t patternIndex = 0; patternIndex < m_patterns.size(); ++patternIndex) {
+		const auto& pattern = m_patterns[patternIndex];
+		for (size_t i = 0; i + pattern.Mask.size() <= data.size(); ++i) {
+			if (Matches(pattern, &data[i]))
+				result[patternIndex].push_back(i);
+		}
+	}
+	return result;
+}
+
+bool Utils::SignatureScanner::Matches(const Pattern& pattern, const uint8_t* data) {
+	for (size_t i = 0; i < pattern.Mask.size(); ++i) {
+		if ((data[i] & static_cast<uint8_t>(pattern.Mask[i])) != static_cast<uint8_t>(pattern.MaskedBytes[i]))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Utils {
+	/// \brief Finds every occurrence of a set of masked byte patterns in a buffer.
+	///
+	/// A byte at offset i of a pattern matches a byte b if (b & mask[i]) == (pattern[i] & mask[i]).
+	/// The buffer is scanned in blocks small enough to stay in cache, and every pattern is looked for in a block
+	/// before moving on to the next one. Candidates for each pattern are found by comparing 16 positions at a time
+	/// against the first and the last byte of the longest run of bytes that must match exactly, and then verified.
+	/// Without SSE2, candidates are found one position at a time the same way.
+	class SignatureScanner {
+		struct Pattern {
+			std::string MaskedBytes;
+			std::string Mask;
+
+			// Longest run of bytes with mask 0xFF. AnchorLength is 0 if there is none.
+			size_t AnchorOffset;
+			size_t AnchorLength;
+		};
+
+		std::vector<Pattern> m_patterns;
+
+	public:
+		static constexpr size_t BlockSize = 65536;
+
+		/// \brief Adds a pattern to look for.
+		/// \returns Index of the pattern in the result of Scan.
+		size_t Add(std::string_view pattern, std::string_view mask);
+
+		[[nodiscard]] size_t PatternCount() const { return m_patterns.size(); }
+
+		/// \returns Offsets of every match of each pattern, in ascending order, in the order the patterns were added.
+		[[nodiscard]] std::vector<std::vector<size_t>> Scan(std::span<const uint8_t> data) const;
+
+		/// \brief Same as Scan, comparing every pattern at every offset one byte at a time.
+		[[nodiscard]] std::vector<std::vector<size_t>> ScanNaive(std::span<const uint8_t> data) const;
+
+	private:
+		[[nodiscard]] static bool Matches(const Pattern& pattern, const uint8_t* data);
+	};
+}
@@ -351,7 +351,24 @@ void Utils::SaveJsonToFile(const std::filesystem::path& path, const nlohmann::js
 }
 
 void Utils::SaveToFile(const std::filesystem::path& path, std::span<const char> s) {
-	void(Win32::Handle::FromCreateFile(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, 0).Write(0, s));
+	// Write next to the target and then replace it, so that the target is never seen, or left, partially written.
+	auto tempPath = path;
+	tempPath += std::format(L".{}.tmp", GetCurrentThreadId());
+
+	try {
+		{
+			const auto file = Win32::Handle::FromCreateFile(tempPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, 0);
+			void(file.Write(0, s));
+			if (!FlushFileBuffers(file))
+				throw Win32::Error("FlushFileBuffers");
+		}
+		if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+			throw Win32::Error("MoveFileExW");
+	} catch (...) {
+		std::error_code ec;
+		std::filesystem::remove(tempPath, ec);
+		throw;
+	}
 }
 
 void std::filesystem::to_json(nlohmann::json& j, const path& value) {
@@ -27,4 +27,26 @@ namespace Utils::Win32 {
 		void WaitOutstanding();
 		void Cancel();
 	};
-}
\ No newline at end of file
+
+	/// \brief Calls fn(from, to) over consecutive ranges covering [0, count), and waits for all of them.
+	///
+	/// The work is split across a new thread pool of up to preferredThreadCount threads only if there are more than
+	/// minimumCountPerTask items and more than one thread is allowed; otherwise, fn is called from the current thread.
+	template<typename Fn>
+	void ParallelForRanges(std::wstring name, size_t count, size_t minimumCountPerTask, const Fn& fn, DWORD preferredThreadCount = UINT32_MAX) {
+		minimumCountPerTask = std::max<size_t>(1, minimumCountPerTask);
+		if (count <= minimumCountPerTask || preferredThreadCount <= 1) {
+			fn(size_t(), count);
+			return;
+		}
+
+		TpEnvironment pool(std::move(name), preferredThreadCount);
+		const auto taskCount = std::min((count + minimumCountPerTask - 1) / minimumCountPerTask, pool.ThreadCount() * 4);
+		const auto countPerTask = (count + taskCount - 1) / taskCount;
+		for (size_t from = 0; from < count; from += countPerTask) {
+			const auto to = std::min(count, from + countPerTask);
+			pool.SubmitWork([&fn, from, to]() { fn(from, to); });
+		}
+		pool.WaitOutstanding();
+	}
+}